@@ -7,7 +7,8 @@
  *
  * Программа координирует взаимодействие между несколькими независимыми компонентами:
  * - **Project_manager** — создание, открытие, переименование или удаление проекта;
- * - **Graph_verilog_generator** — генерация описания сети (графа) и Verilog-файлов;
+ * - **Graph_verilog_generator** — генерация описания сети (графа) и Verilog-файлов
+ *   (граф может строиться и внутри Broker библиотекой Topology, см. `--native`);
  * - **Quartus_compiler** — автоматическая компиляция проекта Quartus;
  * - **Database_writer** — запись итоговых данных в базу данных.
  *
@@ -19,9 +20,22 @@
  * Пример запуска:
  * @code
  * Broker --project -n MyProject -l ./projects --create
+ * Broker --project -n MyProject -l ./projects --clone MyVariant --quartus
  * Broker --graph -l ./projects -n MyProject --params "Nx=4 Ny=4"
+ * Broker --graph -l ./projects -n MyProject --native --params "topology=torus Nx=16 Ny=16" -j 8
+ * Broker --graph -l ./projects -n MyProject --native --parameterized --params "Nx=64 Ny=64"
  * Broker --quartus -l ./projects -n MyProject
+ * Broker --quartus -l ./projects --projects A B C --cores 16 --max-fits 2
+ * Broker --quartus -l ./projects -n MyProject --exploration
+ * Broker --quartus -l ./projects --projects A B --max-fits 4 --seeds 4
+ * Broker --quartus -l ./projects --projects A B C --abort-slack -0.5
+ * Broker --quartus -l ./projects -n MyProject --devices 5CGXFC9E7F35C8,10M50DAF484C7G
+ * Broker --quartus -l ./projects --projects A B C --seat-dir /shared/quartus_seats --seats 4
+ * Broker --quartus -l ./projects -n MyProject --stage asm
+ * Broker --quartus -l ./projects --projects A B C D --pareto skip --pareto-margin 0.05
  * Broker --database -l ./projects -n MyProject --write
+ * Broker --quartus -l ./projects --projects A B C --database --write
+ * Broker --quartus -l ./projects --projects A B C --database --spool
  * @endcode
  *
  * @section metadata Метаданные проекта
@@ -33,18 +47,22 @@
  * При каждом запуске Broker обновляет эти флаги, чтобы исключить повторные или некорректные действия.
  */
 
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
 #include <vector>
 #include <map>
+#include <memory>
 #include <filesystem>
 #include <cstdlib>
+#include <limits>
 #include <thread>
 #include <chrono>
 
 #ifdef _WIN32
+#define NOMINMAX // Макросы min/max из windows.h ломают std::min/std::max здесь и в Parallel.hpp.
 #include <windows.h>
 #define PLATFORM_WINDOWS
 #else
@@ -54,6 +72,16 @@
 #endif
 
 #include "nlohmann/json.hpp"
+#include "Topology.hpp"
+#include "GraphJson.hpp"
+#include "GraphBinary.hpp"
+#include "VerilogEmitter.hpp"
+#include "Floorplan.hpp"
+#include "FileLock.hpp"
+#include "Parallel.hpp"
+#include "StageScheduler.hpp"
+#include "SeatPool.hpp"
+#include "ParetoFront.hpp"
 
 using json = nlohmann::json;
 namespace fs = std::filesystem;
@@ -99,6 +127,7 @@ void uncheckMetadata(const std::string& jsonPath, int stage) {
         return;
     }
 
+    common::FileLock lock(common::metadataLockPath(jsonPath));
     std::ifstream in(jsonPath);
     json j;
     in >> j;
@@ -124,6 +153,156 @@ void uncheckMetadata(const std::string& jsonPath, int stage) {
     out << std::setw(4) << j;
 }
 
+/**
+ * @brief Записывает значение в раздел JSON-файла метаданных проекта, сохраняя остальные поля.
+ *
+ * @param jsonPath Путь к JSON-файлу с метаданными проекта.
+ * @param section Раздел метаданных (например, `graphVerilogMetadata`).
+ * @param key Имя поля в разделе.
+ * @param value Новое значение.
+ */
+void setMetadataValue(const std::string& jsonPath, const std::string& section, const std::string& key, const json& value) {
+    if (!fs::exists(jsonPath)) {
+        std::cerr << "Metadata file not found: " << jsonPath << std::endl;
+        return;
+    }
+
+    common::FileLock lock(common::metadataLockPath(jsonPath));
+    json j;
+    {
+        std::ifstream in(jsonPath);
+        in >> j;
+    }
+    j[section][key] = value;
+
+    std::ofstream out(jsonPath);
+    out << std::setw(4) << j;
+}
+
+/**
+ * @brief Выполняет этап построения графа внутри Broker с помощью библиотеки Topology.
+ *
+ * Параметры берутся из аргументов после `--params` (до следующего аргумента, начинающегося с `-`),
+ * поэтому одинаково обрабатываются `--params "Nx=4 Ny=4"` и `--params Nx=4 Ny=4`.
+ * Граф записывается во временный файл и переименовывается в `<имя>_graph_object_serialized.json`,
+ * после чего в метаданных выставляется `graphSerialized` и сохраняются параметры.
+ * Затем по графу генерируется Verilog-описание `<имя>_NoC_description` (`-j/--jobs` — число потоков,
+ * `--parameterized` — общие параметризованные модули вместо модулей на каждый узел),
+ * к нему добавляется `noc_floorplan.qsf` с разделами и областями размещения (`--region-size` —
+ * маршрутизаторов в области, `--device-grid <столбцы>x<строки>` — закрепить области на сетке LAB)
+ * и выставляется `verilogGenerated`.
+ *
+ * @param location Расположение проекта.
+ * @param name Имя проекта.
+ * @param args Аргументы этапа `--graph`.
+ * @return 0 — успех, 1 — ошибка.
+ */
+int runNativeGraph(const std::string& location, const std::string& name, const std::vector<std::string>& args) {
+    std::string params;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (args[i] != "--params") continue;
+        while (i + 1 < args.size() && args[i + 1].rfind("-", 0) != 0)
+            params += (params.empty() ? "" : " ") + args[++i];
+    }
+    unsigned jobs = common::defaultJobs();
+    noc::FloorplanOptions floorplan;
+    // std::stoul принимает знак минус и числа больше uint32_t: такие значения отклоняются, а не усекаются.
+    auto parseCount = [](const std::string& text) {
+        size_t pos = 0;
+        unsigned long long n = std::stoull(text, &pos);
+        if (pos != text.size() || text.find('-') != std::string::npos || n > std::numeric_limits<uint32_t>::max())
+            throw std::out_of_range(text);
+        return static_cast<uint32_t>(n);
+    };
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        const std::string& option = args[i];
+        const std::string& value = args[i + 1];
+        try {
+            if (option == "-j" || option == "--jobs") {
+                jobs = common::parseJobs(value);
+            }
+            else if (option == "--region-size") {
+                floorplan.routersPerRegion = parseCount(value);
+                if (floorplan.routersPerRegion == 0) throw std::out_of_range(value);
+            }
+            else if (option == "--device-grid") {
+                // Размер сетки LAB в виде "<столбцы>x<строки>".
+                size_t x = value.find('x');
+                if (x == std::string::npos) throw std::invalid_argument(value);
+                floorplan.deviceColumns = parseCount(value.substr(0, x));
+                floorplan.deviceRows = parseCount(value.substr(x + 1));
+            }
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid value for " << option << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    try {
+        auto started = std::chrono::steady_clock::now();
+        noc::Graph graph = noc::buildTopology(noc::TopologyParams::parse(params));
+        auto built = std::chrono::steady_clock::now();
+
+        std::string graphPath = location + "/" + name + "_graph_object_serialized.json";
+        {
+            std::ofstream out(graphPath + ".tmp", std::ios::binary | std::ios::trunc);
+            noc::writeGraphJson(graph, out);
+            out.close();
+            if (!out) throw std::runtime_error("Failed to write " + graphPath);
+        }
+        fs::rename(graphPath + ".tmp", graphPath);
+
+        // Двоичная копия графа: последующие стадии отображают её в память вместо разбора JSON.
+        std::string binaryPath = location + "/" + name + "_graph_object.bin";
+        {
+            std::ofstream out(binaryPath + ".tmp", std::ios::binary | std::ios::trunc);
+            noc::writeGraphBinary(graph, out);
+            out.close();
+            if (!out) throw std::runtime_error("Failed to write " + binaryPath);
+        }
+        fs::rename(binaryPath + ".tmp", binaryPath);
+
+        std::string metadataPath = location + "/" + name + "_metadata.json";
+        setMetadataValue(metadataPath, "graphVerilogMetadata", "params", params);
+        setMetadataValue(metadataPath, "graphVerilogMetadata", "graphSerialized", true);
+
+        auto serialized = std::chrono::steady_clock::now();
+
+        noc::VerilogOptions options;
+        options.jobs = jobs;
+        if (std::find(args.begin(), args.end(), "--parameterized") != args.end())
+            options.style = noc::VerilogStyle::Parameterized;
+
+        // Разделы и области размещения для генерируемого проекта Quartus. Разбиение строится до генерации
+        // Verilog: при разделах по областям маршрутизаторы областей оборачиваются в модули.
+        floorplan.style = options.style;
+        noc::Floorplan plan = noc::planFloorplan(graph, floorplan);
+        options.groups = noc::verilogGroups(plan);
+        // Назначения разделов пишутся вместе с модулями: каталог описания не бывает без них виден.
+        std::ostringstream qsf;
+        noc::writeFloorplanQsf(graph, plan, floorplan, qsf);
+        options.extraFiles.emplace_back("noc_floorplan.qsf", qsf.str());
+        std::string descriptionPath = location + "/" + name + "_NoC_description";
+        noc::VerilogStats verilog = noc::emitVerilog(graph, descriptionPath, options);
+        setMetadataValue(metadataPath, "graphVerilogMetadata", "verilogGenerated", true);
+
+        auto ms = [](auto d) { return std::chrono::duration<double, std::milli>(d).count(); };
+        std::cout << "Native topology " << noc::topologyName(graph.params.kind) << ": " << graph.nodeCount()
+            << " nodes, " << graph.edgeCount() << " edges, built in " << ms(built - started)
+            << " ms, serialized in " << ms(serialized - built) << " ms\n";
+        std::cout << "Verilog: " << verilog.modules << " modules in " << verilog.files << " files, " << verilog.bytes
+            << " bytes, generated in " << ms(std::chrono::steady_clock::now() - serialized) << " ms on " << jobs << " threads\n";
+        std::cout << "Floorplan: " << plan.regions.size() << " regions (" << plan.tilesX << "x" << plan.tilesY << "), "
+            << noc::partitionCount(graph, plan) << (plan.grouped ? " region partitions\n" : " partitions\n");
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Native graph generation failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
 /**
  * @brief Запускает внешний процесс и отображает его вывод.
  *
@@ -159,6 +338,188 @@ int runProcess(const std::string& command) {
 #endif
 }
 
+/**
+ * @brief Наибольшее число одновременно работающих программ Quartus при полной компиляции проекта
+ * одним запуском Quartus_compiler: устройства (`--devices`, до `--parallel-devices` сразу),
+ * умноженные на начальные значения фиттера (`--seeds`, до `--parallel-seeds` сразу).
+ *
+ * @param args Аргументы этапа `--quartus`; некорректные значения считаются единицей
+ * (их отвергнет сам Quartus_compiler).
+ */
+unsigned concurrentTools(const std::vector<std::string>& args) {
+    unsigned devices = 1, seeds = 1, parallelDevices = 0, parallelSeeds = 0;
+    for (size_t i = 0; i + 1 < args.size(); ++i) {
+        const std::string& value = args[i + 1];
+        try {
+            if (args[i] == "--devices") devices = static_cast<unsigned>(std::count(value.begin(), value.end(), ',')) + 1;
+            else if (args[i] == "--seeds") seeds = common::parseJobs(value);
+            else if (args[i] == "--parallel-devices") parallelDevices = common::parseJobs(value);
+            else if (args[i] == "--parallel-seeds") parallelSeeds = common::parseJobs(value);
+        }
+        catch (const std::exception&) {
+        }
+    }
+    if (parallelDevices != 0) devices = std::min(devices, parallelDevices);
+    if (parallelSeeds != 0) seeds = std::min(seeds, parallelSeeds);
+    return std::max(1u, devices * seeds);
+}
+
+/**
+ * @brief Компилирует несколько проектов Quartus, чередуя их стадии.
+ *
+ * Для каждого проекта строится цепочка стадий Quartus_compiler `--stage map|fit|asm|sta`
+ * (с `--exploration` — без asm); цепочки выполняет StageScheduler. Ресурсы стадий:
+ * - map, asm, sta — один поток на каждое одновременно компилируемое устройство;
+ * - fit — `--fit-threads` потоков (по умолчанию половина `--cores`) и тяжёлый слот
+ *   (их число задаёт `--max-fits`, по умолчанию 1): фиттер потребляет больше всего памяти;
+ * - fit с `--devices` (D устройств) и `--seeds N` — K = min(D × N, `--max-fits`) одновременных
+ *   фиттеров: K тяжёлых слотов и K × `--fit-threads` потоков. K делится между устройствами
+ *   (`--parallel-devices`) и начальными значениями (`--parallel-seeds`) Quartus_compiler.
+ *
+ * Так синтез следующего проекта идёт, пока фиттер занят предыдущим. Число потоков фиттера
+ * передаётся Quartus_compiler (`--threads`) на стадии map и попадает в настройки проекта.
+ * Остальные аргументы этапа `--quartus` передаются Quartus_compiler без изменений.
+ *
+ * Если задан пул лицензионных мест, каждая стадия до допуска планировщиком занимает по месту
+ * на каждую одновременно работающую программу Quartus (фиттер — parallelFits мест, остальные
+ * стадии — по месту на устройство) и освобождает их по завершении. Пока стадия ждёт мест,
+ * её потоки и тяжёлые слоты достаются другим стадиям.
+ *
+ * Если задано отслеживание фронта Парето (`--pareto`), итоги стадии sta пополняют фронт, а перед
+ * стадией fit проект сравнивается с фронтом по оценке после синтеза (см. ParetoTracker):
+ * доминируемый проект по политике только попадает в отчёт (report), компилируется после
+ * остальных (defer) или не компилируется дальше синтеза (skip).
+ *
+ * @param quartusExec Путь к Quartus_compiler.
+ * @param location Расположение проектов.
+ * @param names Имена проектов в порядке приоритета.
+ * @param args Аргументы этапа `--quartus` без `--projects`, имён проектов и параметров пула мест.
+ * @param seats Пул лицензионных мест или nullptr.
+ * @param pareto Фронт Парето серии или nullptr.
+ * @return 0 — все проекты скомпилированы или пропущены как доминируемые, 1 — есть сбои.
+ */
+int runQuartusPipeline(const std::string& quartusExec, const std::string& location,
+                       const std::vector<std::string>& names, const std::vector<std::string>& args,
+                       SeatPool* seats, ParetoTracker* pareto) {
+    SchedulerLimits limits;
+    limits.threads = common::defaultJobs();
+    unsigned fitThreads = 0;
+    std::string forwarded;
+    for (size_t i = 0; i < args.size(); ++i) {
+        const std::string& option = args[i];
+        bool scheduling = option == "--cores" || option == "--max-fits" || option == "--fit-threads";
+        if (!scheduling) {
+            forwarded += " " + option;
+            continue;
+        }
+        if (i + 1 >= args.size()) {
+            std::cerr << "Missing value for " << option << std::endl;
+            return 1;
+        }
+        try {
+            unsigned value = common::parseJobs(args[++i]);
+            if (option == "--cores") limits.threads = value;
+            else if (option == "--max-fits") limits.heavySlots = value;
+            else fitThreads = value;
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid value for " << option << ": " << args[i] << std::endl;
+            return 1;
+        }
+    }
+    if (fitThreads == 0) fitThreads = std::max(1u, limits.threads / 2);
+
+    // В режиме исследования ассемблер не запускается.
+    const bool exploration = std::find(args.begin(), args.end(), "--exploration") != args.end();
+    // Компиляция для нескольких устройств и перебор начальных значений фиттера занимают несколько тяжёлых слотов сразу.
+    unsigned deviceCount = 1, seedCount = 1;
+    auto devices = std::find(args.begin(), args.end(), "--devices");
+    if (devices != args.end() && devices + 1 != args.end())
+        deviceCount = static_cast<unsigned>(std::count((devices + 1)->begin(), (devices + 1)->end(), ',')) + 1;
+    auto seeds = std::find(args.begin(), args.end(), "--seeds");
+    if (seeds != args.end() && seeds + 1 != args.end()) {
+        try {
+            seedCount = common::parseJobs(*(seeds + 1));
+        }
+        catch (const std::exception&) {
+            std::cerr << "Invalid value for --seeds: " << *(seeds + 1) << std::endl;
+            return 1;
+        }
+    }
+    const unsigned parallelFits = std::max(1u, std::min(deviceCount * seedCount, limits.heavySlots));
+    const unsigned parallelDevices = std::min(deviceCount, parallelFits);
+    const unsigned parallelSeeds = std::max(1u, parallelFits / parallelDevices);
+
+    StageScheduler scheduler(limits);
+    for (const std::string& name : names) {
+        uncheckMetadata(location + "/" + name + "_metadata.json", 2);
+        std::vector<StageTask> stages;
+        for (const std::string stage : {"map", "fit", "asm", "sta"}) {
+            if (exploration && stage == "asm") continue;
+            StageTask task;
+            task.stage = stage;
+            if (stage == "fit") task.resources = {fitThreads * parallelFits, parallelFits};
+            else task.resources = {parallelDevices, 0};
+            std::ostringstream ss;
+            ss << quartusExec << " -l " << location << " -n " << name << " --stage " << stage;
+            if (stage == "map") ss << " --threads " << fitThreads;
+            if (deviceCount > 1) ss << " --parallel-devices " << parallelDevices;
+            if (stage == "fit" && seedCount > 1) ss << " --parallel-seeds " << parallelSeeds;
+            ss << forwarded;
+            if (seats) {
+                const unsigned tools = stage == "fit" ? parallelFits : parallelDevices;
+                task.reserve = [seats, holder = name + ": " + stage, tools] {
+                    return std::shared_ptr<void>(seats->acquire(holder, tools));
+                };
+            }
+            task.run = [command = ss.str(), pareto, name, stage] {
+                int code = runProcess(command);
+                if (pareto && code == 0 && stage == "map") pareto->prepare(name);
+                if (pareto && code == 0 && stage == "sta") pareto->addCompiled(name);
+                return code;
+            };
+            if (pareto && stage == "fit") {
+                task.admit = [pareto, name] {
+                    std::vector<ParetoDominance> dominance = pareto->dominance(name);
+                    if (dominance.empty()) return StageAdmission::Run;
+                    const ParetoPolicy policy = pareto->options().policy;
+                    const char* decision = policy == ParetoPolicy::Skip ? "skipped" : policy == ParetoPolicy::Defer ? "deferred" : "dominated";
+                    pareto->record(decision, dominance);
+                    std::cout << "[pareto] " << name << ": " << decision << ", dominated by "
+                              << dominance.front().dominator.project << " on " << dominance.front().estimate.device << std::endl;
+                    if (policy == ParetoPolicy::Skip) return StageAdmission::Skip;
+                    return policy == ParetoPolicy::Defer ? StageAdmission::Defer : StageAdmission::Run;
+                };
+            }
+            stages.push_back(std::move(task));
+        }
+        scheduler.addPipeline(name, std::move(stages));
+    }
+
+    auto started = std::chrono::steady_clock::now();
+    std::vector<StageOutcome> outcomes = scheduler.run();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    double serial = 0;
+    std::map<std::string, std::string> failed, skipped;
+    for (const StageOutcome& outcome : outcomes) {
+        serial += outcome.endSeconds - outcome.startSeconds;
+        std::map<std::string, std::string>& problems = outcome.skipped ? skipped : failed;
+        if (outcome.exitCode != 0 && !problems.count(outcome.pipeline)) problems[outcome.pipeline] = outcome.stage;
+    }
+    for (const std::string& name : names) {
+        if (failed.count(name)) std::cout << name << ": failed at " << failed[name] << "\n";
+        else if (skipped.count(name)) std::cout << name << ": skipped at " << skipped[name] << " (dominated)\n";
+        else std::cout << name << ": compiled\n";
+    }
+    if (pareto) pareto->report();
+    std::cout << "Pipeline: " << names.size() << " projects";
+    if (!skipped.empty()) std::cout << " (" << skipped.size() << " skipped)";
+    std::cout << " in " << wall << " s (stage time " << serial << " s, " << limits.threads << " threads, "
+              << limits.heavySlots << " concurrent fits)\n";
+    return failed.empty() ? 0 : 1;
+}
+
 /**
  * @brief Главная функция программы.
  *
@@ -167,9 +528,9 @@ int runProcess(const std::string& command) {
  *
  * Поддерживаемые режимы:
  * - `--project` — управление проектами;
- * - `--graph` — генерация графа и Verilog-файлов;
- * - `--quartus` — компиляция проекта Quartus;
- * - `--database` — запись итогов в базу данных;
+ * - `--graph` — генерация графа и Verilog-файлов (`--native` — встроенной библиотекой Topology);
+ * - `--quartus` — компиляция проекта Quartus (`--projects` — нескольких проектов с чередованием стадий);
+ * - `--database` — запись итогов в базу данных (`--projects` — нескольких проектов за один сеанс);
  * - `--help` — отображение справки.
  *
  * @param argc Количество аргументов командной строки.
@@ -186,6 +547,12 @@ int main(int argc, char* argv[]) {
     bool launch_manager = false, launch_graph = false, launch_quartus = false, launch_db = false;
     std::string project_name, project_location, project_new_name, project_action = "o";
     std::string graph_args, quartus_args, db_args;
+    std::vector<std::string> graph_arg_list; // Аргументы этапа --graph по отдельности (для встроенного генератора).
+    std::vector<std::string> quartus_arg_list; // Аргументы этапа --quartus, кроме --projects и имён проектов.
+    std::vector<std::string> pipeline_projects; // Проекты из --projects: стадии компиляции чередуются, итоги пишутся в БД одним сеансом.
+    bool native_graph = false;
+    SeatPoolOptions seat_options; // Лицензионные места Quartus (--seat-dir, --seats, --seat-lease).
+    ParetoOptions pareto_options; // Отслеживание фронта Парето серии (--pareto, --pareto-margin).
     std::string key_arg;
 
     try {
@@ -206,6 +573,10 @@ int main(int argc, char* argv[]) {
                         project_action = "r";
                         project_new_name = args[++i];
                     }
+                    else if (next == "--clone") {
+                        project_action = "cl";
+                        project_new_name = args[++i];
+                    }
                     else {
                         i--;
                         project_breaker = true;
@@ -239,8 +610,46 @@ int main(int argc, char* argv[]) {
                     std::cerr << "Invalid argument: " << arg << std::endl;
                     return 1;
                 }
-                if (key_arg == "--graph") graph_args += " " + arg;
-                else if (key_arg == "--quartus") quartus_args += " " + arg;
+                // Расположение и имя проекта общие для всех этапов (см. примеры в описании).
+                if ((arg == "-l" || arg == "--location") && i + 1 < args.size()) {
+                    project_location = args[++i];
+                    continue;
+                }
+                if ((arg == "-n" || arg == "--name") && i + 1 < args.size()) {
+                    project_name = args[++i];
+                    continue;
+                }
+                if (key_arg == "--graph" && arg == "--native") native_graph = true;
+                else if (key_arg == "--graph") {
+                    graph_args += " " + arg;
+                    graph_arg_list.push_back(arg);
+                }
+                else if ((key_arg == "--quartus" || key_arg == "--database") && arg == "--projects") {
+                    while (i + 1 < args.size() && args[i + 1].rfind("-", 0) != 0)
+                        pipeline_projects.push_back(args[++i]);
+                }
+                else if (key_arg == "--quartus" && arg == "--seat-dir" && i + 1 < args.size()) {
+                    seat_options.directory = args[++i];
+                }
+                else if (key_arg == "--quartus" && arg == "--seats" && i + 1 < args.size()) {
+                    seat_options.seats = static_cast<unsigned>(std::stoul(args[++i]));
+                    if (seat_options.seats == 0) throw std::invalid_argument("--seats");
+                }
+                else if (key_arg == "--quartus" && arg == "--seat-lease" && i + 1 < args.size()) {
+                    seat_options.lease = std::chrono::seconds(std::stoul(args[++i]));
+                    if (seat_options.lease.count() < 3) throw std::invalid_argument("--seat-lease");
+                }
+                else if (key_arg == "--quartus" && arg == "--pareto" && i + 1 < args.size()) {
+                    pareto_options.policy = parseParetoPolicy(args[++i]);
+                }
+                else if (key_arg == "--quartus" && arg == "--pareto-margin" && i + 1 < args.size()) {
+                    pareto_options.margin = std::stod(args[++i]);
+                    if (pareto_options.margin < 0 || pareto_options.margin >= 1) throw std::invalid_argument("--pareto-margin");
+                }
+                else if (key_arg == "--quartus") {
+                    quartus_args += " " + arg;
+                    quartus_arg_list.push_back(arg);
+                }
                 else if (key_arg == "--database") db_args += " " + arg;
             }
         }
@@ -264,8 +673,9 @@ int main(int argc, char* argv[]) {
 
     if (launch_manager) {
         std::ostringstream ss;
-        ss << manager_exec << " -l " << project_location << " -n " << project_name
-            << " -" << project_action;
+        ss << manager_exec << " -l " << project_location << " -n " << project_name;
+        if (project_action == "cl") ss << " --clone " << project_new_name;
+        else ss << " -" << project_action;
         if (project_action == "r") ss << " " << project_new_name;
         int res = runProcess(ss.str());
         if (res != 0) {
@@ -273,26 +683,84 @@ int main(int argc, char* argv[]) {
             return 1;
         }
         std::cout << "Project_manager success.\n";
-        if (project_action == "r") project_name = project_new_name;
+        // После переименования или клонирования следующие этапы работают с новым проектом.
+        if (project_action == "r" || project_action == "cl") project_name = project_new_name;
     }
 
-    if (launch_graph) {
-        uncheckMetadata(project_location + "/" + project_name + "_metadata.json", 0);
+    // Архивированный проект распаковывается через Project_manager до запуска любого этапа, работающего с его артефактами.
+    if ((launch_graph || launch_quartus || launch_db) &&
+        fs::exists(project_location + "/" + project_name + "_archive.pack")) {
         std::ostringstream ss;
-        ss << veriloger_exec << " -l " << project_location << " -n " << project_name << graph_args;
-        int res = runProcess(ss.str());
-        if (res != 0) {
-            std::cerr << "Graph_verilog_generator failure.\n";
+        ss << manager_exec << " -l " << project_location << " -n " << project_name << " -o";
+        if (runProcess(ss.str()) != 0) {
+            std::cerr << "Project_manager failed to rehydrate the project.\n";
             return 1;
         }
-        std::cout << "Graph_verilog_generator success.\n";
     }
 
-    if (launch_quartus) {
+    if (launch_graph) {
+        uncheckMetadata(project_location + "/" + project_name + "_metadata.json", 0);
+        if (native_graph) {
+            if (runNativeGraph(project_location, project_name, graph_arg_list) != 0) {
+                std::cerr << "Native graph failure.\n";
+                return 1;
+            }
+            std::cout << "Native graph success.\n";
+        }
+        else {
+            // Внешний генератор пишет только JSON; двоичная копия прошлого графа устарела бы,
+            // а ParetoTracker читает её раньше JSON.
+            std::error_code ec;
+            fs::remove(project_location + "/" + project_name + "_graph_object.bin", ec);
+            std::ostringstream ss;
+            ss << veriloger_exec << " -l " << project_location << " -n " << project_name << graph_args;
+            int res = runProcess(ss.str());
+            if (res != 0) {
+                std::cerr << "Graph_verilog_generator failure.\n";
+                return 1;
+            }
+            std::cout << "Graph_verilog_generator success.\n";
+        }
+    }
+
+    // Без общего каталога блокировок лицензионные места не ограничиваются.
+    std::unique_ptr<SeatPool> seats;
+    if (!seat_options.directory.empty()) seats = std::make_unique<SeatPool>(seat_options);
+
+    // Фронт Парето имеет смысл только для серии проектов (--projects).
+    std::unique_ptr<ParetoTracker> pareto;
+    if (launch_quartus && !pipeline_projects.empty() && pareto_options.policy != ParetoPolicy::Off)
+        pareto = std::make_unique<ParetoTracker>(project_location, pareto_options);
+
+    if (launch_quartus && !pipeline_projects.empty()) {
+        // Проект из -n компилируется первым, за ним — проекты из --projects.
+        std::vector<std::string> names;
+        if (!project_name.empty()) names.push_back(project_name);
+        for (const std::string& name : pipeline_projects)
+            if (std::find(names.begin(), names.end(), name) == names.end()) names.push_back(name);
+        for (const std::string& name : names) {
+            if (!fs::exists(project_location + "/" + name + "_archive.pack")) continue;
+            std::ostringstream ss;
+            ss << manager_exec << " -l " << project_location << " -n " << name << " -o";
+            if (runProcess(ss.str()) != 0) {
+                std::cerr << "Project_manager failed to rehydrate " << name << ".\n";
+                return 1;
+            }
+        }
+        if (runQuartusPipeline(quartus_exec, project_location, names, quartus_arg_list, seats.get(), pareto.get()) != 0) {
+            std::cerr << "Quartus_compiler failure.\n";
+            return 1;
+        }
+        std::cout << "Quartus_compiler success.\n";
+    }
+    else if (launch_quartus) {
         uncheckMetadata(project_location + "/" + project_name + "_metadata.json", 2);
         std::ostringstream ss;
-        ss << quartus_exec << " -l " << project_location << " -n " << project_name;
+        ss << quartus_exec << " -l " << project_location << " -n " << project_name << quartus_args;
+        std::unique_ptr<SeatLease> lease;
+        if (seats) lease = seats->acquire(project_name + ": compile", concurrentTools(quartus_arg_list));
         int res = runProcess(ss.str());
+        lease.reset();
         if (res != 0) {
             std::cerr << "Quartus_compiler failure.\n";
             return 1;
@@ -301,9 +769,29 @@ int main(int argc, char* argv[]) {
     }
 
     if (launch_db) {
-        uncheckMetadata(project_location + "/" + project_name + "_metadata.json", 3);
+        // Итоги всех проектов из --projects записываются одним запуском Database_writer через общий пул соединений.
+        std::vector<std::string> names;
+        if (!project_name.empty()) names.push_back(project_name);
+        for (const std::string& name : pipeline_projects)
+            if (std::find(names.begin(), names.end(), name) == names.end()) names.push_back(name);
+        // Проекты, пропущенные как доминируемые, не скомпилированы, и их итогов нет.
+        if (pareto) {
+            for (const std::string& name : pareto->skippedProjects())
+                names.erase(std::remove(names.begin(), names.end(), name), names.end());
+            if (names.empty()) {
+                std::cout << "Database_writer skipped: every project was dominated.\n";
+                return 0;
+            }
+        }
         std::ostringstream ss;
-        ss << db_exec << " -l " << project_location << " -n " << project_name << db_args;
+        ss << db_exec << " -l " << project_location;
+        if (names.size() == 1) ss << " -n " << names.front();
+        else ss << " --projects";
+        for (const std::string& name : names) {
+            uncheckMetadata(project_location + "/" + name + "_metadata.json", 3);
+            if (names.size() > 1) ss << " " << name;
+        }
+        ss << db_args;
         int res = runProcess(ss.str());
         if (res != 0) {
             std::cerr << "Database_writer failure.\n";
@@ -0,0 +1,314 @@
+#include "ParetoFront.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+
+#include "nlohmann/json.hpp"
+#include "Topology.hpp"
+#include "GraphBinary.hpp"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+/// @brief Число маршрутизаторов, от которых считаются расстояния: для оценки задержки крупной сети
+/// достаточно равномерной выборки источников.
+constexpr uint32_t hopSources = 64;
+
+/**
+ * @brief Среднее число переходов между узлами с локальными портами (поиск в ширину от выборки источников).
+ *
+ * У fat-tree локальные порты есть только у листьев (уровень 0), у остальных топологий — у всех узлов.
+ */
+double averageHops(std::span<const uint64_t> offsets, std::span<const uint32_t> targets,
+                   std::span<const int32_t> level, bool leavesOnly) {
+    const uint32_t count = static_cast<uint32_t>(offsets.size() - 1);
+    std::vector<uint32_t> endpoints;
+    for (uint32_t node = 0; node < count; ++node)
+        if (!leavesOnly || level[node] == 0) endpoints.push_back(node);
+    if (endpoints.size() < 2) return 0;
+
+    const size_t step = std::max<size_t>(1, endpoints.size() / hopSources);
+    std::vector<uint32_t> distance(count), queue(count);
+    double total = 0;
+    uint64_t pairs = 0;
+    for (size_t s = 0; s < endpoints.size(); s += step) {
+        std::fill(distance.begin(), distance.end(), std::numeric_limits<uint32_t>::max());
+        size_t head = 0, tail = 0;
+        distance[endpoints[s]] = 0;
+        queue[tail++] = endpoints[s];
+        while (head < tail) {
+            uint32_t node = queue[head++];
+            for (uint64_t e = offsets[node]; e < offsets[node + 1]; ++e) {
+                uint32_t next = targets[e];
+                if (distance[next] != std::numeric_limits<uint32_t>::max()) continue;
+                distance[next] = distance[node] + 1;
+                queue[tail++] = next;
+            }
+        }
+        for (uint32_t node : endpoints) {
+            if (node == endpoints[s] || distance[node] == std::numeric_limits<uint32_t>::max()) continue;
+            total += distance[node];
+            ++pairs;
+        }
+    }
+    return pairs == 0 ? 0 : total / static_cast<double>(pairs);
+}
+
+/**
+ * @brief a лучше b: не хуже по всем целям (по площади и Fmax — с запасом margin) и строго лучше хотя бы по одной.
+ */
+bool dominates(const ParetoPoint& a, const ParetoPoint& b, double margin) {
+    if (a.device != b.device) return false;
+    bool noWorse = a.alms <= b.alms * (1 - margin) && a.fmaxMhz >= b.fmaxMhz * (1 + margin) && a.hops <= b.hops;
+    bool better = a.alms < b.alms || a.fmaxMhz > b.fmaxMhz || a.hops < b.hops;
+    return noWorse && better;
+}
+
+json pointJson(const ParetoPoint& point) {
+    json value = {{"project", point.project}, {"device", point.device}, {"alms", point.alms},
+                  {"hops", point.hops}, {"routers", point.routers}};
+    value["fmaxMhz"] = std::isinf(point.fmaxMhz) ? json() : json(point.fmaxMhz);
+    return value;
+}
+
+std::string describe(const ParetoPoint& point, bool estimate) {
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(0) << point.alms << " ALMs, " << std::setprecision(2);
+    if (std::isinf(point.fmaxMhz)) text << "Fmax unknown";
+    else text << (estimate ? "~" : "") << point.fmaxMhz << " MHz";
+    text << ", " << point.hops << " hops";
+    return text.str();
+}
+
+/**
+ * @brief Итоги или оценки по устройствам из раздела quartusMetadata; устройства без нужных данных пропускаются.
+ */
+std::vector<ParetoPoint> devicePoints(const json& quartus, bool estimate) {
+    std::vector<const json*> entries;
+    if (quartus.contains("devices") && !quartus["devices"].empty())
+        for (const json& device : quartus["devices"]) entries.push_back(&device);
+    else
+        entries.push_back(&quartus);
+
+    std::vector<ParetoPoint> points;
+    for (const json* entry : entries) {
+        ParetoPoint point;
+        point.device = entry->value("deviceName", "");
+        if (estimate) {
+            point.alms = static_cast<double>(entry->value("estimatedAlms", 0LL));
+            if (point.alms <= 0) return {};
+            points.push_back(point);
+            continue;
+        }
+        if (!entry->value("quartusCompiled", false) || !entry->contains("clocks") || (*entry)["clocks"].empty()) continue;
+        point.alms = static_cast<double>(entry->value("alms", 0LL));
+        point.fmaxMhz = std::numeric_limits<double>::infinity();
+        for (const json& clock : (*entry)["clocks"])
+            point.fmaxMhz = std::min(point.fmaxMhz, clock.value("fmaxMhz", 0.0));
+        points.push_back(point);
+    }
+    return points;
+}
+
+} // namespace
+
+ParetoPolicy parseParetoPolicy(const std::string& text) {
+    if (text == "off") return ParetoPolicy::Off;
+    if (text == "report") return ParetoPolicy::Report;
+    if (text == "defer") return ParetoPolicy::Defer;
+    if (text == "skip") return ParetoPolicy::Skip;
+    throw std::invalid_argument("unknown Pareto policy " + text + " (expected off, report, defer or skip)");
+}
+
+const char* paretoPolicyName(ParetoPolicy policy) {
+    switch (policy) {
+    case ParetoPolicy::Off: return "off";
+    case ParetoPolicy::Report: return "report";
+    case ParetoPolicy::Defer: return "defer";
+    case ParetoPolicy::Skip: return "skip";
+    }
+    return "off";
+}
+
+ParetoTracker::ParetoTracker(std::string location, ParetoOptions options)
+    : location_(std::move(location)), options_(options) {}
+
+ParetoTracker::Shape ParetoTracker::shape(const std::string& project) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = shapes_.find(project);
+        if (found != shapes_.end()) return found->second;
+    }
+    Shape result;
+    try {
+        // Двоичный граф строит Broker --native; без него граф восстанавливается по параметрам из метаданных.
+        std::string binary = location_ + "/" + project + "_graph_object.bin";
+        if (fs::exists(binary)) {
+            noc::GraphView view = noc::GraphView::open(binary);
+            result.routers = view.nodeCount();
+            result.hops = averageHops(view.offsets(), view.targets(), view.y(), view.params().kind == noc::TopologyKind::FatTree);
+        }
+        else {
+            json metadata;
+            std::ifstream(location_ + "/" + project + "_metadata.json") >> metadata;
+            noc::Graph graph = noc::buildTopology(noc::TopologyParams::parse(metadata["graphVerilogMetadata"].value("params", "")));
+            result.routers = graph.nodeCount();
+            result.hops = averageHops(graph.offsets, graph.targets, graph.nodes.y, graph.params.kind == noc::TopologyKind::FatTree);
+        }
+        result.known = result.routers != 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[pareto] " << project << ": failed to estimate latency: " << e.what() << std::endl;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    shapes_[project] = result;
+    return result;
+}
+
+void ParetoTracker::addCompiled(const std::string& project) {
+    Shape projectShape = shape(project);
+    if (!projectShape.known) return;
+    std::vector<ParetoPoint> points;
+    try {
+        json metadata;
+        std::ifstream(location_ + "/" + project + "_metadata.json") >> metadata;
+        points = devicePoints(metadata["quartusMetadata"], false);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[pareto] " << project << ": failed to read compile results: " << e.what() << std::endl;
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    compiled_.erase(std::remove_if(compiled_.begin(), compiled_.end(),
+                                   [&](const ParetoPoint& point) { return point.project == project; }),
+                    compiled_.end());
+    for (ParetoPoint& point : points) {
+        point.project = project;
+        point.hops = projectShape.hops;
+        point.routers = projectShape.routers;
+        compiled_.push_back(std::move(point));
+    }
+}
+
+double ParetoTracker::estimateFmax(const std::string& device, uint32_t routers) const {
+    // Метод наименьших квадратов: Fmax ≈ a + b · число маршрутизаторов.
+    double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+    uint32_t minRouters = std::numeric_limits<uint32_t>::max(), maxRouters = 0;
+    for (const ParetoPoint& point : compiled_) {
+        if (point.device != device) continue;
+        double x = point.routers;
+        n += 1;
+        sx += x;
+        sy += point.fmaxMhz;
+        sxx += x * x;
+        sxy += x * point.fmaxMhz;
+        minRouters = std::min(minRouters, point.routers);
+        maxRouters = std::max(maxRouters, point.routers);
+    }
+    // Вне диапазона скомпилированных размеров прямая не проверена: оценки нет, и проект не отсекается.
+    if (n == 0 || routers < minRouters || routers > maxRouters) return std::numeric_limits<double>::infinity();
+    if (minRouters == maxRouters) return sy / n;
+    double slope = (n * sxy - sx * sy) / (n * sxx - sx * sx);
+    return (sy - slope * sx) / n + slope * routers;
+}
+
+std::vector<ParetoDominance> ParetoTracker::dominance(const std::string& project) {
+    Shape projectShape = shape(project);
+    if (!projectShape.known) return {};
+    std::vector<ParetoPoint> estimates;
+    try {
+        json metadata;
+        std::ifstream(location_ + "/" + project + "_metadata.json") >> metadata;
+        estimates = devicePoints(metadata["quartusMetadata"], true);
+    }
+    catch (const std::exception&) {
+        return {};
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ParetoDominance> result;
+    for (ParetoPoint& estimate : estimates) {
+        estimate.project = project;
+        estimate.hops = projectShape.hops;
+        estimate.routers = projectShape.routers;
+        estimate.fmaxMhz = estimateFmax(estimate.device, estimate.routers);
+        const ParetoPoint* dominator = nullptr;
+        for (const ParetoPoint& point : compiled_)
+            if (dominates(point, estimate, options_.margin) && (!dominator || point.alms < dominator->alms))
+                dominator = &point;
+        if (!dominator) return {};
+        result.push_back({estimate, *dominator});
+    }
+    return result;
+}
+
+void ParetoTracker::record(const std::string& decision, const std::vector<ParetoDominance>& dominance) {
+    if (dominance.empty()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    decisions_[dominance.front().estimate.project] = {decision, dominance};
+}
+
+std::vector<std::string> ParetoTracker::skippedProjects() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> projects;
+    for (const auto& [project, decision] : decisions_)
+        if (decision.first == "skipped") projects.push_back(project);
+    return projects;
+}
+
+std::vector<ParetoPoint> ParetoTracker::frontier() const {
+    std::vector<ParetoPoint> result;
+    for (const ParetoPoint& point : compiled_) {
+        bool dominated = std::any_of(compiled_.begin(), compiled_.end(),
+                                     [&](const ParetoPoint& other) { return dominates(other, point, 0); });
+        if (!dominated) result.push_back(point);
+    }
+    std::sort(result.begin(), result.end(), [](const ParetoPoint& a, const ParetoPoint& b) {
+        return a.device != b.device ? a.device < b.device : a.alms < b.alms;
+    });
+    return result;
+}
+
+void ParetoTracker::report() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json document = {{"policy", paretoPolicyName(options_.policy)}, {"margin", options_.margin},
+                     {"frontier", json::array()}, {"dominated", json::array()}};
+    for (const ParetoPoint& point : frontier()) {
+        std::cout << "[pareto] frontier " << point.device << ": " << point.project << " (" << describe(point, false) << ")\n";
+        document["frontier"].push_back(pointJson(point));
+    }
+    for (const auto& [project, decision] : decisions_) {
+        const ParetoDominance& first = decision.second.front();
+        std::cout << "[pareto] " << project << ": " << decision.first << ", estimate on " << first.estimate.device << " ("
+                  << describe(first.estimate, true) << ") dominated by " << first.dominator.project << " ("
+                  << describe(first.dominator, false) << ")\n";
+        json devices = json::array();
+        for (const ParetoDominance& entry : decision.second)
+            devices.push_back({{"estimate", pointJson(entry.estimate)}, {"dominatedBy", pointJson(entry.dominator)}});
+        document["dominated"].push_back({{"project", project}, {"decision", decision.first}, {"devices", devices}});
+    }
+
+    std::string path = location_ + "/pareto_report.json";
+    try {
+        {
+            std::ofstream out(path + ".tmp", std::ios::trunc);
+            out << std::setw(4) << document;
+            out.close();
+            if (!out) throw std::runtime_error("Failed to write " + path);
+        }
+        fs::rename(path + ".tmp", path);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "[pareto] " << e.what() << std::endl;
+    }
+}
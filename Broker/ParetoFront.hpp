@@ -0,0 +1,135 @@
+#pragma once
+/**
+ * @file ParetoFront.hpp
+ * @brief Отслеживание фронта Парето по площади, Fmax и задержке при компиляции серии проектов.
+ *
+ * Из серии (`Broker --quartus --projects ...`) интересны только проекты на фронте Парето:
+ * - площадь — ALM (меньше — лучше);
+ * - Fmax худшего тактового сигнала (больше — лучше);
+ * - задержка — среднее число переходов между маршрутизаторами без нагрузки (меньше — лучше).
+ *
+ * По мере завершения компиляций ParetoTracker пополняет фронт каждого устройства. Перед запуском
+ * фиттера проект оценивается без размещения:
+ * - площадь — оценка ALM по отчёту синтеза (quartusMetadata.estimatedAlms);
+ * - задержка — точно, по графу топологии;
+ * - Fmax — линейная зависимость Fmax от числа маршрутизаторов по скомпилированным проектам устройства;
+ *   пока её не из чего построить или число маршрутизаторов проекта вне диапазона скомпилированных,
+ *   Fmax считается неограниченным и проект не отбрасывается.
+ *
+ * Оценка считается доминируемой, если скомпилированный проект того же устройства не хуже по всем трём
+ * целям с запасом margin по площади и Fmax (оценки неточны). Проект для нескольких устройств
+ * доминируем, только если доминируема оценка для каждого устройства.
+ */
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Что делать с проектом, оценка которого доминируема.
+ */
+enum class ParetoPolicy {
+    Off,     ///< Фронт не отслеживается.
+    Report,  ///< Только отчёт о фронте и доминируемых оценках.
+    Defer,   ///< Фиттер доминируемого проекта запускается после всех остальных.
+    Skip     ///< Фиттер и следующие стадии доминируемого проекта не запускаются.
+};
+
+/**
+ * @brief Разбирает политику: `off`, `report`, `defer` или `skip`.
+ * @throws std::invalid_argument при неизвестном имени.
+ */
+ParetoPolicy parseParetoPolicy(const std::string& text);
+
+const char* paretoPolicyName(ParetoPolicy policy);
+
+/**
+ * @brief Параметры отслеживания фронта (`--pareto`, `--pareto-margin`).
+ */
+struct ParetoOptions {
+    ParetoPolicy policy = ParetoPolicy::Off;
+    double margin = 0.05;  ///< Доля, на которую скомпилированный проект должен быть лучше оценки по площади и Fmax.
+};
+
+/**
+ * @brief Точка пространства целей: итог компиляции или оценка проекта для устройства.
+ */
+struct ParetoPoint {
+    std::string project;
+    std::string device;
+    double alms = 0;
+    double fmaxMhz = 0;  ///< Бесконечность — оценки Fmax нет.
+    double hops = 0;
+    uint32_t routers = 0;
+};
+
+/**
+ * @brief Доминируемая оценка и скомпилированный проект, который её доминирует.
+ */
+struct ParetoDominance {
+    ParetoPoint estimate;
+    ParetoPoint dominator;
+};
+
+/**
+ * @brief Фронт Парето серии проектов одного расположения. Методы можно вызывать из разных потоков.
+ */
+class ParetoTracker {
+public:
+    ParetoTracker(std::string location, ParetoOptions options);
+
+    const ParetoOptions& options() const { return options_; }
+
+    /**
+     * @brief Заранее вычисляет задержку проекта по графу, чтобы dominance() не строил граф
+     * под блокировкой планировщика.
+     */
+    void prepare(const std::string& project) { shape(project); }
+
+    /**
+     * @brief Добавляет итоги скомпилированного проекта из его метаданных (все устройства).
+     */
+    void addCompiled(const std::string& project);
+
+    /**
+     * @brief Оценивает проект после синтеза.
+     * @return Доминирующие точки по каждому устройству или пустой вектор, если проект
+     * не доминируем или его не удалось оценить.
+     */
+    std::vector<ParetoDominance> dominance(const std::string& project);
+
+    /**
+     * @brief Запоминает решение по доминируемому проекту для отчёта (`skipped` или `deferred`).
+     */
+    void record(const std::string& decision, const std::vector<ParetoDominance>& dominance);
+
+    /// @brief Проекты, фиттер которых не запускался.
+    std::vector<std::string> skippedProjects() const;
+
+    /**
+     * @brief Выводит фронт по устройствам и решения по доминируемым проектам и сохраняет
+     * их в `<расположение>/pareto_report.json`.
+     */
+    void report() const;
+
+private:
+    /// @brief Задержка и число маршрутизаторов проекта по графу (не зависят от компиляции).
+    struct Shape {
+        double hops = 0;
+        uint32_t routers = 0;
+        bool known = false;
+    };
+
+    Shape shape(const std::string& project);
+    double estimateFmax(const std::string& device, uint32_t routers) const;
+    std::vector<ParetoPoint> frontier() const;
+
+    std::string location_;
+    ParetoOptions options_;
+    mutable std::mutex mutex_;
+    std::map<std::string, Shape> shapes_;
+    std::vector<ParetoPoint> compiled_;
+    std::map<std::string, std::pair<std::string, std::vector<ParetoDominance>>> decisions_;
+};
@@ -0,0 +1,223 @@
+#include "SeatPool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/**
+ * @brief Уникальный в пределах всех узлов идентификатор участника: узел, процесс, номер запроса.
+ */
+std::string uniqueToken() {
+    static std::atomic<unsigned> counter{0};
+    std::string host;
+    unsigned long pid = 0;
+#ifdef _WIN32
+    const char* name = std::getenv("COMPUTERNAME");
+    host = name ? name : "host";
+    pid = GetCurrentProcessId();
+#else
+    char name[256] = {};
+    host = gethostname(name, sizeof(name) - 1) == 0 ? name : "host";
+    pid = static_cast<unsigned long>(getpid());
+#endif
+    std::replace(host.begin(), host.end(), '-', '_');
+    return host + "-" + std::to_string(pid) + "-" + std::to_string(counter++);
+}
+
+/**
+ * @brief Обновляет время изменения файла; ошибки (файл уже удалён) игнорируются.
+ */
+void touch(const fs::path& path) {
+    std::error_code ec;
+    fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+}
+
+void writeHolder(const fs::path& path, const std::string& holder) {
+    std::ofstream out(path, std::ios::trunc);
+    out << holder << "\n";
+}
+
+/**
+ * @brief Файл аренды места: первая строка — маркер владельца, вторая — описание для журнала.
+ */
+void writeLease(const fs::path& path, const std::string& token, const std::string& holder) {
+    std::ofstream out(path, std::ios::trunc);
+    out << token << "\n" << holder << "\n";
+}
+
+/**
+ * @brief Проверяет, что место занято владельцем с маркером token.
+ */
+bool ownsSeat(const fs::path& seat, const std::string& token) {
+    std::ifstream in(seat / "lease");
+    std::string line;
+    return std::getline(in, line) && line == token;
+}
+
+/**
+ * @brief Число мест запроса по имени билета (суффикс ".<число>"); у билетов без суффикса — одно место.
+ */
+unsigned ticketSeats(const std::string& ticket) {
+    size_t dot = ticket.rfind('.');
+    if (dot == std::string::npos || dot + 1 == ticket.size() || ticket.size() - dot > 6) return 1;
+    unsigned seats = 0;
+    for (size_t i = dot + 1; i < ticket.size(); ++i) {
+        if (ticket[i] < '0' || ticket[i] > '9') return 1;
+        seats = seats * 10 + static_cast<unsigned>(ticket[i] - '0');
+    }
+    return std::max(1u, seats);
+}
+
+} // namespace
+
+SeatLease::SeatLease(std::vector<std::string> seatDirectories, std::string token, std::chrono::seconds lease)
+    : seatDirectories_(std::move(seatDirectories)), token_(std::move(token)) {
+    heartbeat_ = std::thread([this, period = std::max<std::chrono::milliseconds>(lease / 3, std::chrono::milliseconds(100))] {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_.wait_for(lock, period, [this] { return stopping_; }))
+            for (const std::string& seat : seatDirectories_) touch(fs::path(seat) / "lease");
+    });
+}
+
+SeatLease::~SeatLease() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stop_.notify_one();
+    heartbeat_.join();
+    // Место могли признать брошенным (процесс был приостановлен дольше срока аренды) и занять заново:
+    // удаляется только место со своим маркером. Как и при освобождении брошенного места, каталог сначала
+    // переименовывается, а маркер проверяется ещё раз — место могли занять между проверкой и переименованием.
+    for (const std::string& seat : seatDirectories_) {
+        const fs::path path(seat);
+        if (!ownsSeat(path, token_)) {
+            std::cout << "[seats] " << path.filename().string() << " was reclaimed by another holder; not released" << std::endl;
+            continue;
+        }
+        const fs::path released = path.parent_path() / ("released_" + path.filename().string() + "_" + token_);
+        std::error_code ec;
+        fs::rename(path, released, ec);
+        if (ec) continue;
+        if (ownsSeat(released, token_)) fs::remove_all(released, ec);
+        else fs::rename(released, path, ec);
+    }
+}
+
+SeatPool::SeatPool(SeatPoolOptions options) : options_(std::move(options)) {}
+
+unsigned SeatPool::sweepExpired() {
+    const fs::path root = options_.directory;
+    const auto now = fs::file_time_type::clock::now();
+    auto expired = [&](const fs::path& path) {
+        std::error_code ec;
+        auto time = fs::last_write_time(path, ec);
+        return !ec && now - time > options_.lease;
+    };
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(root / "queue", ec))
+        if (expired(entry.path())) fs::remove(entry.path(), ec);
+
+    unsigned held = 0;
+    for (const auto& entry : fs::directory_iterator(root / "seats", ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.rfind("seat_", 0) != 0) continue;
+        // Файл аренды появляется сразу после каталога места; до этого возраст места — возраст каталога.
+        fs::path lease = entry.path() / "lease";
+        if (!expired(fs::exists(lease, ec) ? lease : entry.path())) {
+            held++;
+            continue;
+        }
+        // Брошенное место сначала переименовывается: переименование удаётся только одному участнику.
+        fs::path stale = root / "seats" / ("stale_" + name + "_" + uniqueToken());
+        std::error_code renameError;
+        fs::rename(entry.path(), stale, renameError);
+        if (!renameError) {
+            std::cout << "[seats] reclaimed expired " << name << std::endl;
+            fs::remove_all(stale, ec);
+        }
+    }
+    return held;
+}
+
+std::unique_ptr<SeatLease> SeatPool::acquire(const std::string& holder, unsigned count) {
+    count = std::clamp(count, 1u, options_.seats);
+    const fs::path root = options_.directory;
+    fs::create_directories(root / "queue");
+    fs::create_directories(root / "seats");
+
+    // Время постановки в очередь с ведущими нулями: порядок имён билетов совпадает с порядком запросов.
+    auto queued = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::ostringstream name;
+    const std::string token = uniqueToken();
+    name << std::setw(20) << std::setfill('0') << queued << "-" << token << "." << count;
+    const std::string ticket = name.str();
+    const fs::path ticketPath = root / "queue" / ticket;
+    writeHolder(ticketPath, holder);
+
+    const auto poll = std::min<std::chrono::milliseconds>(std::chrono::seconds(1), options_.lease / 3);
+    const auto started = std::chrono::steady_clock::now();
+    size_t announced = SIZE_MAX;
+    std::vector<std::string> taken; // Места, занятые до того, как освободились все нужные.
+    for (;;) {
+        // Билет, удалённый как брошенный (например, после приостановки процесса), восстанавливается на прежнем месте очереди.
+        if (fs::exists(ticketPath)) touch(ticketPath);
+        else writeHolder(ticketPath, holder);
+        for (const std::string& seat : taken) touch(fs::path(seat) / "lease");
+
+        unsigned held = sweepExpired();
+        std::vector<std::string> tickets;
+        std::error_code ec;
+        for (const auto& entry : fs::directory_iterator(root / "queue", ec))
+            tickets.push_back(entry.path().filename().string());
+        std::sort(tickets.begin(), tickets.end());
+        size_t position = std::lower_bound(tickets.begin(), tickets.end(), ticket) - tickets.begin();
+        unsigned ahead = 0; // Места, нужные запросам перед этим билетом.
+        for (size_t i = 0; i < position; ++i) ahead += ticketSeats(tickets[i]);
+
+        const unsigned needed = count - static_cast<unsigned>(taken.size());
+        if (held < options_.seats && ahead + needed <= options_.seats - held) {
+            for (unsigned k = 0; k < options_.seats && taken.size() < count; ++k) {
+                fs::path seat = root / "seats" / ("seat_" + std::to_string(k));
+                if (!fs::create_directory(seat, ec) || ec) continue;
+                writeLease(seat / "lease", token, holder);
+                taken.push_back(seat.string());
+            }
+            if (taken.size() == count) {
+                fs::remove(ticketPath, ec);
+                if (announced != SIZE_MAX) {
+                    double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+                    std::cout << "[seats] " << holder << ": " << count << (count == 1 ? " seat" : " seats")
+                              << " acquired after " << waited << " s" << std::endl;
+                }
+                return std::make_unique<SeatLease>(std::move(taken), token, options_.lease);
+            }
+        }
+        if (position != announced) {
+            std::cout << "[seats] " << holder << ": waiting for " << (count == 1 ? "a license seat" : std::to_string(count) + " license seats")
+                      << " (queue position " << position + 1 << ", " << held << "/" << options_.seats << " seats in use)" << std::endl;
+            announced = position;
+        }
+        std::this_thread::sleep_for(poll);
+    }
+}
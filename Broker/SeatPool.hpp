@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * @file SeatPool.hpp
+ * @brief Семафор лицензионных мест Quartus на общем каталоге блокировок.
+ *
+ * Число одновременно работающих программ Quartus ограничено числом лицензионных мест.
+ * Несколько Broker, в том числе на разных узлах, согласуют занятие мест через общий
+ * каталог (например, на сетевом диске):
+ * - `queue/<билет>` — очередь ожидающих; имя билета начинается с времени постановки
+ *   в очередь, поэтому лексикографический порядок билетов — порядок FIFO;
+ * - `seats/seat_<k>/lease` — занятое место k и маркер его владельца. Каталог места создаётся
+ *   атомарно (create_directory), поэтому одно место не могут занять двое.
+ *
+ * Запрос может занимать несколько мест сразу (по одному на каждую одновременно работающую
+ * программу Quartus). Места занимает только тот из первых ожидающих, кому вместе со всеми
+ * запросами перед ним хватает свободных мест, поэтому поздний запрос не обгоняет ранний,
+ * а два запроса не держат по части мест, ожидая остальные. Число мест запроса записано
+ * в имени билета. Владелец места и ожидающие периодически обновляют
+ * время изменения своих файлов; место или билет без обновления дольше срока аренды
+ * считается брошенным (Broker аварийно завершён) и удаляется любым участником.
+ *
+ * Для проверки без кластера достаточно локального каталога и нескольких процессов Broker.
+ * Часы узлов, использующих один каталог, должны быть синхронизированы с точностью
+ * много меньше срока аренды.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Параметры пула мест.
+ */
+struct SeatPoolOptions {
+    std::string directory;                 ///< Общий каталог блокировок; пустой — места не ограничены.
+    unsigned seats = 1;                    ///< Число лицензионных мест.
+    std::chrono::seconds lease{60};        ///< Срок, после которого место без обновления считается брошенным.
+};
+
+/**
+ * @brief Занятые места одного запроса; освобождаются в деструкторе.
+ *
+ * Пока объект существует, фоновый поток обновляет время изменения файлов аренды.
+ * Деструктор удаляет только места, в файле аренды которых по-прежнему записан маркер token.
+ */
+class SeatLease {
+public:
+    SeatLease(std::vector<std::string> seatDirectories, std::string token, std::chrono::seconds lease);
+    ~SeatLease();
+    SeatLease(const SeatLease&) = delete;
+    SeatLease& operator=(const SeatLease&) = delete;
+
+private:
+    std::vector<std::string> seatDirectories_;
+    std::string token_;
+    std::mutex mutex_;
+    std::condition_variable stop_;
+    bool stopping_ = false;
+    std::thread heartbeat_;
+};
+
+/**
+ * @brief Очередь к лицензионным местам.
+ */
+class SeatPool {
+public:
+    explicit SeatPool(SeatPoolOptions options);
+
+    /**
+     * @brief Ставит запрос в очередь и ждёт, пока освободятся count мест.
+     *
+     * @param holder Описание владельца для журнала и файла аренды (например, "A: fit").
+     * @param count Число мест; больше числа мест пула не запрашивается.
+     * @return Занятые места.
+     * @throws std::filesystem::filesystem_error при ошибке доступа к каталогу.
+     */
+    std::unique_ptr<SeatLease> acquire(const std::string& holder, unsigned count = 1);
+
+private:
+    /**
+     * @brief Удаляет брошенные билеты и места, возвращает число занятых мест.
+     */
+    unsigned sweepExpired();
+
+    SeatPoolOptions options_;
+};
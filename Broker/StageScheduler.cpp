@@ -0,0 +1,149 @@
+#include "StageScheduler.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+
+StageScheduler::StageScheduler(SchedulerLimits limits) : limits_(limits) {}
+
+void StageScheduler::addPipeline(const std::string& name, std::vector<StageTask> stages) {
+    pipelines_.push_back({name, std::move(stages)});
+}
+
+std::vector<StageOutcome> StageScheduler::run() {
+    std::mutex mutex;
+    std::condition_variable finished;
+    // Потоки стадий и ожиданий reserve; завершившиеся присоединяются на каждом проходе, а не в конце работы.
+    std::map<size_t, std::thread> workers;
+    std::vector<size_t> exited;
+    size_t nextWorker = 0;
+    std::vector<StageOutcome> outcomes;
+    unsigned usedThreads = 0, usedHeavy = 0, running = 0, reserving = 0;
+    const auto start = std::chrono::steady_clock::now();
+    auto elapsed = [&] { return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count(); };
+
+    std::unique_lock<std::mutex> lock(mutex);
+    // Присоединяет завершившиеся потоки; блокировка на это время снимается, чтобы не ждать поток,
+    // который её ещё удерживает.
+    auto reap = [&] {
+        std::vector<std::thread> done;
+        for (size_t id : exited) {
+            done.push_back(std::move(workers.at(id)));
+            workers.erase(id);
+        }
+        exited.clear();
+        if (done.empty()) return;
+        lock.unlock();
+        for (std::thread& worker : done) worker.join();
+        lock.lock();
+    };
+    auto active = [](const Pipeline& pipeline) {
+        return !pipeline.failed && !pipeline.skipped && pipeline.next != pipeline.stages.size();
+    };
+    for (;;) {
+        reap();
+        bool pending = false;
+        // Есть неотложенная работа: отложенные стадии ждут.
+        bool urgent = false;
+        for (const Pipeline& pipeline : pipelines_)
+            if (active(pipeline) && !pipeline.deferred) urgent = true;
+        for (Pipeline& pipeline : pipelines_) {
+            if (pipeline.running || !active(pipeline)) continue;
+            pending = true;
+            StageTask& task = pipeline.stages[pipeline.next];
+            const bool waiting = pipeline.deferred && pipeline.next == pipeline.deferredStage;
+            if (waiting && urgent) continue;
+            if (task.reserve && !pipeline.reservation) {
+                if (pipeline.reserving) continue;
+                pipeline.reserving = true;
+                reserving++;
+                workers.emplace(nextWorker, std::thread([&, id = nextWorker, pipelinePtr = &pipeline, taskPtr = &task] {
+                    std::shared_ptr<void> reservation;
+                    try {
+                        reservation = taskPtr->reserve();
+                    }
+                    catch (const std::exception& e) {
+                        std::cerr << "[scheduler] " << pipelinePtr->name << ": " << e.what() << std::endl;
+                    }
+                    std::lock_guard<std::mutex> guard(mutex);
+                    pipelinePtr->reserving = false;
+                    reserving--;
+                    if (reservation) pipelinePtr->reservation = std::move(reservation);
+                    else {
+                        outcomes.push_back({pipelinePtr->name, taskPtr->stage, -1, false, elapsed(), elapsed()});
+                        pipelinePtr->next++;
+                        pipelinePtr->failed = true;
+                    }
+                    exited.push_back(id);
+                    finished.notify_one();
+                }));
+                nextWorker++;
+                continue;
+            }
+            const StageResources& need = task.resources;
+            bool fits = usedThreads + need.threads <= limits_.threads && usedHeavy + need.heavy <= limits_.heavySlots;
+            if (!fits && running != 0) continue;
+            if (!waiting && task.admit) {
+                StageAdmission admission = task.admit();
+                if (admission != StageAdmission::Run) pipeline.reservation.reset();
+                if (admission == StageAdmission::Skip) {
+                    pipeline.skipped = true;
+                    std::cout << "[scheduler] " << pipeline.name << ": " << task.stage << " skipped" << std::endl;
+                    continue;
+                }
+                if (admission == StageAdmission::Defer) {
+                    pipeline.deferred = true;
+                    pipeline.deferredStage = pipeline.next;
+                    std::cout << "[scheduler] " << pipeline.name << ": " << task.stage << " deferred" << std::endl;
+                    continue;
+                }
+            }
+
+            pipeline.running = true;
+            usedThreads += need.threads;
+            usedHeavy += need.heavy;
+            running++;
+            std::cout << "[scheduler] " << pipeline.name << ": " << task.stage << " started ("
+                      << need.threads << " threads" << (need.heavy ? ", heavy" : "") << ")" << std::endl;
+            workers.emplace(nextWorker, std::thread([&, id = nextWorker, pipelinePtr = &pipeline, taskPtr = &task, begin = elapsed(),
+                                                     reservation = std::move(pipeline.reservation)]() mutable {
+                int code = -1;
+                try {
+                    code = taskPtr->run();
+                }
+                catch (const std::exception& e) {
+                    std::cerr << "[scheduler] " << pipelinePtr->name << ": " << e.what() << std::endl;
+                }
+                reservation.reset();
+                std::lock_guard<std::mutex> guard(mutex);
+                outcomes.push_back({pipelinePtr->name, taskPtr->stage, code, false, begin, elapsed()});
+                usedThreads -= taskPtr->resources.threads;
+                usedHeavy -= taskPtr->resources.heavy;
+                running--;
+                pipelinePtr->running = false;
+                pipelinePtr->next++;
+                if (code != 0) pipelinePtr->failed = true;
+                std::cout << "[scheduler] " << pipelinePtr->name << ": " << taskPtr->stage
+                          << (code == 0 ? " finished" : " failed") << std::endl;
+                exited.push_back(id);
+                finished.notify_one();
+            }));
+            nextWorker++;
+        }
+        if (!pending && running == 0) break;
+        // Если ничего не запущено, решения Defer и Skip этого прохода меняют состав неотложенной работы:
+        // следующий проход запустит оставшиеся стадии.
+        if (running != 0 || reserving != 0) finished.wait(lock);
+    }
+    lock.unlock();
+    for (auto& [id, worker] : workers) worker.join();
+
+    // Стадии, не запущенные из-за сбоя предыдущей стадии цепочки или пропущенные.
+    for (const Pipeline& pipeline : pipelines_)
+        for (size_t i = pipeline.next; i < pipeline.stages.size(); ++i)
+            outcomes.push_back({pipeline.name, pipeline.stages[i].stage, -1, pipeline.skipped, 0, 0});
+    return outcomes;
+}
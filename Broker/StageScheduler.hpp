@@ -0,0 +1,119 @@
+#pragma once
+/**
+ * @file StageScheduler.hpp
+ * @brief Планировщик допуска для стадий компиляции нескольких проектов.
+ *
+ * Компиляция каждого проекта — цепочка стадий (map → fit → asm → sta), которые выполняются
+ * строго по порядку. Стадии разных проектов независимы, поэтому пока фиттер одного проекта
+ * занимает много потоков и памяти, синтез другого может идти параллельно.
+ *
+ * Каждая стадия помечена требуемыми ресурсами (StageResources): числом потоков и числом
+ * "тяжёлых" слотов — мест для стадий с большим потреблением памяти (фиттер). Стадия
+ * запускается, только если свободных ресурсов хватает; если не запущено ничего, стадия
+ * допускается в любом случае, чтобы слишком крупная задача не ждала вечно.
+ *
+ * Готовые стадии просматриваются в порядке добавления цепочек: более ранний проект
+ * продвигается первым, а стадии следующих проектов занимают оставшиеся ресурсы.
+ *
+ * Стадия может заранее занять внешние ресурсы, например лицензионные места (StageTask::reserve):
+ * ожидание идёт в отдельном потоке до допуска, поэтому потоки и тяжёлые слоты узла не простаивают,
+ * пока стадия ждёт.
+ *
+ * Перед запуском стадия может спросить разрешение (StageTask::admit). Отложенная стадия
+ * ждёт, пока не завершатся все цепочки, которые не откладывались; пропущенная стадия
+ * и следующие стадии её цепочки не запускаются.
+ */
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Ресурсы, которые занимает стадия на время выполнения.
+ */
+struct StageResources {
+    unsigned threads = 1;  ///< Число потоков.
+    unsigned heavy = 0;    ///< Число тяжёлых (по памяти) слотов.
+};
+
+/**
+ * @brief Решение о запуске стадии.
+ */
+enum class StageAdmission {
+    Run,    ///< Запустить, как только хватит ресурсов.
+    Defer,  ///< Запустить после всех цепочек, которые не откладывались.
+    Skip    ///< Не запускать стадию и остаток цепочки.
+};
+
+/**
+ * @brief Стадия цепочки.
+ */
+struct StageTask {
+    std::string stage;            ///< Имя стадии (для журнала).
+    StageResources resources;     ///< Требуемые ресурсы.
+    std::function<int()> run;     ///< Выполняет стадию и возвращает код завершения (0 — успех).
+    /// Вызывается под блокировкой планировщика, когда стадии хватает ресурсов; пустая — всегда Run.
+    /// Решение Defer окончательно: повторно стадия не спрашивает.
+    std::function<StageAdmission()> admit;
+    /// Вызывается вне блокировки планировщика до допуска и может долго ждать; результат удерживается
+    /// до завершения стадии (или до решения Skip/Defer). Пустая — внешние ресурсы не нужны.
+    std::function<std::shared_ptr<void>()> reserve;
+};
+
+/**
+ * @brief Ограничения ресурсов узла.
+ */
+struct SchedulerLimits {
+    unsigned threads = 1;     ///< Всего потоков.
+    unsigned heavySlots = 1;  ///< Всего тяжёлых слотов.
+};
+
+/**
+ * @brief Итог выполнения стадии.
+ */
+struct StageOutcome {
+    std::string pipeline;
+    std::string stage;
+    int exitCode = -1;       ///< -1, если стадия не запускалась из-за сбоя предыдущей или пропуска.
+    bool skipped = false;    ///< Стадия не запускалась по решению StageTask::admit.
+    double startSeconds = 0; ///< Время запуска от начала работы планировщика.
+    double endSeconds = 0;
+};
+
+/**
+ * @brief Планировщик цепочек стадий.
+ */
+class StageScheduler {
+public:
+    explicit StageScheduler(SchedulerLimits limits);
+
+    /**
+     * @brief Добавляет цепочку стадий, выполняемых по порядку.
+     *
+     * После сбоя стадии остальные стадии цепочки не запускаются; другие цепочки продолжают работу.
+     */
+    void addPipeline(const std::string& name, std::vector<StageTask> stages);
+
+    /**
+     * @brief Выполняет все цепочки и возвращает итоги стадий в порядке завершения.
+     */
+    std::vector<StageOutcome> run();
+
+private:
+    struct Pipeline {
+        std::string name;
+        std::vector<StageTask> stages;
+        size_t next = 0;
+        bool running = false;
+        bool failed = false;
+        bool skipped = false;
+        bool deferred = false;    ///< Цепочка отложена и не задерживает отложенные стадии других цепочек.
+        size_t deferredStage = 0; ///< Стадия, которая ждёт завершения неотложенных цепочек.
+        bool reserving = false;   ///< Идёт StageTask::reserve следующей стадии.
+        std::shared_ptr<void> reservation = nullptr; ///< Результат StageTask::reserve следующей стадии.
+    };
+
+    SchedulerLimits limits_;
+    std::vector<Pipeline> pipelines_;
+};
@@ -0,0 +1,83 @@
+#pragma once
+/**
+ * @file FileLock.hpp
+ * @brief Исключительная блокировка между процессами на файле-замке.
+ *
+ * Процессы разных сервисов (Quartus_compiler, Database_writer, Broker, Project_manager)
+ * изменяют один файл метаданных проекта чтением, правкой и записью целиком. Чтобы
+ * одновременные изменения разных разделов не терялись, каждое такое изменение выполняется
+ * под блокировкой metadataLockPath() расположения.
+ */
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#endif
+
+namespace common {
+
+/**
+ * @brief Файл-замок для изменений метаданных проектов расположения, в котором лежит metadataPath.
+ */
+inline std::string metadataLockPath(const std::string& metadataPath) {
+    std::filesystem::path directory = std::filesystem::path(metadataPath).parent_path();
+    return (directory.empty() ? std::filesystem::path("metadata.lock") : directory / "metadata.lock").string();
+}
+
+/**
+ * @brief Исключительная блокировка файла path (создаётся при необходимости); снимается при разрушении.
+ */
+class FileLock {
+public:
+    /**
+     * @throws std::runtime_error если файл не удалось открыть или заблокировать.
+     */
+    explicit FileLock(const std::string& path) {
+#if defined(_WIN32)
+        handle_ = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        OVERLAPPED overlapped{};
+        if (handle_ == INVALID_HANDLE_VALUE || !LockFileEx(handle_, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped)) {
+            if (handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+            throw std::runtime_error("Failed to lock " + path);
+        }
+#else
+        fd_ = open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (fd_ < 0 || flock(fd_, LOCK_EX) != 0) {
+            if (fd_ >= 0) close(fd_);
+            throw std::runtime_error("Failed to lock " + path);
+        }
+#endif
+    }
+    ~FileLock() {
+#if defined(_WIN32)
+        CloseHandle(handle_);
+#else
+        close(fd_);
+#endif
+    }
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+private:
+#if defined(_WIN32)
+    HANDLE handle_ = INVALID_HANDLE_VALUE;
+#else
+    int fd_ = -1;
+#endif
+};
+
+} // namespace common
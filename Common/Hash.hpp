@@ -0,0 +1,122 @@
+#pragma once
+/**
+ * @file Hash.hpp
+ * @brief Быстрое некриптографическое хеширование содержимого файлов (XXH64).
+ *
+ * Используется для адресации по содержимому и для обнаружения изменений.
+ * Хеш не защищает от подбора коллизий, поэтому там, где совпадение влечёт
+ * разделение данных, содержимое дополнительно сравнивается побайтно.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace common {
+
+namespace detail {
+
+constexpr uint64_t prime1 = 11400714785074694791ULL;
+constexpr uint64_t prime2 = 14029467366897019727ULL;
+constexpr uint64_t prime3 = 1609587929392839161ULL;
+constexpr uint64_t prime4 = 9650029242287828579ULL;
+constexpr uint64_t prime5 = 2870177450012600261ULL;
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * prime2;
+    acc = rotl(acc, 31);
+    return acc * prime1;
+}
+
+inline uint64_t mergeRound(uint64_t acc, uint64_t val) {
+    acc ^= round(0, val);
+    return acc * prime1 + prime4;
+}
+
+} // namespace detail
+
+/**
+ * @brief Вычисляет XXH64 от блока данных (порядок байтов little-endian).
+ *
+ * @param data Данные.
+ * @param seed Начальное значение.
+ * @return 64-битный хеш.
+ */
+inline uint64_t hash64(std::string_view data, uint64_t seed = 0) {
+    using namespace detail;
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data());
+    const unsigned char* end = p + data.size();
+    uint64_t h;
+
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + prime1 + prime2;
+        uint64_t v2 = seed + prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - prime1;
+        const unsigned char* limit = end - 32;
+        do {
+            v1 = round(v1, read64(p)); p += 8;
+            v2 = round(v2, read64(p)); p += 8;
+            v3 = round(v3, read64(p)); p += 8;
+            v4 = round(v4, read64(p)); p += 8;
+        } while (p <= limit);
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = mergeRound(h, v1);
+        h = mergeRound(h, v2);
+        h = mergeRound(h, v3);
+        h = mergeRound(h, v4);
+    }
+    else {
+        h = seed + prime5;
+    }
+
+    h += static_cast<uint64_t>(data.size());
+    while (p + 8 <= end) {
+        h ^= round(0, read64(p));
+        h = rotl(h, 27) * prime1 + prime4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= static_cast<uint64_t>(read32(p)) * prime1;
+        h = rotl(h, 23) * prime2 + prime3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= (*p) * prime5;
+        h = rotl(h, 11) * prime1;
+        ++p;
+    }
+    h ^= h >> 33;
+    h *= prime2;
+    h ^= h >> 29;
+    h *= prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+/**
+ * @brief Представляет 64-битный хеш в виде 16 шестнадцатеричных символов.
+ */
+inline std::string toHex(uint64_t value) {
+    char text[17];
+    std::snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(value));
+    return text;
+}
+
+} // namespace common
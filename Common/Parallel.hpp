@@ -0,0 +1,91 @@
+#pragma once
+/**
+ * @file Parallel.hpp
+ * @brief Общие примитивы параллельного выполнения для всех сервисов.
+ *
+ * Пул потоков не хранится между вызовами: каждый вызов parallelFor()
+ * поднимает нужное число потоков, раздаёт индексы через атомарный счётчик
+ * и дожидается завершения всех задач.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace common {
+
+/**
+ * @brief Число рабочих потоков по умолчанию (число логических ядер, не меньше 1).
+ */
+inline unsigned defaultJobs() {
+    unsigned n = std::thread::hardware_concurrency();
+    return n == 0 ? 1 : n;
+}
+
+/**
+ * @brief Разбирает значение опции `-j/--jobs`.
+ *
+ * @param value Строка с числом потоков; `0` означает "по числу ядер".
+ * @return Число потоков (не меньше 1).
+ * @throws std::invalid_argument если строка не является неотрицательным числом.
+ */
+inline unsigned parseJobs(const std::string& value) {
+    size_t pos = 0;
+    long n = std::stol(value, &pos);
+    if (pos != value.size() || n < 0)
+        throw std::invalid_argument("invalid jobs value: " + value);
+    return n == 0 ? defaultJobs() : static_cast<unsigned>(n);
+}
+
+/**
+ * @brief Выполняет `fn(i)` для всех `i` из `[0, count)` на `jobs` потоках.
+ *
+ * Индексы раздаются динамически, поэтому неравные по стоимости задачи
+ * (файлы разного размера) распределяются равномерно. Первое исключение,
+ * выброшенное задачей, прекращает раздачу новых индексов и пробрасывается
+ * вызывающему после остановки всех потоков.
+ *
+ * @param count Количество задач.
+ * @param jobs Максимальное число потоков.
+ * @param fn Функция, принимающая индекс задачи.
+ */
+template <class Fn>
+void parallelFor(size_t count, unsigned jobs, Fn&& fn) {
+    if (count == 0) return;
+    unsigned threads = static_cast<unsigned>(std::min<size_t>(std::max(1u, jobs), count));
+    if (threads == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    auto worker = [&]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            try {
+                fn(i);
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) error = std::current_exception();
+                next.store(count);
+            }
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) pool.emplace_back(worker);
+    worker();
+    for (auto& t : pool) t.join();
+    if (error) std::rethrow_exception(error);
+}
+
+} // namespace common
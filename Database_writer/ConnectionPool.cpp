@@ -0,0 +1,58 @@
+#include "ConnectionPool.hpp"
+using namespace std;
+
+ConnectionPool::Lease::Lease(ConnectionPool& pool, unique_ptr<PgConnection> connection)
+    : pool(&pool), connection(move(connection))
+{
+}
+
+ConnectionPool::Lease::~Lease()
+{
+    if (pool != nullptr)
+        pool->release(move(connection));
+}
+
+ConnectionPool::ConnectionPool(ConnectionSettings settings, unsigned size, function<void(PgConnection&, const ConnectionSettings&)> setup)
+    : connectionSettings(move(settings)), size(max(1u, size)), setup(move(setup))
+{
+}
+
+ConnectionPool::Lease ConnectionPool::acquire()
+{
+    {
+        unique_lock<mutex> lock(access);
+        returned.wait(lock, [this] { return !idle.empty() || open < size; });
+        if (!idle.empty())
+        {
+            unique_ptr<PgConnection> connection = move(idle.back());
+            idle.pop_back();
+            return Lease(*this, move(connection));
+        }
+        open++;
+    }
+    // Соединение устанавливается вне блокировки: остальные потоки тем временем получают свободные соединения.
+    try
+    {
+        auto connection = make_unique<PgConnection>(connectionSettings);
+        if (setup)
+            setup(*connection, connectionSettings);
+        return Lease(*this, move(connection));
+    }
+    catch (...)
+    {
+        release(nullptr);
+        throw;
+    }
+}
+
+void ConnectionPool::release(unique_ptr<PgConnection> connection)
+{
+    {
+        lock_guard<mutex> lock(access);
+        if (connection && !connection->broken())
+            idle.push_back(move(connection));
+        else
+            open--;
+    }
+    returned.notify_one();
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+#include "PgConnection.hpp"
+
+/// <summary>
+/// Пул соединений с одной базой данных. Соединения создаются по мере надобности (не более size),
+/// после использования возвращаются в пул и переиспользуются: рукопожатие и подготовка операторов
+/// выполняются один раз на соединение, а не на проект.
+/// </summary>
+class ConnectionPool
+{
+public:
+    /// <summary>
+    /// Соединение, выданное пулом потоку; при уничтожении возвращается в пул, неисправное — закрывается.
+    /// </summary>
+    class Lease
+    {
+    public:
+        Lease(ConnectionPool& pool, std::unique_ptr<PgConnection> connection);
+        ~Lease();
+        Lease(Lease&& other) noexcept : pool(std::exchange(other.pool, nullptr)), connection(std::move(other.connection)) {}
+        Lease& operator=(Lease&&) = delete;
+        PgConnection& operator*() const { return *connection; }
+        PgConnection* operator->() const { return connection.get(); }
+        /// <summary>
+        /// Закрывает соединение вместо возврата в пул (например, если откат транзакции не удался).
+        /// </summary>
+        void discard() { connection.reset(); }
+
+    private:
+        ConnectionPool* pool;
+        std::unique_ptr<PgConnection> connection;
+    };
+
+    /// <param name="settings">Параметры подключения.</param>
+    /// <param name="size">Наибольшее число одновременно открытых соединений.</param>
+    /// <param name="setup">Вызывается для каждого нового соединения с параметрами подключения пула
+    /// (создание временных таблиц, подготовка операторов).</param>
+    ConnectionPool(ConnectionSettings settings, unsigned size, std::function<void(PgConnection&, const ConnectionSettings&)> setup);
+
+    /// <summary>
+    /// Выдаёт свободное соединение; если все заняты и предел достигнут, ждёт возврата.
+    /// </summary>
+    /// <exception cref="std::runtime_error">Если новое соединение установить не удалось.</exception>
+    Lease acquire();
+
+    const ConnectionSettings& settings() const { return connectionSettings; }
+
+private:
+    void release(std::unique_ptr<PgConnection> connection);
+
+    ConnectionSettings connectionSettings;
+    unsigned size;
+    std::function<void(PgConnection&, const ConnectionSettings&)> setup;
+    std::mutex access;
+    std::condition_variable returned;
+    std::vector<std::unique_ptr<PgConnection>> idle;
+    unsigned open = 0;
+};
@@ -0,0 +1,213 @@
+#include "PgConnection.hpp"
+#include <cstdlib>
+#include <memory>
+#include <libpq-fe.h>
+using namespace std;
+
+namespace {
+
+/// <summary>
+/// Время ожидания подключения и неподтверждённой передачи: зависшее соединение не должно останавливать запись навсегда.
+/// </summary>
+const int socketTimeoutSeconds = 120;
+
+using Result = unique_ptr<PGresult, decltype(&PQclear)>;
+
+/// <summary>
+/// Текст ошибки сервера: уровень, сообщение и код SQLSTATE.
+/// </summary>
+PgError serverError(const PGresult* result)
+{
+    const char* severity = PQresultErrorField(result, PG_DIAG_SEVERITY);
+    const char* message = PQresultErrorField(result, PG_DIAG_MESSAGE_PRIMARY);
+    const char* state = PQresultErrorField(result, PG_DIAG_SQLSTATE);
+    string text = message != nullptr ? string(message) : string(PQresultErrorMessage(result));
+    while (!text.empty() && text.back() == '\n')
+        text.pop_back();
+    return PgError(string(severity != nullptr ? severity : "ERROR") + ": " + text + (state != nullptr ? " (SQLSTATE " + string(state) + ")" : ""),
+                   state != nullptr ? state : "");
+}
+
+/// <summary>
+/// Число строк из тега завершения команды ("INSERT 0 12", "COPY 12", "UPDATE 3").
+/// </summary>
+long long commandCount(PGresult* result)
+{
+    const char* tuples = PQcmdTuples(result);
+    return tuples != nullptr && *tuples != '\0' ? atoll(tuples) : 0;
+}
+
+} // namespace
+
+string ConnectionSettings::key() const
+{
+    return user + "@" + host + ":" + to_string(port) + "/" + database;
+}
+
+PgError::PgError(const string& message, string sqlState) : runtime_error(message), state(move(sqlState)) {}
+
+PgConnection::PgConnection(const ConnectionSettings& settings)
+{
+    const string host = settings.host.empty() ? "localhost" : settings.host;
+    const string port = to_string(settings.port);
+    const string database = settings.database.empty() ? settings.user : settings.database;
+    const string connectTimeout = to_string(socketTimeoutSeconds);
+    const string userTimeout = to_string(socketTimeoutSeconds * 1000);
+    const char* keys[] = {"host", "port", "user", "password", "dbname", "application_name", "client_encoding",
+                          "connect_timeout", "keepalives", "tcp_user_timeout", nullptr};
+    const char* values[] = {host.c_str(), port.c_str(), settings.user.c_str(), settings.password.c_str(), database.c_str(),
+                            "Database_writer", "UTF8", connectTimeout.c_str(), "1", userTimeout.c_str(), nullptr};
+    connection = PQconnectdbParams(keys, values, 0);
+    if (connection == nullptr)
+        throw runtime_error("Cannot allocate a database connection");
+    if (PQstatus(connection) != CONNECTION_OK)
+    {
+        string message = PQerrorMessage(connection);
+        while (!message.empty() && message.back() == '\n')
+            message.pop_back();
+        PQfinish(connection);
+        throw runtime_error("Cannot connect to database server " + host + ":" + port + ": " + message);
+    }
+}
+
+PgConnection::~PgConnection()
+{
+    PQfinish(connection);
+}
+
+bool PgConnection::broken() const
+{
+    return failed || PQstatus(connection) != CONNECTION_OK;
+}
+
+void PgConnection::fail(const string& message)
+{
+    failed = true;
+    string detail = PQerrorMessage(connection);
+    while (!detail.empty() && detail.back() == '\n')
+        detail.pop_back();
+    throw runtime_error(detail.empty() ? message : message + ": " + detail);
+}
+
+pg_result* PgConnection::check(pg_result* result, int expected)
+{
+    if (result == nullptr)
+        fail("Connection to the database server lost");
+    ExecStatusType status = PQresultStatus(result);
+    if (status == expected)
+        return result;
+    Result owner(result, PQclear);
+    if (PQstatus(connection) != CONNECTION_OK)
+        fail("Connection to the database server lost");
+    if (status == PGRES_FATAL_ERROR || status == PGRES_NONFATAL_ERROR)
+        throw serverError(result);
+    if (status == PGRES_COPY_IN)
+    {
+        // COPY FROM STDIN через execute не поддерживается: сервер получает отказ и возвращает ошибку.
+        PQputCopyEnd(connection, "COPY FROM STDIN must use copyIn");
+        while (PGresult* rest = PQgetResult(connection))
+            PQclear(rest);
+        throw PgError("ERROR: COPY FROM STDIN must use copyIn", "");
+    }
+    throw runtime_error(string("Unexpected database server response ") + PQresStatus(status));
+}
+
+vector<PgRow> PgConnection::execute(const string& sql)
+{
+    // PQexec возвращает результат последнего оператора; ошибка любого оператора прерывает запрос.
+    PGresult* raw = PQexec(connection, sql.c_str());
+    if (raw != nullptr && PQresultStatus(raw) == PGRES_COMMAND_OK)
+    {
+        PQclear(raw);
+        return {};
+    }
+    Result result(check(raw, PGRES_TUPLES_OK), PQclear);
+    vector<PgRow> rows;
+    int columns = PQnfields(result.get());
+    for (int row = 0; row < PQntuples(result.get()); row++)
+    {
+        PgRow values;
+        for (int column = 0; column < columns; column++)
+        {
+            if (PQgetisnull(result.get(), row, column))
+                values.emplace_back();
+            else
+                values.emplace_back(string(PQgetvalue(result.get(), row, column), static_cast<size_t>(PQgetlength(result.get(), row, column))));
+        }
+        rows.push_back(move(values));
+    }
+    return rows;
+}
+
+void PgConnection::prepare(const string& name, const string& sql)
+{
+    Result result(check(PQprepare(connection, name.c_str(), sql.c_str(), 0, nullptr), PGRES_COMMAND_OK), PQclear);
+}
+
+long long PgConnection::executePrepared(const string& name, const vector<optional<string>>& parameters)
+{
+    vector<const char*> values;
+    values.reserve(parameters.size());
+    for (const optional<string>& parameter : parameters)
+        values.push_back(parameter ? parameter->c_str() : nullptr);
+    Result result(check(PQexecPrepared(connection, name.c_str(), static_cast<int>(values.size()), values.data(), nullptr, nullptr, 0),
+                        PGRES_COMMAND_OK),
+                  PQclear);
+    return commandCount(result.get());
+}
+
+long long PgConnection::copyIn(const string& sql, const string& data)
+{
+    Result start(check(PQexec(connection, sql.c_str()), PGRES_COPY_IN), PQclear);
+    const size_t chunk = 1 << 16;
+    for (size_t offset = 0; offset < data.size(); offset += chunk)
+    {
+        const size_t size = min(chunk, data.size() - offset);
+        if (PQputCopyData(connection, data.data() + offset, static_cast<int>(size)) != 1)
+            fail("Connection to the database server lost while sending");
+    }
+    if (PQputCopyEnd(connection, nullptr) != 1)
+        fail("Connection to the database server lost while sending");
+    // После завершения COPY сервер присылает итог команды; ошибка в данных приходит здесь же.
+    optional<PgError> error;
+    long long count = 0;
+    while (PGresult* raw = PQgetResult(connection))
+    {
+        Result result(raw, PQclear);
+        ExecStatusType status = PQresultStatus(raw);
+        if (status == PGRES_COMMAND_OK)
+            count = commandCount(raw);
+        else if (status == PGRES_FATAL_ERROR && PQstatus(connection) == CONNECTION_OK)
+        {
+            if (!error)
+                error = serverError(raw);
+        }
+        else
+            fail("Unexpected database server response after COPY");
+    }
+    if (PQstatus(connection) != CONNECTION_OK)
+        fail("Connection to the database server lost");
+    if (error)
+        throw *error;
+    return count;
+}
+
+string copyField(const optional<string>& value)
+{
+    if (!value)
+        return "\\N";
+    string out;
+    out.reserve(value->size());
+    for (char c : *value)
+    {
+        switch (c)
+        {
+        case '\\': out += "\\\\"; break;
+        case '\t': out += "\\t"; break;
+        case '\n': out += "\\n"; break;
+        case '\r': out += "\\r"; break;
+        default: out += c;
+        }
+    }
+    return out;
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+struct pg_conn;
+struct pg_result;
+
+/// <summary>
+/// Параметры подключения к серверу PostgreSQL (раздел databaseMetadata метаданных проекта).
+/// </summary>
+struct ConnectionSettings
+{
+    std::string host;
+    int port = 5432;
+    std::string user;
+    std::string password;
+    std::string database;
+
+    /// <summary>
+    /// Ключ для группировки проектов с одной базой данных: проекты с одинаковым ключом пишутся через один пул соединений.
+    /// </summary>
+    std::string key() const;
+};
+
+/// <summary>
+/// Ошибка, возвращённая сервером (ErrorResponse). Соединение после неё пригодно для работы.
+/// </summary>
+class PgError : public std::runtime_error
+{
+public:
+    PgError(const std::string& message, std::string sqlState);
+    /// <summary>
+    /// Код SQLSTATE (например, "23505" — нарушение уникальности).
+    /// </summary>
+    const std::string& sqlState() const { return state; }
+
+private:
+    std::string state;
+};
+
+/// <summary>
+/// Значения строки результата в текстовом формате; NULL — пустое значение.
+/// </summary>
+using PgRow = std::vector<std::optional<std::string>>;
+
+/// <summary>
+/// Соединение с сервером PostgreSQL через libpq: простые запросы, подготовленные операторы
+/// и загрузка данных командой COPY ... FROM STDIN. Аутентификацию и TLS выполняет libpq.
+/// Объект не потокобезопасен: одновременно его использует один поток (см. ConnectionPool).
+/// Потеря соединения выбрасывается как std::runtime_error; после неё соединение
+/// помечается как неисправное (broken) и должно быть закрыто.
+/// </summary>
+class PgConnection
+{
+public:
+    /// <summary>
+    /// Устанавливает соединение и проходит аутентификацию.
+    /// </summary>
+    /// <exception cref="std::runtime_error">Если сервер недоступен или отклонил подключение.</exception>
+    explicit PgConnection(const ConnectionSettings& settings);
+    ~PgConnection();
+    PgConnection(const PgConnection&) = delete;
+    PgConnection& operator=(const PgConnection&) = delete;
+
+    /// <summary>
+    /// Выполняет простой запрос (один или несколько операторов через точку с запятой) и возвращает строки последнего результата.
+    /// </summary>
+    /// <exception cref="PgError">Если сервер вернул ошибку.</exception>
+    std::vector<PgRow> execute(const std::string& sql);
+
+    /// <summary>
+    /// Подготавливает именованный оператор для выполнения через executePrepared.
+    /// </summary>
+    void prepare(const std::string& name, const std::string& sql);
+
+    /// <summary>
+    /// Выполняет подготовленный оператор с параметрами в текстовом формате и возвращает число затронутых строк.
+    /// </summary>
+    long long executePrepared(const std::string& name, const std::vector<std::optional<std::string>>& parameters);
+
+    /// <summary>
+    /// Выполняет COPY ... FROM STDIN и передаёт данные в текстовом формате COPY; возвращает число загруженных строк.
+    /// </summary>
+    long long copyIn(const std::string& sql, const std::string& data);
+
+    /// <summary>
+    /// Соединение разорвано или протокол нарушен; дальнейшее использование невозможно.
+    /// </summary>
+    bool broken() const;
+
+private:
+    /// <summary>
+    /// Проверяет результат libpq: при потере соединения помечает его неисправным и выбрасывает
+    /// std::runtime_error, при ошибке сервера выбрасывает PgError (результат при этом освобождается).
+    /// </summary>
+    pg_result* check(pg_result* result, int expected);
+    [[noreturn]] void fail(const std::string& message);
+
+    pg_conn* connection = nullptr;
+    bool failed = false;
+};
+
+/// <summary>
+/// Экранирует значение для текстового формата COPY; пустое значение записывается как \N.
+/// </summary>
+std::string copyField(const std::optional<std::string>& value);
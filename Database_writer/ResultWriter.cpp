@@ -0,0 +1,523 @@
+#include "ResultWriter.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <sstream>
+#include "Hash.hpp"
+using namespace std;
+
+namespace {
+
+/// <summary>
+/// Столбцы итогов в порядке строк COPY; project и device образуют первичный ключ.
+/// </summary>
+const string resultColumns = "project, device, params, alms, alms_available, registers, ram_blocks, block_memory_bits, "
+                             "dsp_blocks, fmax_mhz, restricted_fmax_mhz, setup_slack_ns, seed, bitstream, write_id";
+
+const string createResultsTable =
+    "CREATE TABLE IF NOT EXISTS noc_results ("
+    "project text NOT NULL, device text NOT NULL, params text NOT NULL DEFAULT '', "
+    "alms bigint, alms_available bigint, registers bigint, ram_blocks bigint, block_memory_bits bigint, dsp_blocks bigint, "
+    "fmax_mhz double precision, restricted_fmax_mhz double precision, setup_slack_ns double precision, "
+    "seed integer, bitstream boolean, written_at timestamptz NOT NULL DEFAULT now(), write_id bigint NOT NULL DEFAULT 0, "
+    "PRIMARY KEY (project, device))";
+
+// Таблицы, созданные до появления ключа идемпотентности.
+const string addWriteId = "ALTER TABLE noc_results ADD COLUMN IF NOT EXISTS write_id bigint NOT NULL DEFAULT 0";
+
+/// <summary>
+/// Столбец итогов, кроме ключа (project, device) и write_id; type — приведение значения из noc_results_changes.
+/// </summary>
+struct FieldColumn
+{
+    const char* name;
+    const char* type;
+};
+
+// В порядке столбцов resultColumns.
+const FieldColumn fieldColumns[] = {
+    {"params", "text"}, {"alms", "bigint"}, {"alms_available", "bigint"}, {"registers", "bigint"},
+    {"ram_blocks", "bigint"}, {"block_memory_bits", "bigint"}, {"dsp_blocks", "bigint"},
+    {"fmax_mhz", "double precision"}, {"restricted_fmax_mhz", "double precision"}, {"setup_slack_ns", "double precision"},
+    {"seed", "integer"}, {"bitstream", "boolean"}};
+
+const size_t fieldCount = sizeof(fieldColumns) / sizeof(fieldColumns[0]);
+
+// Промежуточные таблицы свои у каждого соединения и очищаются при фиксации транзакции.
+// replace_rows отличает проекты, строки которых заменяются целиком, от новых строк проектов, записываемых по отличиям.
+const string createStagingTable =
+    "CREATE TEMP TABLE IF NOT EXISTS noc_results_staging ("
+    "project text, device text, params text, alms bigint, alms_available bigint, registers bigint, ram_blocks bigint, "
+    "block_memory_bits bigint, dsp_blocks bigint, fmax_mhz double precision, restricted_fmax_mhz double precision, "
+    "setup_slack_ns double precision, seed integer, bitstream boolean, write_id bigint, replace_rows boolean) "
+    "ON COMMIT DELETE ROWS";
+
+const string createChangesTable =
+    "CREATE TEMP TABLE IF NOT EXISTS noc_results_changes ("
+    "project text, device text, column_name text, value text, write_id bigint) ON COMMIT DELETE ROWS";
+
+const string createRemovedTable =
+    "CREATE TEMP TABLE IF NOT EXISTS noc_results_removed (project text, device text, write_id bigint) ON COMMIT DELETE ROWS";
+
+// Повторно полученные или устаревшие итоги проекта не перезаписывают более позднюю запись.
+const string dropStaleResults =
+    "DELETE FROM noc_results_staging s WHERE EXISTS "
+    "(SELECT 1 FROM noc_results r WHERE r.project = s.project AND r.write_id >= s.write_id)";
+
+// Устройства, для которых проект больше не компилируется, удаляются вместе с их строками.
+const string pruneResults =
+    "DELETE FROM noc_results WHERE project IN (SELECT project FROM noc_results_staging WHERE replace_rows) "
+    "AND (project, device) NOT IN (SELECT project, device FROM noc_results_staging)";
+
+const string upsertResults =
+    "INSERT INTO noc_results (" + resultColumns + ") SELECT " + resultColumns + " FROM noc_results_staging "
+    "ON CONFLICT (project, device) DO UPDATE SET params = EXCLUDED.params, alms = EXCLUDED.alms, "
+    "alms_available = EXCLUDED.alms_available, registers = EXCLUDED.registers, ram_blocks = EXCLUDED.ram_blocks, "
+    "block_memory_bits = EXCLUDED.block_memory_bits, dsp_blocks = EXCLUDED.dsp_blocks, fmax_mhz = EXCLUDED.fmax_mhz, "
+    "restricted_fmax_mhz = EXCLUDED.restricted_fmax_mhz, setup_slack_ns = EXCLUDED.setup_slack_ns, seed = EXCLUDED.seed, "
+    "bitstream = EXCLUDED.bitstream, write_id = EXCLUDED.write_id, written_at = now()";
+
+// Изменённое поле применяется, только если строка не записана позже; ключ writeId строки обновляется
+// отдельным оператором после всех столбцов.
+string updateField(const FieldColumn& column)
+{
+    return string("UPDATE noc_results r SET ") + column.name + " = c.value::" + column.type
+           + " FROM noc_results_changes c WHERE c.column_name = '" + column.name
+           + "' AND r.project = c.project AND r.device = c.device AND r.write_id < c.write_id";
+}
+
+const string touchChangedResults =
+    "UPDATE noc_results r SET write_id = c.write_id, written_at = now() "
+    "FROM (SELECT DISTINCT project, device, write_id FROM noc_results_changes) c "
+    "WHERE r.project = c.project AND r.device = c.device AND r.write_id < c.write_id";
+
+// Изменённые строки, которых нет в таблице (её очистили или строку удалили вручную после записи снимка):
+// они записываются целиком из текущих итогов проекта, иначе изменения полей некуда применить.
+const string missingChangedResults =
+    "SELECT DISTINCT c.project, c.device FROM noc_results_changes c WHERE NOT EXISTS "
+    "(SELECT 1 FROM noc_results r WHERE r.project = c.project AND r.device = c.device)";
+
+const string removeResults =
+    "DELETE FROM noc_results r USING noc_results_removed d "
+    "WHERE r.project = d.project AND r.device = d.device AND r.write_id < d.write_id";
+
+/// <summary>
+/// Число попыток записи партии: повторяются обрывы соединения, взаимоблокировки и конфликты сериализации.
+/// </summary>
+const int flushAttempts = 3;
+
+/// <summary>
+/// Ошибки, после которых транзакция может пройти при повторе: конфликт сериализации и взаимоблокировка.
+/// </summary>
+bool transientError(const PgError& e)
+{
+    return e.sqlState() == "40001" || e.sqlState() == "40P01";
+}
+
+mutex schemaAccess;
+/// <summary>
+/// Базы данных (ConnectionSettings::key), в которых таблица итогов уже создана этим процессом.
+/// </summary>
+set<string> schemaReady;
+
+optional<string> number(const optional<double>& value)
+{
+    if (!value)
+        return nullopt;
+    ostringstream out;
+    out<<setprecision(15)<<*value;
+    return out.str();
+}
+
+/// <summary>
+/// Значения столбцов fieldColumns в текстовом виде COPY.
+/// </summary>
+vector<optional<string>> fieldValues(const ResultRow& row)
+{
+    return {row.params, to_string(row.alms), to_string(row.almsAvailable), to_string(row.registers),
+            to_string(row.ramBlocks), to_string(row.blockMemoryBits), to_string(row.dspBlocks), number(row.fmaxMhz),
+            number(row.restrictedFmaxMhz), number(row.setupSlackNs), to_string(row.seed), string(row.bitstream ? "t" : "f")};
+}
+
+void appendLine(string& data, const vector<optional<string>>& fields)
+{
+    bool first = true;
+    for (const optional<string>& field : fields)
+    {
+        if (!first)
+            data += '\t';
+        data += copyField(field);
+        first = false;
+    }
+    data += '\n';
+}
+
+void appendRow(string& data, const ResultRow& row, long long writeId, bool replace)
+{
+    vector<optional<string>> fields = {row.project, row.device};
+    for (optional<string>& value : fieldValues(row))
+        fields.push_back(move(value));
+    fields.push_back(to_string(writeId));
+    fields.push_back(string(replace ? "t" : "f"));
+    appendLine(data, fields);
+}
+
+/// <summary>
+/// Добавляет в данные COPY полную строку проекта партии, изменения которой не к чему применить.
+/// </summary>
+void appendMissingRow(string& data, const vector<ProjectResults>& batch, const PgRow& key)
+{
+    if (key.size() < 2 || !key[0] || !key[1])
+        return;
+    for (const ProjectResults& results : batch)
+    {
+        if (results.project != *key[0])
+            continue;
+        for (const ResultRow& row : results.rows)
+            if (row.device == *key[1])
+                appendRow(data, row, results.writeId, false);
+    }
+}
+
+ResultRow deviceRow(const string& project, const string& params, const QuartusMetadata& device)
+{
+    ResultRow row;
+    row.project = project;
+    row.device = device.deviceName;
+    row.params = params;
+    row.alms = device.alms;
+    row.almsAvailable = device.almsAvailable;
+    row.registers = device.registers;
+    row.ramBlocks = device.ramBlocks;
+    row.blockMemoryBits = device.blockMemoryBits;
+    row.dspBlocks = device.dspBlocks;
+    auto worst = min_element(device.clocks.begin(), device.clocks.end(),
+                             [](const ClockTiming& a, const ClockTiming& b) { return a.setupSlackNs < b.setupSlackNs; });
+    if (worst != device.clocks.end())
+    {
+        row.fmaxMhz = worst->fmaxMhz;
+        row.restrictedFmaxMhz = worst->restrictedFmaxMhz;
+        row.setupSlackNs = worst->setupSlackNs;
+    }
+    row.seed = device.seed;
+    row.bitstream = device.bitstreamGenerated;
+    return row;
+}
+
+} // namespace
+
+vector<ResultRow> resultRows(const string& project, const ProjectSettings& settings)
+{
+    const QuartusMetadata& quartus = settings.quartusMetadata;
+    const string& params = settings.graphVerilogMetadata.params;
+    vector<ResultRow> rows;
+    if (quartus.devices.empty())
+        rows.push_back(deviceRow(project, params, quartus));
+    for (const QuartusMetadata& device : quartus.devices)
+        if (device.quartusCompiled)
+            rows.push_back(deviceRow(project, params, device));
+    return rows;
+}
+
+size_t ProjectResults::changedRows() const
+{
+    if (replace)
+        return rows.size();
+    set<string> devices(added.begin(), added.end());
+    devices.insert(removed.begin(), removed.end());
+    for (const FieldChange& change : changes)
+        devices.insert(change.device);
+    return devices.size();
+}
+
+DatabaseSnapshot resultsSnapshot(const ProjectResults& results, const ConnectionSettings& connection)
+{
+    DatabaseSnapshot snapshot;
+    snapshot.target = connection.key() + "/" + results.project;
+    for (const ResultRow& row : results.rows)
+    {
+        map<string, string>& fields = snapshot.rows[row.device];
+        vector<optional<string>> values = fieldValues(row);
+        for (size_t i = 0; i < fieldCount; i++)
+            if (values[i])
+                fields[fieldColumns[i].name] = *values[i];
+    }
+    ostringstream hash;
+    hash<<hex<<setw(16)<<setfill('0')<<common::hash64(nlohmann::json(snapshot.rows).dump());
+    snapshot.hash = hash.str();
+    return snapshot;
+}
+
+void diffResults(ProjectResults& results, const DatabaseSnapshot& previous, const ConnectionSettings& connection)
+{
+    results.replace = true;
+    results.added.clear();
+    results.changes.clear();
+    results.removed.clear();
+    DatabaseSnapshot current = resultsSnapshot(results, connection);
+    if (previous.target != current.target)
+        return;
+    results.replace = false;
+    if (previous.hash == current.hash)
+        return;
+    auto value = [](const map<string, string>& fields, const char* column) -> optional<string>
+    {
+        auto found = fields.find(column);
+        return found == fields.end() ? nullopt : optional<string>(found->second);
+    };
+    for (const auto& [device, fields] : current.rows)
+    {
+        auto before = previous.rows.find(device);
+        if (before == previous.rows.end())
+        {
+            results.added.push_back(device);
+            continue;
+        }
+        for (const FieldColumn& column : fieldColumns)
+        {
+            optional<string> now = value(fields, column.name);
+            if (now != value(before->second, column.name))
+                results.changes.push_back({device, column.name, now});
+        }
+    }
+    for (const auto& [device, fields] : previous.rows)
+        if (!current.rows.count(device))
+            results.removed.push_back(device);
+}
+
+ResultWriter::ResultWriter(ConnectionPool& pool, ResultWriterOptions options, Callback done)
+    : pool(pool), options(options), done(move(done))
+{
+    for (unsigned i = 0; i < max(1u, options.flushers); i++)
+        flushers.emplace_back([this] { flushLoop(); });
+}
+
+ResultWriter::~ResultWriter()
+{
+    finish();
+}
+
+void ResultWriter::setupConnection(PgConnection& connection, const ConnectionSettings& settings)
+{
+    {
+        // Одновременное создание таблицы из нескольких соединений приводит к ошибке на сервере.
+        lock_guard<mutex> lock(schemaAccess);
+        if (schemaReady.count(settings.key()) == 0)
+        {
+            connection.execute(createResultsTable);
+            connection.execute(addWriteId);
+            schemaReady.insert(settings.key());
+        }
+    }
+    connection.execute(createStagingTable);
+    connection.execute(createChangesTable);
+    connection.execute(createRemovedTable);
+    connection.prepare("drop_stale_results", dropStaleResults);
+    connection.prepare("prune_results", pruneResults);
+    connection.prepare("upsert_results", upsertResults);
+    for (const FieldColumn& column : fieldColumns)
+        connection.prepare(string("update_") + column.name, updateField(column));
+    connection.prepare("touch_changed_results", touchChangedResults);
+    connection.prepare("remove_results", removeResults);
+}
+
+void ResultWriter::add(ProjectResults results)
+{
+    if (results.changedRows() == 0)
+    {
+        // Строки проекта в таблице уже совпадают с текущими.
+        done(results, "");
+        return;
+    }
+    {
+        lock_guard<mutex> lock(access);
+        if (queue.empty())
+            oldest = chrono::steady_clock::now();
+        queuedRows += results.changedRows();
+        queue.push_back(move(results));
+    }
+    ready.notify_one();
+}
+
+void ResultWriter::finish()
+{
+    {
+        lock_guard<mutex> lock(access);
+        if (finishing && flushers.empty())
+            return;
+        finishing = true;
+    }
+    ready.notify_all();
+    for (thread& flusher : flushers)
+        flusher.join();
+    flushers.clear();
+}
+
+void ResultWriter::wait()
+{
+    unique_lock<mutex> lock(access);
+    idle.wait(lock, [this] { return queue.empty() && inFlight == 0; });
+}
+
+void ResultWriter::flushLoop()
+{
+    unique_lock<mutex> lock(access);
+    for (;;)
+    {
+        // Неполная партия ждёт новых проектов не дольше linger: при быстром чтении метаданных транзакции крупнее.
+        ready.wait(lock, [this] { return finishing || !queue.empty(); });
+        if (queue.empty())
+            return;
+        ready.wait_until(lock, oldest + options.linger, [this] { return finishing || queuedRows >= options.batchSize; });
+        if (queue.empty())
+            continue;
+
+        vector<ProjectResults> batch;
+        size_t batchRows = 0;
+        while (!queue.empty() && (batch.empty() || batchRows + queue.front().changedRows() <= options.batchSize))
+        {
+            const size_t projectRows = queue.front().changedRows();
+            batchRows += projectRows;
+            queuedRows -= projectRows;
+            batch.push_back(move(queue.front()));
+            queue.pop_front();
+        }
+        oldest = chrono::steady_clock::now();
+        inFlight++;
+        if (!queue.empty())
+            ready.notify_one();
+        lock.unlock();
+
+        vector<string> errors(batch.size());
+        const size_t committed = flushIsolating(batch, errors);
+        size_t committedRows = 0;
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            if (errors[i].empty())
+                committedRows += batch[i].changedRows();
+            done(batch[i], errors[i]);
+        }
+
+        lock.lock();
+        rows += committedRows;
+        batches += committed;
+        inFlight--;
+        if (queue.empty() && inFlight == 0)
+            idle.notify_all();
+    }
+}
+
+size_t ResultWriter::flushIsolating(const vector<ProjectResults>& batch, vector<string>& errors)
+{
+    try
+    {
+        flush(batch);
+        return 1;
+    }
+    catch (PgError& e)
+    {
+        if (batch.size() == 1 || transientError(e))
+        {
+            fill(errors.begin(), errors.end(), e.what());
+            return 0;
+        }
+    }
+    catch (exception& e)
+    {
+        fill(errors.begin(), errors.end(), e.what());
+        return 0;
+    }
+    const size_t middle = batch.size() / 2;
+    vector<ProjectResults> first(batch.begin(), batch.begin() + middle), second(batch.begin() + middle, batch.end());
+    vector<string> firstErrors(first.size()), secondErrors(second.size());
+    const size_t committed = flushIsolating(first, firstErrors) + flushIsolating(second, secondErrors);
+    move(firstErrors.begin(), firstErrors.end(), errors.begin());
+    move(secondErrors.begin(), secondErrors.end(), errors.begin() + middle);
+    return committed;
+}
+
+void ResultWriter::flush(const vector<ProjectResults>& batch)
+{
+    string rowsData, changesData, removedData;
+    vector<bool> changedColumns(fieldCount, false);
+    for (const ProjectResults& results : batch)
+    {
+        const string writeId = to_string(results.writeId);
+        if (results.replace)
+        {
+            for (const ResultRow& row : results.rows)
+                appendRow(rowsData, row, results.writeId, true);
+            continue;
+        }
+        for (const ResultRow& row : results.rows)
+            if (find(results.added.begin(), results.added.end(), row.device) != results.added.end())
+                appendRow(rowsData, row, results.writeId, false);
+        for (const FieldChange& change : results.changes)
+        {
+            appendLine(changesData, {results.project, change.device, change.column, change.value, writeId});
+            for (size_t i = 0; i < fieldCount; i++)
+                if (change.column == fieldColumns[i].name)
+                    changedColumns[i] = true;
+        }
+        for (const string& device : results.removed)
+            appendLine(removedData, {results.project, device, writeId});
+    }
+
+    for (int attempt = 1;; attempt++)
+    {
+        ConnectionPool::Lease connection = pool.acquire();
+        try
+        {
+            connection->execute("BEGIN");
+            string stagedData = rowsData;
+            if (!changesData.empty())
+            {
+                connection->copyIn("COPY noc_results_changes (project, device, column_name, value, write_id) FROM STDIN",
+                                   changesData);
+                for (const PgRow& missing : connection->execute(missingChangedResults))
+                    appendMissingRow(stagedData, batch, missing);
+            }
+            if (!stagedData.empty())
+            {
+                connection->copyIn("COPY noc_results_staging (" + resultColumns + ", replace_rows) FROM STDIN", stagedData);
+                connection->executePrepared("drop_stale_results", {});
+                connection->executePrepared("prune_results", {});
+                connection->executePrepared("upsert_results", {});
+            }
+            if (!changesData.empty())
+            {
+                // Операторы выполняются только для столбцов, которые изменились хотя бы в одном проекте партии.
+                for (size_t i = 0; i < fieldCount; i++)
+                    if (changedColumns[i])
+                        connection->executePrepared(string("update_") + fieldColumns[i].name, {});
+                connection->executePrepared("touch_changed_results", {});
+            }
+            if (!removedData.empty())
+            {
+                connection->copyIn("COPY noc_results_removed (project, device, write_id) FROM STDIN", removedData);
+                connection->executePrepared("remove_results", {});
+            }
+            connection->execute("COMMIT");
+            return;
+        }
+        catch (PgError& e)
+        {
+            try
+            {
+                connection->execute("ROLLBACK");
+            }
+            catch (exception&)
+            {
+                connection.discard();
+            }
+            if (!transientError(e) || attempt == flushAttempts)
+                throw;
+        }
+        catch (exception&)
+        {
+            // Обрыв соединения: неисправное соединение закрывается пулом, попытка повторяется с новым.
+            if (!connection->broken() || attempt == flushAttempts)
+                throw;
+        }
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ConnectionPool.hpp"
+#include "ProjectSettings.hpp"
+
+/// <summary>
+/// Строка таблицы noc_results: итоги компиляции проекта для одного устройства.
+/// </summary>
+struct ResultRow
+{
+    std::string project;
+    std::string device;
+    std::string params;
+    long long alms = 0;
+    long long almsAvailable = 0;
+    long long registers = 0;
+    long long ramBlocks = 0;
+    long long blockMemoryBits = 0;
+    long long dspBlocks = 0;
+    /// <summary>
+    /// Временные характеристики худшего по запасу тактового сигнала; пустые, если отчёт их не содержит.
+    /// </summary>
+    std::optional<double> fmaxMhz;
+    std::optional<double> restrictedFmaxMhz;
+    std::optional<double> setupSlackNs;
+    unsigned seed = 0;
+    bool bitstream = false;
+};
+
+/// <summary>
+/// Изменённое поле строки noc_results.
+/// </summary>
+struct FieldChange
+{
+    std::string device;
+    std::string column;
+    /// <summary>
+    /// Новое значение в текстовом виде COPY; nullopt — NULL.
+    /// </summary>
+    std::optional<std::string> value;
+};
+
+/// <summary>
+/// Итоги одного проекта: записываются в базу данных одной транзакцией.
+/// </summary>
+struct ProjectResults
+{
+    std::string project;
+    std::string metadataPath;
+    /// <summary>
+    /// Ключ идемпотентности записи: время получения итогов в наносекундах. Строки проекта заменяются
+    /// только более поздней записью, поэтому повторная запись (например, из журнала после сбоя) ничего не меняет.
+    /// </summary>
+    long long writeId = 0;
+    /// <summary>
+    /// Все текущие строки проекта: их содержит таблица после записи.
+    /// </summary>
+    std::vector<ResultRow> rows;
+    /// <summary>
+    /// true — строки проекта в таблице заменяются целиком; false — записываются только отличия от снимка
+    /// последней записи (diffResults): строки новых устройств added, изменённые поля changes
+    /// и строки устройств removed, для которых проект больше не компилируется.
+    /// </summary>
+    bool replace = true;
+    std::vector<std::string> added;
+    std::vector<FieldChange> changes;
+    std::vector<std::string> removed;
+
+    /// <summary>
+    /// Число строк таблицы, которые изменит запись; 0 — проект не изменился со времени последней записи.
+    /// </summary>
+    size_t changedRows() const;
+};
+
+/// <summary>
+/// Строки noc_results для проекта: по строке на устройство из quartusMetadata.devices,
+/// без компиляции для нескольких устройств — одна строка для устройства проекта.
+/// </summary>
+std::vector<ResultRow> resultRows(const std::string& project, const ProjectSettings& settings);
+
+/// <summary>
+/// Снимок строк проекта для databaseMetadata.synced после их записи в базу данных connection.
+/// </summary>
+DatabaseSnapshot resultsSnapshot(const ProjectResults& results, const ConnectionSettings& connection);
+
+/// <summary>
+/// Сравнивает строки проекта со снимком последней записи и оставляет для записи только отличия (replace = false).
+/// Снимок другой базы данных или другого проекта не используется: строки записываются целиком.
+/// Снимок не проверяется по таблице: строки, изменённые в ней в обход Database_writer, восстанавливает запись целиком.
+/// </summary>
+void diffResults(ProjectResults& results, const DatabaseSnapshot& previous, const ConnectionSettings& connection);
+
+/// <summary>
+/// Параметры записи.
+/// </summary>
+struct ResultWriterOptions
+{
+    /// <summary>
+    /// Наибольшее число изменяемых строк в одной транзакции; итоги проекта не делятся между транзакциями.
+    /// </summary>
+    unsigned batchSize = 500;
+    /// <summary>
+    /// Число потоков записи (не больше размера пула соединений).
+    /// </summary>
+    unsigned flushers = 4;
+    /// <summary>
+    /// Сколько неполная партия ждёт новых проектов перед записью.
+    /// </summary>
+    std::chrono::milliseconds linger{50};
+};
+
+/// <summary>
+/// Конвейерная запись итогов в базу данных. Проекты добавляются по мере чтения метаданных, потоки записи
+/// одновременно собирают их в партии и записывают каждую партию одной транзакцией: строки загружаются
+/// командой COPY во временную таблицу, затем подготовленные операторы отбрасывают проекты, уже записанные
+/// с тем же или более поздним ключом writeId, удаляют устаревшие строки проектов партии и вставляют
+/// или обновляют новые (INSERT ... ON CONFLICT). Изменённые поля проектов, записываемых по отличиям,
+/// загружаются во временную таблицу noc_results_changes и применяются операторами UPDATE по одному
+/// на изменённый столбец. Для каждого проекта вызывается обработчик с пустой строкой после фиксации
+/// транзакции или с текстом ошибки; для проекта без изменений — сразу, без обращения к базе данных.
+/// Если сервер отверг партию не временной ошибкой (например, из-за недопустимого значения одного проекта),
+/// партия делится пополам, пока ошибка не будет отнесена к отдельным проектам: остальные проекты записываются.
+/// </summary>
+class ResultWriter
+{
+public:
+    using Callback = std::function<void(const ProjectResults& results, const std::string& error)>;
+
+    ResultWriter(ConnectionPool& pool, ResultWriterOptions options, Callback done);
+    ~ResultWriter();
+
+    /// <summary>
+    /// Подготавливает новое соединение пула: создаёт таблицу итогов (один раз для каждой базы данных),
+    /// временные таблицы и операторы.
+    /// </summary>
+    static void setupConnection(PgConnection& connection, const ConnectionSettings& settings);
+
+    /// <summary>
+    /// Ставит итоги проекта в очередь записи.
+    /// </summary>
+    void add(ProjectResults results);
+
+    /// <summary>
+    /// Записывает оставшиеся проекты и останавливает потоки записи.
+    /// </summary>
+    void finish();
+
+    /// <summary>
+    /// Ждёт записи всех поставленных в очередь проектов, не останавливая потоки записи.
+    /// </summary>
+    void wait();
+
+    size_t rowsWritten() const { return rows; }
+    size_t batchesWritten() const { return batches; }
+
+private:
+    void flushLoop();
+    void flush(const std::vector<ProjectResults>& batch);
+    /// <summary>
+    /// Записывает партию, при не временной ошибке сервера — по частям; errors получает ошибку каждого проекта.
+    /// Возвращает число зафиксированных транзакций.
+    /// </summary>
+    size_t flushIsolating(const std::vector<ProjectResults>& batch, std::vector<std::string>& errors);
+
+    ConnectionPool& pool;
+    ResultWriterOptions options;
+    Callback done;
+    std::mutex access;
+    std::condition_variable ready;
+    std::condition_variable idle;
+    size_t inFlight = 0;
+    std::deque<ProjectResults> queue;
+    size_t queuedRows = 0;
+    std::chrono::steady_clock::time_point oldest;
+    bool finishing = false;
+    size_t rows = 0;
+    size_t batches = 0;
+    std::vector<std::thread> flushers;
+};
@@ -0,0 +1,579 @@
+#include "Spool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include "Hash.hpp"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+/// <summary>
+/// Сегмент ".part", который не изменялся дольше этого времени, оставлен упавшим процессом и выгружается.
+/// </summary>
+const chrono::minutes abandonedSegmentAge{10};
+
+/// <summary>
+/// Блокировка выгрузки считается брошенной, если не обновлялась дольше этого времени.
+/// </summary>
+const chrono::seconds drainerLease{30};
+
+/// <summary>
+/// Сколько строк выгружается за один проход: сегменты удаляются по мере выгрузки, а не после всего журнала.
+/// </summary>
+const size_t rowsPerRound = 50000;
+
+string processToken()
+{
+    static atomic<unsigned> counter{0};
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    return to_string(pid) + "-" + to_string(counter++);
+}
+
+void say(const string& text)
+{
+    cout<<(text + "\n")<<flush;
+}
+
+json recordToJson(const SpoolRecord& record)
+{
+    const ConnectionSettings& c = record.connection;
+    const ProjectResults& r = record.results;
+    json rows = json::array();
+    for (const ResultRow& row : r.rows)
+    {
+        auto optionalNumber = [](const optional<double>& value) { return value ? json(*value) : json(nullptr); };
+        rows.push_back({{"device", row.device}, {"params", row.params}, {"alms", row.alms},
+                        {"almsAvailable", row.almsAvailable}, {"registers", row.registers}, {"ramBlocks", row.ramBlocks},
+                        {"blockMemoryBits", row.blockMemoryBits}, {"dspBlocks", row.dspBlocks},
+                        {"fmaxMhz", optionalNumber(row.fmaxMhz)}, {"restrictedFmaxMhz", optionalNumber(row.restrictedFmaxMhz)},
+                        {"setupSlackNs", optionalNumber(row.setupSlackNs)}, {"seed", row.seed}, {"bitstream", row.bitstream}});
+    }
+    // Пароль в журнал не записывается: при выгрузке он берётся из метаданных проекта.
+    return {{"connection", {{"host", c.host}, {"port", c.port}, {"user", c.user}, {"database", c.database}}},
+            {"project", r.project}, {"metadataPath", r.metadataPath}, {"writeId", r.writeId},
+            {"metadataHash", record.metadataHash}, {"rows", rows}};
+}
+
+SpoolRecord recordFromJson(const json& j)
+{
+    SpoolRecord record;
+    const json& c = j.at("connection");
+    record.connection.host = c.at("host").get<string>();
+    record.connection.port = c.at("port").get<int>();
+    record.connection.user = c.at("user").get<string>();
+    record.connection.database = c.at("database").get<string>();
+    record.results.project = j.at("project").get<string>();
+    record.results.metadataPath = j.at("metadataPath").get<string>();
+    record.results.writeId = j.at("writeId").get<long long>();
+    record.metadataHash = j.at("metadataHash").get<string>();
+    for (const json& r : j.at("rows"))
+    {
+        auto optionalNumber = [](const json& value) { return value.is_null() ? optional<double>() : value.get<double>(); };
+        ResultRow row;
+        row.project = record.results.project;
+        row.device = r.at("device").get<string>();
+        row.params = r.at("params").get<string>();
+        row.alms = r.at("alms").get<long long>();
+        row.almsAvailable = r.at("almsAvailable").get<long long>();
+        row.registers = r.at("registers").get<long long>();
+        row.ramBlocks = r.at("ramBlocks").get<long long>();
+        row.blockMemoryBits = r.at("blockMemoryBits").get<long long>();
+        row.dspBlocks = r.at("dspBlocks").get<long long>();
+        row.fmaxMhz = optionalNumber(r.at("fmaxMhz"));
+        row.restrictedFmaxMhz = optionalNumber(r.at("restrictedFmaxMhz"));
+        row.setupSlackNs = optionalNumber(r.at("setupSlackNs"));
+        row.seed = r.at("seed").get<unsigned>();
+        row.bitstream = r.at("bitstream").get<bool>();
+        record.results.rows.push_back(move(row));
+    }
+    return record;
+}
+
+void putLittleEndian(string& out, uint64_t value, int bytes)
+{
+    for (int i = 0; i < bytes; i++)
+        out += static_cast<char>((value >> (8 * i)) & 0xff);
+}
+
+uint64_t getLittleEndian(const string& data, size_t offset, int bytes)
+{
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--)
+        value = (value << 8) | static_cast<unsigned char>(data[offset + i]);
+    return value;
+}
+
+/// <summary>
+/// Записи сегмента. Чтение останавливается на первой неполной или повреждённой записи: так выглядит
+/// хвост сегмента, запись которого прервал сбой до fsync.
+/// </summary>
+vector<SpoolRecord> readSegment(const fs::path& path, bool& torn)
+{
+    ifstream in(path, ios::binary);
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    vector<SpoolRecord> records;
+    size_t offset = 0;
+    torn = false;
+    while (offset < data.size())
+    {
+        if (data.size() - offset < 12)
+        {
+            torn = true;
+            break;
+        }
+        size_t length = static_cast<size_t>(getLittleEndian(data, offset, 4));
+        uint64_t checksum = getLittleEndian(data, offset + 4, 8);
+        if (data.size() - offset - 12 < length || common::hash64(string_view(data).substr(offset + 12, length)) != checksum)
+        {
+            torn = true;
+            break;
+        }
+        try
+        {
+            records.push_back(recordFromJson(json::parse(data.substr(offset + 12, length))));
+        }
+        catch (exception&)
+        {
+            torn = true;
+            break;
+        }
+        offset += 12 + length;
+    }
+    return records;
+}
+
+/// <summary>
+/// Опубликованные сегменты по порядку записи и брошенные упавшими процессами сегменты ".part".
+/// </summary>
+vector<fs::path> listSegments(const fs::path& directory)
+{
+    vector<fs::path> segments;
+    error_code ec;
+    const auto now = fs::file_time_type::clock::now();
+    for (const auto& entry : fs::directory_iterator(directory, ec))
+    {
+        const fs::path& path = entry.path();
+        if (path.extension() == ".wal")
+            segments.push_back(path);
+        else if (path.extension() == ".part")
+        {
+            auto time = fs::last_write_time(path, ec);
+            if (!ec && now - time > abandonedSegmentAge)
+                segments.push_back(path);
+        }
+    }
+    sort(segments.begin(), segments.end(), [](const fs::path& a, const fs::path& b) { return a.filename() < b.filename(); });
+    return segments;
+}
+
+void syncDirectory(const fs::path& directory)
+{
+#ifndef _WIN32
+    int fd = open(directory.string().c_str(), O_RDONLY);
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+#else
+    (void)directory;
+#endif
+}
+
+/// <summary>
+/// Блокировка выгрузки журнала: каталог "drainer.lock" с файлом heartbeat, в котором записан маркер владельца;
+/// время изменения файла обновляется, пока процесс выгрузки работает.
+/// </summary>
+class DrainerLock
+{
+public:
+    static unique_ptr<DrainerLock> tryAcquire(const fs::path& directory)
+    {
+        fs::path path = directory / "drainer.lock";
+        for (int attempt = 0; attempt < 2; attempt++)
+        {
+            error_code ec;
+            if (fs::create_directory(path, ec))
+                return unique_ptr<DrainerLock>(new DrainerLock(path));
+            fs::path heartbeat = path / "heartbeat";
+            auto time = fs::last_write_time(fs::exists(heartbeat, ec) ? heartbeat : path, ec);
+            if (ec || fs::file_time_type::clock::now() - time <= drainerLease)
+                return nullptr;
+            // Брошенная блокировка сначала переименовывается: переименование удаётся только одному процессу.
+            fs::path stale = directory / ("stale_drainer_" + processToken());
+            fs::rename(path, stale, ec);
+            if (!ec)
+                fs::remove_all(stale, ec);
+        }
+        return nullptr;
+    }
+
+    ~DrainerLock()
+    {
+        {
+            lock_guard<mutex> lock(access);
+            stopping = true;
+        }
+        stop.notify_one();
+        heartbeat.join();
+        // Блокировку могли признать брошенной (процесс был приостановлен дольше срока) и занять заново:
+        // удаляется только блокировка со своим маркером. Как и при освобождении брошенной блокировки,
+        // каталог сначала переименовывается, а маркер проверяется ещё раз.
+        if (!owns(path))
+        {
+            say("Spool: the drainer lock was taken over by another process; not released");
+            return;
+        }
+        fs::path released = path.parent_path() / ("released_drainer_" + token);
+        error_code ec;
+        fs::rename(path, released, ec);
+        if (ec)
+            return;
+        if (owns(released))
+            fs::remove_all(released, ec);
+        else
+            fs::rename(released, path, ec);
+    }
+
+private:
+    explicit DrainerLock(fs::path lockPath) : path(move(lockPath)), token(processToken())
+    {
+        ofstream(path / "heartbeat", ios::trunc)<<token<<"\n";
+        heartbeat = thread([this]
+        {
+            unique_lock<mutex> lock(access);
+            while (!stop.wait_for(lock, drainerLease / 10, [this] { return stopping; }))
+                touch();
+        });
+    }
+
+    void touch()
+    {
+        error_code ec;
+        fs::last_write_time(path / "heartbeat", fs::file_time_type::clock::now(), ec);
+    }
+
+    bool owns(const fs::path& lockPath) const
+    {
+        ifstream in(lockPath / "heartbeat");
+        string line;
+        return getline(in, line) && line == token;
+    }
+
+    fs::path path;
+    string token;
+    mutex access;
+    condition_variable stop;
+    bool stopping = false;
+    thread heartbeat;
+};
+
+/// <summary>
+/// Пул соединений и конвейер записи для одной базы данных.
+/// </summary>
+struct DrainSession
+{
+    unique_ptr<ConnectionPool> pool;
+    unique_ptr<ResultWriter> writer;
+};
+
+} // namespace
+
+string spoolDirectory(const string& location)
+{
+    return (fs::path(location) / "database_spool").string();
+}
+
+SpoolWriter::SpoolWriter(const string& directory)
+{
+    fs::create_directories(directory);
+    auto now = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    ostringstream name;
+    name<<setw(20)<<setfill('0')<<now<<"-"<<processToken()<<".part";
+    path = (fs::path(directory) / name.str()).string();
+#ifdef _WIN32
+    file = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    file = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+#endif
+    if (file < 0)
+        throw runtime_error("Cannot create spool segment " + path);
+}
+
+SpoolWriter::~SpoolWriter()
+{
+    try
+    {
+        commit();
+    }
+    catch (exception& e)
+    {
+        say(string("Spool: ") + e.what());
+    }
+}
+
+void SpoolWriter::append(const SpoolRecord& record)
+{
+    string payload = recordToJson(record).dump();
+    string frame;
+    putLittleEndian(frame, payload.size(), 4);
+    putLittleEndian(frame, common::hash64(payload), 8);
+    frame += payload;
+    lock_guard<mutex> lock(access);
+    if (committed)
+        throw runtime_error("Spool segment is already committed");
+    // Запись целиком одним вызовом: при сбое повреждается только хвост сегмента, который отбрасывается при чтении.
+    size_t written = 0;
+    while (written < frame.size())
+    {
+#ifdef _WIN32
+        int n = _write(file, frame.data() + written, static_cast<unsigned>(frame.size() - written));
+#else
+        auto n = write(file, frame.data() + written, frame.size() - written);
+#endif
+        if (n <= 0)
+            throw runtime_error("Failed to append to spool segment " + path);
+        written += static_cast<size_t>(n);
+    }
+    records++;
+}
+
+void SpoolWriter::commit()
+{
+    lock_guard<mutex> lock(access);
+    if (committed)
+        return;
+    committed = true;
+#ifdef _WIN32
+    int synced = _commit(file);
+    _close(file);
+#else
+    int synced = fsync(file);
+    close(file);
+#endif
+    if (records == 0)
+    {
+        fs::remove(path);
+        return;
+    }
+    if (synced != 0)
+        throw runtime_error("Failed to sync spool segment " + path);
+    fs::path published = fs::path(path).replace_extension(".wal");
+    fs::rename(path, published);
+    syncDirectory(published.parent_path());
+}
+
+int drainSpool(const string& directory, const DrainOptions& options,
+               const function<optional<string>(const SpoolRecord& record)>& password,
+               const function<void(ProjectResults& results, const ConnectionSettings& connection)>& prepare,
+               const function<void(const SpoolRecord& record)>& written)
+{
+    unique_ptr<DrainerLock> lock = DrainerLock::tryAcquire(directory);
+    if (!lock)
+        return 0;
+    // Состояние прохода объявлено до сеансов: потоки записи сеансов обращаются к нему до своей остановки.
+    mutex access;
+    map<string, const SpoolRecord*> latest; // Проект -> последняя запись прохода.
+    map<string, string> failures; // Проект -> ошибка записи.
+    map<string, DrainSession> sessions;
+    chrono::seconds backoff{1};
+    auto lastProgress = chrono::steady_clock::now();
+    for (;;)
+    {
+        vector<fs::path> segments = listSegments(directory);
+        if (segments.empty())
+        {
+            // Блокировка снимается до повторной проверки: сегмент, опубликованный после неё, выгрузит процесс,
+            // запущенный его автором.
+            lock.reset();
+            if (listSegments(directory).empty())
+                return 0;
+            lock = DrainerLock::tryAcquire(directory);
+            if (!lock)
+                return 0;
+            continue;
+        }
+
+        // Записи проходов читаются по сегментам; для каждого проекта записывается только последняя запись.
+        vector<vector<SpoolRecord>> loaded;
+        vector<bool> torn;
+        size_t rows = 0;
+        for (const fs::path& segment : segments)
+        {
+            if (rows >= rowsPerRound)
+                break;
+            bool damaged = false;
+            loaded.push_back(readSegment(segment, damaged));
+            torn.push_back(damaged);
+            if (damaged && segment.extension() == ".wal")
+                say("Spool: " + segment.filename().string() + " has a damaged record; later records are skipped");
+            for (const SpoolRecord& record : loaded.back())
+                rows += record.results.rows.size();
+        }
+        latest.clear();
+        failures.clear();
+        for (const vector<SpoolRecord>& records : loaded)
+            for (const SpoolRecord& record : records)
+            {
+                const SpoolRecord*& current = latest[record.results.project];
+                if (current == nullptr || current->results.writeId < record.results.writeId)
+                    current = &record;
+            }
+
+        // Журнал не хранит паролей: пароль базы данных берётся у любого проекта прохода, который пишет в неё.
+        map<string, string> passwords;
+        for (const auto& [project, record] : latest)
+        {
+            const string key = record->connection.key();
+            if (sessions.count(key) || passwords.count(key))
+                continue;
+            if (optional<string> found = password(*record))
+                passwords[key] = *found;
+        }
+
+        for (const auto& [project, record] : latest)
+        {
+            const string key = record->connection.key();
+            if (!sessions.count(key) && !passwords.count(key))
+            {
+                lock_guard<mutex> lock(access);
+                failures[project] = "no project metadata names database " + key + " any more; its password is unknown";
+                continue;
+            }
+            DrainSession& session = sessions[key];
+            if (!session.writer)
+            {
+                ConnectionSettings connection = record->connection;
+                connection.password = passwords.at(key);
+                session.pool = make_unique<ConnectionPool>(connection, options.poolSize, ResultWriter::setupConnection);
+                ResultWriterOptions writerOptions;
+                writerOptions.batchSize = options.batchSize;
+                writerOptions.flushers = options.poolSize;
+                session.writer = make_unique<ResultWriter>(*session.pool, writerOptions,
+                                                           [&access, &failures, &latest, &written](const ProjectResults& results, const string& error)
+                {
+                    const SpoolRecord* record = latest.at(results.project);
+                    if (error.empty())
+                    {
+                        written(*record);
+                        return;
+                    }
+                    lock_guard<mutex> lock(access);
+                    failures[results.project] = error;
+                });
+            }
+            ProjectResults results = record->results;
+            prepare(results, record->connection);
+            session.writer->add(move(results));
+        }
+        for (auto& [key, session] : sessions)
+            session.writer->wait();
+
+        // Сегмент удаляется, когда все его проекты записаны (более поздней записью того же прохода или этой).
+        size_t drained = 0;
+        for (size_t i = 0; i < loaded.size(); i++)
+        {
+            bool complete = all_of(loaded[i].begin(), loaded[i].end(),
+                                   [&](const SpoolRecord& record) { return !failures.count(record.results.project); });
+            if (!complete)
+                continue;
+            if (torn[i] && segments[i].extension() == ".wal")
+                fs::rename(segments[i], fs::path(segments[i]).replace_extension(".damaged"));
+            else
+                fs::remove(segments[i]);
+            drained++;
+        }
+        if (failures.empty())
+        {
+            say("Spool: drained " + to_string(latest.size()) + " projects from " + to_string(drained) + " segments");
+            backoff = chrono::seconds(1);
+            lastProgress = chrono::steady_clock::now();
+            continue;
+        }
+        say("Spool: " + to_string(failures.size()) + " projects not written (" + failures.begin()->first + ": "
+            + failures.begin()->second + "); retrying in " + to_string(backoff.count()) + " s");
+        if (drained > 0)
+            lastProgress = chrono::steady_clock::now();
+        if (chrono::steady_clock::now() - lastProgress > options.giveUpAfter)
+        {
+            say("Spool: giving up; the spool is kept for the next run");
+            return 1;
+        }
+        this_thread::sleep_for(backoff);
+        backoff = min(backoff * 2, options.maxBackoff);
+    }
+}
+
+void startDrainer(const string& program, const string& location, const vector<string>& arguments)
+{
+    const string log = (fs::path(spoolDirectory(location)) / "drainer.log").string();
+    vector<string> command = {program, "--drain", "-l", location};
+    command.insert(command.end(), arguments.begin(), arguments.end());
+#ifdef _WIN32
+    string line;
+    for (const string& argument : command)
+        line += "\"" + argument + "\" ";
+    SECURITY_ATTRIBUTES inherit{sizeof(SECURITY_ATTRIBUTES), nullptr, TRUE};
+    HANDLE output = CreateFileA(log.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE, &inherit,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    STARTUPINFOA startup{};
+    startup.cb = sizeof(startup);
+    startup.dwFlags = STARTF_USESTDHANDLES;
+    startup.hStdOutput = output;
+    startup.hStdError = output;
+    PROCESS_INFORMATION process{};
+    if (CreateProcessA(nullptr, line.data(), nullptr, nullptr, TRUE, DETACHED_PROCESS | CREATE_NEW_PROCESS_GROUP,
+                       nullptr, nullptr, &startup, &process))
+    {
+        CloseHandle(process.hProcess);
+        CloseHandle(process.hThread);
+    }
+    if (output != INVALID_HANDLE_VALUE)
+        CloseHandle(output);
+#else
+    pid_t pid = fork();
+    if (pid != 0)
+        return;
+    // Новый сеанс отделяет процесс выгрузки от терминала и группы процессов Broker.
+    setsid();
+    int output = open(log.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0600);
+    int input = open("/dev/null", O_RDONLY);
+    if (output >= 0)
+    {
+        dup2(output, 1);
+        dup2(output, 2);
+    }
+    if (input >= 0)
+        dup2(input, 0);
+    vector<char*> argv;
+    for (const string& argument : command)
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    argv.push_back(nullptr);
+    execv(program.c_str(), argv.data());
+    _exit(127);
+#endif
+}
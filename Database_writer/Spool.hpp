@@ -0,0 +1,101 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "PgConnection.hpp"
+#include "ResultWriter.hpp"
+
+/// <summary>
+/// Запись журнала: итоги проекта и параметры подключения к его базе данных. Пароль в журнал не записывается.
+/// </summary>
+struct SpoolRecord
+{
+    ConnectionSettings connection;
+    ProjectResults results;
+    /// <summary>
+    /// Отпечаток итогов компиляции в метаданных на момент записи в журнал: флаг writtenToDB устанавливается,
+    /// только если проект с тех пор не перекомпилирован.
+    /// </summary>
+    std::string metadataHash;
+};
+
+/// <summary>
+/// Каталог журнала для расположения проектов: "<расположение>/database_spool".
+/// </summary>
+std::string spoolDirectory(const std::string& location);
+
+/// <summary>
+/// Сегмент журнала, который пишет один процесс. Записи дописываются в файл "<время>-<процесс>.part"
+/// (длина, контрольная сумма XXH64, JSON), commit сбрасывает их на диск одним вызовом fsync
+/// и переименовывает файл в ".wal": только после этого записи видны процессу выгрузки.
+/// Методы append и commit можно вызывать из разных потоков.
+/// </summary>
+class SpoolWriter
+{
+public:
+    /// <exception cref="std::runtime_error">Если файл сегмента не удалось создать.</exception>
+    explicit SpoolWriter(const std::string& directory);
+    ~SpoolWriter();
+    SpoolWriter(const SpoolWriter&) = delete;
+    SpoolWriter& operator=(const SpoolWriter&) = delete;
+
+    void append(const SpoolRecord& record);
+
+    /// <summary>
+    /// Сбрасывает записанное на диск и публикует сегмент; после возврата записи переживают сбой питания.
+    /// </summary>
+    /// <exception cref="std::runtime_error">Если запись или fsync не удались.</exception>
+    void commit();
+
+private:
+    std::mutex access;
+    std::string path;
+    int file = -1;
+    bool committed = false;
+    size_t records = 0;
+};
+
+/// <summary>
+/// Параметры выгрузки журнала в базу данных.
+/// </summary>
+struct DrainOptions
+{
+    unsigned poolSize = 4;
+    unsigned batchSize = 5000;
+    /// <summary>
+    /// Наибольшая пауза между повторными попытками; пауза удваивается после каждой неудачной попытки.
+    /// </summary>
+    std::chrono::seconds maxBackoff{60};
+    /// <summary>
+    /// Выгрузка прекращается, если за это время не записано ни одной записи; журнал остаётся для следующего запуска.
+    /// </summary>
+    std::chrono::seconds giveUpAfter{3600};
+};
+
+/// <summary>
+/// Выгружает журнал в базу данных, пока он не опустеет. Одновременно работает один процесс выгрузки
+/// (блокировка "drainer.lock" с периодическим обновлением); если блокировка занята, функция сразу возвращает 0.
+/// Сегмент удаляется, когда все его записи зафиксированы в базе данных или заменены более поздними записями
+/// того же проекта. При ошибках попытка повторяется с экспоненциально растущей паузой; повторная запись
+/// безопасна благодаря ключу идемпотентности writeId.
+/// </summary>
+/// <param name="password">Возвращает пароль базы данных записи (например, из метаданных проекта, если проект
+/// по-прежнему пишет в эту базу данных); пустое значение — пароль неизвестен.</param>
+/// <param name="prepare">Вызывается для копии итогов каждой записи перед записью в базу данных
+/// (отбор изменившихся полей).</param>
+/// <param name="written">Вызывается для каждой зафиксированной записи (обновление метаданных проекта).</param>
+/// <returns>0, если журнал выгружен; 1, если выгрузка прекращена по giveUpAfter.</returns>
+int drainSpool(const std::string& directory, const DrainOptions& options,
+               const std::function<std::optional<std::string>(const SpoolRecord& record)>& password,
+               const std::function<void(ProjectResults& results, const ConnectionSettings& connection)>& prepare,
+               const std::function<void(const SpoolRecord& record)>& written);
+
+/// <summary>
+/// Запускает процесс выгрузки в фоне ("<program> --drain -l <location> ...") с выводом в "drainer.log" журнала.
+/// Процесс не связан с вызывающим: Broker не ждёт его завершения.
+/// </summary>
+void startDrainer(const std::string& program, const std::string& location, const std::vector<std::string>& arguments);
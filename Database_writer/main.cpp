@@ -0,0 +1,553 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include "ConnectionPool.hpp"
+#include "FileLock.hpp"
+#include "Hash.hpp"
+#include "Parallel.hpp"
+#include "ProjectSettings.hpp"
+#include "ResultWriter.hpp"
+#include "ResultsStore.hpp"
+#include "Spool.hpp"
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+/// <summary>
+/// Читает файл целиком.
+/// </summary>
+static string readFile(const string& path)
+{
+    ifstream file(path, ios::binary);
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+/// <summary>
+/// Сохраняет в метаданных проекта снимок записанных строк и, если written, отмечает, что итоги записаны
+/// в базу данных; остальные разделы не меняются. Метаданные без изменений не перезаписываются.
+/// Процесс выгрузки журнала работает одновременно со следующими этапами Broker, поэтому чтение и запись
+/// выполняются под блокировкой метаданных расположения.
+/// </summary>
+static void markWritten(const string& metadataPath, const DatabaseSnapshot& synced, bool written)
+{
+    common::FileLock lock(common::metadataLockPath(metadataPath));
+    json j = json::parse(readFile(metadataPath));
+    json& database = j["databaseMetadata"];
+    const json snapshot = synced;
+    if (database.value("synced", json()) == snapshot && (!written || database.value("writtenToDB", false)))
+        return;
+    database["synced"] = snapshot;
+    if (written)
+        database["writtenToDB"] = true;
+    string tmp = metadataPath + ".tmp";
+    {
+        ofstream out(tmp, ios::trunc);
+        out << setw(4) << j;
+        if (!out)
+            throw runtime_error("Failed to write " + metadataPath);
+    }
+    fs::rename(tmp, metadataPath);
+}
+
+/// <summary>
+/// Отпечаток итогов компиляции проекта: по нему процесс выгрузки журнала определяет,
+/// не перекомпилирован ли проект после записи итогов в журнал.
+/// </summary>
+static string resultsFingerprint(const ProjectSettings& settings)
+{
+    ostringstream out;
+    out<<hex<<setw(16)<<setfill('0')
+       <<common::hash64(json(settings.quartusMetadata).dump() + "\n" + settings.graphVerilogMetadata.params);
+    return out.str();
+}
+
+/// <summary>
+/// Параметры подключения к базе данных проекта.
+/// </summary>
+static ConnectionSettings connectionSettings(const DatabaseMetadata& database)
+{
+    ConnectionSettings connection;
+    connection.host = database.dbIp;
+    connection.port = database.dbPort > 0 ? database.dbPort : 5432;
+    connection.user = database.dbUsername;
+    connection.password = database.dbPassword;
+    connection.database = database.dbName;
+    return connection;
+}
+
+/// <summary>
+/// Читает итоги проекта и параметры подключения к его базе данных.
+/// </summary>
+/// <param name="incremental">Оставить для записи только отличия от снимка databaseMetadata.synced.</param>
+/// <returns>Пустая строка или причина, по которой итоги проекта нельзя записать.</returns>
+static string readProject(const string& location, const string& name, SpoolRecord& record, bool incremental)
+{
+    ProjectResults& results = record.results;
+    results.project = name;
+    results.metadataPath = (fs::path(location) / (name + "_metadata.json")).string();
+    // Время чтения итогов — ключ идемпотентности: более поздняя запись проекта заменяет более раннюю.
+    results.writeId = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    ProjectSettings settings;
+    try
+    {
+        settings = json::parse(readFile(results.metadataPath)).get<ProjectSettings>();
+    }
+    catch (exception& e)
+    {
+        return "failed to read project metadata: " + results.metadataPath;
+    }
+    const DatabaseMetadata& database = settings.databaseMetadata;
+    if (database.dbIp.empty() || database.dbName.empty())
+        return "no database configured in databaseMetadata";
+    if (!settings.quartusMetadata.quartusCompiled)
+        return "project is not compiled";
+    results.rows = resultRows(name, settings);
+    record.connection = connectionSettings(database);
+    record.metadataHash = resultsFingerprint(settings);
+    if (incremental)
+        diffResults(results, database.synced, record.connection);
+    return "";
+}
+
+/// <summary>
+/// Имена всех проектов расположения (по файлам "<имя>_metadata.json").
+/// </summary>
+static vector<string> allProjects(const string& location)
+{
+    const string suffix = "_metadata.json";
+    vector<string> projects;
+    error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(location, ec))
+    {
+        string file = entry.path().filename().string();
+        if (file.size() > suffix.size() && file.compare(file.size() - suffix.size(), suffix.size(), suffix) == 0)
+            projects.push_back(file.substr(0, file.size() - suffix.size()));
+    }
+    return projects;
+}
+
+/// <summary>
+/// Итог записи проекта для вывода.
+/// </summary>
+static string describeWrite(const ProjectResults& results)
+{
+    if (results.replace)
+        return to_string(results.rows.size()) + " rows written";
+    if (results.changedRows() == 0)
+        return "unchanged";
+    return to_string(results.added.size()) + " rows added, " + to_string(results.changes.size()) + " fields changed, "
+           + to_string(results.removed.size()) + " rows removed";
+}
+
+/// <summary>
+/// Выводит строку целиком: потоки записи сообщают об итогах одновременно.
+/// </summary>
+static void say(const string& text)
+{
+    cout<<(text + "\n")<<flush;
+}
+
+/// <summary>
+/// Проекты, строки которых уже есть в хранилище итогов расположения.
+/// </summary>
+static set<string> storedProjects(const string& location)
+{
+    try
+    {
+        return noc::ResultsTable::load(location).projects();
+    }
+    catch (exception&)
+    {
+        return {};
+    }
+}
+
+/// <summary>
+/// Копит строки записанных проектов для хранилища итогов расположения: изменившиеся проекты
+/// и проекты, которых в хранилище ещё нет (скомпилированные до его появления).
+/// </summary>
+class StoreUpdate
+{
+public:
+    explicit StoreUpdate(const string& location) : location(location), stored(storedProjects(location)) {}
+
+    void add(const ProjectResults& results)
+    {
+        lock_guard<mutex> lock(access);
+        if (!results.replace && results.changedRows() == 0 && stored.count(results.project))
+            return;
+        for (const ResultRow& row : results.rows)
+        {
+            noc::ResultRecord record;
+            record.project = row.project;
+            record.device = row.device;
+            record.params = row.params;
+            record.alms = row.alms;
+            record.almsAvailable = row.almsAvailable;
+            record.registers = row.registers;
+            record.ramBlocks = row.ramBlocks;
+            record.blockMemoryBits = row.blockMemoryBits;
+            record.dspBlocks = row.dspBlocks;
+            record.fmaxMhz = row.fmaxMhz;
+            record.restrictedFmaxMhz = row.restrictedFmaxMhz;
+            record.setupSlackNs = row.setupSlackNs;
+            record.seed = row.seed;
+            record.bitstream = row.bitstream;
+            record.time = results.writeId;
+            records.push_back(move(record));
+        }
+    }
+
+    /// <summary>
+    /// Дописывает накопленные строки одним обращением к хранилищу.
+    /// </summary>
+    void commit()
+    {
+        try
+        {
+            noc::appendResults(location, records);
+        }
+        catch (exception& e)
+        {
+            // Хранилище — производные данные: запись в базу данных из-за него не считается неудачной.
+            say(string("Failed to update the results store: ") + e.what());
+        }
+        records.clear();
+    }
+
+private:
+    string location;
+    set<string> stored;
+    mutex access;
+    vector<noc::ResultRecord> records;
+};
+
+/// <summary>
+/// Путь к исполняемому файлу программы для запуска процесса выгрузки.
+/// </summary>
+static string programPath(const char* argv0)
+{
+    error_code ec;
+    fs::path self = fs::read_symlink("/proc/self/exe", ec);
+    return ec ? fs::absolute(argv0).string() : self.string();
+}
+
+/// <summary>
+/// Пул соединений и конвейер записи для одной базы данных.
+/// </summary>
+struct DatabaseSession
+{
+    unique_ptr<ConnectionPool> pool;
+    unique_ptr<ResultWriter> writer;
+};
+
+/// <summary>
+/// Главная точка входа приложения.
+/// Записывает итоги компиляции проектов (ресурсы, Fmax и запас по устройствам) в таблицу noc_results
+/// базы данных PostgreSQL, указанной в разделе databaseMetadata метаданных проекта.
+/// С опцией --projects за один запуск записываются итоги многих проектов: метаданные читаются параллельно,
+/// проекты одной базы данных пишутся через общий пул соединений (--pool-size) партиями до --batch-size строк,
+/// каждая партия — одной транзакцией с загрузкой строк командой COPY. После фиксации транзакции в метаданных
+/// проекта устанавливается флаг writtenToDB и сохраняется снимок записанных строк (databaseMetadata.synced):
+/// при следующей записи отправляются только новые строки, изменённые поля и удалённые устройства, а проекты
+/// без изменений не требуют обращения к базе данных. Опция --full записывает проекты целиком, опция --all —
+/// все проекты расположения. Записанные итоги дописываются и в хранилище итогов расположения (results_store.bin).
+/// С опцией --spool итоги дописываются в локальный журнал "<расположение>/database_spool" и программа завершается
+/// сразу после fsync, не дожидаясь базы данных; журнал выгружает в базу данных фоновый процесс (--drain),
+/// повторяя попытки с растущей паузой, пока база данных недоступна. Флаг writtenToDB устанавливается после выгрузки.
+/// Для проверки без сервера PostgreSQL — Database_writer/pg_standin/pg_standin.py.
+/// </summary>
+/// <param name="argc">Целое число, содержащее количество аргументов, которые следуют в argv.</param>
+/// <param name="argv">Массив завершающихся null строк, представляющих введенные пользователем программы аргументы командной строки.</param>
+int main(int argc, char *argv[]) {
+    string location; // Расположение проектов.
+    vector<string> names; // Имена проектов (-n и --projects).
+    unsigned jobs = common::defaultJobs(); // Число потоков для чтения метаданных.
+    unsigned pool_size = 4; // Число соединений с каждой базой данных.
+    unsigned batch_size = 0; // Наибольшее число строк в одной транзакции; 0 — 500 при записи, 5000 при выгрузке журнала.
+    bool spool = false; // Записать итоги в журнал и выгрузить их в фоне.
+    bool drain = false; // Выгрузить журнал в базу данных (режим фонового процесса).
+    unsigned drain_timeout = 3600; // Выгрузка прекращается после стольких секунд без успешной записи.
+    bool full = false; // Записать строки проектов целиком, не сравнивая со снимком последней записи.
+    bool all = false; // Записать все проекты расположения.
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "-l"||option == "--location") {
+            if (i < argc - 1)
+            {
+                location = argv[++i]; // Получение значения расположения проекта из следующего аргумента.
+            }
+            else
+            {
+                cout<<("No project location provided");
+                exit(1);
+            }
+        }
+        else if (option == "-n"||option == "--name") {
+            if (i < argc - 1)
+            {
+                names.push_back(argv[++i]); // Получение значения имени проекта из следующего аргумента.
+            }
+            else
+            {
+                cout<<("No project name provided");
+                exit(1);
+            }
+        }
+        else if (option == "--projects") {
+            // Имена проектов идут до следующей опции.
+            while (i < argc - 1 && argv[i + 1][0] != '-')
+                names.push_back(argv[++i]);
+        }
+        else if (option == "-w"||option == "--write") {
+            // Запись — единственное действие программы; опция принимается для совместимости с Broker.
+        }
+        else if (option == "-j"||option == "--jobs") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                jobs = common::parseJobs(argv[++i]); // Получение числа потоков из следующего аргумента.
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid number of jobs");
+                exit(1);
+            }
+        }
+        else if (option == "--all") {
+            all = true;
+        }
+        else if (option == "--full") {
+            full = true;
+        }
+        else if (option == "--spool") {
+            spool = true;
+        }
+        else if (option == "--drain") {
+            drain = true;
+        }
+        else if (option == "--pool-size" || option == "--batch-size" || option == "--drain-timeout") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                size_t pos = 0;
+                string value = argv[++i];
+                long n = stol(value, &pos); // Получение значения из следующего аргумента.
+                if (pos != value.size() || n < 1) throw invalid_argument("invalid count");
+                unsigned& target = option == "--pool-size" ? pool_size : option == "--batch-size" ? batch_size : drain_timeout;
+                target = static_cast<unsigned>(n);
+            }
+            catch (exception& e)
+            {
+                cout<<"Invalid value of "<<option;
+                exit(1);
+            }
+        }
+        else {
+            cout<<"Unknown option: "<<option;
+            exit(1);
+        }
+    }
+    if (all && !location.empty())
+    {
+        vector<string> projects = allProjects(location);
+        names.insert(names.end(), projects.begin(), projects.end());
+    }
+    sort(names.begin(), names.end());
+    names.erase(unique(names.begin(), names.end()), names.end());
+    if (drain && !location.empty())
+    {
+        DrainOptions options;
+        options.poolSize = pool_size;
+        options.batchSize = batch_size == 0 ? options.batchSize : batch_size;
+        options.giveUpAfter = chrono::seconds(drain_timeout);
+        // Отличия вычисляются по снимку в метаданных на момент выгрузки: его обновляет каждая зафиксированная запись.
+        auto prepare = [full](ProjectResults& results, const ConnectionSettings& connection)
+        {
+            if (full)
+                return;
+            try
+            {
+                ProjectSettings settings = json::parse(readFile(results.metadataPath)).get<ProjectSettings>();
+                diffResults(results, settings.databaseMetadata.synced, connection);
+            }
+            catch (exception&)
+            {
+                // Без снимка строки проекта записываются целиком.
+            }
+        };
+        // Пароль записи журнала — из текущих метаданных проекта, если проект по-прежнему пишет в ту же базу данных.
+        auto password = [](const SpoolRecord& record) -> optional<string>
+        {
+            try
+            {
+                ProjectSettings settings = json::parse(readFile(record.results.metadataPath)).get<ProjectSettings>();
+                ConnectionSettings current = connectionSettings(settings.databaseMetadata);
+                if (current.key() == record.connection.key())
+                    return current.password;
+            }
+            catch (exception&)
+            {
+                // Метаданные недоступны: пароль неизвестен.
+            }
+            return nullopt;
+        };
+        // Проект, перекомпилированный после записи итогов в журнал, не отмечается как записанный,
+        // но снимок обновляется: он описывает строки в таблице.
+        StoreUpdate store(location);
+        int code = drainSpool(spoolDirectory(location), options, password, prepare, [&store](const SpoolRecord& record)
+        {
+            store.add(record.results);
+            try
+            {
+                ProjectSettings settings = json::parse(readFile(record.results.metadataPath)).get<ProjectSettings>();
+                markWritten(record.results.metadataPath, resultsSnapshot(record.results, record.connection),
+                            resultsFingerprint(settings) == record.metadataHash);
+            }
+            catch (exception& e)
+            {
+                say(record.results.project + ": written, but failed to update metadata: " + e.what());
+            }
+        });
+        store.commit();
+        exit(code);
+    }
+    if (location.empty() || names.empty())
+    {
+        cout<<("Project location and name are required");
+        exit(1);
+    }
+
+    const auto started = chrono::steady_clock::now();
+    if (spool)
+    {
+        // Итоги подтверждаются после fsync журнала; база данных на этом этапе не нужна.
+        vector<string> problems(names.size());
+        try
+        {
+            SpoolWriter writer(spoolDirectory(location));
+            common::parallelFor(names.size(), jobs, [&](size_t i)
+            {
+                SpoolRecord record;
+                problems[i] = readProject(location, names[i], record, false);
+                if (problems[i].empty())
+                    writer.append(record);
+            });
+            writer.commit();
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to write the database spool: "<<e.what();
+            exit(1);
+        }
+        size_t spooled = 0;
+        for (size_t i = 0; i < names.size(); i++)
+        {
+            say(names[i] + ": " + (problems[i].empty() ? "spooled" : problems[i]));
+            spooled += problems[i].empty();
+        }
+        vector<string> arguments = {"--pool-size", to_string(pool_size), "--drain-timeout", to_string(drain_timeout)};
+        if (batch_size != 0)
+            arguments.insert(arguments.end(), {"--batch-size", to_string(batch_size)});
+        if (full)
+            arguments.push_back("--full");
+        if (spooled > 0)
+            startDrainer(programPath(argv[0]), location, arguments);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        cout<<"Database_writer: "<<spooled<<" of "<<names.size()<<" projects spooled in "<<seconds<<" s"<<endl;
+        if (spooled != names.size())
+            exit(1);
+        return 0;
+    }
+
+    mutex access;
+    map<string, DatabaseSession> sessions; // Сеансы по ключу подключения (ConnectionSettings::key).
+    vector<string> failed;
+    size_t written = 0, unchanged = 0;
+    map<string, ConnectionSettings> connections; // Проект -> подключение для снимка записанных строк.
+    StoreUpdate store(location);
+    auto report = [&](const ProjectResults& results, const string& error)
+    {
+        string problem = error;
+        if (problem.empty())
+        {
+            try
+            {
+                ConnectionSettings connection;
+                {
+                    lock_guard<mutex> lock(access);
+                    connection = connections.at(results.project);
+                }
+                markWritten(results.metadataPath, resultsSnapshot(results, connection), true);
+                store.add(results);
+            }
+            catch (exception& e)
+            {
+                problem = string("written, but failed to update metadata: ") + e.what();
+            }
+        }
+        lock_guard<mutex> lock(access);
+        if (problem.empty())
+        {
+            written++;
+            unchanged += results.changedRows() == 0;
+            say(results.project + ": " + describeWrite(results));
+        }
+        else
+        {
+            failed.push_back(results.project);
+            say(results.project + ": " + problem);
+        }
+    };
+
+    // Чтение метаданных и запись идут одновременно: проект ставится в очередь сразу после чтения.
+    common::parallelFor(names.size(), jobs, [&](size_t i)
+    {
+        SpoolRecord record;
+        string problem = readProject(location, names[i], record, !full);
+        if (!problem.empty())
+        {
+            report(record.results, problem);
+            return;
+        }
+        const ConnectionSettings& connection = record.connection;
+        ResultWriter* writer;
+        {
+            lock_guard<mutex> lock(access);
+            connections[names[i]] = connection;
+            DatabaseSession& session = sessions[connection.key()];
+            if (!session.writer)
+            {
+                session.pool = make_unique<ConnectionPool>(connection, pool_size, ResultWriter::setupConnection);
+                ResultWriterOptions options;
+                options.batchSize = batch_size == 0 ? options.batchSize : batch_size;
+                options.flushers = pool_size;
+                session.writer = make_unique<ResultWriter>(*session.pool, options, report);
+            }
+            writer = session.writer.get();
+        }
+        writer->add(move(record.results));
+    });
+
+    size_t rows = 0, batches = 0;
+    for (auto& [key, session] : sessions)
+    {
+        session.writer->finish();
+        rows += session.writer->rowsWritten();
+        batches += session.writer->batchesWritten();
+    }
+    store.commit();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+    cout<<"Database_writer: "<<written<<" of "<<names.size()<<" projects ("<<unchanged<<" unchanged), "<<rows
+        <<" rows in "<<batches<<" transactions, "<<seconds<<" s"<<endl;
+    if (!failed.empty())
+        exit(1);
+}
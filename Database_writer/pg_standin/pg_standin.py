@@ -0,0 +1,718 @@
+#!/usr/bin/env python3
+# Имитация сервера PostgreSQL для проверки Database_writer без установленной СУБД:
+#   python3 Database_writer/pg_standin/pg_standin.py --port 55432 --auth scram --user noc --password secret
+#
+# Сервер принимает соединения по протоколу PostgreSQL 3.0 (аутентификация trust, password, md5, SCRAM-SHA-256),
+# выполняет простые и подготовленные запросы, COPY ... FROM STDIN и транзакции. SQL не разбирается полностью:
+# понимаются только операторы, которые отправляет Database_writer (CREATE TABLE, ALTER TABLE ... ADD COLUMN,
+# DELETE ... NOT IN (SELECT ...), DELETE ... WHERE EXISTS для временной таблицы, UPDATE ... FROM, DELETE ... USING,
+# INSERT ... SELECT ... ON CONFLICT DO UPDATE, SELECT DISTINCT ... WHERE NOT EXISTS, SELECT столбцов или count(*)
+# с условием равенства).
+# Изменения транзакции применяются к общим таблицам при COMMIT. Временные таблицы свои у каждого соединения.
+# Каждая база данных (параметр database при подключении) имеет собственный набор таблиц.
+#
+# Опции:
+#   --port N       — порт (0 — свободный порт; номер выводится в первой строке);
+#   --auth METHOD  — trust, password, md5 или scram (по умолчанию trust);
+#   --state FILE   — после каждой фиксации таблицы записываются в FILE в формате JSON
+#                    ({база данных: {таблица: строки}});
+#   --latency MS   — задержка перед ответом на каждый запрос (медленная база данных);
+#   --reject NAME  — COPY строки проекта NAME завершается ошибкой 22003 (недопустимое значение одного проекта);
+#   --log          — выводить выполняемые операторы.
+
+import argparse
+import base64
+import hashlib
+import hmac
+import json
+import os
+import re
+import socket
+import socketserver
+import struct
+import threading
+import time
+
+lock = threading.Lock()
+# база данных -> {имя таблицы -> {"columns": [...], "key": [...], "defaults": {...}, "rows": {ключ: {столбец: значение}}}}
+databases = {}
+options = None
+statistics = {"connections": 0, "commits": 0, "statements": 0}
+
+
+class SqlError(Exception):
+    def __init__(self, state, message):
+        super().__init__(message)
+        self.state = state
+
+
+def normalize(sql):
+    return re.sub(r"\s+", " ", sql.strip().rstrip(";")).strip()
+
+
+def split_top_level(text):
+    parts, depth, current = [], 0, ""
+    for c in text:
+        if c == "(":
+            depth += 1
+        elif c == ")":
+            depth -= 1
+        if c == "," and depth == 0:
+            parts.append(current.strip())
+            current = ""
+        else:
+            current += c
+    if current.strip():
+        parts.append(current.strip())
+    return parts
+
+
+def names(text):
+    return [n.strip() for n in text.split(",") if n.strip()]
+
+
+def literal(value):
+    if value is None:
+        return "NULL"
+    return "'" + value.replace("'", "''") + "'"
+
+
+def substitute(sql, parameters):
+    return re.sub(r"\$(\d+)", lambda m: literal(parameters[int(m.group(1)) - 1]), sql)
+
+
+def dump_state():
+    if not options.state:
+        return
+    state = {database: {name: sorted(table["rows"].values(), key=lambda r: [str(r.get(k)) for k in table["key"]])
+                        for name, table in tables.items()}
+             for database, tables in databases.items()}
+    state["_statistics"] = dict(statistics)
+    tmp = options.state + ".tmp"
+    with open(tmp, "w") as out:
+        json.dump(state, out, indent=2, sort_keys=True)
+    os.replace(tmp, options.state)
+
+
+class Session:
+    """Состояние соединения: временные таблицы, подготовленные операторы и текущая транзакция."""
+
+    def __init__(self, database):
+        with lock:
+            self.tables = databases.setdefault(database, {})
+        self.temp = {}
+        self.prepared = {}
+        self.portal = None
+        self.transaction = None  # Список отложенных изменений общих таблиц или None вне транзакции.
+        self.failed = False
+
+    def status(self):
+        if self.transaction is None:
+            return b"I"
+        return b"E" if self.failed else b"T"
+
+    def table(self, name):
+        if name in self.temp:
+            return self.temp[name]
+        if name in self.tables:
+            return self.tables[name]
+        raise SqlError("42P01", 'relation "%s" does not exist' % name)
+
+    def apply(self, change):
+        """Изменение общих таблиц: сразу вне транзакции или при COMMIT."""
+        if self.transaction is None:
+            with lock:
+                change()
+                statistics["commits"] += 1
+                dump_state()
+        else:
+            self.transaction.append(change)
+
+    def end_transaction(self, commit):
+        changes, self.transaction = self.transaction or [], None
+        failed, self.failed = self.failed, False
+        for table in self.temp.values():
+            if table.get("on_commit_delete"):
+                table["rows"].clear()
+        if commit and not failed:
+            with lock:
+                for change in changes:
+                    change()
+                statistics["commits"] += 1
+                dump_state()
+            return "COMMIT"
+        return "ROLLBACK"
+
+    def execute(self, sql):
+        """Выполняет оператор; возвращает (тег завершения, описание столбцов, строки) или ("COPY", таблица, столбцы)."""
+        statistics["statements"] += 1
+        if options.log:
+            print("[%d] %s" % (threading.get_ident() % 10000, sql[:160]), flush=True)
+        if options.latency:
+            time.sleep(options.latency / 1000.0)
+        s = normalize(sql)
+        upper = s.upper()
+        if upper in ("BEGIN", "START TRANSACTION"):
+            if self.transaction is None:
+                self.transaction = []
+            return "BEGIN", None, None
+        if upper in ("COMMIT", "END"):
+            return self.end_transaction(True), None, None
+        if upper in ("ROLLBACK", "ABORT"):
+            return self.end_transaction(False), None, None
+        if self.failed:
+            raise SqlError("25P02", "current transaction is aborted, commands ignored until end of transaction block")
+        if upper.startswith("SET "):
+            return "SET", None, None
+
+        m = re.match(r"CREATE (TEMP |TEMPORARY )?TABLE (IF NOT EXISTS )?(\w+) \((.*)\)( ON COMMIT DELETE ROWS)?$", s, re.I | re.S)
+        if m:
+            temporary, name = bool(m.group(1)), m.group(3)
+            definition = {"columns": [], "key": [], "defaults": {}, "rows": {},
+                          "on_commit_delete": bool(m.group(5))}
+            for part in split_top_level(m.group(4)):
+                pk = re.match(r"PRIMARY KEY \((.*)\)", part, re.I)
+                if pk:
+                    definition["key"] = names(pk.group(1))
+                    continue
+                column = part.split()[0]
+                definition["columns"].append(column)
+                if re.search(r"DEFAULT now\(\)", part, re.I):
+                    definition["defaults"][column] = "now"
+            if not definition["key"]:
+                definition["key"] = list(definition["columns"])
+                definition["heap"] = True
+            target = self.temp if temporary else self.tables
+            if name in target:
+                if not m.group(2):
+                    raise SqlError("42P07", 'relation "%s" already exists' % name)
+                return "CREATE TABLE", None, None
+            if temporary:
+                self.temp[name] = definition
+            else:
+                with lock:
+                    self.tables.setdefault(name, definition)
+            return "CREATE TABLE", None, None
+
+        m = re.match(r"ALTER TABLE (\w+) ADD COLUMN (IF NOT EXISTS )?(\w+) (.*)$", s, re.I)
+        if m:
+            table, column = self.table(m.group(1)), m.group(3)
+            if column in table["columns"]:
+                if not m.group(2):
+                    raise SqlError("42701", 'column "%s" already exists' % column)
+                return "ALTER TABLE", None, None
+            default = re.search(r"DEFAULT (\S+)", m.group(4), re.I)
+            with lock:
+                table["columns"].append(column)
+                for row in table["rows"].values():
+                    row[column] = default.group(1).strip("'") if default else None
+            return "ALTER TABLE", None, None
+
+        m = re.match(r"DELETE FROM (\w+) (\w+) WHERE EXISTS \(SELECT 1 FROM (\w+) (\w+) WHERE "
+                     r"(\w+)\.(\w+) = (\w+)\.(\w+) AND (\w+)\.(\w+) (>=|>|=) (\w+)\.(\w+)\)$", s, re.I)
+        if m:
+            # Коррелированное удаление из временной таблицы по условию на общую таблицу (отбор устаревших строк).
+            target = self.table(m.group(1))
+            if target not in self.temp.values():
+                raise SqlError("0A000", "pg_standin supports correlated DELETE only on temporary tables")
+            alias, other_alias = m.group(2), m.group(4)
+            other = self.table(m.group(3))
+            equal = [(m.group(5), m.group(6)), (m.group(7), m.group(8))]
+            compare = [(m.group(9), m.group(10)), (m.group(12), m.group(13))]
+            operator = m.group(11)
+
+            def value(row, other_row, reference):
+                a, c = reference
+                return (other_row if a == other_alias else row).get(c)
+
+            def number(v):
+                try:
+                    return float(v)
+                except (TypeError, ValueError):
+                    return v
+
+            def matches(row, other_row):
+                if value(row, other_row, equal[0]) != value(row, other_row, equal[1]):
+                    return False
+                left, right = number(value(row, other_row, compare[0])), number(value(row, other_row, compare[1]))
+                if left is None or right is None:
+                    return False
+                return left >= right if operator == ">=" else left > right if operator == ">" else left == right
+
+            with lock:
+                existing = list(other["rows"].values())
+            doomed = [k for k, r in target["rows"].items() if any(matches(r, o) for o in existing)]
+            for k in doomed:
+                del target["rows"][k]
+            return "DELETE %d" % len(doomed), None, None
+
+        m = re.match(r"COPY (\w+) \((.*)\) FROM STDIN$", s, re.I)
+        if m:
+            table = self.table(m.group(1))
+            columns = names(m.group(2))
+            for c in columns:
+                if c not in table["columns"]:
+                    raise SqlError("42703", 'column "%s" does not exist' % c)
+            return "COPY", table, columns
+
+        m = re.match(r"DELETE FROM (\w+) WHERE (\w+) IN \(SELECT (\w+) FROM (\w+)( WHERE \w+)?\) "
+                     r"AND \(([\w, ]+)\) NOT IN \(SELECT ([\w, ]+) FROM (\w+)\)$", s, re.I)
+        if m:
+            target_name, column = m.group(1), m.group(2)
+            self.table(target_name)
+            source = self.table(m.group(4))
+            keep_source = self.table(m.group(8))
+            # Условие подзапроса — логический столбец (значение "t" в строке COPY).
+            flag = m.group(5).split()[1] if m.group(5) else None
+            selected = {r.get(m.group(3)) for r in source["rows"].values() if flag is None or r.get(flag) == "t"}
+            tuple_columns, kept_columns = names(m.group(6)), names(m.group(7))
+            kept = {tuple(r.get(c) for c in kept_columns) for r in keep_source["rows"].values()}
+
+            def change():
+                rows = self.tables[target_name]["rows"]
+                doomed = [k for k, r in rows.items()
+                          if r.get(column) in selected and tuple(r.get(c) for c in tuple_columns) not in kept]
+                for k in doomed:
+                    del rows[k]
+                return len(doomed)
+
+            self.apply(change)
+            return "DELETE 0", None, None
+
+        m = re.match(r"UPDATE (\w+) (\w+) SET (.*?) FROM (\(SELECT DISTINCT ([\w, ]+) FROM (\w+)\)|(\w+)) (\w+) "
+                     r"WHERE (.*)$", s, re.I)
+        if m:
+            # Обновление общей таблицы по строкам временной (UPDATE ... FROM).
+            target_name, alias, other_alias = m.group(1), m.group(2), m.group(8)
+            self.table(target_name)
+            if m.group(5):
+                columns = names(m.group(5))
+                source = [dict(t) for t in {tuple((c, r.get(c)) for c in columns)
+                                            for r in self.table(m.group(6))["rows"].values()}]
+            else:
+                source = [dict(r) for r in self.table(m.group(7))["rows"].values()]
+            assignments = []
+            for part in split_top_level(m.group(3)):
+                column, value = [x.strip() for x in part.split("=", 1)]
+                reference = re.match(r"(\w+)\.(\w+)(::[\w ]+)?$", value)
+                if value.lower() != "now()" and not (reference and reference.group(1) == other_alias):
+                    raise SqlError("0A000", "pg_standin does not support assignment " + value)
+                assignments.append((column, None if value.lower() == "now()" else reference.group(2)))
+            condition = join_condition(m.group(9), alias, other_alias)
+
+            def change():
+                rows = self.tables[target_name]["rows"]
+                now = time.strftime("%Y-%m-%d %H:%M:%S+00", time.gmtime())
+                updated = 0
+                for row in rows.values():
+                    other_row = next((o for o in source if condition(row, o)), None)
+                    if other_row is None:
+                        continue
+                    updated += 1
+                    for column, value in assignments:
+                        row[column] = now if value is None else other_row.get(value)
+                return updated
+
+            self.apply(change)
+            return "UPDATE 0", None, None
+
+        m = re.match(r"DELETE FROM (\w+) (\w+) USING (\w+) (\w+) WHERE (.*)$", s, re.I)
+        if m:
+            target_name, alias, other_alias = m.group(1), m.group(2), m.group(4)
+            self.table(target_name)
+            source = [dict(r) for r in self.table(m.group(3))["rows"].values()]
+            condition = join_condition(m.group(5), alias, other_alias)
+
+            def change():
+                rows = self.tables[target_name]["rows"]
+                doomed = [k for k, r in rows.items() if any(condition(r, o) for o in source)]
+                for k in doomed:
+                    del rows[k]
+                return len(doomed)
+
+            self.apply(change)
+            return "DELETE 0", None, None
+
+        m = re.match(r"INSERT INTO (\w+) \((.*?)\) SELECT (.*?) FROM (\w+) ON CONFLICT \((.*?)\) DO UPDATE SET (.*)$", s, re.I)
+        if m:
+            target_name = m.group(1)
+            target = self.table(target_name)
+            columns, selected = names(m.group(2)), names(m.group(3))
+            source = self.table(m.group(4))
+            conflict = names(m.group(5))
+            assignments = {}
+            for part in split_top_level(m.group(6)):
+                column, value = [x.strip() for x in part.split("=", 1)]
+                if value.lower() != "now()" and not value.upper().startswith("EXCLUDED."):
+                    raise SqlError("0A000", "pg_standin does not support assignment " + value)
+                assignments[column] = value
+            incoming = []
+            for row in source["rows"].values():
+                incoming.append({c: row.get(sc) for c, sc in zip(columns, selected)})
+            if conflict != target["key"]:
+                raise SqlError("42P10", "there is no unique or exclusion constraint matching the ON CONFLICT specification")
+            keys = [tuple(r.get(k) for k in conflict) for r in incoming]
+            if len(set(keys)) != len(keys):
+                raise SqlError("21000", "ON CONFLICT DO UPDATE command cannot affect row a second time")
+
+            def change():
+                rows = self.tables[target_name]["rows"]
+                now = time.strftime("%Y-%m-%d %H:%M:%S+00", time.gmtime())
+                for key, row in zip(keys, incoming):
+                    existing = rows.get(key)
+                    if existing is None:
+                        new = {c: None for c in self.tables[target_name]["columns"]}
+                        for c, d in self.tables[target_name]["defaults"].items():
+                            new[c] = now if d == "now" else d
+                        new.update(row)
+                        rows[key] = new
+                        continue
+                    for column, value in assignments.items():
+                        if value.lower() == "now()":
+                            existing[column] = now
+                        else:
+                            existing[column] = row.get(value.split(".", 1)[1])
+
+            self.apply(change)
+            return "INSERT 0 %d" % len(incoming), None, None
+
+        m = re.match(r"SELECT DISTINCT ([\w., ]+) FROM (\w+) (\w+) WHERE NOT EXISTS "
+                     r"\(SELECT 1 FROM (\w+) (\w+) WHERE (.*)\)$", s, re.I)
+        if m:
+            # Строки временной таблицы без пары в общей (изменения строк, которых нет в таблице).
+            alias, other_alias = m.group(3), m.group(5)
+            source = list(self.table(m.group(2))["rows"].values())
+            with lock:
+                existing = [dict(r) for r in self.table(m.group(4))["rows"].values()]
+            condition = join_condition(m.group(6), other_alias, alias)
+            columns = [c.split(".")[-1] for c in names(m.group(1))]
+            result = []
+            for row in source:
+                values = [row.get(c) for c in columns]
+                if values not in result and not any(condition(o, row) for o in existing):
+                    result.append(values)
+            return "SELECT %d" % len(result), columns, result
+
+        m = re.match(r"SELECT (.*?) FROM (\w+)( WHERE (\w+) = '((?:[^']|'')*)')?( ORDER BY [\w, ]+)?$", s, re.I)
+        if m:
+            table = self.table(m.group(2))
+            rows = list(table["rows"].values())
+            if m.group(3):
+                value = m.group(5).replace("''", "'")
+                rows = [r for r in rows if r.get(m.group(4)) == value]
+            if m.group(1).lower() == "count(*)":
+                return "SELECT 1", ["count"], [[str(len(rows))]]
+            columns = table["columns"] if m.group(1) == "*" else names(m.group(1))
+            return "SELECT %d" % len(rows), columns, [[r.get(c) for c in columns] for r in rows]
+
+        raise SqlError("42601", "pg_standin does not understand: " + s[:120])
+
+
+def comparable(v):
+    try:
+        return float(v)
+    except (TypeError, ValueError):
+        return v
+
+
+def join_condition(text, alias, other_alias):
+    """Условие соединения строк двух таблиц: сравнения "a.x = b.y", "a.x < b.y" и "a.x = 'текст'" через AND."""
+    terms = []
+    for term in re.split(r" AND ", text, flags=re.I):
+        m = re.match(r"(\w+)\.(\w+) (=|<|<=|>|>=) (?:(\w+)\.(\w+)|'((?:[^']|'')*)')$", term.strip())
+        if not m:
+            raise SqlError("0A000", "pg_standin does not support condition " + term)
+        terms.append(m.groups())
+
+    def value(row, other_row, a, c):
+        return (other_row if a == other_alias else row).get(c)
+
+    def condition(row, other_row):
+        for a, c, operator, b, d, text_value in terms:
+            left = value(row, other_row, a, c)
+            right = value(row, other_row, b, d) if b else text_value.replace("''", "'")
+            if left is None or right is None:
+                return False
+            left, right = comparable(left), comparable(right)
+            if not {"=": left == right, "<": left < right, "<=": left <= right,
+                    ">": left > right, ">=": left >= right}[operator]:
+                return False
+        return True
+
+    return condition
+
+
+def unescape_copy(field):
+    if field == "\\N":
+        return None
+    out, i = "", 0
+    while i < len(field):
+        c = field[i]
+        if c == "\\" and i + 1 < len(field):
+            n = field[i + 1]
+            out += {"t": "\t", "n": "\n", "r": "\r", "\\": "\\"}.get(n, n)
+            i += 2
+        else:
+            out += c
+            i += 1
+    return out
+
+
+class Handler(socketserver.BaseRequestHandler):
+    def setup(self):
+        self.buffer = b""
+        self.request.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+
+    def read(self, n):
+        while len(self.buffer) < n:
+            chunk = self.request.recv(65536)
+            if not chunk:
+                raise ConnectionError("client closed")
+            self.buffer += chunk
+        data, self.buffer = self.buffer[:n], self.buffer[n:]
+        return data
+
+    def message(self):
+        header = self.read(5)
+        length = struct.unpack("!I", header[1:])[0]
+        return header[:1], self.read(length - 4)
+
+    def send(self, kind, body=b""):
+        self.request.sendall(kind + struct.pack("!I", len(body) + 4) + body)
+
+    def error(self, state, text, severity="ERROR"):
+        body = b"S" + severity.encode() + b"\0V" + severity.encode() + b"\0C" + state.encode() + b"\0M" + text.encode() + b"\0\0"
+        self.send(b"E", body)
+
+    def authenticate(self, user):
+        method = options.auth
+        if method == "trust":
+            return True
+        if method == "password":
+            self.send(b"R", struct.pack("!I", 3))
+            _, body = self.message()
+            return body.rstrip(b"\0").decode() == options.password
+        if method == "md5":
+            salt = os.urandom(4)
+            self.send(b"R", struct.pack("!I", 5) + salt)
+            _, body = self.message()
+            inner = hashlib.md5((options.password + user).encode()).hexdigest()
+            expected = "md5" + hashlib.md5(inner.encode() + salt).hexdigest()
+            return body.rstrip(b"\0").decode() == expected
+        # SCRAM-SHA-256 (RFC 5802, RFC 7677).
+        self.send(b"R", struct.pack("!I", 10) + b"SCRAM-SHA-256\0\0")
+        _, body = self.message()
+        mechanism, rest = body.split(b"\0", 1)
+        if mechanism != b"SCRAM-SHA-256":
+            return False
+        length = struct.unpack("!i", rest[:4])[0]
+        client_first = rest[4:4 + length].decode()
+        client_first_bare = client_first.split(",", 2)[2]
+        client_nonce = dict(a.split("=", 1) for a in client_first_bare.split(","))["r"]
+        salt, iterations = os.urandom(16), 4096
+        nonce = client_nonce + base64.b64encode(os.urandom(18)).decode()
+        server_first = "r=%s,s=%s,i=%d" % (nonce, base64.b64encode(salt).decode(), iterations)
+        self.send(b"R", struct.pack("!I", 11) + server_first.encode())
+        _, body = self.message()
+        client_final = body.decode()
+        attributes = dict(a.split("=", 1) for a in client_final.split(","))
+        without_proof = client_final[:client_final.rindex(",p=")]
+        if attributes.get("r") != nonce:
+            return False
+        salted = hashlib.pbkdf2_hmac("sha256", options.password.encode(), salt, iterations)
+        client_key = hmac.new(salted, b"Client Key", hashlib.sha256).digest()
+        stored_key = hashlib.sha256(client_key).digest()
+        auth_message = (client_first_bare + "," + server_first + "," + without_proof).encode()
+        signature = hmac.new(stored_key, auth_message, hashlib.sha256).digest()
+        proof = base64.b64decode(attributes["p"])
+        if hashlib.sha256(bytes(a ^ b for a, b in zip(proof, signature))).digest() != stored_key:
+            return False
+        server_key = hmac.new(salted, b"Server Key", hashlib.sha256).digest()
+        verifier = base64.b64encode(hmac.new(server_key, auth_message, hashlib.sha256).digest())
+        self.send(b"R", struct.pack("!I", 12) + b"v=" + verifier)
+        return True
+
+    def startup(self):
+        while True:
+            length = struct.unpack("!I", self.read(4))[0]
+            body = self.read(length - 4)
+            code = struct.unpack("!I", body[:4])[0]
+            if code in (80877103, 80877104):  # SSLRequest, GSSENCRequest: шифрование не поддерживается.
+                self.request.sendall(b"N")
+                continue
+            if code != 196608:
+                return None
+            items = body[4:].split(b"\0")
+            parameters = dict(zip(items[0::2], items[1::2]))
+            return {k.decode(): v.decode() for k, v in parameters.items() if k}
+
+    def row_description(self, columns):
+        body = struct.pack("!H", len(columns))
+        for c in columns:
+            body += c.encode() + b"\0" + struct.pack("!IHIhih", 0, 0, 25, -1, -1, 0)
+        self.send(b"T", body)
+
+    def data_rows(self, rows):
+        for row in rows:
+            body = struct.pack("!H", len(row))
+            for value in row:
+                if value is None:
+                    body += struct.pack("!i", -1)
+                else:
+                    encoded = str(value).encode()
+                    body += struct.pack("!i", len(encoded)) + encoded
+            self.send(b"D", body)
+
+    def copy_in(self, session, table, columns):
+        self.send(b"G", b"\0" + struct.pack("!H", len(columns)) + b"\0\0" * len(columns))
+        data = b""
+        while True:
+            kind, body = self.message()
+            if kind == b"d":
+                data += body
+            elif kind == b"c":
+                break
+            elif kind == b"f":
+                raise SqlError("57014", "COPY from stdin failed: " + body.rstrip(b"\0").decode())
+        count = 0
+        for line in data.decode().split("\n"):
+            if not line or line == "\\.":
+                continue
+            fields = [unescape_copy(f) for f in line.split("\t")]
+            if len(fields) != len(columns):
+                raise SqlError("22P04", "extra or missing data for columns")
+            row = {c: None for c in table["columns"]}
+            row.update(zip(columns, fields))
+            if options.reject and row.get("project") == options.reject:
+                raise SqlError("22003", 'numeric field overflow in row of project "%s"' % options.reject)
+            key = tuple(row.get(k) for k in table["key"]) if not table.get("heap") else (len(table["rows"]),)
+            table["rows"][key] = row
+            count += 1
+        return "COPY %d" % count
+
+    def handle(self):
+        try:
+            parameters = self.startup()
+            if parameters is None:
+                return
+            user = parameters.get("user", "")
+            if options.user and user != options.user or not self.authenticate(user):
+                self.error("28P01", 'password authentication failed for user "%s"' % user, "FATAL")
+                return
+            self.send(b"R", struct.pack("!I", 0))
+            for key, value in (("server_version", "16.0 (pg_standin)"), ("client_encoding", "UTF8"),
+                               ("standard_conforming_strings", "on")):
+                self.send(b"S", key.encode() + b"\0" + value.encode() + b"\0")
+            self.send(b"K", struct.pack("!II", os.getpid(), threading.get_ident() & 0x7fffffff))
+            with lock:
+                statistics["connections"] += 1
+            session = Session(parameters.get("database", user))
+            self.send(b"Z", session.status())
+            self.serve(session)
+        except ConnectionError:
+            pass
+
+    def run(self, session, sql):
+        tag, columns, rows = session.execute(sql)
+        if tag == "COPY":
+            # Для COPY execute возвращает таблицу и список загружаемых столбцов.
+            tag = self.copy_in(session, columns, rows)
+            columns = rows = None
+        if columns is not None:
+            self.row_description(columns)
+            self.data_rows(rows)
+        self.send(b"C", tag.encode() + b"\0")
+
+    def fail(self, session, e):
+        if session.transaction is not None:
+            session.failed = True
+        self.error(e.state, str(e))
+
+    def serve(self, session):
+        skipping = False  # После ошибки в расширенном протоколе сообщения пропускаются до Sync.
+        while True:
+            kind, body = self.message()
+            if kind == b"X":
+                return
+            if kind == b"Q":
+                try:
+                    for statement in [s for s in body.rstrip(b"\0").decode().split(";") if s.strip()]:
+                        self.run(session, statement)
+                except SqlError as e:
+                    self.fail(session, e)
+                self.send(b"Z", session.status())
+                continue
+            if kind == b"S":
+                skipping = False
+                self.send(b"Z", session.status())
+                continue
+            if kind == b"H" or skipping:
+                continue
+            try:
+                if kind == b"P":
+                    name, rest = body.split(b"\0", 1)
+                    query = rest.split(b"\0", 1)[0].decode()
+                    session.prepared[name.decode()] = query
+                    self.send(b"1")
+                elif kind == b"B":
+                    portal, rest = body.split(b"\0", 1)
+                    name, rest = rest.split(b"\0", 1)
+                    offset = 0
+                    formats = struct.unpack("!H", rest[offset:offset + 2])[0]
+                    offset += 2 + 2 * formats
+                    count = struct.unpack("!H", rest[offset:offset + 2])[0]
+                    offset += 2
+                    values = []
+                    for _ in range(count):
+                        length = struct.unpack("!i", rest[offset:offset + 4])[0]
+                        offset += 4
+                        if length < 0:
+                            values.append(None)
+                        else:
+                            values.append(rest[offset:offset + length].decode())
+                            offset += length
+                    if name.decode() not in session.prepared:
+                        raise SqlError("26000", 'prepared statement "%s" does not exist' % name.decode())
+                    session.portal = substitute(session.prepared[name.decode()], values)
+                    self.send(b"2")
+                elif kind == b"D":
+                    if body[:1] == b"S":
+                        self.send(b"t", struct.pack("!H", 0))
+                    self.send(b"n")
+                elif kind == b"E":
+                    self.run(session, session.portal)
+                elif kind == b"C":
+                    self.send(b"3")
+            except SqlError as e:
+                self.fail(session, e)
+                skipping = True
+
+
+class Server(socketserver.ThreadingTCPServer):
+    allow_reuse_address = True
+    daemon_threads = True
+
+
+def main():
+    global options
+    parser = argparse.ArgumentParser(description="PostgreSQL wire-protocol stand-in for Database_writer")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=55432)
+    parser.add_argument("--auth", choices=["trust", "password", "md5", "scram"], default="trust")
+    parser.add_argument("--user", default="")
+    parser.add_argument("--password", default="")
+    parser.add_argument("--state")
+    parser.add_argument("--latency", type=float, default=0)
+    parser.add_argument("--reject")
+    parser.add_argument("--log", action="store_true")
+    options = parser.parse_args()
+    server = Server((options.host, options.port), Handler)
+    print("pg_standin listening on %s:%d (%s)" % (options.host, server.server_address[1], options.auth), flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
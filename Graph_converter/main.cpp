@@ -0,0 +1,81 @@
+/**
+ * @file main.cpp
+ * @brief Graph_converter — преобразование графа проекта между JSON и двоичным форматом.
+ *
+ * Пример запуска:
+ * @code
+ * Graph_converter -l ./projects -n MyProject --to-binary   # _graph_object_serialized.json -> _graph_object.bin
+ * Graph_converter -l ./projects -n MyProject --to-json     # _graph_object.bin -> _graph_object_serialized.json
+ * @endcode
+ *
+ * Результат сначала пишется во временный файл и затем переименовывается,
+ * поэтому прерванное преобразование не оставляет повреждённый файл.
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "GraphBinary.hpp"
+#include "GraphJson.hpp"
+
+namespace fs = std::filesystem;
+
+/**
+ * @brief Записывает файл через временный файл рядом с ним.
+ */
+template <class Write>
+void writeAtomically(const std::string& path, Write&& write) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) throw std::runtime_error("Failed to create " + tmp);
+        write(out);
+        out.close();
+        if (!out) throw std::runtime_error("Failed to write " + tmp);
+    }
+    fs::rename(tmp, path);
+}
+
+int main(int argc, char* argv[]) {
+    std::string location, name, direction;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if ((arg == "-l" || arg == "--location") && i + 1 < argc) location = argv[++i];
+        else if ((arg == "-n" || arg == "--name") && i + 1 < argc) name = argv[++i];
+        else if (arg == "--to-binary" || arg == "--to-json") direction = arg;
+        else {
+            std::cerr << "Invalid argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (location.empty() || name.empty() || direction.empty()) {
+        std::cerr << "Usage: Graph_converter -l <location> -n <name> --to-binary|--to-json" << std::endl;
+        return 1;
+    }
+
+    const std::string jsonPath = location + "/" + name + "_graph_object_serialized.json";
+    const std::string binaryPath = location + "/" + name + "_graph_object.bin";
+    try {
+        if (direction == "--to-binary") {
+            std::ifstream in(jsonPath, std::ios::binary);
+            if (!in) throw std::runtime_error("Failed to open " + jsonPath);
+            noc::Graph graph = noc::readGraphJson(in);
+            writeAtomically(binaryPath, [&](std::ostream& out) { noc::writeGraphBinary(graph, out); });
+            std::cout << "Converted " << graph.nodeCount() << " nodes, " << graph.edgeCount() << " edges to " << binaryPath << "\n";
+        }
+        else {
+            noc::GraphView view = noc::GraphView::open(binaryPath);
+            view.verify();
+            noc::Graph graph = view.toGraph();
+            writeAtomically(jsonPath, [&](std::ostream& out) { noc::writeGraphJson(graph, out); });
+            std::cout << "Converted " << graph.nodeCount() << " nodes, " << graph.edgeCount() << " edges to " << jsonPath << "\n";
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Graph conversion failed: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,164 @@
+#include "ArtifactStore.hpp"
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include "DirectoryReader.hpp"
+#include "Hash.hpp"
+#include "Parallel.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const string artifactStoreDirectoryName = ".cas";
+
+namespace {
+
+string readBytes(const fs::path& path)
+{
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open())
+        throw runtime_error("Failed to open " + path.string());
+    streamsize size = file.tellg();
+    string content(static_cast<size_t>(size), '\0');
+    file.seekg(0);
+    if (!file.read(content.data(), size))
+        throw runtime_error("Failed to read " + path.string());
+    return content;
+}
+
+/// <summary>
+/// Снимает права на запись: объект разделяется несколькими проектами и не должен изменяться на месте.
+/// </summary>
+void makeReadOnly(const fs::path& path)
+{
+    fs::permissions(path, fs::perms::owner_write | fs::perms::group_write | fs::perms::others_write, fs::perm_options::remove);
+}
+
+/// <summary>
+/// Атомарно заменяет файл жёсткой ссылкой на объект: ссылка создаётся под временным именем и переименовывается поверх файла.
+/// </summary>
+void replaceWithLink(const fs::path& object, const fs::path& file)
+{
+    fs::path temporary = file;
+    temporary += ".cas-tmp";
+    fs::remove(temporary);
+    fs::create_hard_link(object, temporary);
+    fs::rename(temporary, file);
+}
+
+/// <summary>
+/// Результат помещения одного файла в хранилище.
+/// </summary>
+enum class StoreResult
+{
+    AlreadyLinked,
+    Linked,
+    Stored
+};
+
+StoreResult storeFile(const fs::path& objects, const fs::path& file, const string& content)
+{
+    string hex = common::toHex(common::hash64(content));
+    fs::path directory = objects / hex.substr(0, 2);
+    error_code ec;
+    fs::create_directories(directory, ec);
+
+    // При коллизии хеша с другим содержимым объект получает суффикс "-1", "-2" и т.д.
+    for (int n = 0;;)
+    {
+        fs::path object = directory / (n == 0 ? hex.substr(2) : hex.substr(2) + "-" + to_string(n));
+        if (fs::equivalent(file, object, ec))
+            return StoreResult::AlreadyLinked;
+        if (!fs::exists(object))
+        {
+            fs::create_hard_link(file, object, ec);
+            if (!ec)
+            {
+                makeReadOnly(object);
+                return StoreResult::Stored;
+            }
+            if (!fs::exists(object))
+                throw runtime_error("Failed to store " + file.string() + ": " + ec.message());
+            // Объект только что создан другим потоком — сравниваем с ним на следующей итерации.
+            continue;
+        }
+        if (readBytes(object) == content)
+        {
+            replaceWithLink(object, file);
+            return StoreResult::Linked;
+        }
+        ++n;
+    }
+}
+
+}
+
+DedupStats deduplicateProject(const string& location, const string& name, unsigned jobs)
+{
+    DedupStats stats;
+    string root = location + "/" + name + "_NoC_description";
+    if (!fs::exists(root))
+        return stats;
+
+    fs::path objects = fs::path(location) / artifactStoreDirectoryName / "objects";
+    fs::create_directories(objects);
+
+    DirectoryTree tree = readDirectoryTree(root);
+    vector<fs::path> files;
+    for (const DirectoryTree::Entry& entry : tree.entries)
+    {
+        if (entry.type == DirectoryEntryType::File)
+            files.push_back(fs::path(tree.directoryPath(root, entry.directory)) / entry.name);
+    }
+
+    atomic<size_t> linked{0}, stored{0};
+    atomic<uintmax_t> bytesSaved{0};
+    common::parallelFor(files.size(), jobs, [&](size_t i) {
+        string content = readBytes(files[i]);
+        if (content.empty())
+            return;
+        switch (storeFile(objects, files[i], content))
+        {
+        case StoreResult::Linked:
+            ++linked;
+            bytesSaved += content.size();
+            break;
+        case StoreResult::Stored:
+            ++stored;
+            break;
+        case StoreResult::AlreadyLinked:
+            break;
+        }
+    });
+
+    stats.files = files.size();
+    stats.linked = linked;
+    stats.stored = stored;
+    stats.bytesSaved = bytesSaved;
+    return stats;
+}
+
+size_t pruneArtifactStore(const string& location, unsigned jobs)
+{
+    string objects = location + "/" + artifactStoreDirectoryName + "/objects";
+    if (!fs::exists(objects))
+        return 0;
+
+    DirectoryTree tree = readDirectoryTree(objects);
+    atomic<size_t> removed{0};
+    common::parallelFor(tree.entries.size(), jobs, [&](size_t i) {
+        const DirectoryTree::Entry& entry = tree.entries[i];
+        fs::path object = fs::path(tree.directoryPath(objects, entry.directory)) / entry.name;
+        // Единственная оставшаяся ссылка — сам объект хранилища: ни один проект на него больше не ссылается.
+        if (entry.type == DirectoryEntryType::File && fs::hard_link_count(object) == 1)
+        {
+            fs::permissions(object, fs::perms::owner_write, fs::perm_options::add);
+            fs::remove(object);
+            ++removed;
+        }
+    });
+    return removed;
+}
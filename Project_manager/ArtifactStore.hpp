@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/// <summary>
+/// Имя каталога хранилища, адресуемого по содержимому, внутри расположения проектов.
+/// </summary>
+extern const std::string artifactStoreDirectoryName;
+
+/// <summary>
+/// Результат дедупликации.
+/// </summary>
+struct DedupStats
+{
+    /// <summary>
+    /// Число просмотренных файлов.
+    /// </summary>
+    size_t files = 0;
+    /// <summary>
+    /// Число файлов, заменённых ссылкой на уже существующий объект хранилища.
+    /// </summary>
+    size_t linked = 0;
+    /// <summary>
+    /// Число файлов, ставших новыми объектами хранилища.
+    /// </summary>
+    size_t stored = 0;
+    /// <summary>
+    /// Объём данных, который больше не хранится повторно.
+    /// </summary>
+    uintmax_t bytesSaved = 0;
+};
+
+/// <summary>
+/// Переносит файлы каталога Verilog-описания проекта в хранилище расположения ".cas".
+/// Каждый файл хранится один раз в ".cas/objects/<xx>/<хеш>" (XXH64 содержимого, совпадение проверяется побайтно),
+/// а в проекте заменяется жёсткой ссылкой на объект. Число ссылок на объект хранится файловой системой,
+/// поэтому переименование проекта ничего не меняет, а удаление проекта уменьшает счётчик ссылок.
+/// Объекты делаются доступными только для чтения: инструменты должны заменять такие файлы, а не изменять их на месте.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="name">Имя проекта.</param>
+/// <param name="jobs">Число потоков хеширования.</param>
+DedupStats deduplicateProject(const std::string& location, const std::string& name, unsigned jobs);
+
+/// <summary>
+/// Удаляет объекты хранилища, на которые больше не ссылается ни один проект (число жёстких ссылок равно 1).
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="jobs">Число потоков.</param>
+/// <returns>Число удалённых объектов.</returns>
+size_t pruneArtifactStore(const std::string& location, unsigned jobs);
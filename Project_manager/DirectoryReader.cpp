@@ -0,0 +1,110 @@
+#include "DirectoryReader.hpp"
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace std;
+
+void readDirectory(const string& path, const function<void(const char*, size_t, DirectoryEntryType)>& visit)
+{
+#ifdef __linux__
+    int fd = open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        throw runtime_error("Failed to open directory: " + path);
+    // Большой буфер позволяет прочитать каталог с тысячами элементов за несколько системных вызовов.
+    vector<char> buffer(1 << 20);
+    for (;;)
+    {
+        long bytes = syscall(SYS_getdents64, fd, buffer.data(), buffer.size());
+        if (bytes < 0)
+        {
+            close(fd);
+            throw runtime_error("Failed to read directory: " + path);
+        }
+        if (bytes == 0) break;
+        for (long offset = 0; offset < bytes;)
+        {
+            // Разметка linux_dirent64: d_ino(8), d_off(8), d_reclen(2), d_type(1), d_name.
+            const char* entry = buffer.data() + offset;
+            unsigned short recordLength;
+            memcpy(&recordLength, entry + 16, sizeof(recordLength));
+            unsigned char type = static_cast<unsigned char>(entry[18]);
+            const char* name = entry + 19;
+            offset += recordLength;
+
+            size_t length = strlen(name);
+            if ((length == 1 && name[0] == '.') || (length == 2 && name[0] == '.' && name[1] == '.'))
+                continue;
+            if (type == DT_UNKNOWN)
+            {
+                struct stat st;
+                if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0)
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG : DT_LNK;
+            }
+            DirectoryEntryType kind = type == DT_DIR ? DirectoryEntryType::Directory
+                                    : type == DT_REG ? DirectoryEntryType::File
+                                    : DirectoryEntryType::Other;
+            visit(name, length, kind);
+        }
+    }
+    close(fd);
+#else
+    error_code ec;
+    filesystem::directory_iterator it(path, ec);
+    if (ec)
+        throw runtime_error("Failed to open directory: " + path);
+    for (const auto& entry : it)
+    {
+        string name = entry.path().filename().string();
+        DirectoryEntryType kind = entry.is_symlink() ? DirectoryEntryType::Other
+                                : entry.is_directory() ? DirectoryEntryType::Directory
+                                : entry.is_regular_file() ? DirectoryEntryType::File
+                                : DirectoryEntryType::Other;
+        visit(name.data(), name.size(), kind);
+    }
+#endif
+}
+
+namespace {
+
+void gatherTree(const string& root, size_t index, DirectoryTree& tree)
+{
+    string path = tree.directoryPath(root, index);
+    vector<string> subdirectories;
+    readDirectory(path, [&](const char* name, size_t length, DirectoryEntryType type) {
+        if (type == DirectoryEntryType::Directory)
+            subdirectories.emplace_back(name, length);
+        else
+            tree.entries.push_back({index, string(name, length), type});
+    });
+    string prefix = tree.directories[index].empty() ? "" : tree.directories[index] + "/";
+    for (const string& subdirectory : subdirectories)
+    {
+        tree.directories.push_back(prefix + subdirectory);
+        gatherTree(root, tree.directories.size() - 1, tree);
+    }
+}
+
+}
+
+string DirectoryTree::directoryPath(const string& root, size_t index) const
+{
+    return directories[index].empty() ? root : root + "/" + directories[index];
+}
+
+DirectoryTree readDirectoryTree(const string& root)
+{
+    DirectoryTree tree;
+    tree.directories.push_back("");
+    gatherTree(root, 0, tree);
+    return tree;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Тип элемента каталога, определённый без перехода по символическим ссылкам.
+/// </summary>
+enum class DirectoryEntryType
+{
+    File,
+    Directory,
+    Other
+};
+
+/// <summary>
+/// Перечисляет элементы каталога (кроме "." и "..").
+/// На Linux каталог читается пачками через getdents64 в буфер размером 1 МБ, тип берётся из d_type
+/// (при DT_UNKNOWN — через fstatat без перехода по ссылкам); на остальных платформах используется std::filesystem.
+/// Символические ссылки на каталоги возвращаются как Other, поэтому обход по ним не уходит за пределы дерева.
+/// </summary>
+/// <param name="path">Путь к каталогу.</param>
+/// <param name="visit">Обработчик, получающий имя элемента, его длину и тип.</param>
+/// <exception cref="std::runtime_error">Если каталог не удалось открыть или прочитать.</exception>
+void readDirectory(const std::string& path, const std::function<void(const char* name, size_t length, DirectoryEntryType type)>& visit);
+
+/// <summary>
+/// Плоское представление дерева каталогов, собранное за один обход.
+/// </summary>
+struct DirectoryTree
+{
+    /// <summary>
+    /// Элемент дерева, не являющийся каталогом.
+    /// </summary>
+    struct Entry
+    {
+        size_t directory;        // Индекс каталога в directories.
+        std::string name;        // Имя элемента внутри каталога.
+        DirectoryEntryType type; // File или Other.
+    };
+
+    /// <summary>
+    /// Пути каталогов относительно корня в прямом порядке обхода; корень — пустая строка с индексом 0.
+    /// Родитель всегда идёт раньше своих потомков.
+    /// </summary>
+    std::vector<std::string> directories;
+    /// <summary>
+    /// Файлы и прочие элементы; элементы одного каталога идут подряд.
+    /// </summary>
+    std::vector<Entry> entries;
+
+    /// <summary>
+    /// Возвращает полный путь каталога с индексом index относительно root.
+    /// </summary>
+    std::string directoryPath(const std::string& root, size_t index) const;
+};
+
+/// <summary>
+/// Обходит дерево каталогов с корнем root, не переходя по символическим ссылкам.
+/// </summary>
+/// <param name="root">Путь к корню дерева.</param>
+/// <exception cref="std::runtime_error">Если какой-либо каталог не удалось прочитать.</exception>
+DirectoryTree readDirectoryTree(const std::string& root);
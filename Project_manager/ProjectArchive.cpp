@@ -0,0 +1,573 @@
+#include "ProjectArchive.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include <zlib.h>
+#include "DirectoryReader.hpp"
+#include "Hash.hpp"
+#include "Parallel.hpp"
+#include "ProjectScanner.hpp"
+#include "ProjectStorage.hpp"
+
+using namespace std;
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+namespace {
+
+/// <summary>
+/// Сигнатура в начале и в конце архива.
+/// </summary>
+const char archiveMagic[8] = {'N', 'O', 'C', 'P', 'A', 'C', 'K', '1'};
+
+/// <summary>
+/// Размер хвоста архива: смещение индекса, число записей и сигнатура.
+/// </summary>
+const size_t trailerSize = 8 + 8 + sizeof(archiveMagic);
+
+/// <summary>
+/// Максимальный исходный объём файлов, сжимаемых в памяти одновременно.
+/// </summary>
+const uintmax_t windowBytes = uintmax_t(256) << 20;
+
+/// <summary>
+/// Размер порции при потоковой распаковке.
+/// </summary>
+const size_t chunkSize = 256 << 10;
+
+enum class EntryType : uint8_t
+{
+    File = 0,
+    Directory = 1,
+    Symlink = 2
+};
+
+/// <summary>
+/// Запись индекса архива. Путь хранится без имени проекта ("_NoC_description/router_0.v"),
+/// поэтому архив остаётся корректным после переименования или клонирования проекта.
+/// </summary>
+struct ArchiveEntry
+{
+    string path;
+    EntryType type = EntryType::File;
+    uint32_t permissions = 0;
+    uint64_t offset = 0;
+    uint64_t packedSize = 0;
+    uint64_t size = 0;
+};
+
+template <class T>
+void put(string& out, T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <class T>
+T take(const char*& p, const char* end)
+{
+    if (end - p < static_cast<ptrdiff_t>(sizeof(T)))
+        throw runtime_error("Corrupted archive index");
+    T value;
+    memcpy(&value, p, sizeof(T));
+    p += sizeof(T);
+    return value;
+}
+
+string readBytes(const fs::path& path)
+{
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open())
+        throw runtime_error("Failed to open " + path.string());
+    streamsize size = file.tellg();
+    string content(static_cast<size_t>(size), '\0');
+    file.seekg(0);
+    if (!file.read(content.data(), size))
+        throw runtime_error("Failed to read " + path.string());
+    return content;
+}
+
+string deflateBytes(const string& input)
+{
+    z_stream zs{};
+    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK)
+        throw runtime_error("deflateInit failed");
+    string output;
+    vector<char> buffer(chunkSize);
+    size_t consumed = 0;
+    int ret;
+    do
+    {
+        // avail_in — 32-битное поле, поэтому большие файлы подаются порциями.
+        if (zs.avail_in == 0 && consumed < input.size())
+        {
+            size_t portion = min<size_t>(input.size() - consumed, 1u << 30);
+            zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data() + consumed));
+            zs.avail_in = static_cast<uInt>(portion);
+            consumed += portion;
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(buffer.data());
+        zs.avail_out = static_cast<uInt>(buffer.size());
+        ret = deflate(&zs, consumed == input.size() ? Z_FINISH : Z_NO_FLUSH);
+        if (ret == Z_STREAM_ERROR)
+        {
+            deflateEnd(&zs);
+            throw runtime_error("deflate failed");
+        }
+        output.append(buffer.data(), buffer.size() - zs.avail_out);
+    } while (ret != Z_STREAM_END);
+    deflateEnd(&zs);
+    return output;
+}
+
+/// <summary>
+/// Потоково распаковывает packedSize байт из input в output порциями chunkSize.
+/// </summary>
+uint64_t inflateStream(istream& input, uint64_t packedSize, ostream& output)
+{
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK)
+        throw runtime_error("inflateInit failed");
+    vector<char> in(chunkSize), out(chunkSize);
+    uint64_t remaining = packedSize, produced = 0;
+    int ret = Z_OK;
+    while (ret != Z_STREAM_END)
+    {
+        if (zs.avail_in == 0)
+        {
+            if (remaining == 0)
+                break;
+            size_t portion = static_cast<size_t>(min<uint64_t>(remaining, in.size()));
+            if (!input.read(in.data(), portion))
+                break;
+            remaining -= portion;
+            zs.next_in = reinterpret_cast<Bytef*>(in.data());
+            zs.avail_in = static_cast<uInt>(portion);
+        }
+        zs.next_out = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = static_cast<uInt>(out.size());
+        ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            break;
+        size_t bytes = out.size() - zs.avail_out;
+        output.write(out.data(), bytes);
+        produced += bytes;
+    }
+    inflateEnd(&zs);
+    if (ret != Z_STREAM_END)
+        throw runtime_error("Corrupted archive data");
+    return produced;
+}
+
+/// <summary>
+/// Собирает записи архива для всех существующих артефактов проекта: сначала каталоги, затем файлы.
+/// </summary>
+vector<ArchiveEntry> collectEntries(const string& location, const string& name)
+{
+    vector<ArchiveEntry> directories, files;
+    auto addFile = [&](const fs::path& path, const string& relative) {
+        fs::file_status status = fs::symlink_status(path);
+        ArchiveEntry entry;
+        entry.path = relative;
+        entry.permissions = static_cast<uint32_t>(status.permissions());
+        if (fs::is_symlink(status))
+        {
+            entry.type = EntryType::Symlink;
+            entry.size = fs::read_symlink(path).string().size();
+        }
+        else if (fs::is_regular_file(status))
+        {
+            entry.size = fs::file_size(path);
+        }
+        else
+        {
+            return;
+        }
+        files.push_back(entry);
+    };
+
+    for (const string& suffix : projectArtifactSuffixes)
+    {
+        if (suffix == archiveSuffix)
+            continue;
+        fs::path root = location + "/" + name + suffix;
+        fs::file_status status = fs::symlink_status(root);
+        if (!fs::exists(status))
+            continue;
+        if (!fs::is_directory(status))
+        {
+            addFile(root, suffix);
+            continue;
+        }
+        DirectoryTree tree = readDirectoryTree(root.string());
+        for (size_t i = 0; i < tree.directories.size(); ++i)
+        {
+            ArchiveEntry entry;
+            entry.path = tree.directories[i].empty() ? suffix : suffix + "/" + tree.directories[i];
+            entry.type = EntryType::Directory;
+            entry.permissions = static_cast<uint32_t>(fs::status(tree.directoryPath(root.string(), i)).permissions());
+            directories.push_back(entry);
+        }
+        for (const DirectoryTree::Entry& item : tree.entries)
+        {
+            string relative = tree.directories[item.directory].empty() ? suffix : suffix + "/" + tree.directories[item.directory];
+            addFile(fs::path(tree.directoryPath(root.string(), item.directory)) / item.name, relative + "/" + item.name);
+        }
+    }
+    directories.insert(directories.end(), files.begin(), files.end());
+    return directories;
+}
+
+/// <summary>
+/// Совпадает ли существующий файл или символическая ссылка с записью архива (размер, затем хеш содержимого).
+/// </summary>
+bool matchesEntry(const fs::path& path, const ArchiveEntry& entry, const string& archivePath)
+{
+    fs::file_status status = fs::symlink_status(path);
+    string existing;
+    if (entry.type == EntryType::Symlink)
+    {
+        if (!fs::is_symlink(status))
+            return false;
+        existing = fs::read_symlink(path).string();
+    }
+    else
+    {
+        if (!fs::is_regular_file(status) || fs::file_size(path) != entry.size)
+            return false;
+        existing = readBytes(path);
+    }
+    if (existing.size() != entry.size)
+        return false;
+    ifstream archive(archivePath, ios::binary);
+    archive.seekg(static_cast<streamoff>(entry.offset));
+    ostringstream packed;
+    inflateStream(archive, entry.packedSize, packed);
+    return common::hash64(packed.str()) == common::hash64(existing);
+}
+
+/// <summary>
+/// Есть ли в пути компонент "..": имена вроде "a..b.v" допустимы.
+/// </summary>
+bool hasParentComponent(const string& path)
+{
+    size_t start = 0;
+    while (start <= path.size())
+    {
+        size_t end = path.find_first_of("/\\", start);
+        if (end == string::npos)
+            end = path.size();
+        if (path.compare(start, end - start, "..") == 0)
+            return true;
+        start = end + 1;
+    }
+    return false;
+}
+
+vector<ArchiveEntry> readIndex(ifstream& archive, const string& path)
+{
+    archive.seekg(0, ios::end);
+    uint64_t fileSize = static_cast<uint64_t>(archive.tellg());
+    if (fileSize < sizeof(archiveMagic) + trailerSize)
+        throw runtime_error("Not an archive: " + path);
+
+    string trailer(trailerSize, '\0');
+    archive.seekg(static_cast<streamoff>(fileSize - trailerSize));
+    archive.read(trailer.data(), trailerSize);
+    if (memcmp(trailer.data() + 16, archiveMagic, sizeof(archiveMagic)) != 0)
+        throw runtime_error("Not an archive: " + path);
+    const char* p = trailer.data();
+    uint64_t indexOffset = take<uint64_t>(p, trailer.data() + trailer.size());
+    uint64_t count = take<uint64_t>(p, trailer.data() + trailer.size());
+    if (indexOffset > fileSize - trailerSize)
+        throw runtime_error("Corrupted archive index");
+
+    string index(static_cast<size_t>(fileSize - trailerSize - indexOffset), '\0');
+    archive.seekg(static_cast<streamoff>(indexOffset));
+    archive.read(index.data(), index.size());
+    p = index.data();
+    const char* end = index.data() + index.size();
+
+    // Число записей из хвоста не должно определять объём выделяемой памяти: запись занимает не меньше minEntrySize байт.
+    const size_t minEntrySize = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t) + 3 * sizeof(uint64_t);
+    if (count > index.size() / minEntrySize)
+        throw runtime_error("Corrupted archive index");
+    vector<ArchiveEntry> entries(static_cast<size_t>(count));
+    for (ArchiveEntry& entry : entries)
+    {
+        uint32_t length = take<uint32_t>(p, end);
+        if (static_cast<uint64_t>(end - p) < length)
+            throw runtime_error("Corrupted archive index");
+        entry.path.assign(p, length);
+        p += length;
+        entry.type = static_cast<EntryType>(take<uint8_t>(p, end));
+        entry.permissions = take<uint32_t>(p, end);
+        entry.offset = take<uint64_t>(p, end);
+        entry.packedSize = take<uint64_t>(p, end);
+        entry.size = take<uint64_t>(p, end);
+        // Пути в индексе не должны выводить за пределы каталога проекта.
+        if (entry.path.empty() || entry.path[0] != '_' || hasParentComponent(entry.path))
+            throw runtime_error("Corrupted archive index");
+    }
+    return entries;
+}
+
+fs::file_time_type projectActivity(const string& location, const string& name)
+{
+    fs::file_time_type latest = fs::last_write_time(location + "/" + name + "_metadata.json");
+    for (const string& suffix : projectArtifactSuffixes)
+    {
+        error_code ec;
+        fs::file_time_type time = fs::last_write_time(location + "/" + name + suffix, ec);
+        if (!ec && time > latest)
+            latest = time;
+    }
+    return latest;
+}
+
+bool hasUnpackedArtifacts(const string& location, const string& name)
+{
+    for (const string& suffix : projectArtifactSuffixes)
+    {
+        if (suffix != archiveSuffix && fs::exists(fs::symlink_status(location + "/" + name + suffix)))
+            return true;
+    }
+    return false;
+}
+
+}
+
+ArchivePolicy loadArchivePolicy(const string& location)
+{
+    ArchivePolicy policy;
+    string path = location + "/archive_policy.json";
+    if (!fs::exists(path))
+        return policy;
+    json j = json::parse(readBytes(path));
+    policy.maxIdleDays = j.value("maxIdleDays", -1.0);
+    policy.keepHot = j.value("keepHot", -1L);
+    return policy;
+}
+
+vector<string> selectProjectsToArchive(const string& location, const ArchivePolicy& policy)
+{
+    vector<pair<fs::file_time_type, string>> candidates;
+    for (const string& name : listProjectNames(location))
+    {
+        if (hasUnpackedArtifacts(location, name))
+            candidates.emplace_back(projectActivity(location, name), name);
+    }
+    // Самые недавно использованные проекты — первыми.
+    sort(candidates.begin(), candidates.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    auto now = fs::file_time_type::clock::now();
+    vector<string> selected;
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        double idleDays = chrono::duration<double>(now - candidates[i].first).count() / 86400.0;
+        bool beyondHotSet = policy.keepHot >= 0 && i >= static_cast<size_t>(policy.keepHot);
+        bool idle = policy.maxIdleDays >= 0 && idleDays > policy.maxIdleDays;
+        if (beyondHotSet || idle)
+            selected.push_back(candidates[i].second);
+    }
+    return selected;
+}
+
+ArchiveStats archiveProject(const string& location, const string& name, unsigned jobs)
+{
+    ArchiveStats stats;
+    string archivePath = location + "/" + name + archiveSuffix;
+    if (fs::exists(archivePath))
+        throw runtime_error("Project is already archived: " + name);
+
+    vector<ArchiveEntry> entries = collectEntries(location, name);
+    if (entries.empty())
+        return stats;
+
+    string temporary = archivePath + ".tmp";
+    {
+        ofstream out(temporary, ios::binary | ios::trunc);
+        if (!out.is_open())
+            throw runtime_error("Failed to create " + temporary);
+        out.write(archiveMagic, sizeof(archiveMagic));
+        uint64_t offset = sizeof(archiveMagic);
+
+        // Файлы сжимаются окнами: внутри окна параллельно, запись — по порядку индекса.
+        size_t begin = 0;
+        while (begin < entries.size())
+        {
+            size_t end = begin;
+            uintmax_t windowSize = 0;
+            while (end < entries.size() && (end == begin || windowSize + entries[end].size <= windowBytes))
+                windowSize += entries[end++].size;
+
+            vector<string> packed(end - begin);
+            common::parallelFor(end - begin, jobs, [&](size_t i) {
+                const ArchiveEntry& entry = entries[begin + i];
+                fs::path source = location + "/" + name + entry.path;
+                if (entry.type == EntryType::File)
+                    packed[i] = deflateBytes(readBytes(source));
+                else if (entry.type == EntryType::Symlink)
+                    packed[i] = deflateBytes(fs::read_symlink(source).string());
+            });
+            for (size_t i = 0; i < packed.size(); ++i)
+            {
+                ArchiveEntry& entry = entries[begin + i];
+                entry.offset = offset;
+                entry.packedSize = packed[i].size();
+                out.write(packed[i].data(), packed[i].size());
+                offset += packed[i].size();
+                if (entry.type != EntryType::Directory)
+                {
+                    ++stats.files;
+                    stats.bytes += entry.size;
+                }
+            }
+            begin = end;
+        }
+
+        string index;
+        for (const ArchiveEntry& entry : entries)
+        {
+            put<uint32_t>(index, static_cast<uint32_t>(entry.path.size()));
+            index += entry.path;
+            put<uint8_t>(index, static_cast<uint8_t>(entry.type));
+            put<uint32_t>(index, entry.permissions);
+            put<uint64_t>(index, entry.offset);
+            put<uint64_t>(index, entry.packedSize);
+            put<uint64_t>(index, entry.size);
+        }
+        put<uint64_t>(index, offset);
+        put<uint64_t>(index, static_cast<uint64_t>(entries.size()));
+        index.append(archiveMagic, sizeof(archiveMagic));
+        out.write(index.data(), index.size());
+        stats.packedBytes = offset + index.size();
+        out.close();
+        if (!out)
+            throw runtime_error("Failed to write " + temporary);
+    }
+    fs::rename(temporary, archivePath);
+
+    // Архив записан полностью — исходные артефакты больше не нужны.
+    vector<string> originals;
+    for (const string& suffix : projectArtifactSuffixes)
+    {
+        if (suffix != archiveSuffix)
+            originals.push_back(location + "/" + name + suffix);
+    }
+    moveToTrash(location, name + ".archived", originals);
+    return stats;
+}
+
+ArchiveStats rehydrateProject(const string& location, const string& name, unsigned jobs)
+{
+    ArchiveStats stats;
+    string archivePath = location + "/" + name + archiveSuffix;
+    vector<ArchiveEntry> entries;
+    {
+        ifstream archive(archivePath, ios::binary);
+        if (!archive.is_open())
+            throw runtime_error("Failed to open " + archivePath);
+        entries = readIndex(archive, archivePath);
+        stats.packedBytes = fs::file_size(archivePath);
+    }
+
+    // Распаковка идёт во временный каталог: прерванная распаковка не оставляет полупустых артефактов.
+    fs::path staging = fs::path(location) / (".rehydrate." + name);
+    fs::remove_all(staging);
+    fs::create_directories(staging);
+
+    vector<size_t> files;
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].type == EntryType::Directory)
+            fs::create_directory(staging / (name + entries[i].path));
+        else
+            files.push_back(i);
+    }
+
+    // Файл, уже существующий вне архива, не распаковывается (present); отличающийся от архива учитывается в kept.
+    vector<char> present(entries.size(), 0);
+    set<string> existingRoots;
+    for (const ArchiveEntry& entry : entries)
+    {
+        if (entry.path.find('/') == string::npos && fs::exists(fs::symlink_status(location + "/" + name + entry.path)))
+            existingRoots.insert(entry.path);
+    }
+    atomic<uintmax_t> bytes{0};
+    atomic<size_t> kept{0};
+    common::parallelFor(files.size(), jobs, [&](size_t i) {
+        const ArchiveEntry& entry = entries[files[i]];
+        fs::path existing = location + "/" + name + entry.path;
+        if (fs::exists(fs::symlink_status(existing)))
+        {
+            present[files[i]] = 1;
+            if (matchesEntry(existing, entry, archivePath))
+                bytes += entry.size;
+            else
+                ++kept;
+            return;
+        }
+        fs::path target = staging / (name + entry.path);
+        ifstream archive(archivePath, ios::binary);
+        archive.seekg(static_cast<streamoff>(entry.offset));
+        if (entry.type == EntryType::Symlink)
+        {
+            ostringstream link;
+            inflateStream(archive, entry.packedSize, link);
+            fs::create_symlink(link.str(), target);
+            bytes += entry.size;
+            return;
+        }
+        ofstream out(target, ios::binary | ios::trunc);
+        if (!out.is_open())
+            throw runtime_error("Failed to create " + target.string());
+        if (inflateStream(archive, entry.packedSize, out) != entry.size)
+            throw runtime_error("Corrupted archive data: " + entry.path);
+        out.close();
+        if (!out)
+            throw runtime_error("Failed to write " + target.string());
+        bytes += entry.size;
+    });
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (entries[i].type != EntryType::Symlink && !present[i])
+            fs::permissions(staging / (name + entries[i].path), static_cast<fs::perms>(entries[i].permissions) & fs::perms::mask);
+    }
+    // Отсутствующие артефакты верхнего уровня переименовываются целиком, в существующие каталоги
+    // переносятся только недостающие файлы.
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const ArchiveEntry& entry = entries[i];
+        fs::path target = location + "/" + name + entry.path;
+        if (present[i])
+            continue;
+        if (!existingRoots.count(entry.path.substr(0, entry.path.find('/'))))
+        {
+            if (entry.path.find('/') == string::npos)
+                fs::rename(staging / (name + entry.path), target);
+        }
+        else if (entry.type == EntryType::Directory)
+        {
+            fs::create_directories(target);
+        }
+        else
+        {
+            fs::rename(staging / (name + entry.path), target);
+        }
+    }
+    fs::remove_all(staging);
+    fs::remove(archivePath);
+
+    stats.files = files.size() - kept;
+    stats.bytes = bytes;
+    stats.kept = kept;
+    return stats;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Результат упаковки или распаковки проекта.
+/// </summary>
+struct ArchiveStats
+{
+    size_t files = 0;
+    uintmax_t bytes = 0;
+    uintmax_t packedBytes = 0;
+    /// <summary>
+    /// Файлы, которые при распаковке уже существовали и отличались от архива; они оставлены как есть.
+    /// </summary>
+    size_t kept = 0;
+};
+
+/// <summary>
+/// Политика выбора неактивных проектов для архивации.
+/// Активность проекта — самое позднее время изменения его метаданных и артефактов
+/// (открытие проекта и любой этап Broker обновляют файл метаданных).
+/// </summary>
+struct ArchivePolicy
+{
+    /// <summary>
+    /// Архивировать проекты, неактивные дольше указанного числа дней (отрицательное значение — не учитывать).
+    /// </summary>
+    double maxIdleDays = -1;
+    /// <summary>
+    /// Оставлять распакованными столько наиболее недавно использованных проектов (LRU), остальные архивировать
+    /// (отрицательное значение — не учитывать).
+    /// </summary>
+    long keepHot = -1;
+
+    bool empty() const { return maxIdleDays < 0 && keepHot < 0; }
+};
+
+/// <summary>
+/// Читает политику архивации из файла "<расположение>/archive_policy.json" вида
+/// {"maxIdleDays": 30, "keepHot": 100}. Если файла нет, возвращается пустая политика.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+ArchivePolicy loadArchivePolicy(const std::string& location);
+
+/// <summary>
+/// Возвращает имена распакованных проектов, которые по политике нужно архивировать.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="policy">Политика архивации.</param>
+std::vector<std::string> selectProjectsToArchive(const std::string& location, const ArchivePolicy& policy);
+
+/// <summary>
+/// Упаковывает артефакты проекта (граф, Verilog-описание, выходные файлы Quartus) в один файл "<имя>_archive.pack".
+/// Файлы сжимаются zlib параллельно окнами ограниченного объёма и записываются подряд; в конце файла
+/// находится индекс со смещениями, поэтому при распаковке каждый файл читается независимо.
+/// Исходные артефакты после записи архива перемещаются в корзину. Метаданные остаются на месте,
+/// чтобы проект был виден в --list и мог быть открыт.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="name">Имя проекта.</param>
+/// <param name="jobs">Число потоков сжатия.</param>
+ArchiveStats archiveProject(const std::string& location, const std::string& name, unsigned jobs);
+
+/// <summary>
+/// Распаковывает архив проекта: файлы потоково распаковываются параллельно во временный каталог,
+/// затем артефакты верхнего уровня переименовываются на место, а архив удаляется.
+/// Файлы, уже существующие вне архива (после прерванной распаковки или повторного этапа), не распаковываются:
+/// совпадающие по размеру и хешу считаются распакованными, отличающиеся новее архива и остаются как есть.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="name">Имя проекта.</param>
+/// <param name="jobs">Число потоков распаковки.</param>
+ArchiveStats rehydrateProject(const std::string& location, const std::string& name, unsigned jobs);
@@ -0,0 +1,245 @@
+#include "ProjectScanner.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include "DirectoryReader.hpp"
+#include "Parallel.hpp"
+
+using json = nlohmann::json;
+using namespace std;
+
+namespace {
+
+const string metadataSuffix = "_metadata.json";
+
+/// <summary>
+/// Проверяет, является ли имя файла файлом метаданных, и добавляет имя проекта в список.
+/// </summary>
+void addIfMetadata(const char* fileName, size_t length, vector<string>& names)
+{
+    if (length <= metadataSuffix.size()) return;
+    if (memcmp(fileName + length - metadataSuffix.size(), metadataSuffix.data(), metadataSuffix.size()) != 0) return;
+    names.emplace_back(fileName, length - metadataSuffix.size());
+}
+
+/// <summary>
+/// Читает файл целиком одним вызовом read, заранее выделив буфер по размеру файла.
+/// </summary>
+string readWhole(const string& path)
+{
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open())
+        throw runtime_error("Failed to open " + path);
+    streamsize size = file.tellg();
+    string content(static_cast<size_t>(size), '\0');
+    file.seekg(0);
+    if (!file.read(content.data(), size))
+        throw runtime_error("Failed to read " + path);
+    return content;
+}
+
+ProjectScanRecord scanOne(const string& location, const string& name)
+{
+    ProjectScanRecord record;
+    record.name = name;
+    try
+    {
+        string content = readWhole(location + "/" + name + metadataSuffix);
+        record.settings = json::parse(content).get<ProjectSettings>();
+        if (record.settings.projectMetadata.name != name)
+            record.error = "Wrong project name in the metadata";
+        else
+            record.ok = true;
+    }
+    catch (const exception& e)
+    {
+        record.error = e.what();
+    }
+    return record;
+}
+
+const char* csvBool(bool value)
+{
+    return value ? "true" : "false";
+}
+
+
+}
+
+string csvField(const string& value)
+{
+    if (value.find_first_of(",\"\r\n") == string::npos) return value;
+    string quoted = "\"";
+    for (char c : value)
+    {
+        if (c == '"') quoted += '"';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+vector<string> listProjectNames(const string& location)
+{
+    vector<string> names;
+    readDirectory(location, [&](const char* fileName, size_t length, DirectoryEntryType type) {
+        if (type != DirectoryEntryType::Directory)
+            addIfMetadata(fileName, length, names);
+    });
+    sort(names.begin(), names.end());
+    return names;
+}
+
+void scanProjects(const string& location, unsigned jobs, const function<void(const ProjectScanRecord&)>& sink)
+{
+    vector<string> names = listProjectNames(location);
+    vector<ProjectScanRecord> records(names.size());
+    vector<char> ready(names.size(), 0);
+    mutex readyMutex;
+    condition_variable readyChanged;
+    exception_ptr scanError;
+    bool cancelled = false;
+
+    thread workers([&]() {
+        try
+        {
+            common::parallelFor(names.size(), jobs, [&](size_t i) {
+                {
+                    lock_guard<mutex> lock(readyMutex);
+                    if (cancelled)
+                        return;
+                }
+                records[i] = scanOne(location, names[i]);
+                {
+                    lock_guard<mutex> lock(readyMutex);
+                    ready[i] = 1;
+                }
+                readyChanged.notify_one();
+            });
+        }
+        catch (...)
+        {
+            lock_guard<mutex> lock(readyMutex);
+            scanError = current_exception();
+        }
+        readyChanged.notify_one();
+    });
+
+    // Выдаём записи строго по порядку: ждём готовности очередной и сразу освобождаем её память.
+    // Если сканирование или sink завершились исключением, оставшиеся проекты не сканируются,
+    // а поток дожидается до проброса исключения.
+    try
+    {
+        for (size_t next = 0; next < names.size(); ++next)
+        {
+            {
+                unique_lock<mutex> lock(readyMutex);
+                readyChanged.wait(lock, [&]() { return ready[next] != 0 || scanError; });
+                if (!ready[next])
+                    break;
+            }
+            sink(records[next]);
+            records[next] = ProjectScanRecord();
+        }
+    }
+    catch (...)
+    {
+        {
+            lock_guard<mutex> lock(readyMutex);
+            cancelled = true;
+        }
+        workers.join();
+        throw;
+    }
+    workers.join();
+    if (scanError)
+        rethrow_exception(scanError);
+}
+
+void writeRecordJsonLine(ostream& out, const ProjectScanRecord& record)
+{
+    json line;
+    line["name"] = record.name;
+    if (!record.ok)
+    {
+        line["error"] = record.error;
+    }
+    else
+    {
+        const ProjectSettings& s = record.settings;
+        line["graphSerialized"] = s.graphVerilogMetadata.graphSerialized;
+        line["verilogGenerated"] = s.graphVerilogMetadata.verilogGenerated;
+        line["quartusCompiled"] = s.quartusMetadata.quartusCompiled;
+        line["deviceName"] = s.quartusMetadata.deviceName;
+        line["writtenToDB"] = s.databaseMetadata.writtenToDB;
+    }
+    out << line.dump() << '\n';
+}
+
+void writeRecordCsvHeader(ostream& out)
+{
+    out << "name,graphSerialized,verilogGenerated,quartusCompiled,deviceName,writtenToDB,error\n";
+}
+
+void writeRecordCsv(ostream& out, const ProjectScanRecord& record)
+{
+    const ProjectSettings& s = record.settings;
+    out << csvField(record.name) << ',';
+    if (record.ok)
+    {
+        out << csvBool(s.graphVerilogMetadata.graphSerialized) << ','
+            << csvBool(s.graphVerilogMetadata.verilogGenerated) << ','
+            << csvBool(s.quartusMetadata.quartusCompiled) << ','
+            << csvField(s.quartusMetadata.deviceName) << ','
+            << csvBool(s.databaseMetadata.writtenToDB) << ",\n";
+    }
+    else
+    {
+        out << ",,,,," << csvField(record.error) << '\n';
+    }
+}
+
+void ProjectScanStats::add(const ProjectScanRecord& record)
+{
+    ++projects;
+    if (!record.ok)
+    {
+        ++errors;
+        return;
+    }
+    const ProjectSettings& s = record.settings;
+    graphSerialized += s.graphVerilogMetadata.graphSerialized;
+    verilogGenerated += s.graphVerilogMetadata.verilogGenerated;
+    quartusCompiled += s.quartusMetadata.quartusCompiled;
+    writtenToDB += s.databaseMetadata.writtenToDB;
+    ++byDevice[s.quartusMetadata.deviceName];
+}
+
+void ProjectScanStats::writeJson(ostream& out) const
+{
+    json stats;
+    stats["projects"] = projects;
+    stats["errors"] = errors;
+    stats["graphSerialized"] = graphSerialized;
+    stats["verilogGenerated"] = verilogGenerated;
+    stats["quartusCompiled"] = quartusCompiled;
+    stats["writtenToDB"] = writtenToDB;
+    stats["deviceName"] = byDevice;
+    out << stats.dump() << '\n';
+}
+
+void ProjectScanStats::writeCsv(ostream& out) const
+{
+    out << "metric,value,count\n";
+    out << "projects,," << projects << '\n';
+    out << "errors,," << errors << '\n';
+    out << "graphSerialized,true," << graphSerialized << '\n';
+    out << "verilogGenerated,true," << verilogGenerated << '\n';
+    out << "quartusCompiled,true," << quartusCompiled << '\n';
+    out << "writtenToDB,true," << writtenToDB << '\n';
+    for (const auto& [device, count] : byDevice)
+        out << "deviceName," << csvField(device) << ',' << count << '\n';
+}
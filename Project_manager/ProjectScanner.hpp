@@ -0,0 +1,88 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "ProjectSettings.hpp"
+
+/// <summary>
+/// Результат разбора одного файла метаданных при сканировании расположения.
+/// </summary>
+struct ProjectScanRecord
+{
+    /// <summary>
+    /// Имя проекта, полученное из имени файла (без суффикса "_metadata.json").
+    /// </summary>
+    std::string name;
+    /// <summary>
+    /// true, если метаданные прочитаны и имя в них совпадает с именем файла.
+    /// </summary>
+    bool ok = false;
+    /// <summary>
+    /// Текст ошибки, если ok == false.
+    /// </summary>
+    std::string error;
+    /// <summary>
+    /// Разобранные настройки проекта (валидны только при ok == true).
+    /// </summary>
+    ProjectSettings settings;
+};
+
+/// <summary>
+/// Агрегированная статистика по всем проектам расположения.
+/// </summary>
+struct ProjectScanStats
+{
+    size_t projects = 0;
+    size_t errors = 0;
+    size_t graphSerialized = 0;
+    size_t verilogGenerated = 0;
+    size_t quartusCompiled = 0;
+    size_t writtenToDB = 0;
+    /// <summary>
+    /// Количество проектов по значению deviceName (упорядочено для стабильного вывода).
+    /// </summary>
+    std::map<std::string, size_t> byDevice;
+
+    void add(const ProjectScanRecord& record);
+    void writeJson(std::ostream& out) const;
+    void writeCsv(std::ostream& out) const;
+};
+
+/// <summary>
+/// Возвращает отсортированный список имён проектов, для которых в расположении есть файл "<имя>_metadata.json".
+/// Каталог читается через readDirectory (пачками getdents64 на Linux).
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+std::vector<std::string> listProjectNames(const std::string& location);
+
+/// <summary>
+/// Параллельно разбирает метаданные всех проектов расположения.
+/// Записи передаются в sink по одной, в порядке сортировки имён, как только готов очередной префикс,
+/// поэтому вывод начинается до окончания сканирования, а порядок не зависит от числа потоков.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="jobs">Число потоков разбора.</param>
+/// <param name="sink">Обработчик записей; вызывается только из вызывающего потока.</param>
+void scanProjects(const std::string& location, unsigned jobs, const std::function<void(const ProjectScanRecord&)>& sink);
+
+/// <summary>
+/// Записывает одну запись сканирования строкой JSON Lines.
+/// </summary>
+void writeRecordJsonLine(std::ostream& out, const ProjectScanRecord& record);
+
+/// <summary>
+/// Экранирует поле CSV: поля с запятыми, кавычками, переводами строк и возвратами каретки заключаются в кавычки.
+/// </summary>
+std::string csvField(const std::string& value);
+
+/// <summary>
+/// Записывает заголовок CSV для вывода writeRecordCsv.
+/// </summary>
+void writeRecordCsvHeader(std::ostream& out);
+
+/// <summary>
+/// Записывает одну запись сканирования строкой CSV.
+/// </summary>
+void writeRecordCsv(std::ostream& out, const ProjectScanRecord& record);
@@ -0,0 +1,271 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+/// <summary>
+/// Класс, представляющий метаданные проекта.
+/// Содержит информацию о названии проекта.
+/// </summary>
+class ProjectMetadata
+{
+    public:
+    /// <summary>
+    /// Название проекта.
+    /// </summary>
+    /// <value>
+    /// Строковое значение, представляющее название проекта.
+    /// </value>
+    std::string name;
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(ProjectMetadata, name)
+};
+
+/// <summary>
+/// Класс, представляющий метаданные, связанные с сериализацией графа и генерацией Verilog.
+/// </summary>
+class GraphVerilogMetadata
+{
+    public:
+    /// <summary>
+    /// Флаг, указывающий, был ли сериализован граф.
+    /// </summary>
+    /// <value>
+    /// true, если граф был сериализован; в противном случае — false.
+    /// </value>
+    bool graphSerialized = false;
+    /// <summary>
+    /// Флаг, указывающий, был ли сгенерирован Verilog код.
+    /// </summary>
+    /// <value>
+    /// true, если Verilog код был сгенерирован; в противном случае — false.
+    /// </value>
+    bool verilogGenerated = false;
+    /// <summary>
+    /// Параметры, с которыми был построен граф.
+    /// </summary>
+    /// <value>
+    /// Строка вида "topology=mesh Nx=4 Ny=4"; пустая, если граф строился внешним генератором.
+    /// </value>
+    std::string params;
+    // Поля, добавленные позже, могут отсутствовать в метаданных старых проектов, поэтому используются значения по умолчанию.
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(GraphVerilogMetadata, graphSerialized, verilogGenerated, params)
+};
+
+/// <summary>
+/// Класс, представляющий временные характеристики одного тактового сигнала по отчёту анализа временных характеристик.
+/// Для каждого сигнала хранятся худшие значения по всем моделям (углам) анализа.
+/// </summary>
+class ClockTiming
+{
+    public:
+    /// <summary>
+    /// Имя тактового сигнала.
+    /// </summary>
+    std::string name;
+    /// <summary>
+    /// Максимальная частота в МГц.
+    /// </summary>
+    double fmaxMhz = 0;
+    /// <summary>
+    /// Максимальная частота с учётом ограничений устройства в МГц.
+    /// </summary>
+    double restrictedFmaxMhz = 0;
+    /// <summary>
+    /// Запас по установке (setup slack) в нс.
+    /// </summary>
+    double setupSlackNs = 0;
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(ClockTiming, name, fmaxMhz, restrictedFmaxMhz, setupSlackNs)
+};
+
+/// <summary>
+/// Класс, представляющий метаданные, связанные с компиляцией в Quartus.
+/// </summary>
+class QuartusMetadata
+    {
+    public:
+    /// <summary>
+    /// Флаг, указывающий, была ли выполнена компиляция в Quartus.
+    /// </summary>
+    /// <value>
+    /// true, если компиляция в Quartus была выполнена; в противном случае — false.
+    /// </value>
+    bool quartusCompiled = false;
+
+    /// <summary>
+    /// Название устройства, для которого выполнялась компиляция в Quartus.
+    /// </summary>
+    /// <value>
+    /// Строковое значение, представляющее название устройства.
+    /// </value>
+     std::string deviceName = "5CGXFC9E7F35C8";
+
+    /// <summary>
+    /// Использованные и доступные адаптивные логические модули (ALM) по отчёту фиттера.
+    /// </summary>
+    long long alms = 0;
+    long long almsAvailable = 0;
+    /// <summary>
+    /// Оценка числа ALM по отчёту синтеза (quartus_map): известна до размещения; 0 — оценки нет.
+    /// </summary>
+    long long estimatedAlms = 0;
+    /// <summary>
+    /// Число регистров по отчёту фиттера.
+    /// </summary>
+    long long registers = 0;
+    /// <summary>
+    /// Использованные блоки памяти M10K (строка "Total RAM Blocks" отчёта фиттера) и биты блочной памяти.
+    /// </summary>
+    long long ramBlocks = 0;
+    long long blockMemoryBits = 0;
+    /// <summary>
+    /// Использованные блоки DSP.
+    /// </summary>
+    long long dspBlocks = 0;
+    /// <summary>
+    /// Временные характеристики по тактовым сигналам из отчёта анализа временных характеристик.
+    /// </summary>
+    std::vector<ClockTiming> clocks;
+    /// <summary>
+    /// Флаг, указывающий, создан ли файл программирования (.sof).
+    /// </summary>
+    /// <value>
+    /// false после компиляции в режиме исследования (без ассемблера), пока проект не дополнен стадией asm.
+    /// </value>
+    bool bitstreamGenerated = false;
+    /// <summary>
+    /// Начальное значение фиттера (SEED), выбранное при компиляции с несколькими значениями;
+    /// 0 — значение Quartus по умолчанию.
+    /// </summary>
+    unsigned seed = 0;
+    /// <summary>
+    /// Причина досрочной остановки компиляции (переполнение устройства, сбой фиттера, недостаточный
+    /// запас по времени); пустая строка, если компиляция не останавливалась.
+    /// </summary>
+    std::string abortReason;
+    /// <summary>
+    /// Итоги компиляции для каждого устройства при компиляции для нескольких устройств (--devices);
+    /// пусто при компиляции для одного устройства.
+    /// </summary>
+    std::vector<QuartusMetadata> devices;
+    // Итоги компиляции добавлены позже и отсутствуют в метаданных старых проектов.
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(QuartusMetadata, quartusCompiled, deviceName, alms, almsAvailable, registers,
+                                                ramBlocks, blockMemoryBits, dspBlocks, clocks, bitstreamGenerated, seed,
+                                                abortReason, devices, estimatedAlms)
+
+};
+
+/// <summary>
+/// Снимок строк проекта, последними записанных в базу данных: по нему Database_writer отправляет
+/// только изменившиеся поля.
+/// </summary>
+class DatabaseSnapshot {
+    public:
+    /// <summary>
+    /// База данных и проект, для которых записаны строки; снимок другой базы данных или проекта
+    /// (после переименования или клонирования) не используется.
+    /// </summary>
+    std::string target;
+    /// <summary>
+    /// Хеш XXH64 строк снимка: совпадение с хешем текущих итогов означает, что проект не изменился.
+    /// </summary>
+    std::string hash;
+    /// <summary>
+    /// Значения столбцов таблицы noc_results по устройствам в текстовом виде COPY; отсутствующий столбец — NULL.
+    /// </summary>
+    std::map<std::string, std::map<std::string, std::string>> rows;
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(DatabaseSnapshot, target, hash, rows)
+};
+
+/// <summary>
+/// Класс, представляющий метаданные, связанные с базой данных.
+/// </summary>
+class DatabaseMetadata {
+    public:
+    /// <summary>
+    /// IP-адрес базы данных.
+    /// </summary>
+    /// <value>
+    /// Строковое значение, представляющее IP-адрес базы данных.
+    /// </value>
+    std::string dbIp;
+    /// <summary>
+    /// Имя пользователя базы данных.
+    /// </summary>
+    /// <value>
+    /// Строковое значение, представляющее имя пользователя базы данных.
+    /// </value>
+    std::string dbUsername;
+    /// <summary>
+    /// Пароль для доступа к базе данных.
+    /// </summary>
+    /// <value>
+    /// Массив байтов, представляющий зашифрованный пароль для доступа к базе данных.
+    /// </value>
+    std::string dbPassword;// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
+    /// <summary>
+    /// Название базы данных.
+    /// </summary>
+    /// <value>
+    /// Строковое значение, представляющее название базы данных.
+    /// </value>
+    std::string dbName;
+    /// <summary>
+    /// Порт базы данных.
+    /// </summary>
+    /// <value>
+    /// Целочисленное значение, представляющее порт базы данных.
+    /// </value>
+    int dbPort = -1;
+    /// <summary>
+    /// Флаг, указывающий, были ли данные записаны в базу данных.
+    /// </summary>
+    /// <value>
+    /// true, если данные были записаны в базу данных; в противном случае — false.
+    /// </value>
+    bool writtenToDB = false;
+    /// <summary>
+    /// Снимок последней записи в базу данных; пустой, если проект ещё не записывался.
+    /// </summary>
+    DatabaseSnapshot synced;
+    // Снимок добавлен позже и отсутствует в метаданных старых проектов.
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(DatabaseMetadata, dbIp, dbUsername, dbPassword, dbName, dbPort, writtenToDB,
+                                                synced)
+};
+
+/// <summary>
+/// Класс, представляющий настройки проекта.
+/// Содержит все метаданные, относящиеся к проекту.
+/// </summary>
+class ProjectSettings {
+public:
+    /// <summary>
+    /// Метаданные проекта.
+    /// </summary>
+    /// <value>
+    /// Экземпляр класса ProjectMetadata, содержащий информацию о проекте.
+    /// </value>
+    ProjectMetadata projectMetadata;
+    /// <summary>
+    /// Метаданные, связанные с сериализацией графа и генерацией Verilog.
+    /// </summary>
+    /// <value>
+    /// Экземпляр класса GraphVerilogMetadata.
+    /// </value>
+    GraphVerilogMetadata graphVerilogMetadata;
+    /// <summary>
+    /// Метаданные, связанные с компиляцией в Quartus.
+    /// </summary>
+    /// <value>
+    /// Экземпляр класса QuartusMetadata.
+    /// </value>
+    QuartusMetadata quartusMetadata;
+    /// <summary>
+    /// Метаданные, связанные с базой данных.
+    /// </summary>
+    /// <value>
+    /// Экземпляр класса DatabaseMetadata.
+    /// </value>
+    DatabaseMetadata databaseMetadata;
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(ProjectSettings, projectMetadata, graphVerilogMetadata, quartusMetadata, databaseMetadata)
+};
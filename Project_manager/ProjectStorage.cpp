@@ -0,0 +1,349 @@
+#include "ProjectStorage.hpp"
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <stdexcept>
+#include "DirectoryReader.hpp"
+#include "Parallel.hpp"
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+const string quartusOutputSuffix = "_quartus";
+
+const string archiveSuffix = "_archive.pack";
+
+const vector<string> projectArtifactSuffixes = {
+    "_graph_object_serialized.json", // Сериализованный граф (Graph_verilog_generator).
+    "_graph_object.bin",             // Тот же граф в двоичном формате для отображения в память (Topology).
+    "_NoC_description",              // Каталог с Verilog-описанием сети.
+    quartusOutputSuffix,             // Каталог проекта и выходных файлов Quartus.
+    archiveSuffix,                   // Упакованные артефакты холодного проекта.
+};
+
+const string trashDirectoryName = ".trash";
+
+namespace {
+
+/// <summary>
+/// Максимальное число файлов, удаляемых или копируемых одной задачей пула.
+/// </summary>
+const size_t batchSize = 256;
+
+/// <summary>
+/// Пачка файлов одного каталога, обрабатываемая одной задачей пула.
+/// </summary>
+struct EntryBatch
+{
+    size_t directory;
+    vector<string> names;
+};
+
+/// <summary>
+/// Разбивает элементы дерева на пачки не более чем по batchSize файлов одного каталога.
+/// </summary>
+vector<EntryBatch> splitIntoBatches(const DirectoryTree& tree)
+{
+    vector<EntryBatch> batches;
+    for (const DirectoryTree::Entry& entry : tree.entries)
+    {
+        if (batches.empty() || batches.back().directory != entry.directory || batches.back().names.size() == batchSize)
+            batches.push_back({entry.directory, {}});
+        batches.back().names.push_back(entry.name);
+    }
+    return batches;
+}
+
+void unlinkBatch(const string& directory, const vector<string>& names)
+{
+#ifdef __linux__
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0)
+        throw runtime_error("Failed to open directory: " + directory);
+    for (const string& name : names)
+    {
+        if (unlinkat(fd, name.c_str(), 0) != 0 && errno != ENOENT)
+        {
+            close(fd);
+            throw runtime_error("Failed to delete " + directory + "/" + name);
+        }
+    }
+    close(fd);
+#else
+    for (const string& name : names)
+    {
+        // На Windows файл только для чтения (например, объект хранилища артефактов) нельзя удалить без снятия атрибута.
+        error_code ec;
+        fs::permissions(fs::path(directory) / name, fs::perms::owner_write, fs::perm_options::add, ec);
+        fs::remove(fs::path(directory) / name);
+    }
+#endif
+}
+
+void removeDirectory(const string& directory)
+{
+#ifdef __linux__
+    if (rmdir(directory.c_str()) != 0 && errno != ENOENT)
+        throw runtime_error("Failed to delete directory: " + directory);
+#else
+    fs::remove(directory);
+#endif
+}
+
+/// <summary>
+/// Счётчики способов, которыми были клонированы файлы.
+/// </summary>
+struct CloneCounters
+{
+    atomic<size_t> reflinked{0};
+    atomic<size_t> linked{0};
+    atomic<size_t> copied{0};
+};
+
+#ifdef __linux__
+/// <summary>
+/// Копирует содержимое файла средствами ядра (copy_file_range), при неудаче — через буфер.
+/// </summary>
+void copyContents(int in, int out, const string& source)
+{
+    for (;;)
+    {
+        ssize_t copied = copy_file_range(in, nullptr, out, nullptr, 1 << 30, 0);
+        if (copied == 0) return;
+        if (copied > 0) continue;
+        if (errno != EXDEV && errno != ENOSYS && errno != EINVAL && errno != EOPNOTSUPP)
+            throw runtime_error("Failed to copy " + source);
+        break;
+    }
+    vector<char> buffer(1 << 20);
+    for (;;)
+    {
+        ssize_t bytes = read(in, buffer.data(), buffer.size());
+        if (bytes == 0) return;
+        if (bytes < 0 || write(out, buffer.data(), bytes) != bytes)
+            throw runtime_error("Failed to copy " + source);
+    }
+}
+#endif
+
+/// <summary>
+/// Клонирует один файл: reflink (FICLONE), затем жёсткая ссылка (если разрешена), затем копирование.
+/// </summary>
+void cloneFile(const string& source, const string& target, bool allowHardLinks, CloneCounters& counters)
+{
+#ifdef __linux__
+    int in = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        throw runtime_error("Failed to open " + source);
+    struct stat st;
+    fstat(in, &st);
+    int out = open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777);
+    if (out < 0)
+    {
+        close(in);
+        throw runtime_error("Failed to create " + target);
+    }
+    try
+    {
+        if (ioctl(out, FICLONE, in) == 0)
+        {
+            ++counters.reflinked;
+        }
+        else
+        {
+            bool linked = false;
+            if (allowHardLinks)
+            {
+                close(out);
+                out = -1;
+                unlink(target.c_str());
+                if (link(source.c_str(), target.c_str()) == 0)
+                {
+                    linked = true;
+                    ++counters.linked;
+                }
+                else if ((out = open(target.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, st.st_mode & 07777)) < 0)
+                {
+                    throw runtime_error("Failed to create " + target);
+                }
+            }
+            if (!linked)
+            {
+                copyContents(in, out, source);
+                ++counters.copied;
+            }
+        }
+    }
+    catch (...)
+    {
+        if (out >= 0) close(out);
+        close(in);
+        throw;
+    }
+    if (out >= 0) close(out);
+    close(in);
+#else
+    error_code ec;
+    if (allowHardLinks)
+    {
+        fs::create_hard_link(source, target, ec);
+        if (!ec)
+        {
+            ++counters.linked;
+            return;
+        }
+    }
+    fs::copy_file(source, target);
+    ++counters.copied;
+#endif
+}
+
+/// <summary>
+/// Клонирует файл или дерево каталогов source в target: каталоги создаются последовательно,
+/// файлы клонируются пачками на пуле потоков.
+/// </summary>
+void cloneArtifact(const string& source, const string& target, unsigned jobs, bool allowHardLinks, CloneCounters& counters)
+{
+    fs::file_status status = fs::symlink_status(source);
+    if (fs::is_symlink(status))
+    {
+        fs::copy_symlink(source, target);
+        return;
+    }
+    if (!fs::is_directory(status))
+    {
+        cloneFile(source, target, allowHardLinks, counters);
+        return;
+    }
+
+    DirectoryTree tree = readDirectoryTree(source);
+    for (size_t i = 0; i < tree.directories.size(); ++i)
+        fs::create_directory(tree.directoryPath(target, i));
+
+    vector<EntryBatch> batches = splitIntoBatches(tree);
+    common::parallelFor(batches.size(), jobs, [&](size_t i) {
+        const EntryBatch& batch = batches[i];
+        string from = tree.directoryPath(source, batch.directory);
+        string to = tree.directoryPath(target, batch.directory);
+        for (const string& name : batch.names)
+        {
+            if (fs::is_symlink(fs::symlink_status(from + "/" + name)))
+                fs::copy_symlink(from + "/" + name, to + "/" + name);
+            else
+                cloneFile(from + "/" + name, to + "/" + name, allowHardLinks, counters);
+        }
+    });
+}
+
+}
+
+vector<string> projectPaths(const string& location, const string& name)
+{
+    vector<string> paths;
+    paths.push_back(location + "/" + name + "_metadata.json");
+    for (const string& suffix : projectArtifactSuffixes)
+        paths.push_back(location + "/" + name + suffix);
+    return paths;
+}
+
+string moveToTrash(const string& location, const string& label, const vector<string>& paths)
+{
+    fs::path trash = fs::path(location) / trashDirectoryName;
+    fs::create_directories(trash);
+
+    // Уникальное имя позволяет удалять и заново создавать проект с тем же именем до сборки мусора.
+    string stamp = label + "." + to_string(chrono::system_clock::now().time_since_epoch().count());
+    fs::path target = trash / stamp;
+    for (int n = 1; fs::exists(target); ++n)
+        target = trash / (stamp + "." + to_string(n));
+    fs::create_directory(target);
+
+    for (const string& item : paths)
+    {
+        fs::path source(item);
+        if (!fs::exists(fs::symlink_status(source)))
+            continue;
+        fs::rename(source, target / source.filename());
+    }
+    return target.string();
+}
+
+string moveProjectToTrash(const string& location, const string& name)
+{
+    return moveToTrash(location, name, projectPaths(location, name));
+}
+
+size_t collectTrash(const string& location, unsigned jobs)
+{
+    string trash = location + "/" + trashDirectoryName;
+    if (!fs::exists(trash))
+        return 0;
+
+    DirectoryTree tree = readDirectoryTree(trash);
+    vector<EntryBatch> batches = splitIntoBatches(tree);
+
+    atomic<size_t> removed{0};
+    common::parallelFor(batches.size(), jobs, [&](size_t i) {
+        const EntryBatch& batch = batches[i];
+        unlinkBatch(tree.directoryPath(trash, batch.directory), batch.names);
+        removed += batch.names.size();
+    });
+
+    // Каталоги обходились в прямом порядке, поэтому в обратном порядке дочерние идут раньше родителей.
+    // Сам каталог корзины (индекс 0) сохраняется.
+    for (size_t i = tree.directories.size(); i-- > 1;)
+        removeDirectory(tree.directoryPath(trash, i));
+    return removed;
+}
+
+CloneStats cloneProjectArtifacts(const string& location, const string& name, const string& newName, unsigned jobs, bool allowHardLinks)
+{
+    // Сначала проверяем все цели, чтобы не оставить частично созданный клон поверх чужих файлов.
+    for (const string& suffix : projectArtifactSuffixes)
+    {
+        if (fs::exists(fs::symlink_status(location + "/" + newName + suffix)))
+            throw runtime_error("Artifact already exists: " + location + "/" + newName + suffix);
+    }
+
+    // Артефакты клонируются под временными именами и переименовываются только после успеха всех:
+    // после ошибки не остаётся неполных артефактов, из-за которых повторное клонирование было бы отклонено.
+    CloneCounters counters;
+    vector<string> targets;
+    size_t renamed = 0;
+    try
+    {
+        for (const string& suffix : projectArtifactSuffixes)
+        {
+            // Выходные файлы Quartus относятся к конкретной компиляции и не переносятся в вариант.
+            if (suffix == quartusOutputSuffix)
+                continue;
+            string source = location + "/" + name + suffix;
+            if (!fs::exists(fs::symlink_status(source)))
+                continue;
+            targets.push_back(location + "/" + newName + suffix);
+            // Временное имя могло остаться от клонирования, прерванного вместе с процессом.
+            error_code ec;
+            fs::remove_all(targets.back() + ".cloning", ec);
+            cloneArtifact(source, targets.back() + ".cloning", jobs, allowHardLinks, counters);
+        }
+        for (; renamed < targets.size(); renamed++)
+            fs::rename(targets[renamed] + ".cloning", targets[renamed]);
+    }
+    catch (...)
+    {
+        error_code ec;
+        for (size_t i = 0; i < targets.size(); i++)
+            fs::remove_all(i < renamed ? targets[i] : targets[i] + ".cloning", ec);
+        throw;
+    }
+    return CloneStats{counters.reflinked, counters.linked, counters.copied};
+}
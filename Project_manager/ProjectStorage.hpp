@@ -0,0 +1,90 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Суффиксы файлов и каталогов проекта, которые создаются стадиями конвейера рядом с метаданными.
+/// Полный путь артефакта — "<расположение>/<имя><суффикс>".
+/// </summary>
+extern const std::vector<std::string> projectArtifactSuffixes;
+
+/// <summary>
+/// Суффикс каталога проекта и выходных файлов Quartus.
+/// </summary>
+extern const std::string quartusOutputSuffix;
+
+/// <summary>
+/// Суффикс архива, в который упаковываются артефакты неактивного проекта.
+/// </summary>
+extern const std::string archiveSuffix;
+
+/// <summary>
+/// Имя каталога корзины внутри расположения проектов.
+/// </summary>
+extern const std::string trashDirectoryName;
+
+/// <summary>
+/// Возвращает пути к файлу метаданных и всем артефактам проекта (существующим и нет).
+/// Файл метаданных идёт первым.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="name">Имя проекта.</param>
+std::vector<std::string> projectPaths(const std::string& location, const std::string& name);
+
+/// <summary>
+/// Перемещает перечисленные файлы и каталоги в новый каталог корзины "<label>.<метка времени>".
+/// Несуществующие пути пропускаются.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="label">Префикс имени каталога корзины (обычно имя проекта).</param>
+/// <param name="paths">Пути внутри расположения.</param>
+/// <returns>Путь к созданному каталогу корзины.</returns>
+std::string moveToTrash(const std::string& location, const std::string& label, const std::vector<std::string>& paths);
+
+/// <summary>
+/// Перемещает метаданные и артефакты проекта в отдельный каталог корзины расположения.
+/// Каждое перемещение — это атомарный rename в пределах одной файловой системы, поэтому вызов
+/// не зависит от размера артефактов. Метаданные перемещаются первыми: с этого момента проект
+/// считается удалённым, даже если перенос остальных артефактов прервётся.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="name">Имя проекта.</param>
+/// <returns>Путь к каталогу корзины, куда перемещён проект.</returns>
+std::string moveProjectToTrash(const std::string& location, const std::string& name);
+
+/// <summary>
+/// Окончательно удаляет содержимое корзины расположения.
+/// Сначала дерево обходится и собирается список каталогов и файлов, затем файлы удаляются
+/// пачками параллельно (unlinkat относительно дескриптора каталога на Linux), после чего
+/// каталоги удаляются от самых глубоких к корню.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="jobs">Число потоков удаления.</param>
+/// <returns>Число удалённых файлов.</returns>
+size_t collectTrash(const std::string& location, unsigned jobs);
+
+/// <summary>
+/// Количество файлов, клонированных каждым из способов.
+/// </summary>
+struct CloneStats
+{
+    size_t reflinked = 0;
+    size_t linked = 0;
+    size_t copied = 0;
+};
+
+/// <summary>
+/// Клонирует артефакты проекта (граф и каталог Verilog-описания) под новым именем.
+/// Каждый файл клонируется через reflink (FICLONE) — данные разделяются файловой системой до первой записи;
+/// если файловая система этого не поддерживает, создаётся жёсткая ссылка (только при allowHardLinks,
+/// так как изменение такого файла на месте затронет оба проекта) или выполняется копирование.
+/// Файлы обрабатываются пачками на пуле потоков. Выходные файлы Quartus не клонируются.
+/// Метаданные нового проекта создаёт вызывающий.
+/// </summary>
+/// <param name="location">Путь к расположению проектов.</param>
+/// <param name="name">Имя исходного проекта.</param>
+/// <param name="newName">Имя нового проекта.</param>
+/// <param name="jobs">Число потоков.</param>
+/// <param name="allowHardLinks">Разрешить жёсткие ссылки, если reflink недоступен.</param>
+/// <exception cref="std::runtime_error">Если какой-либо артефакт нового проекта уже существует или клонирование не удалось.</exception>
+CloneStats cloneProjectArtifacts(const std::string& location, const std::string& name, const std::string& newName, unsigned jobs, bool allowHardLinks);
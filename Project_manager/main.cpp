@@ -1,163 +1,21 @@
 #include <iostream>
+#include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include "ProjectSettings.hpp"
+#include "ProjectScanner.hpp"
+#include "ProjectStorage.hpp"
+#include "ArtifactStore.hpp"
+#include "ProjectArchive.hpp"
+#include "FileLock.hpp"
+#include "Parallel.hpp"
+#include "GraphJson.hpp"
+#include "ResultsQuery.hpp"
 using json = nlohmann::json;
 using namespace std;
 using namespace std::filesystem;
 
-/// <summary>
-/// Класс, представляющий метаданные проекта.
-/// Содержит информацию о названии проекта.
-/// </summary>
-class ProjectMetadata
-{
-    public:
-    /// <summary>
-    /// Название проекта.
-    /// </summary>
-    /// <value>
-    /// Строковое значение, представляющее название проекта.
-    /// </value>
-    string name;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(ProjectMetadata, name)
-};
-
-/// <summary>
-/// Класс, представляющий метаданные, связанные с сериализацией графа и генерацией Verilog.
-/// </summary>
-class GraphVerilogMetadata
-{
-    public:
-    /// <summary>
-    /// Флаг, указывающий, был ли сериализован граф.
-    /// </summary>
-    /// <value>
-    /// true, если граф был сериализован; в противном случае — false.
-    /// </value>
-    bool graphSerialized = false;
-    /// <summary>
-    /// Флаг, указывающий, был ли сгенерирован Verilog код.
-    /// </summary>
-    /// <value>
-    /// true, если Verilog код был сгенерирован; в противном случае — false.
-    /// </value>
-    bool verilogGenerated = false;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(GraphVerilogMetadata, graphSerialized, verilogGenerated)
-};
-
-/// <summary>
-/// Класс, представляющий метаданные, связанные с компиляцией в Quartus.
-/// </summary>
-class QuartusMetadata
-    {
-    public:
-    /// <summary>
-    /// Флаг, указывающий, была ли выполнена компиляция в Quartus.
-    /// </summary>
-    /// <value>
-    /// true, если компиляция в Quartus была выполнена; в противном случае — false.
-    /// </value>
-    bool quartusCompiled = false;
-
-    /// <summary>
-    /// Название устройства, для которого выполнялась компиляция в Quartus.
-    /// </summary>
-    /// <value>
-    /// Строковое значение, представляющее название устройства.
-    /// </value>
-     string deviceName = "5CGXFC9E7F35C8";
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(QuartusMetadata, quartusCompiled, deviceName)
-
-};
-
-/// <summary>
-/// Класс, представляющий метаданные, связанные с базой данных.
-/// </summary>
-class DatabaseMetadata {
-    public:
-    /// <summary>
-    /// IP-адрес базы данных.
-    /// </summary>
-    /// <value>
-    /// Строковое значение, представляющее IP-адрес базы данных.
-    /// </value>
-    string dbIp;
-    /// <summary>
-    /// Имя пользователя базы данных.
-    /// </summary>
-    /// <value>
-    /// Строковое значение, представляющее имя пользователя базы данных.
-    /// </value>
-    string dbUsername;
-    /// <summary>
-    /// Пароль для доступа к базе данных.
-    /// </summary>
-    /// <value>
-    /// Массив байтов, представляющий зашифрованный пароль для доступа к базе данных.
-    /// </value>
-    string dbPassword;// !!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!
-    /// <summary>
-    /// Название базы данных.
-    /// </summary>
-    /// <value>
-    /// Строковое значение, представляющее название базы данных.
-    /// </value>
-    string dbName;
-    /// <summary>
-    /// Порт базы данных.
-    /// </summary>
-    /// <value>
-    /// Целочисленное значение, представляющее порт базы данных.
-    /// </value>
-    int dbPort = -1;
-    /// <summary>
-    /// Флаг, указывающий, были ли данные записаны в базу данных.
-    /// </summary>
-    /// <value>
-    /// true, если данные были записаны в базу данных; в противном случае — false.
-    /// </value>
-    bool writtenToDB = false;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(DatabaseMetadata, dbIp, dbUsername, dbPassword, dbName, dbPort, writtenToDB)
-};
-
-/// <summary>
-/// Класс, представляющий настройки проекта.
-/// Содержит все метаданные, относящиеся к проекту.
-/// </summary>
-class ProjectSettings {
-public:
-    /// <summary>
-    /// Метаданные проекта.
-    /// </summary>
-    /// <value>
-    /// Экземпляр класса ProjectMetadata, содержащий информацию о проекте.
-    /// </value>
-    ProjectMetadata projectMetadata;
-    /// <summary>
-    /// Метаданные, связанные с сериализацией графа и генерацией Verilog.
-    /// </summary>
-    /// <value>
-    /// Экземпляр класса GraphVerilogMetadata.
-    /// </value>
-    GraphVerilogMetadata graphVerilogMetadata;
-    /// <summary>
-    /// Метаданные, связанные с компиляцией в Quartus.
-    /// </summary>
-    /// <value>
-    /// Экземпляр класса QuartusMetadata.
-    /// </value>
-    QuartusMetadata quartusMetadata;
-    /// <summary>
-    /// Метаданные, связанные с базой данных.
-    /// </summary>
-    /// <value>
-    /// Экземпляр класса DatabaseMetadata.
-    /// </value>
-    DatabaseMetadata databaseMetadata;
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(ProjectSettings, projectMetadata, graphVerilogMetadata, quartusMetadata, databaseMetadata)
-};
-
 string readFile(const string& path) {
     ifstream file(path);
     if (!file.is_open())
@@ -175,8 +33,13 @@ int main(int argc, char *argv[]) {
     // Инициализация переменных для хранения параметров командной строки.
     string location; // Расположение проекта.
     string name;     // Имя проекта.
-    string action = "o";   // Действие, которое необходимо выполнить (o - открыть, c - создать, e - удалить, r - переименовать). По умолчанию "o".
-    string new_name; // Новое имя проекта (используется при переименовании).
+    string action = "o";   // Действие, которое необходимо выполнить (o - открыть, c - создать, e - удалить, r - переименовать, cl - клонировать, l - список, s - статистика, g - очистка корзины, d - дедупликация, a - архивация, gi - сводка по графу, q - запрос к хранилищу итогов). По умолчанию "o".
+    string new_name; // Новое имя проекта (используется при переименовании и клонировании).
+    bool allow_hard_links = false; // Разрешить жёсткие ссылки при клонировании, если reflink недоступен.
+    ArchivePolicy archive_policy; // Политика архивации, заданная в командной строке.
+    string format = "jsonl"; // Формат вывода списка и статистики (jsonl или csv).
+    unsigned jobs = common::defaultJobs(); // Число потоков для сканирования расположения.
+    string where, group_by, select; // Условия, группировка и агрегаты запроса к хранилищу итогов.
     // Итерация по аргументам командной строки.
     for (int i = 1; i < argc; i++) {
         string option = argv[i];
@@ -229,21 +92,353 @@ int main(int argc, char *argv[]) {
                 exit(1);
             }
             
+        }
+        else if (option == "--clone"){
+            action = "cl"; // Установка действия "клонировать".
+            if (i < argc - 1)
+            {
+                new_name = argv[++i]; // Получение имени нового проекта из следующего аргумента.
+            }
+            else
+            {
+                cout<<("No new name provided");
+                exit(1);
+            }
+
+        }
+        else if (option == "--hardlink"){
+            allow_hard_links = true; // Разрешение жёстких ссылок при клонировании.
+
+        }
+        else if (option == "--list"){
+            action = "l"; // Установка действия "вывести список проектов".
+
+        }
+        else if (option == "--stats"){
+            action = "s"; // Установка действия "вывести статистику по проектам".
+
+        }
+        else if (option == "--gc"){
+            action = "g"; // Установка действия "очистить корзину".
+
+        }
+        else if (option == "--dedup"){
+            action = "d"; // Установка действия "дедуплицировать артефакты".
+
+        }
+        else if (option == "--archive"){
+            action = "a"; // Установка действия "архивировать".
+
+        }
+        else if (option == "--graph-info"){
+            action = "gi"; // Установка действия "вывести сводку по сериализованному графу".
+
+        }
+        else if (option == "--query"){
+            action = "q"; // Установка действия "запрос к хранилищу итогов".
+
+        }
+        else if (option == "--where" || option == "--group-by" || option == "--select"){
+            if (i < argc - 1)
+            {
+                // Получение части запроса к хранилищу итогов из следующего аргумента.
+                (option == "--where" ? where : option == "--group-by" ? group_by : select) = argv[++i];
+            }
+            else
+            {
+                cout<<("No value provided for "+option);
+                exit(1);
+            }
+
+        }
+        else if (option == "--max-idle-days" || option == "--keep-hot"){
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                // Получение параметра политики архивации из следующего аргумента.
+                if (option == "--max-idle-days")
+                    archive_policy.maxIdleDays = stod(argv[++i]);
+                else
+                    archive_policy.keepHot = stol(argv[++i]);
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid value for "+option);
+                exit(1);
+            }
+
+        }
+        else if (option == "--format"){
+            if (i < argc - 1 && (string(argv[i + 1]) == "jsonl" || string(argv[i + 1]) == "csv"))
+            {
+                format = argv[++i]; // Получение формата вывода из следующего аргумента.
+            }
+            else
+            {
+                cout<<("Format must be jsonl or csv");
+                exit(1);
+            }
+
+        }
+        else if (option == "-j"||option == "--jobs"){
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                jobs = common::parseJobs(argv[++i]); // Получение числа потоков из следующего аргумента.
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid number of jobs");
+                exit(1);
+            }
+
         }
         else {
             cout<<("Argument "+option+" is invalid"); // Вывод сообщения об ошибке.
             exit(1); // Завершение программы с кодом ошибки 1.
         }
     }
+    // Обработка действий "список" и "статистика": они относятся ко всему расположению, а не к одному проекту.
+    if(action == "l" || action == "s") {
+        if (!exists(location))
+        {
+            cout<<("Failed to find project directory"); // Вывод сообщения об ошибке.
+            exit(1);                                  // Завершение программы с кодом ошибки 1.
+        }
+
+        try
+        {
+            ProjectScanStats stats;
+            if (action == "l" && format == "csv")
+                writeRecordCsvHeader(cout);
+            scanProjects(location, jobs, [&](const ProjectScanRecord& record) {
+                if (action == "s")
+                    stats.add(record);
+                else if (format == "csv")
+                    writeRecordCsv(cout, record);
+                else
+                    writeRecordJsonLine(cout, record);
+            });
+            if (action == "s")
+            {
+                if (format == "csv")
+                    stats.writeCsv(cout);
+                else
+                    stats.writeJson(cout);
+            }
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to scan the project directory: "<<e.what(); // Вывод сообщения об ошибке.
+            exit(1); // Завершение программы с кодом ошибки 1.
+        }
+        return 0;
+    }
+
+    // Обработка действия "очистить корзину": окончательное удаление артефактов ранее удалённых проектов.
+    if(action == "g") {
+        if (!exists(location))
+        {
+            cout<<("Non-existent directory"); // Вывод сообщения об ошибке.
+            exit(0);                        // Завершение программы с кодом 0.
+        }
+
+        try
+        {
+            size_t removed = collectTrash(location, jobs);
+            // После удаления проектов из корзины часть объектов хранилища могла остаться без ссылок.
+            size_t pruned = pruneArtifactStore(location, jobs);
+            cout<<"Removed "<<removed<<" files from the trash and "<<pruned<<" unreferenced objects from the artifact store";
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to empty the trash: "<<e.what(); // Вывод сообщения об ошибке.
+            exit(1); // Завершение программы с кодом ошибки 1.
+        }
+        return 0;
+    }
+
+    // Обработка действия "дедуплицировать": перенос Verilog-описания одного (-n) или всех проектов в хранилище по содержимому.
+    if(action == "d") {
+        if (!exists(location))
+        {
+            cout<<("Failed to find project directory"); // Вывод сообщения об ошибке.
+            exit(1);                                  // Завершение программы с кодом ошибки 1.
+        }
+
+        try
+        {
+            vector<string> names = name.empty() ? listProjectNames(location) : vector<string>{name};
+            DedupStats total;
+            for (const string& project : names)
+            {
+                DedupStats stats = deduplicateProject(location, project, jobs);
+                total.files += stats.files;
+                total.linked += stats.linked;
+                total.stored += stats.stored;
+                total.bytesSaved += stats.bytesSaved;
+            }
+            cout<<"Deduplicated "<<total.files<<" files: "<<total.linked<<" linked to existing objects, "
+                <<total.stored<<" new objects, "<<total.bytesSaved<<" bytes saved";
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to deduplicate: "<<e.what(); // Вывод сообщения об ошибке.
+            exit(1); // Завершение программы с кодом ошибки 1.
+        }
+        return 0;
+    }
+
+    // Обработка действия "архивировать": упаковка одного проекта (-n) или всех неактивных проектов по политике.
+    if(action == "a") {
+        if (!exists(location))
+        {
+            cout<<("Failed to find project directory"); // Вывод сообщения об ошибке.
+            exit(1);                                  // Завершение программы с кодом ошибки 1.
+        }
+
+        try
+        {
+            vector<string> names;
+            if (!name.empty())
+            {
+                if (!exists(location + "/" + name + "_metadata.json"))
+                {
+                    cout<<("Failed to find project metadata"); // Вывод сообщения об ошибке.
+                    exit(1);                                  // Завершение программы с кодом ошибки 1.
+                }
+                names.push_back(name);
+            }
+            else
+            {
+                // Параметры командной строки имеют приоритет над файлом archive_policy.json.
+                ArchivePolicy policy = archive_policy.empty() ? loadArchivePolicy(location) : archive_policy;
+                if (policy.empty())
+                {
+                    cout<<("No archive policy: use --max-idle-days, --keep-hot or archive_policy.json"); // Вывод сообщения об ошибке.
+                    exit(1); // Завершение программы с кодом ошибки 1.
+                }
+                names = selectProjectsToArchive(location, policy);
+            }
+
+            for (const string& project : names)
+            {
+                // По политике архив не перезаписывается: новые файлы проекта, у которого уже есть архив
+                // (например, после частичной распаковки), остаются на месте, остальные проекты архивируются.
+                if (name.empty() && exists(location + "/" + project + archiveSuffix))
+                {
+                    cout<<"Skipped "<<project<<": already archived\n";
+                    continue;
+                }
+                ArchiveStats stats = archiveProject(location, project, jobs);
+                cout<<"Archived "<<project<<": "<<stats.files<<" files, "<<stats.bytes<<" -> "<<stats.packedBytes<<" bytes\n";
+            }
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to archive: "<<e.what(); // Вывод сообщения об ошибке.
+            exit(1); // Завершение программы с кодом ошибки 1.
+        }
+        return 0;
+    }
+
+    // Обработка действия "сводка по графу": файл графа читается потоково, без загрузки целиком в память.
+    if(action == "gi") {
+        string graph_location = location + "/" + name + "_graph_object_serialized.json";
+        ifstream graph_file(graph_location, ios::binary);
+        if (!graph_file.is_open())
+        {
+            cout<<("Failed to find the serialized graph"); // Вывод сообщения об ошибке.
+            exit(1);                                     // Завершение программы с кодом ошибки 1.
+        }
+
+        try
+        {
+            noc::GraphJsonReader reader(graph_file);
+            uint64_t nodes = 0, edges = 0, max_radix = 0, max_node_ref = 0;
+            for (noc::GraphEvent event; (event = reader.next()) != noc::GraphEvent::End;)
+            {
+                if (event == noc::GraphEvent::Node)
+                {
+                    nodes++;
+                    max_radix = max<uint64_t>(max_radix, reader.node().radix);
+                    continue;
+                }
+                edges++;
+                // Узлы могут идти в файле после рёбер, поэтому проверяется только наибольший номер узла.
+                max_node_ref = max<uint64_t>(max_node_ref, max(reader.edge().src, reader.edge().dst));
+            }
+
+            const noc::GraphHeader& header = reader.header();
+            if (nodes != header.nodeCount || edges != header.edgeCount)
+                throw runtime_error("record count does not match nodeCount/edgeCount");
+            if (edges != 0 && max_node_ref >= nodes)
+                throw runtime_error("edge references a missing node");
+            json info = {{"name", name}, {"topology", header.topology}, {"params", header.params},
+                         {"nodes", nodes}, {"edges", edges}, {"maxRadix", max_radix}};
+            cout<<info.dump()<<"\n";
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to read the serialized graph: "<<e.what(); // Вывод сообщения об ошибке.
+            exit(1); // Завершение программы с кодом ошибки 1.
+        }
+        return 0;
+    }
+
+    // Обработка действия "запрос к хранилищу итогов": итоги всех проектов расположения читаются из results_store.bin.
+    if(action == "q") {
+        try
+        {
+            noc::ResultsQuery query = noc::parseResultsQuery(where, group_by, select);
+            noc::ResultsQueryResult result = noc::runResultsQuery(noc::ResultsTable::load(location), query);
+            if (format == "csv")
+            {
+                for (size_t c = 0; c < result.columns.size(); c++)
+                    cout<<(c ? "," : "")<<csvField(result.columns[c]);
+                cout<<"\n";
+            }
+            for (const vector<noc::ResultsValue>& row : result.rows)
+            {
+                nlohmann::ordered_json line = nlohmann::ordered_json::object(); // Столбцы в порядке запроса.
+                for (size_t c = 0; c < row.size(); c++)
+                {
+                    nlohmann::ordered_json value;
+                    if (const double* number = get_if<double>(&row[c]))
+                    {
+                        // Целые значения (count, параметры Nx/Ny, ресурсы) выводятся без дробной части.
+                        if (*number == trunc(*number) && fabs(*number) < 9007199254740992.0)
+                            value = static_cast<int64_t>(*number);
+                        else
+                            value = *number;
+                    }
+                    else if (const string* text = get_if<string>(&row[c]))
+                        value = *text;
+                    if (format == "jsonl")
+                    {
+                        line[result.columns[c]] = value;
+                        continue;
+                    }
+                    cout<<(c ? "," : "");
+                    if (!value.is_null())
+                        cout<<csvField(value.is_string() ? value.get<string>() : value.dump());
+                }
+                cout<<(format == "jsonl" ? line.dump() + "\n" : "\n");
+            }
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to query the results store: "<<e.what(); // Вывод сообщения об ошибке.
+            exit(1); // Завершение программы с кодом ошибки 1.
+        }
+        return 0;
+    }
+
     // Формирование путей к файлам и папкам проекта на основе полученных параметров.
     string metadata_location      = location + "/" + name + "_metadata.json";
     string new_metadata_location  = location + "/" + new_name + "_metadata.json";
-    string graph_location         = location + "/" + name + "_graph_object_serialized.json";
-    string new_graph_location     = location + "/" + new_name + "_graph_object_serialized.json";
-    string verilog_location       = location + "/" + name + "_NoC_description";
-    string new_verilog_location   = location + "/" + new_name + "_NoC_description";
-    // Обработка действий "открыть" и "переименовать".
-    if(action == "o"|| action == "r") {
+    // Обработка действий "открыть", "переименовать" и "клонировать".
+    if(action == "o"|| action == "r" || action == "cl") {
         // Проверка существования директории проекта.
         if (!exists(location))
         {
@@ -289,35 +484,56 @@ int main(int argc, char *argv[]) {
         }
 
 
+        // Если действие - "открыть".
+        if (action == "o")
+        {
+            try
+            {
+                // Прозрачная распаковка архивированного проекта.
+                if (exists(location + "/" + name + archiveSuffix))
+                {
+                    ArchiveStats stats = rehydrateProject(location, name, jobs);
+                    cout<<"Rehydrated "<<name<<": "<<stats.files<<" files, "<<stats.bytes<<" bytes";
+                    if (stats.kept > 0)
+                        cout<<" ("<<stats.kept<<" existing files differ from the archive and were kept)";
+                }
+                // Открытие обновляет время изменения метаданных, по которому политика архивации определяет активность.
+                last_write_time(metadata_location, file_time_type::clock::now());
+            }
+            catch (exception& e)
+            {
+                cout<<"Failed to rehydrate the project: "<<e.what(); // Вывод сообщения об ошибке.
+                exit(1); // Завершение программы с кодом ошибки 1.
+            }
+        }
+
         // Если действие - "переименовать".
         if (action == "r")
         {
-            // Изменение имени проекта в объекте ProjectSettings.
-            projectSettings.projectMetadata.name = new_name;
-            // Сериализация объекта ProjectSettings в JSON-формат с отступами.
-            json = nlohmann::json(projectSettings).dump(4);
-
             try
             {
+                // Метаданные перечитываются под блокировкой: процесс выгрузки Database_writer мог изменить их
+                // после чтения выше, а после удаления старого файла не должен записать его заново.
+                common::FileLock lock(common::metadataLockPath(metadata_location));
+                projectSettings = nlohmann::json::parse(readFile(metadata_location)).get<ProjectSettings>();
+                // Изменение имени проекта в объекте ProjectSettings.
+                projectSettings.projectMetadata.name = new_name;
+                // Сериализация объекта ProjectSettings в JSON-формат с отступами.
+                json = nlohmann::json(projectSettings).dump(4);
+
                 ofstream(new_metadata_location) << json;
 
                 // Удаление старого файла метаданных.
                 remove(metadata_location);
 
-                // Перемещение файла графа, если он существует.
-                if (exists(graph_location))
-                {
-                    rename(graph_location, new_graph_location);
-                }
-                // Перемещение файла метаданных, если он существует.
-                if (exists(metadata_location))
+                // Перемещение артефактов проекта (граф, Verilog-описание, выходные файлы Quartus), если они существуют.
+                for (const string& suffix : projectArtifactSuffixes)
                 {
-                    rename(metadata_location, new_metadata_location);
-                }
-                // Перемещение директории Verilog-описания, если она существует.
-                if (exists(verilog_location))
-                {
-                    rename(verilog_location, new_verilog_location);
+                    string artifact_location = location + "/" + name + suffix;
+                    if (exists(artifact_location))
+                    {
+                        rename(artifact_location, location + "/" + new_name + suffix);
+                    }
                 }
             }
             catch (exception e)
@@ -327,6 +543,42 @@ int main(int argc, char *argv[]) {
             }
         }
 
+        // Если действие - "клонировать".
+        if (action == "cl")
+        {
+            // Проверка, что проект с новым именем ещё не существует.
+            if (exists(new_metadata_location))
+            {
+                cout<<("Project "+new_name+" already exists"); // Вывод сообщения об ошибке.
+                exit(1); // Завершение программы с кодом ошибки 1.
+            }
+
+            try
+            {
+                // Клонирование графа и Verilog-описания: время зависит от числа файлов, а не от их объёма.
+                CloneStats stats = cloneProjectArtifacts(location, name, new_name, jobs, allow_hard_links);
+
+                // Результаты компиляции и записи в БД относятся к исходному проекту и не клонируются:
+                // от итогов компиляции остаётся только целевое устройство.
+                projectSettings.projectMetadata.name = new_name;
+                QuartusMetadata quartusMetadata;
+                quartusMetadata.deviceName = projectSettings.quartusMetadata.deviceName;
+                projectSettings.quartusMetadata = quartusMetadata;
+                projectSettings.databaseMetadata.writtenToDB = false;
+                projectSettings.databaseMetadata.synced = DatabaseSnapshot();
+                // Метаданные создаются последними, чтобы частично клонированный проект не был виден как готовый.
+                ofstream(new_metadata_location) << nlohmann::json(projectSettings).dump(4);
+
+                cout<<"Cloned "<<name<<" to "<<new_name<<": "<<stats.reflinked<<" reflinked, "
+                    <<stats.linked<<" hard-linked, "<<stats.copied<<" copied";
+            }
+            catch (exception& e)
+            {
+                cout<<"Failed to clone the project: "<<e.what(); // Вывод сообщения об ошибке.
+                exit(1); // Завершение программы с кодом ошибки 1.
+            }
+        }
+
     }
 
     // Обработка действия "создать".
@@ -389,21 +641,9 @@ int main(int argc, char *argv[]) {
 
         try
         {
-            // Удаление файла графа, если он существует.
-            if (exists(graph_location))
-            {
-                remove(graph_location);
-            }
-            // Удаление файла метаданных, если он существует.
-            if (exists(metadata_location))
-            {
-              remove(metadata_location);
-            }
-            // Удаление директории Verilog-описания, если она существует.
-            if (exists(verilog_location))
-            {
-                remove_all(verilog_location);
-            }
+            // Перемещение метаданных и артефактов проекта в корзину. Само удаление выполняется позже действием --gc,
+            // поэтому время удаления не зависит от размера Verilog-описания и выходных файлов Quartus.
+            moveProjectToTrash(location, name);
         }
         catch (exception e)
         {
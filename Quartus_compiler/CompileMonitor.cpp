@@ -0,0 +1,68 @@
+#include "CompileMonitor.hpp"
+#include <regex>
+#include <sstream>
+using namespace std;
+
+namespace {
+
+/// <summary>
+/// Сообщения Quartus, после которых компиляция заведомо завершится ошибкой.
+/// </summary>
+struct FatalMessage
+{
+    const char* text;
+    const char* reason;
+};
+
+const FatalMessage fatalMessages[] = {
+    // Error (170012): Fitter requires N LABs to implement the design, but the device contains only M LABs
+    {"but the device contains only", "resource overflow"},
+    // Error (170048): Selected device has N RAM location(s) of type M10K. However, the current design needs more than N ...
+    {"the current design needs more than", "resource overflow"},
+    // Error (11802): Can't fit design in device
+    {"Can't fit design in device", "resource overflow"},
+    // Error (170084)/(170113): Can't route signal ... / Can't place ...
+    {"Can't route", "fitter failure"},
+    {"Can't place", "fitter failure"},
+};
+
+} // namespace
+
+bool parseSlackEstimate(const string& line, double& slack)
+{
+    static const regex estimate(R"(Worst-case setup slack is (-?[0-9]+(\.[0-9]+)?))");
+    smatch match;
+    if (!regex_search(line, match, estimate))
+        return false;
+    slack = stod(match[1].str());
+    return true;
+}
+
+string abortReason(const AbortPolicy& policy, const string& tool, const string& line)
+{
+    // Признаки фатальных ошибок проверяются только в строках ошибок: например, "Can't place" встречается
+    // и в предупреждениях, после которых фиттер продолжает работу.
+    size_t start = line.find_first_not_of(" \t");
+    if (start != string::npos && line.compare(start, 5, "Error") == 0)
+    {
+        for (const FatalMessage& message : fatalMessages)
+            if (line.find(message.text) != string::npos)
+                return string(message.reason) + ": " + line;
+    }
+
+    // Загрузка ровно 100% в отчёте разведённых проектов встречается; сбой трассировки означает только превышение.
+    static const regex interconnect(R"(Peak interconnect usage is ([0-9]+)%)");
+    smatch match;
+    if (line.find("Peak interconnect usage") != string::npos && regex_search(line, match, interconnect)
+        && stoi(match[1].str()) > 100)
+        return "fitter failure: routing congestion (" + match[1].str() + "% interconnect usage)";
+
+    double slack = 0;
+    if (policy.checkSlack && tool == "quartus_fit" && parseSlackEstimate(line, slack) && slack < policy.minSlack)
+    {
+        ostringstream reason;
+        reason<<"timing estimate: setup slack "<<slack<<" ns below "<<policy.minSlack<<" ns";
+        return reason.str();
+    }
+    return string();
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+
+/// <summary>
+/// Условия досрочной остановки компиляции по выводу программ Quartus.
+/// Переполнение устройства и признаки неразводимого проекта проверяются всегда,
+/// оценка запаса по времени — только если задан порог.
+/// </summary>
+struct AbortPolicy
+{
+    /// <summary>
+    /// Останавливать фиттер, если его оценка запаса по установке ниже minSlack (нс).
+    /// </summary>
+    bool checkSlack = false;
+    double minSlack = 0;
+};
+
+/// <summary>
+/// Извлекает оценку запаса по установке из строки вывода "... Worst-case setup slack is X".
+/// </summary>
+/// <returns>true, если строка содержит оценку; значение записывается в slack.</returns>
+bool parseSlackEstimate(const std::string& line, double& slack);
+
+/// <summary>
+/// Проверяет строку вывода программы Quartus и возвращает причину остановки компиляции
+/// или пустую строку, если компиляцию нужно продолжать. Причины:
+/// - переполнение устройства: проекту не хватает логики, памяти или выводов выбранной ПЛИС;
+/// - предвестники сбоя фиттера: невозможность размещения или трассировки, загрузка трассировочных
+///   ресурсов выше 100%;
+/// - оценка запаса по установке во время работы фиттера ниже порога policy.minSlack.
+/// Признаки переполнения и невозможности размещения ищутся только в строках ошибок ("Error (...)"):
+/// те же слова встречаются в предупреждениях успешной компиляции.
+/// </summary>
+/// <param name="policy">Условия остановки.</param>
+/// <param name="tool">Программа, выводящая строку, например "quartus_fit".</param>
+/// <param name="line">Строка вывода.</param>
+std::string abortReason(const AbortPolicy& policy, const std::string& tool, const std::string& line);
@@ -0,0 +1,274 @@
+#include "DeviceCompile.hpp"
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include "Parallel.hpp"
+#include "QuartusProject.hpp"
+#include "QuartusRunner.hpp"
+#include "ReportParser.hpp"
+#include "SeedSweep.hpp"
+using namespace std;
+namespace fs = std::filesystem;
+
+const vector<string> compileStages = {"map", "fit", "asm", "sta"};
+
+namespace {
+
+/// <summary>
+/// Выводит строку целиком: при параллельной компиляции для нескольких устройств строки не перемешиваются.
+/// </summary>
+void say(const DeviceCompileOptions& options, const string& text)
+{
+    cout<<(options.tag + text + "\n")<<flush;
+}
+
+/// <summary>
+/// Готовит проект Quartus: план инкрементальной компиляции, файлы проекта, отпечатки для сохранения.
+/// </summary>
+void prepareProject(const DeviceCompileOptions& options)
+{
+    const string& quartus = options.quartusDirectory;
+    fs::create_directories(quartus);
+    IncrementalPlan plan = options.modules != nullptr
+        ? planIncrementalCompile(options.descriptionDirectory, quartus, *options.modules, options.full)
+        : planIncrementalCompile(options.descriptionDirectory, quartus, options.jobs, options.full);
+    writeIncrementalSettings(plan, (fs::path(quartus) / incrementalSettingsFileName).string());
+    QuartusProjectOptions project;
+    project.name = options.name;
+    project.deviceName = options.deviceName;
+    project.clockPeriod = options.clockPeriod;
+    project.threads = options.threads;
+    writeQuartusProject(options.descriptionDirectory, quartus, project, plan);
+    stageFingerprints(plan, quartus);
+    // Файл программирования прежней компиляции не соответствует новой.
+    fs::remove(fs::path(quartus) / "output_files" / (options.name + ".sof"));
+
+    for (const PartitionPlan& partition : plan.partitions)
+        if (!partition.reuse)
+            say(options, "Recompile " + partition.name + ": " + partition.reason);
+    ostringstream summary;
+    summary<<"Partitions: "<<plan.partitions.size()<<", reused: "<<plan.reused()
+           <<", recompiled: "<<plan.partitions.size() - plan.reused()<<(plan.full() ? " (full compile)" : "");
+    say(options, summary.str());
+}
+
+/// <summary>
+/// Выполняет стадию fit с несколькими начальными значениями фиттера.
+/// </summary>
+bool runSeeds(const DeviceCompileOptions& options, DeviceCompileResult& result, double& total)
+{
+    SeedSweepOptions sweepOptions;
+    sweepOptions.name = options.name;
+    sweepOptions.seeds = options.seeds;
+    sweepOptions.parallel = options.parallelSeeds == 0 ? options.seeds : options.parallelSeeds;
+    sweepOptions.margin = options.seedMargin;
+    sweepOptions.abort = options.abort;
+    sweepOptions.tag = options.tag;
+    SeedSweepResult sweep = runSeedSweep(options.toolDirectory, options.quartusDirectory, sweepOptions);
+    total += sweep.seconds;
+    for (const SeedOutcome& outcome : sweep.outcomes)
+    {
+        ostringstream line;
+        line<<"Seed "<<outcome.seed<<": ";
+        if (outcome.completed)
+            line<<"setup slack "<<outcome.slack<<" ns, Fmax "<<outcome.fmax<<" MHz";
+        else if (outcome.cancelled)
+            line<<"cancelled (estimated slack "<<outcome.slack<<" ns)";
+        else if (!outcome.abortReason.empty())
+            line<<"aborted ("<<outcome.abortReason<<")";
+        else
+            line<<"failed; log: "<<(fs::path(options.quartusDirectory) / ("seed_" + to_string(outcome.seed)) / "logs").string();
+        say(options, line.str());
+    }
+    if (sweep.winner == 0)
+    {
+        for (const SeedOutcome& outcome : sweep.outcomes)
+            if (!outcome.abortReason.empty())
+            {
+                result.abortReason = outcome.abortReason;
+                break;
+            }
+        result.error = "quartus_fit failed for all " + to_string(options.seeds) + " seeds";
+        return false;
+    }
+    ostringstream line;
+    line<<"quartus_fit: "<<sweep.seconds<<" s, selected seed "<<sweep.winner;
+    say(options, line.str());
+    return true;
+}
+
+/// <summary>
+/// Запускает программу стадии и останавливает её, если вывод показывает, что компиляция обречена.
+/// </summary>
+bool runStage(const DeviceCompileOptions& options, size_t index, DeviceCompileResult& result, double& total)
+{
+    // Quartus читает сгенерированный .qsf, но не переписывает его.
+    const vector<string> settingsArgs = {"--read_settings_files=on", "--write_settings_files=off"};
+    const string& stage = compileStages[index];
+    const string tool = "quartus_" + stage;
+    vector<string> arguments = {options.name, "-c", options.name};
+    if (stage == "map" || stage == "fit")
+        arguments.insert(arguments.end(), settingsArgs.begin(), settingsArgs.end());
+    ToolCancel cancel;
+    string reason;
+    ToolResult outcome = runTool(options.toolDirectory, tool, arguments, options.quartusDirectory, [&](const string& line)
+    {
+        if (!reason.empty())
+            return;
+        reason = abortReason(options.abort, tool, line);
+        if (!reason.empty())
+            cancel.cancel();
+    }, &cancel, options.tag + tool);
+    total += outcome.seconds;
+    ostringstream line;
+    if (!reason.empty())
+    {
+        result.abortReason = reason;
+        line<<tool<<" aborted after "<<outcome.seconds<<" s: "<<reason;
+        result.error = line.str();
+        return false;
+    }
+    if (!outcome.succeeded())
+    {
+        line<<tool<<" failed (exit code "<<outcome.exitCode<<", "<<outcome.errors<<" errors); log: "
+            <<(fs::path(options.quartusDirectory) / "logs" / (tool + ".log")).string();
+        result.error = line.str();
+        return false;
+    }
+    line<<tool<<": "<<outcome.seconds<<" s, "<<outcome.warnings<<" warnings";
+    say(options, line.str());
+    return true;
+}
+
+/// <summary>
+/// Читает оценку ресурсов из отчёта синтеза. Оценка необязательна: отчёт без неё не считается сбоем.
+/// </summary>
+void estimateResources(const DeviceCompileOptions& options, QuartusMetadata& results)
+{
+    try
+    {
+        parseSynthesisReport((fs::path(options.quartusDirectory) / "output_files" / (options.name + ".map.rpt")).string(), results);
+    }
+    catch (exception&)
+    {
+        results.estimatedAlms = 0;
+    }
+}
+
+/// <summary>
+/// Разбирает отчёты фиттера и анализатора временных характеристик.
+/// </summary>
+void collectResults(const DeviceCompileOptions& options, QuartusMetadata& results)
+{
+    const fs::path quartus = options.quartusDirectory;
+    const fs::path reports = quartus / "output_files";
+    results.deviceName = options.deviceName;
+    QuartusMetadata timing;
+    common::parallelFor(2, options.jobs, [&](size_t i)
+    {
+        if (i == 0)
+            parseFitReport((reports / (options.name + ".fit.rpt")).string(), results);
+        else
+            parseTimingReport((reports / (options.name + ".sta.rpt")).string(), timing);
+    });
+    results.clocks = move(timing.clocks);
+    results.quartusCompiled = true;
+    results.bitstreamGenerated = fs::exists(reports / (options.name + ".sof"));
+    results.seed = configuredSeed((quartus / (options.name + ".qsf")).string());
+
+    ostringstream resources;
+    resources<<"Resources: "<<results.alms<<" / "<<results.almsAvailable<<" ALMs, "<<results.registers<<" registers, "
+             <<results.ramBlocks<<" M10K, "<<results.dspBlocks<<" DSP";
+    say(options, resources.str());
+    for (const ClockTiming& clock : results.clocks)
+    {
+        ostringstream line;
+        line<<"Clock "<<clock.name<<": Fmax "<<clock.fmaxMhz<<" MHz (restricted "<<clock.restrictedFmaxMhz
+            <<" MHz), setup slack "<<clock.setupSlackNs<<" ns";
+        say(options, line.str());
+    }
+}
+
+} // namespace
+
+DeviceCompileResult compileDevice(const DeviceCompileOptions& options)
+{
+    DeviceCompileResult result;
+    const string& quartus = options.quartusDirectory;
+    if (options.first == 0)
+    {
+        try
+        {
+            prepareProject(options);
+        }
+        catch (exception& e)
+        {
+            result.error = string("Failed to prepare the Quartus project: ") + e.what();
+            return result;
+        }
+    }
+    else if (!fs::exists(fs::path(quartus) / (options.name + ".qsf")))
+    {
+        result.error = "Quartus project is not prepared; run the map stage first";
+        return result;
+    }
+
+    const bool single = options.first == options.last;
+    double total = 0;
+    for (size_t i = options.first; i <= options.last; i++)
+    {
+        if (options.exploration && !single && compileStages[i] == "asm")
+            continue;
+        bool succeeded = false;
+        try
+        {
+            succeeded = compileStages[i] == "fit" && options.seeds > 1
+                ? runSeeds(options, result, total)
+                : runStage(options, i, result, total);
+        }
+        catch (exception& e)
+        {
+            result.error = "quartus_" + compileStages[i] + " failed: " + e.what();
+        }
+        if (!succeeded)
+            return result;
+        // Оценка синтеза позволяет Broker сравнить проект с уже скомпилированными до запуска фиттера.
+        if (compileStages[i] == "map")
+            estimateResources(options, result.results);
+    }
+    if (options.last != compileStages.size() - 1)
+    {
+        result.succeeded = true;
+        return result;
+    }
+    if (options.first == 0)
+    {
+        ostringstream line;
+        line<<"Quartus compile finished in "<<total<<" s"<<(options.exploration ? " (exploration, no bitstream)" : "");
+        say(options, line.str());
+    }
+
+    // Итоги сохраняются в метаданных, чтобы следующие этапы не открывали отчёты Quartus.
+    try
+    {
+        collectResults(options, result.results);
+    }
+    catch (exception& e)
+    {
+        result.error = string("Failed to parse Quartus reports: ") + e.what();
+        return result;
+    }
+    // Отпечатки сохраняются только после успешной компиляции: при сбое следующий запуск перекомпилирует те же разделы.
+    try
+    {
+        commitFingerprints(quartus);
+    }
+    catch (exception& e)
+    {
+        result.error = string("Failed to save compile state: ") + e.what();
+        return result;
+    }
+    result.completed = true;
+    result.succeeded = true;
+    return result;
+}
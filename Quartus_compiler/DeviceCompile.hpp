@@ -0,0 +1,88 @@
+#pragma once
+#include <map>
+#include <string>
+#include <vector>
+#include "CompileMonitor.hpp"
+#include "IncrementalCompile.hpp"
+#include "ProjectSettings.hpp"
+
+/// <summary>
+/// Стадии компиляции по порядку: подготовка проекта выполняется перед первой, сохранение итогов — после последней.
+/// </summary>
+extern const std::vector<std::string> compileStages;
+
+/// <summary>
+/// Параметры компиляции сети для одного устройства.
+/// </summary>
+struct DeviceCompileOptions
+{
+    /// <summary>
+    /// Имя проекта NoC (ревизии Quartus) и каталог "<имя>_NoC_description".
+    /// </summary>
+    std::string name;
+    std::string descriptionDirectory;
+    /// <summary>
+    /// Каталог проекта Quartus этого устройства и обозначение устройства.
+    /// </summary>
+    std::string quartusDirectory;
+    std::string deviceName;
+    /// <summary>
+    /// Префикс строк в консоли (например, "5CGXFC9E7F35C8: "); пустой при компиляции для одного устройства.
+    /// </summary>
+    std::string tag;
+    /// <summary>
+    /// Каталог программ Quartus (результат resolveToolDirectory).
+    /// </summary>
+    std::string toolDirectory;
+    /// <summary>
+    /// Выполняемые стадии: индексы в compileStages от first до last включительно.
+    /// </summary>
+    size_t first = 0;
+    size_t last = 3;
+    bool full = false;
+    /// <summary>
+    /// Не запускать ассемблер в полной компиляции (режим исследования).
+    /// </summary>
+    bool exploration = false;
+    unsigned jobs = 1;
+    unsigned threads = 0;
+    double clockPeriod = 10.0;
+    unsigned seeds = 1;
+    unsigned parallelSeeds = 0;
+    double seedMargin = 0;
+    AbortPolicy abort;
+    /// <summary>
+    /// Отпечатки модулей описания сети; вычисляются один раз для всех устройств.
+    /// Нужны только для стадии map.
+    /// </summary>
+    const std::map<std::string, VerilogModule>* modules = nullptr;
+};
+
+/// <summary>
+/// Итог компиляции для одного устройства.
+/// </summary>
+struct DeviceCompileResult
+{
+    bool succeeded = false;
+    /// <summary>
+    /// Сообщение о сбое для консоли.
+    /// </summary>
+    std::string error;
+    /// <summary>
+    /// Причина досрочной остановки (см. abortReason); пустая, если остановки не было.
+    /// </summary>
+    std::string abortReason;
+    /// <summary>
+    /// Итоги компиляции; заполняются после успешной стадии sta, оценка estimatedAlms — после стадии map.
+    /// </summary>
+    bool completed = false;
+    QuartusMetadata results;
+};
+
+/// <summary>
+/// Выполняет стадии компиляции для одного устройства: подготовку проекта (план инкрементальной компиляции,
+/// файлы проекта Quartus), запуск программ Quartus с проверкой вывода, перебор начальных значений фиттера
+/// и разбор отчётов. Метаданные проекта не изменяются: их обновляет вызывающий по итогам всех устройств.
+/// Функцию можно вызывать параллельно для разных каталогов проекта Quartus.
+/// </summary>
+DeviceCompileResult compileDevice(const DeviceCompileOptions& options);
@@ -0,0 +1,426 @@
+#include "IncrementalCompile.hpp"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+#include "Hash.hpp"
+#include "Parallel.hpp"
+
+using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+const string fingerprintsFileName = "noc_fingerprints.json";
+
+const string incrementalSettingsFileName = "noc_incremental.qsf";
+
+namespace {
+
+/// <summary>
+/// Имя фрагмента с разделами, который Broker генерирует вместе с Verilog-описанием.
+/// </summary>
+const string floorplanFileName = "noc_floorplan.qsf";
+
+/// <summary>
+/// Каталог базы инкрементальной компиляции Quartus: без него сохранённых результатов разделов нет.
+/// </summary>
+const string incrementalDatabaseName = "incremental_db";
+
+/// <summary>
+/// Модуль верхнего уровня, относительно которого заданы пути экземпляров разделов.
+/// </summary>
+const string topModuleName = "noc_top";
+
+bool isIdentifierChar(char c)
+{
+    return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+}
+
+string readFile(const fs::path& path)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+        throw runtime_error("Failed to open " + path.string());
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+/// <summary>
+/// Удаляет комментарии и сжимает последовательности пробельных символов до одного пробела.
+/// Содержимое строковых литералов не изменяется.
+/// </summary>
+string normalizeVerilog(const string& source)
+{
+    string result;
+    result.reserve(source.size());
+    bool pendingSpace = false;
+    auto put = [&](char c)
+    {
+        if (pendingSpace && !result.empty())
+            result += ' ';
+        pendingSpace = false;
+        result += c;
+    };
+    for (size_t i = 0; i < source.size(); i++)
+    {
+        char c = source[i];
+        if (c == '/' && i + 1 < source.size() && source[i + 1] == '/')
+        {
+            while (i < source.size() && source[i] != '\n')
+                i++;
+            pendingSpace = true;
+        }
+        else if (c == '/' && i + 1 < source.size() && source[i + 1] == '*')
+        {
+            size_t end = source.find("*/", i + 2);
+            i = end == string::npos ? source.size() : end + 1;
+            pendingSpace = true;
+        }
+        else if (c == '"')
+        {
+            put(c);
+            for (i++; i < source.size() && source[i] != '"'; i++)
+            {
+                result += source[i];
+                if (source[i] == '\\' && i + 1 < source.size())
+                    result += source[++i];
+            }
+            if (i < source.size())
+                result += '"';
+        }
+        else if (isspace(static_cast<unsigned char>(c)))
+            pendingSpace = true;
+        else
+            put(c);
+    }
+    return result;
+}
+
+/// <summary>
+/// Ищет идентификатор word в text начиная с позиции from. Возвращает string::npos, если его нет.
+/// </summary>
+size_t findIdentifier(const string& text, const string& word, size_t from = 0)
+{
+    for (size_t pos = text.find(word, from); pos != string::npos; pos = text.find(word, pos + 1))
+    {
+        bool startOk = pos == 0 || !isIdentifierChar(text[pos - 1]);
+        bool endOk = pos + word.size() == text.size() || !isIdentifierChar(text[pos + word.size()]);
+        if (startOk && endOk)
+            return pos;
+    }
+    return string::npos;
+}
+
+/// <summary>
+/// Разбивает нормализованный текст файла на модули "module ... endmodule".
+/// </summary>
+vector<pair<string, VerilogModule>> splitModules(const string& file, const string& text)
+{
+    vector<pair<string, VerilogModule>> modules;
+    for (size_t begin = findIdentifier(text, "module"); begin != string::npos; begin = findIdentifier(text, "module", begin + 1))
+    {
+        size_t nameBegin = begin + 6;
+        while (nameBegin < text.size() && text[nameBegin] == ' ')
+            nameBegin++;
+        size_t nameEnd = nameBegin;
+        while (nameEnd < text.size() && isIdentifierChar(text[nameEnd]))
+            nameEnd++;
+        size_t end = findIdentifier(text, "endmodule", nameEnd);
+        if (nameEnd == nameBegin || end == string::npos)
+            throw runtime_error("Malformed module declaration in " + file);
+        end += 9;
+        VerilogModule module;
+        module.file = file;
+        module.text = text.substr(begin, end - begin);
+        modules.emplace_back(text.substr(nameBegin, nameEnd - nameBegin), move(module));
+        begin = end - 1;
+    }
+    return modules;
+}
+
+/// <summary>
+/// Вычисляет отпечатки модулей с учётом модулей, экземпляры которых они содержат.
+/// </summary>
+void resolveFingerprints(map<string, VerilogModule>& modules)
+{
+    map<string, uint64_t> own;
+    map<string, vector<string>> dependencies;
+    for (auto& [name, module] : modules)
+    {
+        own[name] = common::hash64(module.text);
+        set<string> used;
+        const string& text = module.text;
+        for (size_t i = 0; i < text.size();)
+        {
+            if (!isIdentifierChar(text[i]) || isdigit(static_cast<unsigned char>(text[i])))
+            {
+                i++;
+                continue;
+            }
+            size_t end = i;
+            while (end < text.size() && isIdentifierChar(text[end]))
+                end++;
+            string identifier = text.substr(i, end - i);
+            if (identifier != name && modules.count(identifier))
+                used.insert(identifier);
+            i = end;
+        }
+        dependencies[name].assign(used.begin(), used.end());
+    }
+
+    set<string> visiting;
+    function<uint64_t(const string&)> resolve = [&](const string& name) -> uint64_t
+    {
+        VerilogModule& module = modules.at(name);
+        if (module.fingerprint != 0)
+            return module.fingerprint;
+        if (!visiting.insert(name).second)
+            throw runtime_error("Recursive instantiation of module " + name);
+        // Зависимости перечислены в порядке имён, поэтому результат не зависит от порядка разбора файлов.
+        string combined = common::toHex(own[name]);
+        for (const string& dependency : dependencies[name])
+            combined += dependency + ":" + common::toHex(resolve(dependency)) + ";";
+        visiting.erase(name);
+        module.fingerprint = max<uint64_t>(common::hash64(combined), 1);
+        return module.fingerprint;
+    };
+    for (auto& [name, module] : modules)
+        resolve(name);
+}
+
+/// <summary>
+/// Раздел из noc_floorplan.qsf.
+/// </summary>
+struct PartitionAssignment
+{
+    string name;
+    string instance;
+};
+
+/// <summary>
+/// Читает назначения PARTITION_HIERARCHY (кроме корневого раздела Top) из фрагмента разбиения.
+/// </summary>
+vector<PartitionAssignment> readPartitions(const fs::path& path)
+{
+    vector<PartitionAssignment> partitions;
+    ifstream file(path);
+    if (!file)
+        return partitions;
+    const string prefix = "set_instance_assignment -name PARTITION_HIERARCHY ";
+    string line;
+    while (getline(file, line))
+    {
+        if (line.compare(0, prefix.size(), prefix) != 0)
+            continue;
+        istringstream fields(line.substr(prefix.size()));
+        PartitionAssignment partition;
+        string option;
+        fields >> partition.name >> option;
+        size_t open = line.find('"'), close = line.rfind('"');
+        if (option != "-to" || open == string::npos || close == open)
+            continue; // root_partition задаётся как "-to |" без кавычек.
+        partition.instance = line.substr(open + 1, close - open - 1);
+        partitions.push_back(partition);
+    }
+    return partitions;
+}
+
+/// <summary>
+/// Текст, от которого зависит раздел с путём instance: отпечаток модуля экземпляра, оператор
+/// создания экземпляра в родительском модуле и объявления параметров родителя.
+/// </summary>
+string partitionSource(const map<string, VerilogModule>& modules, const string& instance, string& module)
+{
+    // Путь Quartus: "модуль:экземпляр|модуль:экземпляр", блоки generate — "метка[индекс].".
+    vector<string> components;
+    istringstream path(instance);
+    for (string component; getline(path, component, '|');)
+        components.push_back(component);
+    if (components.empty())
+        return string();
+    const string& component = components.back();
+    string parent = components.size() > 1 ? components[components.size() - 2].substr(0, components[components.size() - 2].find(':'))
+                                          : topModuleName;
+    size_t colon = component.find(':');
+    module = component.substr(0, colon);
+    string instanceName = colon == string::npos ? string() : component.substr(colon + 1);
+    size_t dot = instanceName.rfind('.');
+    if (dot != string::npos)
+        instanceName = instanceName.substr(dot + 1);
+
+    auto found = modules.find(module);
+    if (found == modules.end())
+        return string();
+    string source = "module:" + common::toHex(found->second.fingerprint) + "\n";
+
+    auto parentModule = modules.find(parent);
+    if (parentModule == modules.end())
+        return source;
+    const string& text = parentModule->second.text;
+    // Заголовок родителя (до первой ';') содержит #(parameter ...), остальные параметры — отдельные операторы.
+    source += "header:" + text.substr(0, text.find(';')) + "\n";
+    for (const string keyword : {"parameter", "localparam", "defparam"})
+        for (size_t pos = findIdentifier(text, keyword); pos != string::npos; pos = findIdentifier(text, keyword, pos + 1))
+            source += text.substr(pos, text.find(';', pos) - pos) + "\n";
+    // Оператор создания экземпляра: от имени модуля до ';', содержащий имя экземпляра.
+    for (size_t pos = findIdentifier(text, module); pos != string::npos; pos = findIdentifier(text, module, pos + 1))
+    {
+        string statement = text.substr(pos, text.find(';', pos) - pos);
+        if (instanceName.empty() || findIdentifier(statement, instanceName) != string::npos)
+        {
+            source += "instance:" + statement + "\n";
+            break;
+        }
+    }
+    return source;
+}
+
+} // namespace
+
+size_t IncrementalPlan::reused() const
+{
+    return count_if(partitions.begin(), partitions.end(), [](const PartitionPlan& p) { return p.reuse; });
+}
+
+map<string, VerilogModule> fingerprintModules(const string& directory, unsigned jobs)
+{
+    vector<fs::path> files;
+    for (const fs::directory_entry& entry : fs::directory_iterator(directory))
+        if (entry.is_regular_file() && entry.path().extension() == ".v")
+            files.push_back(entry.path());
+    sort(files.begin(), files.end());
+
+    vector<vector<pair<string, VerilogModule>>> parsed(files.size());
+    common::parallelFor(files.size(), jobs, [&](size_t i)
+    {
+        parsed[i] = splitModules(files[i].filename().string(), normalizeVerilog(readFile(files[i])));
+    });
+
+    map<string, VerilogModule> modules;
+    for (auto& fileModules : parsed)
+        for (auto& [name, module] : fileModules)
+            if (!modules.emplace(name, move(module)).second)
+                throw runtime_error("Module " + name + " is defined more than once");
+    resolveFingerprints(modules);
+    return modules;
+}
+
+IncrementalPlan planIncrementalCompile(const string& descriptionDirectory, const string& quartusDirectory,
+                                       unsigned jobs, bool forceFull)
+{
+    return planIncrementalCompile(descriptionDirectory, quartusDirectory, fingerprintModules(descriptionDirectory, jobs),
+                                  forceFull);
+}
+
+IncrementalPlan planIncrementalCompile(const string& descriptionDirectory, const string& quartusDirectory,
+                                       map<string, VerilogModule> modules, bool forceFull)
+{
+    IncrementalPlan plan;
+    plan.modules = move(modules);
+
+    json previous = json::object();
+    fs::path manifest = fs::path(quartusDirectory) / fingerprintsFileName;
+    if (fs::exists(manifest))
+    {
+        try
+        {
+            previous = json::parse(readFile(manifest));
+        }
+        catch (exception&)
+        {
+            previous = json::object(); // Повреждённый манифест означает полную компиляцию.
+        }
+    }
+    const json& previousModules = previous.contains("modules") ? previous["modules"] : json::object();
+    const json& previousPartitions = previous.contains("partitions") ? previous["partitions"] : json::object();
+    const bool preserved = fs::is_directory(fs::path(quartusDirectory) / incrementalDatabaseName);
+
+    for (const PartitionAssignment& assignment : readPartitions(fs::path(descriptionDirectory) / floorplanFileName))
+    {
+        PartitionPlan partition;
+        partition.name = assignment.name;
+        partition.instance = assignment.instance;
+        string module;
+        string source = partitionSource(plan.modules, assignment.instance, module);
+        partition.fingerprint = source.empty() ? 0 : max<uint64_t>(common::hash64(source), 1);
+
+        const string fingerprint = common::toHex(partition.fingerprint);
+        const auto last = previousPartitions.find(partition.name);
+        if (partition.fingerprint == 0)
+            partition.reason = "module " + module + " not found";
+        else if (forceFull)
+            partition.reason = "full compile requested";
+        else if (!preserved)
+            partition.reason = "no preserved results";
+        else if (last == previousPartitions.end() || !last->is_string())
+            partition.reason = "new partition";
+        else if (*last != fingerprint)
+        {
+            const auto lastModule = previousModules.find(module);
+            bool moduleChanged = lastModule == previousModules.end()
+                || *lastModule != common::toHex(plan.modules.at(module).fingerprint);
+            partition.reason = moduleChanged ? "module " + module + " changed" : "instantiation changed";
+        }
+        else
+            partition.reuse = true;
+        plan.partitions.push_back(move(partition));
+    }
+    return plan;
+}
+
+string incrementalSettings(const IncrementalPlan& plan)
+{
+    ostringstream out;
+    out << "# Инкрементальная компиляция: из предыдущей компиляции берётся " << plan.reused()
+        << " из " << plan.partitions.size() << " разделов.\n";
+    out << "set_global_assignment -name PARTITION_NETLIST_TYPE SOURCE -section_id Top\n";
+    for (const PartitionPlan& partition : plan.partitions)
+        out << "set_global_assignment -name PARTITION_NETLIST_TYPE " << (partition.reuse ? "POST_FIT" : "SOURCE")
+            << " -section_id " << partition.name << "\n";
+    return out.str();
+}
+
+void writeIncrementalSettings(const IncrementalPlan& plan, const string& path)
+{
+    string tmp = path + ".tmp";
+    {
+        ofstream file(tmp, ios::binary | ios::trunc);
+        file << incrementalSettings(plan);
+        if (!file)
+            throw runtime_error("Failed to write " + path);
+    }
+    fs::rename(tmp, path);
+}
+
+void stageFingerprints(const IncrementalPlan& plan, const string& quartusDirectory)
+{
+    json manifest = {{"modules", json::object()}, {"partitions", json::object()}};
+    for (const auto& [name, module] : plan.modules)
+        manifest["modules"][name] = common::toHex(module.fingerprint);
+    for (const PartitionPlan& partition : plan.partitions)
+        if (partition.fingerprint != 0)
+            manifest["partitions"][partition.name] = common::toHex(partition.fingerprint);
+
+    fs::path path = fs::path(quartusDirectory) / (fingerprintsFileName + ".pending");
+    fs::path tmp = path;
+    tmp += ".tmp";
+    {
+        ofstream file(tmp, ios::binary | ios::trunc);
+        file << manifest.dump(1) << "\n";
+        if (!file)
+            throw runtime_error("Failed to write " + path.string());
+    }
+    fs::rename(tmp, path);
+}
+
+void commitFingerprints(const string& quartusDirectory)
+{
+    fs::path pending = fs::path(quartusDirectory) / (fingerprintsFileName + ".pending");
+    if (!fs::exists(pending))
+        throw runtime_error("No pending fingerprints in " + quartusDirectory);
+    fs::rename(pending, fs::path(quartusDirectory) / fingerprintsFileName);
+}
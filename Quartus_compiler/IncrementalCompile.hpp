@@ -0,0 +1,123 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Имя файла с отпечатками последней успешной компиляции в каталоге "<имя>_quartus".
+/// </summary>
+extern const std::string fingerprintsFileName;
+
+/// <summary>
+/// Имя фрагмента настроек с типом списка соединений каждого раздела в каталоге "<имя>_quartus".
+/// </summary>
+extern const std::string incrementalSettingsFileName;
+
+/// <summary>
+/// Модуль Verilog, найденный в каталоге описания сети.
+/// </summary>
+struct VerilogModule
+{
+    /// <summary>
+    /// Имя файла внутри каталога описания.
+    /// </summary>
+    std::string file;
+    /// <summary>
+    /// Текст модуля от "module" до "endmodule" без комментариев, с пробелами, сжатыми до одного.
+    /// Правка комментариев и форматирования не меняет отпечаток.
+    /// </summary>
+    std::string text;
+    /// <summary>
+    /// XXH64 нормализованного текста модуля и (рекурсивно) всех модулей, экземпляры которых он содержит.
+    /// </summary>
+    uint64_t fingerprint = 0;
+};
+
+/// <summary>
+/// Решение для одного раздела проекта.
+/// </summary>
+struct PartitionPlan
+{
+    std::string name;
+    /// <summary>
+    /// Путь экземпляра раздела ("модуль:экземпляр").
+    /// </summary>
+    std::string instance;
+    uint64_t fingerprint = 0;
+    /// <summary>
+    /// true — раздел не изменился и берётся из предыдущей компиляции (POST_FIT),
+    /// false — компилируется из исходников (SOURCE).
+    /// </summary>
+    bool reuse = false;
+    /// <summary>
+    /// Причина перекомпиляции для отчёта (пусто, если раздел переиспользуется).
+    /// </summary>
+    std::string reason;
+};
+
+/// <summary>
+/// План инкрементальной компиляции: отпечатки модулей и решения по разделам.
+/// </summary>
+struct IncrementalPlan
+{
+    std::map<std::string, VerilogModule> modules;
+    std::vector<PartitionPlan> partitions;
+
+    size_t reused() const;
+    /// <summary>
+    /// true, если переиспользуемых разделов нет и компиляция фактически полная.
+    /// </summary>
+    bool full() const { return reused() == 0; }
+};
+
+/// <summary>
+/// Находит все модули в файлах *.v каталога и вычисляет их отпечатки (файлы разбираются параллельно).
+/// </summary>
+/// <param name="directory">Каталог "<имя>_NoC_description".</param>
+/// <param name="jobs">Число потоков.</param>
+std::map<std::string, VerilogModule> fingerprintModules(const std::string& directory, unsigned jobs);
+
+/// <summary>
+/// Строит план инкрементальной компиляции.
+/// Разделы берутся из назначений PARTITION_HIERARCHY файла noc_floorplan.qsf. Отпечаток раздела включает
+/// отпечаток модуля экземпляра, текст оператора, создающего экземпляр в родительском модуле, и объявления
+/// параметров родителя: от них зависят значения параметров, переданные разделу.
+/// Раздел переиспользуется, если его отпечаток совпал с отпечатком последней успешной компиляции
+/// и в каталоге Quartus есть сохранённая база инкрементальной компиляции.
+/// </summary>
+/// <param name="descriptionDirectory">Каталог "<имя>_NoC_description".</param>
+/// <param name="quartusDirectory">Каталог "<имя>_quartus".</param>
+/// <param name="jobs">Число потоков.</param>
+/// <param name="forceFull">Перекомпилировать все разделы.</param>
+IncrementalPlan planIncrementalCompile(const std::string& descriptionDirectory, const std::string& quartusDirectory,
+                                       unsigned jobs, bool forceFull);
+
+/// <summary>
+/// Строит план по готовым отпечаткам модулей: так одно описание сети разбирается один раз
+/// для нескольких каталогов Quartus (компиляция для нескольких устройств).
+/// </summary>
+IncrementalPlan planIncrementalCompile(const std::string& descriptionDirectory, const std::string& quartusDirectory,
+                                       std::map<std::string, VerilogModule> modules, bool forceFull);
+
+/// <summary>
+/// Возвращает назначения PARTITION_NETLIST_TYPE каждого раздела (POST_FIT или SOURCE) в формате .qsf.
+/// </summary>
+std::string incrementalSettings(const IncrementalPlan& plan);
+
+/// <summary>
+/// Записывает фрагмент настроек с PARTITION_NETLIST_TYPE каждого раздела (POST_FIT или SOURCE).
+/// </summary>
+void writeIncrementalSettings(const IncrementalPlan& plan, const std::string& path);
+
+/// <summary>
+/// Сохраняет отпечатки плана рядом с отпечатками последней успешной компиляции ("noc_fingerprints.json.pending").
+/// Вызывается при подготовке проекта: стадии компиляции могут выполняться отдельными запусками.
+/// </summary>
+void stageFingerprints(const IncrementalPlan& plan, const std::string& quartusDirectory);
+
+/// <summary>
+/// Делает отпечатки, сохранённые stageFingerprints, отпечатками последней успешной компиляции.
+/// Вызывается только после успешного завершения компиляции.
+/// </summary>
+void commitFingerprints(const std::string& quartusDirectory);
@@ -0,0 +1,107 @@
+#include "QuartusProject.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+/// <summary>
+/// Префиксы обозначений устройств и соответствующие семейства Quartus.
+/// Более длинные префиксы проверяются раньше.
+/// </summary>
+const vector<pair<string, string>> devicePrefixes = {
+    {"10AX", "Arria 10"},
+    {"10AS", "Arria 10"},
+    {"10CL", "Cyclone 10 LP"},
+    {"10CX", "Cyclone 10 GX"},
+    {"EP4CE", "Cyclone IV E"},
+    {"EP4CGX", "Cyclone IV GX"},
+    {"10M", "MAX 10"},
+    {"1SG", "Stratix 10"},
+    {"1SX", "Stratix 10"},
+    {"5CE", "Cyclone V"},
+    {"5CG", "Cyclone V"},
+    {"5CS", "Cyclone V"},
+    {"5A", "Arria V"},
+    {"5S", "Stratix V"},
+};
+
+void writeAtomically(const fs::path& path, const string& content)
+{
+    fs::path tmp = path;
+    tmp += ".tmp";
+    {
+        ofstream file(tmp, ios::binary | ios::trunc);
+        file << content;
+        if (!file)
+            throw runtime_error("Failed to write " + path.string());
+    }
+    fs::rename(tmp, path);
+}
+
+} // namespace
+
+string deviceFamily(const string& deviceName)
+{
+    for (const auto& [prefix, family] : devicePrefixes)
+        if (deviceName.compare(0, prefix.size(), prefix) == 0)
+            return family;
+    return string();
+}
+
+void writeQuartusProject(const string& descriptionDirectory, const string& quartusDirectory,
+                         const QuartusProjectOptions& options, const IncrementalPlan& plan)
+{
+    const fs::path dir = quartusDirectory;
+    // Каталог проекта может быть вложен в "<имя>_quartus" (компиляция для нескольких устройств).
+    const string relativeDescription =
+        fs::relative(fs::absolute(descriptionDirectory), fs::absolute(quartusDirectory)).generic_string();
+
+    ostringstream qpf;
+    qpf << "# Проект Quartus сети " << options.name << ". Генерируется Quartus_compiler.\n"
+        << "PROJECT_REVISION = \"" << options.name << "\"\n";
+    writeAtomically(dir / (options.name + ".qpf"), qpf.str());
+
+    ostringstream sdc;
+    sdc << "create_clock -name clk -period " << options.clockPeriod << " [get_ports clk]\n"
+        << "derive_clock_uncertainty\n";
+    writeAtomically(dir / (options.name + ".sdc"), sdc.str());
+
+    vector<string> sources;
+    for (const fs::directory_entry& entry : fs::directory_iterator(descriptionDirectory))
+        if (entry.is_regular_file() && entry.path().extension() == ".v")
+            sources.push_back(entry.path().filename().string());
+    sort(sources.begin(), sources.end());
+
+    ostringstream qsf;
+    qsf << "# Настройки проекта Quartus сети " << options.name << ".\n"
+        << "# Файл пересоздаётся Quartus_compiler при каждой компиляции; правки вносите в метаданные проекта.\n\n";
+    string family = deviceFamily(options.deviceName);
+    if (!family.empty())
+        qsf << "set_global_assignment -name FAMILY \"" << family << "\"\n";
+    qsf << "set_global_assignment -name DEVICE " << options.deviceName << "\n"
+        << "set_global_assignment -name TOP_LEVEL_ENTITY noc_top\n"
+        << "set_global_assignment -name PROJECT_OUTPUT_DIRECTORY output_files\n"
+        << "set_global_assignment -name SDC_FILE " << options.name << ".sdc\n";
+    if (options.threads != 0)
+        qsf << "set_global_assignment -name NUM_PARALLEL_PROCESSORS " << options.threads << "\n";
+    for (const string& source : sources)
+        qsf << "set_global_assignment -name VERILOG_FILE " << relativeDescription << "/" << source << "\n";
+    qsf << "\n";
+
+    // Типы списков соединений разделов задаёт план инкрементальной компиляции, остальные назначения
+    // разбиения переносятся без изменений.
+    ifstream floorplan(fs::path(descriptionDirectory) / "noc_floorplan.qsf");
+    for (string line; getline(floorplan, line);)
+        if (line.find("-name PARTITION_NETLIST_TYPE ") == string::npos)
+            qsf << line << "\n";
+    qsf << "\n" << incrementalSettings(plan);
+    writeAtomically(dir / (options.name + ".qsf"), qsf.str());
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include "IncrementalCompile.hpp"
+
+/// <summary>
+/// Параметры генерируемого проекта Quartus.
+/// </summary>
+struct QuartusProjectOptions
+{
+    /// <summary>
+    /// Имя проекта NoC; совпадает с именем ревизии Quartus.
+    /// </summary>
+    std::string name;
+    /// <summary>
+    /// Устройство из метаданных проекта (QuartusMetadata::deviceName).
+    /// </summary>
+    std::string deviceName;
+    /// <summary>
+    /// Период тактового сигнала clk в наносекундах для анализа временных характеристик.
+    /// </summary>
+    double clockPeriod = 10.0;
+    /// <summary>
+    /// Число потоков, которое могут использовать программы Quartus (NUM_PARALLEL_PROCESSORS);
+    /// 0 — значение Quartus по умолчанию.
+    /// </summary>
+    unsigned threads = 0;
+};
+
+/// <summary>
+/// Определяет семейство ПЛИС по обозначению устройства (например, "5CGXFC9E7F35C8" — Cyclone V).
+/// Возвращает пустую строку, если семейство не распознано: тогда Quartus определит его сам.
+/// </summary>
+std::string deviceFamily(const std::string& deviceName);
+
+/// <summary>
+/// Генерирует файлы проекта Quartus в каталоге "<имя>_quartus": "<имя>.qpf", "<имя>.qsf" и "<имя>.sdc".
+/// Файл настроек пересоздаётся при каждом запуске: в него включаются все Verilog-файлы описания сети,
+/// назначения разделов и областей из noc_floorplan.qsf и типы списков соединений разделов из плана
+/// инкрементальной компиляции. Файлы записываются во временные и переименовываются.
+/// </summary>
+/// <param name="descriptionDirectory">Каталог "<имя>_NoC_description".</param>
+/// <param name="quartusDirectory">Каталог "<имя>_quartus".</param>
+/// <param name="options">Параметры проекта.</param>
+/// <param name="plan">План инкрементальной компиляции.</param>
+void writeQuartusProject(const std::string& descriptionDirectory, const std::string& quartusDirectory,
+                         const QuartusProjectOptions& options, const IncrementalPlan& plan);
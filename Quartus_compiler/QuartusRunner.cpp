@@ -0,0 +1,275 @@
+#include "QuartusRunner.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <regex>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <csignal>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+#if defined(_WIN32)
+const string executableSuffix = ".exe";
+
+/// <summary>
+/// Наследуемый конец канала существует от CreatePipe до закрытия после CreateProcess. Если в это время
+/// другой поток запустит свою программу, она унаследует чужой конец канала, и чтение вывода первой
+/// программы не завершится, пока не завершится вторая. Поэтому каналы и процессы создаются поочерёдно.
+/// </summary>
+mutex inheritAccess;
+#else
+const string executableSuffix = "";
+#endif
+
+/// <summary>
+/// Разбирает итоговую строку программы Quartus: "... was successful. 0 errors, 12 warnings".
+/// </summary>
+void parseSummary(const string& line, ToolResult& result)
+{
+    if (line.find("was successful") == string::npos && line.find("was unsuccessful") == string::npos)
+        return;
+    static const regex counts(R"((\d+) errors?, (\d+) warnings?)");
+    smatch match;
+    if (regex_search(line, match, counts))
+    {
+        result.errors = stoi(match[1].str());
+        result.warnings = stoi(match[2].str());
+    }
+}
+
+/// <summary>
+/// Останавливает процесс (с порождёнными процессами), связанный с ToolCancel.
+/// </summary>
+void terminate(long long process)
+{
+#if defined(_WIN32)
+    TerminateJobObject(reinterpret_cast<HANDLE>(process), 1);
+#else
+    kill(-static_cast<pid_t>(process), SIGTERM);
+#endif
+}
+
+} // namespace
+
+void ToolCancel::cancel()
+{
+    lock_guard<mutex> lock(access);
+    requested = true;
+    if (process != 0)
+        terminate(process);
+}
+
+bool ToolCancel::cancelled() const
+{
+    lock_guard<mutex> lock(access);
+    return requested;
+}
+
+bool ToolCancel::attach(long long handle)
+{
+    lock_guard<mutex> lock(access);
+    process = handle;
+    return !requested;
+}
+
+void ToolCancel::detach()
+{
+    lock_guard<mutex> lock(access);
+    process = 0;
+}
+
+string resolveToolDirectory(const string& configured)
+{
+    string root = configured;
+    if (root.empty())
+    {
+        const char* env = getenv("QUARTUS_ROOTDIR");
+        root = env == nullptr ? "" : env;
+    }
+    if (root.empty())
+        return string();
+    for (const char* sub : {"bin64", "bin", ""})
+    {
+        fs::path dir = fs::path(root) / sub;
+        if (fs::exists(dir / ("quartus_map" + executableSuffix)))
+            return dir.string();
+    }
+    return root;
+}
+
+ToolResult runTool(const string& toolDirectory, const string& tool, const vector<string>& arguments,
+                   const string& projectDirectory, const function<void(const string&)>& onLine,
+                   ToolCancel* cancel, const string& label)
+{
+    ToolResult result;
+    result.tool = tool;
+    const string prefix = "[" + (label.empty() ? tool : label) + "] ";
+    const string executable = toolDirectory.empty() ? tool : fs::absolute(fs::path(toolDirectory) / tool).string();
+
+    fs::create_directories(fs::path(projectDirectory) / "logs");
+    ofstream log(fs::path(projectDirectory) / "logs" / (tool + ".log"), ios::trunc);
+
+    string line;
+    auto emit = [&]()
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        cout<<(prefix + line + "\n")<<flush;
+        log<<line<<"\n";
+        parseSummary(line, result);
+        if (onLine)
+            onLine(line);
+        line.clear();
+    };
+    // Делит прочитанный блок вывода на строки.
+    auto consume = [&](const char* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            if (data[i] == '\n')
+                emit();
+            else
+                line += data[i];
+        }
+    };
+
+    auto start = chrono::steady_clock::now();
+#if defined(_WIN32)
+    string commandLine = "\"" + executable + "\"";
+    for (const string& argument : arguments)
+        commandLine += " \"" + argument + "\"";
+
+    // Процесс помещается в объект задания, чтобы остановка завершала и порождённые им процессы.
+    HANDLE job = CreateJobObjectA(nullptr, nullptr);
+    HANDLE readPipe = nullptr;
+    PROCESS_INFORMATION info{};
+    {
+        lock_guard<mutex> inherit(inheritAccess);
+        SECURITY_ATTRIBUTES security{sizeof(security), nullptr, TRUE};
+        HANDLE writePipe = nullptr;
+        if (!CreatePipe(&readPipe, &writePipe, &security, 0))
+        {
+            CloseHandle(job);
+            return result;
+        }
+        SetHandleInformation(readPipe, HANDLE_FLAG_INHERIT, 0);
+        STARTUPINFOA startup{};
+        startup.cb = sizeof(startup);
+        startup.dwFlags = STARTF_USESTDHANDLES;
+        startup.hStdOutput = writePipe;
+        startup.hStdError = writePipe;
+        startup.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        const bool started = CreateProcessA(nullptr, commandLine.data(), nullptr, nullptr, TRUE,
+                                            CREATE_SUSPENDED | CREATE_NO_WINDOW, nullptr, projectDirectory.c_str(),
+                                            &startup, &info);
+        CloseHandle(writePipe);
+        if (!started)
+        {
+            CloseHandle(readPipe);
+            CloseHandle(job);
+            return result;
+        }
+    }
+    AssignProcessToJobObject(job, info.hProcess);
+    if (cancel != nullptr && !cancel->attach(reinterpret_cast<long long>(job)))
+        TerminateJobObject(job, 1);
+    ResumeThread(info.hThread);
+
+    char buffer[4096];
+    DWORD read = 0;
+    while (ReadFile(readPipe, buffer, sizeof(buffer), &read, nullptr) && read != 0)
+        consume(buffer, read);
+    WaitForSingleObject(info.hProcess, INFINITE);
+    DWORD exitCode = 0;
+    GetExitCodeProcess(info.hProcess, &exitCode);
+    result.exitCode = static_cast<int>(exitCode);
+    if (cancel != nullptr)
+        cancel->detach();
+    CloseHandle(readPipe);
+    CloseHandle(info.hProcess);
+    CloseHandle(info.hThread);
+    CloseHandle(job);
+#else
+    // Аргументы готовятся до fork: в дочернем процессе допустимы только простые системные вызовы.
+    vector<char*> argv;
+    argv.push_back(const_cast<char*>(executable.c_str()));
+    for (const string& argument : arguments)
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    argv.push_back(nullptr);
+
+    // Концы канала не наследуются программами, которые параллельно запускают другие потоки: иначе чтение
+    // вывода не завершится, пока жива чужая программа. В дочернем процессе dup2 снимает флаг с stdout и stderr.
+    int fds[2];
+#if defined(__APPLE__)
+    if (pipe(fds) != 0)
+        return result;
+    fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+#else
+    if (pipe2(fds, O_CLOEXEC) != 0)
+        return result;
+#endif
+    cout.flush();
+    pid_t pid = fork();
+    if (pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        return result;
+    }
+    if (pid == 0)
+    {
+        // Отдельная группа процессов: остановка завершает и процессы, порождённые программой.
+        setpgid(0, 0);
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        if (chdir(projectDirectory.c_str()) != 0)
+            _exit(127);
+        execvp(argv[0], argv.data());
+        _exit(127);
+    }
+    setpgid(pid, pid);
+    close(fds[1]);
+    if (cancel != nullptr && !cancel->attach(pid))
+        kill(-pid, SIGTERM);
+
+    char buffer[4096];
+    for (;;)
+    {
+        ssize_t read = ::read(fds[0], buffer, sizeof(buffer));
+        if (read > 0)
+            consume(buffer, static_cast<size_t>(read));
+        else if (read == 0 || errno != EINTR)
+            break;
+    }
+    close(fds[0]);
+    int status = 0;
+    while (waitpid(pid, &status, 0) < 0 && errno == EINTR)
+        ;
+    if (cancel != nullptr)
+        cancel->detach();
+    result.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+#endif
+    if (!line.empty())
+        emit();
+    result.cancelled = cancel != nullptr && cancel->cancelled();
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// Итог запуска одной программы Quartus (quartus_map, quartus_fit, quartus_asm, quartus_sta).
+/// </summary>
+struct ToolResult
+{
+    std::string tool;
+    /// <summary>
+    /// Код завершения процесса; -1, если процесс не удалось запустить или он был остановлен.
+    /// </summary>
+    int exitCode = -1;
+    /// <summary>
+    /// Число ошибок и предупреждений из итоговой строки программы
+    /// ("Quartus Prime Fitter was successful. 0 errors, 12 warnings").
+    /// </summary>
+    int errors = 0;
+    int warnings = 0;
+    /// <summary>
+    /// Время работы программы в секундах.
+    /// </summary>
+    double seconds = 0;
+    /// <summary>
+    /// true, если процесс был остановлен через ToolCancel.
+    /// </summary>
+    bool cancelled = false;
+
+    bool succeeded() const { return exitCode == 0 && !cancelled; }
+};
+
+/// <summary>
+/// Позволяет остановить выполняемую программу Quartus из другого потока или из обработчика строк вывода.
+/// Останавливается процесс вместе со всеми порождёнными им процессами.
+/// </summary>
+class ToolCancel
+{
+public:
+    /// <summary>
+    /// Останавливает процесс; если он ещё не запущен — не даёт ему запуститься.
+    /// </summary>
+    void cancel();
+    bool cancelled() const;
+
+    /// <summary>
+    /// Связывает объект с запущенным процессом (вызывается runTool).
+    /// Возвращает false, если остановка уже запрошена: тогда процесс нужно остановить сразу.
+    /// </summary>
+    bool attach(long long process);
+    void detach();
+
+private:
+    mutable std::mutex access;
+    bool requested = false;
+    /// <summary>
+    /// Идентификатор группы процессов (POSIX) или дескриптор процесса (Windows); 0 — процесс не запущен.
+    /// </summary>
+    long long process = 0;
+};
+
+/// <summary>
+/// Определяет каталог с программами Quartus.
+/// Порядок поиска: явно заданный путь (--quartus-path), переменная окружения QUARTUS_ROOTDIR, PATH.
+/// В заданном каталоге программы ищутся в подкаталогах bin64 и bin, затем в нём самом.
+/// Возвращает пустую строку, если программы нужно искать в PATH.
+/// </summary>
+/// <param name="configured">Путь из командной строки; может быть пустым.</param>
+std::string resolveToolDirectory(const std::string& configured);
+
+/// <summary>
+/// Запускает программу Quartus в каталоге проекта и построчно передаёт её вывод (stdout и stderr):
+/// каждая строка выводится в консоль с префиксом имени программы, дописывается в журнал
+/// "<каталог проекта>/logs/<программа>.log" и передаётся обработчику onLine.
+/// </summary>
+/// <param name="toolDirectory">Каталог программ (результат resolveToolDirectory).</param>
+/// <param name="tool">Имя программы, например "quartus_fit".</param>
+/// <param name="arguments">Аргументы программы.</param>
+/// <param name="projectDirectory">Рабочий каталог — каталог "<имя>_quartus".</param>
+/// <param name="onLine">Обработчик строк вывода; может быть пустым.</param>
+/// <param name="cancel">Объект для остановки процесса; может быть nullptr.</param>
+/// <param name="label">Префикс строк в консоли; по умолчанию — имя программы.</param>
+ToolResult runTool(const std::string& toolDirectory, const std::string& tool, const std::vector<std::string>& arguments,
+                   const std::string& projectDirectory, const std::function<void(const std::string&)>& onLine = {},
+                   ToolCancel* cancel = nullptr, const std::string& label = "");
@@ -0,0 +1,281 @@
+#include "ReportParser.hpp"
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+/// <summary>
+/// Размер блока чтения отчёта.
+/// </summary>
+const size_t chunkSize = 1 << 20;
+
+/// <summary>
+/// Вызывает fn для каждой строки файла (без символов конца строки).
+/// Файл читается блоками; буфер увеличивается, только если строка не помещается в блок.
+/// </summary>
+template <class Fn>
+void forEachLine(const string& path, Fn&& fn)
+{
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr)
+        throw runtime_error("Failed to open report " + path);
+    vector<char> buffer(chunkSize);
+    size_t filled = 0;
+    auto emit = [&](const char* begin, const char* end)
+    {
+        if (end != begin && end[-1] == '\r')
+            end--;
+        fn(string_view(begin, static_cast<size_t>(end - begin)));
+    };
+    for (;;)
+    {
+        if (filled == buffer.size())
+            buffer.resize(buffer.size() * 2);
+        size_t read = fread(buffer.data() + filled, 1, buffer.size() - filled, file);
+        filled += read;
+        const char* data = buffer.data();
+        size_t start = 0;
+        while (const void* found = memchr(data + start, '\n', filled - start))
+        {
+            const char* newline = static_cast<const char*>(found);
+            emit(data + start, newline);
+            start = static_cast<size_t>(newline - data) + 1;
+        }
+        if (read == 0)
+        {
+            if (start < filled)
+                emit(data + start, data + filled);
+            break;
+        }
+        memmove(buffer.data(), data + start, filled - start);
+        filled -= start;
+    }
+    fclose(file);
+}
+
+string_view trim(string_view value)
+{
+    size_t begin = value.find_first_not_of(' ');
+    if (begin == string_view::npos)
+        return string_view();
+    size_t end = value.find_last_not_of(' ');
+    return value.substr(begin, end - begin + 1);
+}
+
+/// <summary>
+/// Отслеживает таблицы отчёта Quartus:
+/// <code>
+/// +-----------------+
+/// ; Заголовок       ;
+/// +-------+---------+
+/// ; ячейка ; ячейка ;
+/// </code>
+/// Строка из одной ячейки начинает новую таблицу; строки из нескольких ячеек передаются обработчику
+/// вместе с заголовком таблицы и номером строки в таблице. Текст вне таблиц закрывает текущую таблицу.
+/// </summary>
+class ReportTables
+{
+public:
+    template <class Fn>
+    void line(string_view text, Fn&& onRow)
+    {
+        if (text.empty() || text[0] == '+')
+            return;
+        if (text[0] != ';')
+        {
+            title = string_view();
+            return;
+        }
+        cells.clear();
+        size_t pos = 1;
+        while (pos < text.size())
+        {
+            size_t next = text.find(';', pos);
+            if (next == string_view::npos)
+                next = text.size();
+            cells.push_back(trim(text.substr(pos, next - pos)));
+            pos = next + 1;
+        }
+        while (!cells.empty() && cells.back().empty())
+            cells.pop_back();
+        if (cells.size() == 1)
+        {
+            titleStorage.assign(cells[0]);
+            title = titleStorage;
+            row = 0;
+        }
+        else if (!title.empty() && !cells.empty())
+            onRow(title, cells, row++);
+    }
+
+private:
+    string titleStorage;
+    string_view title;
+    vector<string_view> cells;
+    size_t row = 0;
+};
+
+bool endsWith(string_view value, string_view suffix)
+{
+    return value.size() >= suffix.size() && value.substr(value.size() - suffix.size()) == suffix;
+}
+
+/// <summary>
+/// Читает целое число с разделителями разрядов ("113,560") начиная с первой цифры после позиции pos.
+/// Возвращает позицию после числа через pos.
+/// </summary>
+long long parseCount(string_view value, size_t& pos)
+{
+    while (pos < value.size() && (value[pos] < '0' || value[pos] > '9'))
+        pos++;
+    long long result = 0;
+    for (; pos < value.size(); pos++)
+    {
+        char c = value[pos];
+        if (c >= '0' && c <= '9')
+            result = result * 10 + (c - '0');
+        else if (c != ',')
+            break;
+    }
+    return result;
+}
+
+/// <summary>
+/// Разбирает значение вида "3,276 / 113,560 ( 3 % )" или "6552".
+/// </summary>
+void parseUsage(string_view value, long long& used, long long* available = nullptr)
+{
+    size_t pos = 0;
+    used = parseCount(value, pos);
+    size_t slash = value.find('/', pos);
+    if (available != nullptr && slash != string_view::npos)
+    {
+        pos = slash;
+        *available = parseCount(value, pos);
+    }
+}
+
+/// <summary>
+/// Разбирает число с плавающей точкой в начале значения ("250.40 MHz", "-0.125").
+/// </summary>
+bool parseNumber(string_view value, double& result)
+{
+    const char* begin = value.data();
+    const char* end = begin + value.size();
+    return from_chars(begin, end, result).ec == errc();
+}
+
+/// <summary>
+/// Худшее значение по моделям анализа для одного тактового сигнала.
+/// </summary>
+void keepMinimum(map<string, double>& values, string_view clock, double value)
+{
+    auto [it, inserted] = values.emplace(string(clock), value);
+    if (!inserted)
+        it->second = min(it->second, value);
+}
+
+} // namespace
+
+void parseFitReport(const string& path, QuartusMetadata& metadata)
+{
+    ReportTables tables;
+    forEachLine(path, [&](string_view line)
+    {
+        tables.line(line, [&](string_view title, const vector<string_view>& cells, size_t)
+        {
+            // Одноимённые строки других таблиц (например, "Fitter Resource Usage Summary") не учитываются.
+            if (title != "Fitter Summary" || cells.size() < 2)
+                return;
+            string_view key = cells[0], value = cells[1];
+            if (key == "Logic utilization (in ALMs)")
+                parseUsage(value, metadata.alms, &metadata.almsAvailable);
+            else if (key == "Total registers")
+                parseUsage(value, metadata.registers);
+            else if (key == "Total RAM Blocks")
+                parseUsage(value, metadata.ramBlocks);
+            else if (key == "Total block memory bits")
+                parseUsage(value, metadata.blockMemoryBits);
+            else if (key == "Total DSP Blocks")
+                parseUsage(value, metadata.dspBlocks);
+        });
+    });
+}
+
+void parseSynthesisReport(const string& path, QuartusMetadata& metadata)
+{
+    ReportTables tables;
+    forEachLine(path, [&](string_view line)
+    {
+        tables.line(line, [&](string_view title, const vector<string_view>& cells, size_t)
+        {
+            if (title == "Analysis & Synthesis Summary" && cells.size() >= 2 && cells[0] == "Logic utilization (in ALMs)")
+                parseUsage(cells[1], metadata.estimatedAlms);
+        });
+    });
+}
+
+void parseTimingReport(const string& path, QuartusMetadata& metadata)
+{
+    map<string, double> fmax, restrictedFmax, slack;
+    // Номера столбцов текущей таблицы, определяемые по строке заголовков.
+    size_t fmaxColumn = 0, restrictedColumn = 0, clockColumn = 0, slackColumn = 0;
+    ReportTables tables;
+    forEachLine(path, [&](string_view line)
+    {
+        tables.line(line, [&](string_view title, const vector<string_view>& cells, size_t row)
+        {
+            bool fmaxTable = endsWith(title, "Fmax Summary");
+            bool setupTable = endsWith(title, "Setup Summary");
+            if (!fmaxTable && !setupTable)
+                return;
+            if (row == 0)
+            {
+                fmaxColumn = restrictedColumn = clockColumn = slackColumn = cells.size();
+                for (size_t i = 0; i < cells.size(); i++)
+                {
+                    if (cells[i] == "Fmax") fmaxColumn = i;
+                    else if (cells[i] == "Restricted Fmax") restrictedColumn = i;
+                    else if (cells[i] == "Clock Name" || cells[i] == "Clock") clockColumn = i;
+                    else if (cells[i] == "Slack") slackColumn = i;
+                }
+                return;
+            }
+            if (clockColumn >= cells.size())
+                return;
+            string_view clock = cells[clockColumn];
+            double value = 0;
+            if (fmaxTable)
+            {
+                if (fmaxColumn < cells.size() && parseNumber(cells[fmaxColumn], value))
+                    keepMinimum(fmax, clock, value);
+                if (restrictedColumn < cells.size() && parseNumber(cells[restrictedColumn], value))
+                    keepMinimum(restrictedFmax, clock, value);
+            }
+            else if (slackColumn < cells.size() && parseNumber(cells[slackColumn], value))
+                keepMinimum(slack, clock, value);
+        });
+    });
+
+    map<string, ClockTiming> clocks;
+    for (const auto& [clock, value] : fmax)
+        clocks[clock].fmaxMhz = value;
+    for (const auto& [clock, value] : restrictedFmax)
+        clocks[clock].restrictedFmaxMhz = value;
+    for (const auto& [clock, value] : slack)
+        clocks[clock].setupSlackNs = value;
+    metadata.clocks.clear();
+    for (auto& [clock, timing] : clocks)
+    {
+        timing.name = clock;
+        metadata.clocks.push_back(timing);
+    }
+}
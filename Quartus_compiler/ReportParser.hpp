@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include "ProjectSettings.hpp"
+
+/// <summary>
+/// Извлекает из отчёта фиттера ("<ревизия>.fit.rpt") использование ресурсов: ALM, регистры,
+/// блоки памяти M10K, биты блочной памяти и блоки DSP (таблица "Fitter Summary").
+/// Отчёт читается за один проход блоками по 1 МБ, строки выделяются через memchr.
+/// </summary>
+/// <param name="path">Путь к отчёту.</param>
+/// <param name="metadata">Метаданные, в которые записываются найденные значения.</param>
+/// <exception cref="std::runtime_error">Если отчёт не удалось открыть.</exception>
+void parseFitReport(const std::string& path, QuartusMetadata& metadata);
+
+/// <summary>
+/// Извлекает из отчёта синтеза ("<ревизия>.map.rpt") оценку числа ALM (строка "Logic utilization (in ALMs)"
+/// таблицы "Analysis & Synthesis Summary") в metadata.estimatedAlms.
+/// </summary>
+/// <param name="path">Путь к отчёту.</param>
+/// <param name="metadata">Метаданные, в которые записывается оценка.</param>
+/// <exception cref="std::runtime_error">Если отчёт не удалось открыть.</exception>
+void parseSynthesisReport(const std::string& path, QuartusMetadata& metadata);
+
+/// <summary>
+/// Извлекает из отчёта анализа временных характеристик ("<ревизия>.sta.rpt") Fmax и запас по установке
+/// для каждого тактового сигнала (таблицы "... Fmax Summary" и "... Setup Summary" всех моделей).
+/// Для каждого сигнала сохраняются худшие значения по всем моделям.
+/// </summary>
+/// <param name="path">Путь к отчёту.</param>
+/// <param name="metadata">Метаданные, в которые записываются найденные значения.</param>
+/// <exception cref="std::runtime_error">Если отчёт не удалось открыть.</exception>
+void parseTimingReport(const std::string& path, QuartusMetadata& metadata);
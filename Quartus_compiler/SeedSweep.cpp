@@ -0,0 +1,247 @@
+#include "SeedSweep.hpp"
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include "Parallel.hpp"
+#include "QuartusRunner.hpp"
+#include "ReportParser.hpp"
+using namespace std;
+namespace fs = std::filesystem;
+
+namespace {
+
+const string seedAssignment = "set_global_assignment -name SEED ";
+
+string readText(const fs::path& path)
+{
+    ifstream file(path, ios::binary);
+    if (!file)
+        throw runtime_error("Failed to read " + path.string());
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+void writeText(const fs::path& path, const string& text)
+{
+    fs::path tmp = path.string() + ".tmp";
+    {
+        ofstream out(tmp, ios::binary | ios::trunc);
+        out<<text;
+        if (!out)
+            throw runtime_error("Failed to write " + path.string());
+    }
+    fs::rename(tmp, path);
+}
+
+/// <summary>
+/// Возвращает текст файла настроек без назначения SEED; относительные пути к файлам
+/// при необходимости переводятся на уровень выше (для каталога значения внутри каталога проекта).
+/// </summary>
+string settingsWithoutSeed(const string& qsf, bool nested)
+{
+    istringstream in(qsf);
+    ostringstream out;
+    string line;
+    while (getline(in, line))
+    {
+        if (line.rfind(seedAssignment, 0) == 0)
+            continue;
+        size_t path = line.find("_FILE ../");
+        if (nested && path != string::npos)
+            line.insert(path + 6, "../");
+        out<<line<<"\n";
+    }
+    return out.str();
+}
+
+/// <summary>
+/// Копирует каталог целиком, заменяя существующий.
+/// </summary>
+void replaceDirectory(const fs::path& from, const fs::path& to)
+{
+    fs::remove_all(to);
+    if (fs::exists(from))
+        fs::copy(from, to, fs::copy_options::recursive);
+}
+
+/// <summary>
+/// Готовит каталог значения: файлы проекта, результаты синтеза и сохранённые разделы, настройки с SEED.
+/// </summary>
+void prepareSeedDirectory(const fs::path& quartus, const fs::path& directory, const string& name, unsigned seed)
+{
+    fs::remove_all(directory);
+    fs::create_directories(directory);
+    for (const char* extension : {".qpf", ".sdc"})
+        fs::copy_file(quartus / (name + extension), directory / (name + extension));
+    for (const char* database : {"db", "incremental_db"})
+        replaceDirectory(quartus / database, directory / database);
+    string qsf = settingsWithoutSeed(readText(quartus / (name + ".qsf")), true);
+    writeText(directory / (name + ".qsf"), qsf + seedAssignment + to_string(seed) + "\n");
+}
+
+/// <summary>
+/// Переносит результаты значения-победителя в каталог проекта.
+/// </summary>
+void promoteSeed(const fs::path& quartus, const fs::path& directory, const string& name, unsigned seed)
+{
+    for (const char* result : {"db", "incremental_db", "output_files"})
+        replaceDirectory(directory / result, quartus / result);
+    fs::create_directories(quartus / "logs");
+    fs::copy_file(directory / "logs" / "quartus_fit.log", quartus / "logs" / "quartus_fit.log",
+                  fs::copy_options::overwrite_existing);
+    string qsf = settingsWithoutSeed(readText(quartus / (name + ".qsf")), false);
+    writeText(quartus / (name + ".qsf"), qsf + seedAssignment + to_string(seed) + "\n");
+}
+
+} // namespace
+
+unsigned configuredSeed(const string& qsfPath)
+{
+    ifstream file(qsfPath);
+    string line;
+    unsigned seed = 0;
+    while (getline(file, line))
+        if (line.rfind(seedAssignment, 0) == 0)
+            seed = static_cast<unsigned>(stoul(line.substr(seedAssignment.size())));
+    return seed;
+}
+
+SeedSweepResult runSeedSweep(const string& toolDirectory, const string& quartusDirectory, const SeedSweepOptions& options)
+{
+    const fs::path quartus = quartusDirectory;
+    const vector<string> settingsArgs = {"--read_settings_files=on", "--write_settings_files=off"};
+    SeedSweepResult sweep;
+    sweep.outcomes.resize(options.seeds);
+    vector<unique_ptr<ToolCancel>> cancels;
+    vector<bool> running(options.seeds, false), estimated(options.seeds, false);
+    for (unsigned i = 0; i < options.seeds; i++)
+    {
+        sweep.outcomes[i].seed = i + 1;
+        cancels.push_back(make_unique<ToolCancel>());
+    }
+    mutex state;
+    bool haveBest = false;
+    double bestSlack = 0;
+
+    // Останавливает фиттер, если его текущая оценка хуже лучшего результата больше чем на margin (вызывается под state).
+    // Значение, фиттер которого завершился, не останавливается: его анализ времени даст точный результат.
+    auto prune = [&](unsigned i)
+    {
+        SeedOutcome& outcome = sweep.outcomes[i];
+        if (!running[i] || !estimated[i] || !haveBest || outcome.slack + options.margin >= bestSlack)
+            return;
+        running[i] = false;
+        outcome.cancelled = true;
+        cout<<("[" + options.tag + "seed " + to_string(outcome.seed) + "] cancelled: estimated slack " + to_string(outcome.slack)
+               + " ns, best " + to_string(bestSlack) + " ns\n")<<flush;
+        cancels[i]->cancel();
+    };
+
+    auto start = chrono::steady_clock::now();
+    common::parallelFor(options.seeds, options.parallel, [&](size_t index)
+    {
+        const unsigned i = static_cast<unsigned>(index);
+        SeedOutcome& outcome = sweep.outcomes[i];
+        const fs::path directory = quartus / ("seed_" + to_string(outcome.seed));
+        const string label = options.tag + "seed " + to_string(outcome.seed);
+        try
+        {
+            prepareSeedDirectory(quartus, directory, options.name, outcome.seed);
+        }
+        catch (exception& e)
+        {
+            cout<<("[" + label + "] " + e.what() + "\n")<<flush;
+            return;
+        }
+        {
+            lock_guard<mutex> lock(state);
+            running[i] = true;
+        }
+        vector<string> arguments = {options.name, "-c", options.name};
+        arguments.insert(arguments.end(), settingsArgs.begin(), settingsArgs.end());
+        ToolResult fit = runTool(toolDirectory, "quartus_fit", arguments, directory.string(), [&](const string& line)
+        {
+            string reason = abortReason(options.abort, "quartus_fit", line);
+            double slack = 0;
+            bool hasEstimate = parseSlackEstimate(line, slack);
+            if (reason.empty() && !hasEstimate)
+                return;
+            lock_guard<mutex> lock(state);
+            if (!running[i])
+                return;
+            if (!reason.empty())
+            {
+                running[i] = false;
+                outcome.abortReason = reason;
+                cout<<("[" + label + "] aborted: " + reason + "\n")<<flush;
+                cancels[i]->cancel();
+                return;
+            }
+            outcome.slack = slack;
+            estimated[i] = true;
+            prune(i);
+        }, cancels[i].get(), label);
+        {
+            // Оценка фиттера после его завершения больше не используется для отсечения.
+            lock_guard<mutex> lock(state);
+            estimated[i] = false;
+        }
+        ToolResult sta = fit;
+        if (fit.succeeded())
+            sta = runTool(toolDirectory, "quartus_sta", {options.name, "-c", options.name}, directory.string(), {},
+                          cancels[i].get(), label);
+
+        QuartusMetadata timing;
+        bool parsed = false;
+        if (sta.succeeded())
+        {
+            try
+            {
+                parseTimingReport((directory / "output_files" / (options.name + ".sta.rpt")).string(), timing);
+                parsed = !timing.clocks.empty();
+            }
+            catch (exception& e)
+            {
+                cout<<("[" + label + "] " + e.what() + "\n")<<flush;
+            }
+        }
+        lock_guard<mutex> lock(state);
+        running[i] = false;
+        if (!parsed)
+            return;
+        outcome.completed = true;
+        outcome.slack = timing.clocks.front().setupSlackNs;
+        outcome.fmax = timing.clocks.front().fmaxMhz;
+        for (const ClockTiming& clock : timing.clocks)
+        {
+            outcome.slack = min(outcome.slack, clock.setupSlackNs);
+            outcome.fmax = min(outcome.fmax, clock.fmaxMhz);
+        }
+        if (!haveBest || outcome.slack > bestSlack)
+        {
+            haveBest = true;
+            bestSlack = outcome.slack;
+        }
+        for (unsigned j = 0; j < options.seeds; j++)
+            prune(j);
+    });
+    sweep.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    const SeedOutcome* winner = nullptr;
+    for (const SeedOutcome& outcome : sweep.outcomes)
+        if (outcome.completed && (winner == nullptr || outcome.slack > winner->slack
+                                  || (outcome.slack == winner->slack && outcome.fmax > winner->fmax)))
+            winner = &outcome;
+    // Если ни один фиттер не завершился, каталоги значений с журналами остаются для разбора.
+    if (winner == nullptr)
+        return sweep;
+    promoteSeed(quartus, quartus / ("seed_" + to_string(winner->seed)), options.name, winner->seed);
+    sweep.winner = winner->seed;
+    for (const SeedOutcome& outcome : sweep.outcomes)
+        fs::remove_all(quartus / ("seed_" + to_string(outcome.seed)));
+    return sweep;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "CompileMonitor.hpp"
+
+/// <summary>
+/// Параметры перебора начальных значений фиттера.
+/// </summary>
+struct SeedSweepOptions
+{
+    /// <summary>
+    /// Имя проекта (ревизии Quartus).
+    /// </summary>
+    std::string name;
+    /// <summary>
+    /// Число начальных значений: перебираются значения 1..seeds.
+    /// </summary>
+    unsigned seeds = 1;
+    /// <summary>
+    /// Сколько фиттеров выполняется одновременно.
+    /// </summary>
+    unsigned parallel = 1;
+    /// <summary>
+    /// Допуск в наносекундах: фиттер останавливается, когда его оценка запаса по времени хуже
+    /// лучшего завершённого результата больше чем на это значение.
+    /// </summary>
+    double margin = 0;
+    /// <summary>
+    /// Условия досрочной остановки фиттера каждого значения.
+    /// </summary>
+    AbortPolicy abort;
+    /// <summary>
+    /// Префикс строк в консоли перед "seed N" (например, обозначение устройства).
+    /// </summary>
+    std::string tag;
+};
+
+/// <summary>
+/// Итог фиттера с одним начальным значением.
+/// </summary>
+struct SeedOutcome
+{
+    unsigned seed = 0;
+    bool completed = false;
+    bool cancelled = false;
+    /// <summary>
+    /// Худший запас по установке (нс) и наименьшая Fmax (МГц) по всем тактовым сигналам;
+    /// для остановленного фиттера slack — последняя оценка.
+    /// </summary>
+    double slack = 0;
+    double fmax = 0;
+    /// <summary>
+    /// Причина досрочной остановки по выводу фиттера (см. abortReason); пустая, если остановки не было.
+    /// </summary>
+    std::string abortReason;
+};
+
+/// <summary>
+/// Итог перебора: итоги всех значений по порядку и выбранное значение (0 — ни один фиттер не завершился).
+/// </summary>
+struct SeedSweepResult
+{
+    std::vector<SeedOutcome> outcomes;
+    unsigned winner = 0;
+    double seconds = 0;
+};
+
+/// <summary>
+/// Выполняет стадию fit с несколькими начальными значениями фиттера параллельно.
+/// Каждое значение компилируется в отдельном каталоге "<каталог Quartus>/seed_<значение>" с копией
+/// проекта и результатов синтеза; после фиттера там же выполняется анализ временных характеристик.
+/// Пока фиттер работает, его оценки запаса по времени ("Worst-case setup slack is ...") сравниваются
+/// с лучшим завершённым результатом, и заведомо проигрывающие фиттеры останавливаются.
+/// Победитель — наибольший худший запас по установке (при равенстве — наибольшая Fmax); его база данных
+/// и отчёты переносятся в каталог проекта, а значение SEED дописывается в "<имя>.qsf".
+/// Каталоги значений удаляются.
+/// </summary>
+/// <param name="toolDirectory">Каталог программ Quartus.</param>
+/// <param name="quartusDirectory">Каталог "<имя>_quartus" после стадии map.</param>
+/// <param name="options">Параметры перебора.</param>
+SeedSweepResult runSeedSweep(const std::string& toolDirectory, const std::string& quartusDirectory,
+                             const SeedSweepOptions& options);
+
+/// <summary>
+/// Читает значение SEED из файла настроек проекта; 0, если оно не задано.
+/// </summary>
+unsigned configuredSeed(const std::string& qsfPath);
@@ -0,0 +1,180 @@
+#!/bin/sh
+# Имитация программ Quartus (quartus_map, quartus_fit, quartus_asm, quartus_sta) для проверки
+# Quartus_compiler без установленного Quartus:
+#   Quartus_compiler -l <расположение> -n <имя> --quartus-path Quartus_compiler/fake_quartus
+#
+# Программа читает сгенерированный <ревизия>.qsf, выводит журнал в формате Quartus с задержками,
+# записывает отчёты output_files/<ревизия>.<стадия>.rpt и .summary, а quartus_fit создаёт incremental_db.
+# Время стадии quartus_fit пропорционально доле разделов, компилируемых из исходников (SOURCE).
+# Fmax зависит от семейства ПЛИС и начального значения фиттера (SEED); во время размещения quartus_fit выводит
+# оптимистичные оценки запаса по времени, которые уточняются к последней фазе.
+#
+# Переменные окружения:
+#   FAKE_QUARTUS_DELAY — длительность полной стадии в секундах (по умолчанию 1);
+#   FAKE_QUARTUS_FAIL  — стадия (map, fit, asm или sta), которая завершится ошибкой;
+#   FAKE_QUARTUS_OVERFLOW — если задана, quartus_fit после первой фазы сообщает о нехватке LAB
+#                           и завершается ошибкой в конце стадии.
+
+stage=$1
+shift
+project=$1
+revision=$1
+while [ $# -gt 0 ]; do
+    if [ "$1" = "-c" ] && [ $# -gt 1 ]; then
+        revision=$2
+        shift
+    fi
+    shift
+done
+
+case $stage in
+    map) title="Analysis & Synthesis" ;;
+    fit) title="Fitter" ;;
+    asm) title="Assembler" ;;
+    sta) title="Timing Analyzer" ;;
+    *) echo "Error: unknown stage $stage"; exit 2 ;;
+esac
+
+qsf="$revision.qsf"
+if [ ! -f "$qsf" ]; then
+    echo "Error: Can't open project -- $project"
+    echo "Error: Quartus Prime $title was unsuccessful. 1 error, 0 warnings"
+    exit 2
+fi
+
+delay=${FAKE_QUARTUS_DELAY:-1}
+device=$(sed -n 's/^set_global_assignment -name DEVICE //p' "$qsf")
+family=$(sed -n 's/^set_global_assignment -name FAMILY "\(.*\)"/\1/p' "$qsf")
+files=$(grep -c -- '-name VERILOG_FILE ' "$qsf")
+routers=$(grep -c -- '-name PARTITION_HIERARCHY noc_r' "$qsf")
+partitions=$(grep -c -- '-name PARTITION_NETLIST_TYPE ' "$qsf")
+sources=$(grep -c -- '-name PARTITION_NETLIST_TYPE SOURCE ' "$qsf")
+seed=$(sed -n 's/^set_global_assignment -name SEED //p' "$qsf")
+[ -n "$seed" ] || seed=0
+period=$(sed -n 's/^create_clock .*-period \([0-9.]*\).*/\1/p' "$revision.sdc" 2>/dev/null)
+[ -n "$period" ] || period=10
+
+# Оценки ресурсов детерминированы и зависят только от размера проекта.
+[ "$routers" -gt 0 ] || routers=$files
+alms=$((routers * 180 + files * 12))
+registers=$((alms * 2))
+# Быстродействие семейства относительно Cyclone V.
+case $family in
+    "MAX 10") speed=0.7 ;;
+    "Cyclone IV"*) speed=0.8 ;;
+    "Arria"*|"Stratix"*) speed=1.4 ;;
+    *) speed=1 ;;
+esac
+fmax=$(awk -v r="$routers" -v s="$seed" -v k="$speed" 'BEGIN { f = 260 - 0.6 * r; if (f < 80) f = 80; f *= k * (1 + ((s * 7919 + 6) % 13 - 6) / 100); printf "%.2f", f }')
+slack=$(awk -v p="$period" -v f="$fmax" 'BEGIN { printf "%.3f", p - 1000 / f }')
+alms_text=$(awk -v n="$alms" 'BEGIN { s = sprintf("%d", n); r = ""; while (length(s) > 3) { r = "," substr(s, length(s) - 2) r; s = substr(s, 1, length(s) - 3) } print s r }')
+ram=$((routers / 4))
+tns=$(awk -v s="$slack" 'BEGIN { printf "%.3f", s < 0 ? s * 8 : 0 }')
+
+# Доля стадии, которую нужно выполнить: при инкрементальной компиляции фиттер обрабатывает только разделы SOURCE.
+share=1
+if [ "$stage" = "fit" ] && [ "$partitions" -gt 0 ]; then
+    share=$(awk -v s="$sources" -v p="$partitions" 'BEGIN { printf "%.3f", s / p }')
+fi
+step=$(awk -v d="$delay" -v s="$share" 'BEGIN { printf "%.3f", d * s / 4 }')
+
+started=$(date)
+echo "Info: *******************************************************************"
+echo "Info: Running Quartus Prime $title"
+echo "Info:     Version 20.1.0 Build 711 06/05/2020 SJ Lite Edition (fake)"
+echo "Info:     Processing started: $started"
+echo "Info: Command: quartus_$stage $project -c $revision"
+for phase in 1 2 3 4; do
+    sleep "$step"
+    echo "Info: $title phase $phase of 4 complete"
+    if [ "$stage" = "fit" ] && [ "$phase" -eq 1 ] && [ -n "$FAKE_QUARTUS_OVERFLOW" ]; then
+        echo "Error (170012): Fitter requires $((alms / 5)) LABs to implement the design, but the device contains only $((alms / 10)) LABs"
+    fi
+    if [ "$stage" = "fit" ] && [ "$phase" -gt 1 ]; then
+        estimate=$(awk -v s="$slack" -v p="$phase" 'BEGIN { printf "%.3f", s + (4 - p) * 0.2 }')
+        echo "Info (332146): Worst-case setup slack is $estimate"
+    fi
+done
+
+if [ "$stage" = "fit" ] && [ -n "$FAKE_QUARTUS_OVERFLOW" ]; then
+    echo "Error (11802): Can't fit design in device"
+    echo "Error: Quartus Prime $title was unsuccessful. 2 errors, 0 warnings"
+    exit 3
+fi
+if [ "$FAKE_QUARTUS_FAIL" = "$stage" ]; then
+    echo "Error (12006): Simulated $title failure requested by FAKE_QUARTUS_FAIL"
+    echo "Error: Quartus Prime $title was unsuccessful. 1 error, 0 warnings"
+    exit 3
+fi
+
+mkdir -p output_files
+report="output_files/$revision.$stage.rpt"
+summary="output_files/$revision.$stage.summary"
+: > "$summary"
+row() {
+    printf '; %-36s ; %-40s ;\n' "$1" "$2"
+    printf '%s : %s\n' "$1" "$2" >> "$summary"
+}
+{
+    echo "$title report for $revision"
+    echo "$started"
+    echo "Quartus Prime Version 20.1.0 Build 711 06/05/2020 SJ Lite Edition"
+    echo
+    echo "+------------------------------------------------------------------------------------+"
+    printf '; %-82s ;\n' "$title Summary"
+    echo "+--------------------------------------+------------------------------------------+"
+    row "$title Status" "Successful - $started"
+    row "Revision Name" "$revision"
+    row "Top-level Entity Name" "noc_top"
+    row "Family" "$family"
+    row "Device" "$device"
+    case $stage in
+        map|fit)
+            row "Logic utilization (in ALMs)" "$alms_text / 113,560 ( $((alms * 100 / 113560)) % )"
+            row "Total registers" "$registers"
+            row "Total pins" "$((routers * 4 + 2)) / 616"
+            row "Total block memory bits" "$((ram * 10240)) / 12,492,800 ( 0 % )"
+            row "Total RAM Blocks" "$ram / 1,220 ( 0 % )"
+            row "Total DSP Blocks" "0 / 342 ( 0 % )"
+            ;;
+    esac
+    echo "+--------------------------------------+------------------------------------------+"
+    if [ "$stage" = "fit" ]; then
+        echo
+        echo "; Incremental Compilation Preservation Summary"
+        printf '; %-36s ; %-40s ;\n' "Partitions" "$partitions"
+        printf '; %-36s ; %-40s ;\n' "Partitions compiled from source" "$sources"
+    fi
+    if [ "$stage" = "sta" ]; then
+        echo
+        echo "+-------------------------------------------------+"
+        echo "; Slow 1100mV 85C Model Fmax Summary              ;"
+        echo "+------------+-----------------+------------+------+"
+        echo "; Fmax       ; Restricted Fmax ; Clock Name ; Note ;"
+        echo "+------------+-----------------+------------+------+"
+        echo "; $fmax MHz ; $fmax MHz ; clk ;      ;"
+        echo "+------------+-----------------+------------+------+"
+        echo
+        echo "+-----------------------------------------+"
+        echo "; Slow 1100mV 85C Model Setup Summary     ;"
+        echo "+-------+--------+---------------+"
+        echo "; Clock ; Slack  ; End Point TNS ;"
+        echo "+-------+--------+---------------+"
+        echo "; clk   ; $slack ; $tns ;"
+        echo "+-------+--------+---------------+"
+    fi
+} > "$report"
+if [ "$stage" = "sta" ]; then
+    printf "Type  : Slow 1100mV 85C Model Setup 'clk'\nSlack : %s\nTNS   : %s\n" "$slack" "$tns" >> "$summary"
+fi
+
+case $stage in
+    map) mkdir -p db && printf 'fake netlist for %s\n' "$revision" > "db/$revision.map.qmsg" ;;
+    fit) mkdir -p incremental_db ;;
+    asm) printf 'fake bitstream for %s\n' "$device" > "output_files/$revision.sof" ;;
+    sta) echo "Info: Worst-case setup slack is $slack" ;;
+esac
+
+echo "Info: Quartus Prime $title was successful. 0 errors, 2 warnings"
+echo "Info: Processing ended: $(date)"
+exit 0
@@ -1,7 +1,468 @@
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <map>
+#include <sstream>
+#include "DeviceCompile.hpp"
+#include "FileLock.hpp"
+#include "Parallel.hpp"
+#include "ProjectSettings.hpp"
+#include "QuartusRunner.hpp"
+#include "ResultsStore.hpp"
 using namespace std;
+using json = nlohmann::json;
+namespace fs = std::filesystem;
 
+/// <summary>
+/// Читает файл целиком.
+/// </summary>
+static string readFile(const string& path)
+{
+    ifstream file(path, ios::binary);
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
 
+/// <summary>
+/// Записывает в метаданные проекта раздел quartusMetadata, сохраняя остальные разделы
+/// (под блокировкой метаданных: их одновременно может изменять процесс выгрузки Database_writer).
+/// </summary>
+static void saveQuartusMetadata(const string& metadataPath, const QuartusMetadata& quartusMetadata)
+{
+    common::FileLock lock(common::metadataLockPath(metadataPath));
+    json j = json::parse(readFile(metadataPath));
+    j["quartusMetadata"] = quartusMetadata;
+    string tmp = metadataPath + ".tmp";
+    {
+        ofstream out(tmp, ios::trunc);
+        out << setw(4) << j;
+        if (!out)
+            throw runtime_error("Failed to write " + metadataPath);
+    }
+    fs::rename(tmp, metadataPath);
+}
+
+/// <summary>
+/// Строки хранилища итогов расположения для скомпилированных устройств проекта; временные характеристики
+/// берутся по тактовому сигналу с наименьшим запасом, как в таблице noc_results.
+/// </summary>
+static vector<noc::ResultRecord> resultRecords(const string& project, const string& params, const QuartusMetadata& quartus)
+{
+    const long long now = chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
+    vector<const QuartusMetadata*> compiled;
+    if (quartus.devices.empty())
+        compiled.push_back(&quartus);
+    for (const QuartusMetadata& device : quartus.devices)
+        compiled.push_back(&device);
+    vector<noc::ResultRecord> records;
+    for (const QuartusMetadata* device : compiled)
+    {
+        if (!device->quartusCompiled)
+            continue;
+        noc::ResultRecord record;
+        record.project = project;
+        record.device = device->deviceName;
+        record.params = params;
+        record.alms = device->alms;
+        record.almsAvailable = device->almsAvailable;
+        record.registers = device->registers;
+        record.ramBlocks = device->ramBlocks;
+        record.blockMemoryBits = device->blockMemoryBits;
+        record.dspBlocks = device->dspBlocks;
+        auto worst = min_element(device->clocks.begin(), device->clocks.end(),
+                                 [](const ClockTiming& a, const ClockTiming& b) { return a.setupSlackNs < b.setupSlackNs; });
+        if (worst != device->clocks.end())
+        {
+            record.fmaxMhz = worst->fmaxMhz;
+            record.restrictedFmaxMhz = worst->restrictedFmaxMhz;
+            record.setupSlackNs = worst->setupSlackNs;
+        }
+        record.seed = device->seed;
+        record.bitstream = device->bitstreamGenerated;
+        record.time = now;
+        records.push_back(move(record));
+    }
+    return records;
+}
+
+/// <summary>
+/// Главная точка входа приложения.
+/// Определяет по отпечаткам модулей, какие разделы проекта изменились с последней успешной компиляции,
+/// генерирует проект Quartus для устройства из метаданных и последовательно запускает
+/// quartus_map, quartus_fit, quartus_asm и quartus_sta, беря неизменённые разделы из предыдущей компиляции.
+/// С опцией --stage выполняется одна стадия: так Broker чередует стадии разных проектов. Стадия map
+/// готовит проект, стадия sta сохраняет итоги компиляции.
+/// С опцией --exploration ассемблер не запускается и файл программирования не создаётся; позже проект
+/// можно дополнить отдельным запуском --stage asm.
+/// С опцией --seeds N фиттер запускается с начальными значениями 1..N (до --parallel-seeds одновременно),
+/// проигрывающие по оценке запаса фиттеры останавливаются, а дальше используется лучший результат.
+/// Вывод программ Quartus проверяется по мере поступления: при переполнении устройства, признаках сбоя
+/// фиттера или оценке запаса ниже --abort-slack компиляция останавливается, а причина записывается
+/// в метаданные (quartusMetadata.abortReason).
+/// С опцией --devices A,B,... сеть компилируется параллельно для нескольких устройств: описание сети общее,
+/// проект каждого устройства — в каталоге "<имя>_quartus/<устройство>", итоги — в quartusMetadata.devices.
+/// Итоги скомпилированных устройств дописываются в хранилище итогов расположения (results_store.bin),
+/// по которому Project_manager --query строит сводки по серии проектов.
+/// Каталог программ Quartus задаётся опцией --quartus-path или переменной QUARTUS_ROOTDIR
+/// (для проверки без Quartus — каталог Quartus_compiler/fake_quartus).
+/// </summary>
+/// <param name="argc">Целое число, содержащее количество аргументов, которые следуют в argv.</param>
+/// <param name="argv">Массив завершающихся null строк, представляющих введенные пользователем программы аргументы командной строки.</param>
 int main(int argc, char *argv[]) {
-    cout<<"Test"<<endl;
-}
\ No newline at end of file
+    string location; // Расположение проекта.
+    string name;     // Имя проекта.
+    bool full = false; // Перекомпилировать все разделы, не используя результаты предыдущей компиляции.
+    unsigned jobs = common::defaultJobs(); // Число потоков для разбора Verilog-описания.
+    string quartus_path; // Каталог установки или программ Quartus.
+    double clock_period = 10.0; // Период тактового сигнала в наносекундах.
+    string stage; // Выполнить одну стадию (map, fit, asm, sta) вместо полной компиляции.
+    unsigned threads = 0; // Число потоков Quartus (NUM_PARALLEL_PROCESSORS); 0 — значение Quartus по умолчанию.
+    bool exploration = false; // Режим исследования: только ресурсы и временные характеристики, без ассемблера.
+    unsigned seeds = 1; // Число начальных значений фиттера.
+    unsigned parallel_seeds = 0; // Число одновременно выполняемых фиттеров; 0 — все значения сразу.
+    double seed_margin = 0; // Допуск (нс) при остановке проигрывающих фиттеров.
+    AbortPolicy abort_policy; // Условия досрочной остановки компиляции.
+    vector<string> devices; // Устройства для параллельной компиляции (--devices); пусто — устройство из метаданных.
+    unsigned parallel_devices = 0; // Число устройств, компилируемых одновременно; 0 — все сразу.
+    for (int i = 1; i < argc; i++) {
+        string option = argv[i];
+        if (option == "-l"||option == "--location") {
+            if (i < argc - 1)
+            {
+                location = argv[++i]; // Получение значения расположения проекта из следующего аргумента.
+            }
+            else
+            {
+                cout<<("No project location provided");
+                exit(1);
+            }
+        }
+        else if (option == "-n"||option == "--name") {
+            if (i < argc - 1)
+            {
+                name = argv[++i]; // Получение значения имени проекта из следующего аргумента.
+            }
+            else
+            {
+                cout<<("No project name provided");
+                exit(1);
+            }
+        }
+        else if (option == "-j"||option == "--jobs") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                jobs = common::parseJobs(argv[++i]); // Получение числа потоков из следующего аргумента.
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid number of jobs");
+                exit(1);
+            }
+        }
+        else if (option == "--full") {
+            full = true;
+        }
+        else if (option == "--quartus-path") {
+            if (i < argc - 1)
+            {
+                quartus_path = argv[++i]; // Получение каталога Quartus из следующего аргумента.
+            }
+            else
+            {
+                cout<<("No Quartus path provided");
+                exit(1);
+            }
+        }
+        else if (option == "--exploration") {
+            exploration = true;
+        }
+        else if (option == "--stage") {
+            if (i < argc - 1)
+            {
+                stage = argv[++i]; // Получение имени стадии из следующего аргумента.
+            }
+            else
+            {
+                cout<<("No stage provided");
+                exit(1);
+            }
+        }
+        else if (option == "--threads") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                threads = common::parseJobs(argv[++i]); // Получение числа потоков Quartus из следующего аргумента.
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid number of Quartus threads");
+                exit(1);
+            }
+        }
+        else if (option == "--devices") {
+            if (i < argc - 1)
+            {
+                // Получение списка устройств через запятую из следующего аргумента.
+                istringstream list(argv[++i]);
+                string device;
+                while (getline(list, device, ','))
+                    if (!device.empty() && find(devices.begin(), devices.end(), device) == devices.end())
+                        devices.push_back(device);
+            }
+            if (devices.empty())
+            {
+                cout<<("No devices provided");
+                exit(1);
+            }
+        }
+        else if (option == "--seeds" || option == "--parallel-seeds" || option == "--parallel-devices") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                size_t pos = 0;
+                string value = argv[++i];
+                long n = stol(value, &pos); // Получение числа значений из следующего аргумента.
+                if (pos != value.size() || n < 1) throw invalid_argument("invalid count");
+                unsigned& target = option == "--seeds" ? seeds : option == "--parallel-seeds" ? parallel_seeds : parallel_devices;
+                target = static_cast<unsigned>(n);
+            }
+            catch (exception& e)
+            {
+                cout<<"Invalid value of "<<option;
+                exit(1);
+            }
+        }
+        else if (option == "--seed-margin") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                seed_margin = stod(argv[++i]); // Получение допуска из следующего аргумента.
+                if (seed_margin < 0) throw invalid_argument("negative margin");
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid seed margin");
+                exit(1);
+            }
+        }
+        else if (option == "--abort-slack") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                abort_policy.minSlack = stod(argv[++i]); // Получение порога запаса из следующего аргумента.
+                abort_policy.checkSlack = true;
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid abort slack");
+                exit(1);
+            }
+        }
+        else if (option == "--clock-period") {
+            try
+            {
+                if (i >= argc - 1) throw invalid_argument("missing value");
+                clock_period = stod(argv[++i]); // Получение периода тактового сигнала из следующего аргумента.
+                if (clock_period <= 0) throw invalid_argument("non-positive period");
+            }
+            catch (exception& e)
+            {
+                cout<<("Invalid clock period");
+                exit(1);
+            }
+        }
+        else {
+            cout<<"Unknown option: "<<option;
+            exit(1);
+        }
+    }
+    if (location.empty() || name.empty())
+    {
+        cout<<("Project location and name are required");
+        exit(1);
+    }
+
+    string base = (fs::path(location) / name).string();
+    string metadata = base + "_metadata.json";
+    string description = base + "_NoC_description";
+    string quartus = base + "_quartus";
+    if (!fs::is_directory(description))
+    {
+        cout<<"NoC description not found: "<<description;
+        exit(1);
+    }
+    ProjectSettings settings;
+    try
+    {
+        settings = json::parse(readFile(metadata)).get<ProjectSettings>();
+    }
+    catch (exception& e)
+    {
+        cout<<"Failed to read project metadata: "<<metadata;
+        exit(1);
+    }
+
+    size_t first = 0, last = compileStages.size() - 1;
+    if (!stage.empty())
+    {
+        auto found = find(compileStages.begin(), compileStages.end(), stage);
+        if (found == compileStages.end())
+        {
+            cout<<"Unknown stage: "<<stage<<" (expected map, fit, asm or sta)";
+            exit(1);
+        }
+        first = last = static_cast<size_t>(found - compileStages.begin());
+    }
+
+    // Без --devices проект компилируется для устройства из метаданных в каталоге "<имя>_quartus",
+    // со списком — для каждого устройства в каталоге "<имя>_quartus/<устройство>".
+    const bool fan_out = !devices.empty();
+    if (!fan_out)
+        devices.push_back(settings.quartusMetadata.deviceName);
+    map<string, VerilogModule> modules;
+    if (first == 0)
+    {
+        try
+        {
+            // До успешного завершения всех стадий проект считается нескомпилированным, итоги прошлой компиляции сбрасываются.
+            QuartusMetadata cleared;
+            cleared.deviceName = settings.quartusMetadata.deviceName;
+            if (fan_out)
+                for (const string& device : devices)
+                {
+                    QuartusMetadata entry;
+                    entry.deviceName = device;
+                    cleared.devices.push_back(entry);
+                }
+            saveQuartusMetadata(metadata, cleared);
+            // Описание сети общее для всех устройств и разбирается один раз.
+            modules = fingerprintModules(description, jobs);
+        }
+        catch (exception& e)
+        {
+            cout<<"Failed to prepare the Quartus project: "<<e.what();
+            exit(1);
+        }
+    }
+
+    const string tools = resolveToolDirectory(quartus_path);
+    vector<DeviceCompileResult> results(devices.size());
+    common::parallelFor(devices.size(), parallel_devices == 0 ? static_cast<unsigned>(devices.size()) : parallel_devices,
+                        [&](size_t i)
+    {
+        DeviceCompileOptions options;
+        options.name = name;
+        options.descriptionDirectory = description;
+        options.quartusDirectory = fan_out ? (fs::path(quartus) / devices[i]).string() : quartus;
+        options.deviceName = devices[i];
+        options.tag = fan_out ? devices[i] + ": " : "";
+        options.toolDirectory = tools;
+        options.first = first;
+        options.last = last;
+        options.full = full;
+        options.exploration = exploration;
+        options.jobs = jobs;
+        options.threads = threads;
+        options.clockPeriod = clock_period;
+        options.seeds = seeds;
+        options.parallelSeeds = parallel_seeds;
+        options.seedMargin = seed_margin;
+        options.abort = abort_policy;
+        options.modules = first == 0 ? &modules : nullptr;
+        results[i] = compileDevice(options);
+    });
+
+    // Итоги всех устройств записываются в метаданные одним обновлением.
+    bool succeeded = true;
+    try
+    {
+        QuartusMetadata current = json::parse(readFile(metadata)).get<ProjectSettings>().quartusMetadata;
+        for (size_t i = 0; i < devices.size(); i++)
+        {
+            const DeviceCompileResult& result = results[i];
+            QuartusMetadata* entry = &current;
+            if (fan_out)
+            {
+                auto found = find_if(current.devices.begin(), current.devices.end(),
+                                     [&](const QuartusMetadata& device) { return device.deviceName == devices[i]; });
+                if (found == current.devices.end())
+                {
+                    current.devices.emplace_back();
+                    current.devices.back().deviceName = devices[i];
+                    found = current.devices.end() - 1;
+                }
+                entry = &*found;
+            }
+            if (result.completed)
+            {
+                vector<QuartusMetadata> nested = move(entry->devices);
+                long long estimate = entry->estimatedAlms; // Стадия map могла выполняться отдельным запуском.
+                *entry = result.results;
+                entry->devices = move(nested);
+                if (entry->estimatedAlms == 0)
+                    entry->estimatedAlms = estimate;
+            }
+            else if (!result.abortReason.empty())
+            {
+                entry->quartusCompiled = false;
+                entry->abortReason = result.abortReason;
+            }
+            if (!result.completed && result.results.estimatedAlms != 0)
+                entry->estimatedAlms = result.results.estimatedAlms;
+            // Дополнение проекта, скомпилированного в режиме исследования: остальные итоги не меняются.
+            if (stage == "asm" && result.succeeded && entry->quartusCompiled)
+                entry->bitstreamGenerated = true;
+            if (!result.succeeded)
+            {
+                cout<<(fan_out ? devices[i] + ": " : "")<<result.error<<endl;
+                succeeded = false;
+            }
+        }
+        if (fan_out)
+        {
+            // Проект считается скомпилированным, когда скомпилирован для всех устройств.
+            current.quartusCompiled = !current.devices.empty();
+            current.bitstreamGenerated = !current.devices.empty();
+            for (const QuartusMetadata& device : current.devices)
+            {
+                current.quartusCompiled = current.quartusCompiled && device.quartusCompiled;
+                current.bitstreamGenerated = current.bitstreamGenerated && device.bitstreamGenerated;
+            }
+        }
+        saveQuartusMetadata(metadata, current);
+        // В хранилище итогов попадают устройства, итоги которых получены или дополнены этим запуском.
+        bool updated = stage == "asm";
+        for (const DeviceCompileResult& result : results)
+            updated = updated || result.completed;
+        if (updated)
+        {
+            try
+            {
+                noc::appendResults(location, resultRecords(name, settings.graphVerilogMetadata.params, current));
+            }
+            catch (exception& e)
+            {
+                // Хранилище — производные данные: компиляция из-за него не считается неудачной.
+                cout<<"Failed to update the results store: "<<e.what()<<endl;
+            }
+        }
+    }
+    catch (exception& e)
+    {
+        cout<<"Failed to save compile state: "<<e.what();
+        exit(1);
+    }
+    if (fan_out && last == compileStages.size() - 1)
+        for (size_t i = 0; i < devices.size(); i++)
+            if (results[i].completed && !results[i].results.clocks.empty())
+            {
+                const ClockTiming& clock = results[i].results.clocks.front();
+                cout<<devices[i]<<": "<<results[i].results.alms<<" ALMs, Fmax "<<clock.fmaxMhz<<" MHz, setup slack "
+                    <<clock.setupSlackNs<<" ns"<<endl;
+            }
+    if (!succeeded)
+        exit(1);
+}
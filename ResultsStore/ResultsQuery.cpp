@@ -0,0 +1,337 @@
+#include "ResultsQuery.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <optional>
+#include <stdexcept>
+
+namespace noc {
+
+namespace {
+
+std::string trim(const std::string& text) {
+    size_t first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) return "";
+    size_t last = text.find_last_not_of(" \t");
+    return text.substr(first, last - first + 1);
+}
+
+std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t comma = text.find(',', start);
+        if (comma == std::string::npos) comma = text.size();
+        std::string item = trim(text.substr(start, comma - start));
+        if (!item.empty()) items.push_back(item);
+        start = comma + 1;
+    }
+    return items;
+}
+
+std::optional<double> parseNumber(const std::string& text) {
+    if (text.empty()) return std::nullopt;
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size() || std::isnan(value)) return std::nullopt;
+    return value;
+}
+
+/**
+ * @brief Сужает маску отбора по условию на значения столбца; цикл без ветвлений векторизуется.
+ */
+template <class T, class Predicate>
+void narrow(std::vector<uint8_t>& mask, const T* values, Predicate predicate) {
+    uint8_t* m = mask.data();
+    const size_t n = mask.size();
+    for (size_t i = 0; i < n; ++i) m[i] &= static_cast<uint8_t>(predicate(values[i]));
+}
+
+/**
+ * @brief Диапазон чисел, удовлетворяющих условию сравнения (кроме `!=`).
+ */
+struct Range {
+    double low = -INFINITY;
+    double high = INFINITY;
+    bool lowOpen = false;
+    bool highOpen = false;
+};
+
+Range rangeOf(const std::string& op, double v) {
+    Range r;
+    if (op == "=") r.low = r.high = v;
+    else if (op == "<") { r.high = v; r.highOpen = true; }
+    else if (op == "<=") r.high = v;
+    else if (op == ">") { r.low = v; r.lowOpen = true; }
+    else if (op == ">=") r.low = v;
+    return r;
+}
+
+/**
+ * @brief Применяет условие к блоку.
+ * @return false, если по карте зон или словарю ни одна строка блока не может удовлетворить условию
+ * (маска тогда не меняется).
+ */
+bool applyFilter(const ResultsBlock& block, const ResultsFilter& filter, std::vector<uint8_t>& mask) {
+    const ResultsColumnHeader* column = block.find(filter.column);
+    if (!column || column->nullCount == block.rowCount()) return false;
+    const bool ne = filter.op == "!=";
+
+    if (column->type == static_cast<uint32_t>(ResultsType::String)) {
+        const uint32_t size = column->dictionarySize;
+        auto bound = [&](bool upper) {
+            uint32_t low = 0, high = size;
+            while (low < high) {
+                uint32_t middle = (low + high) / 2;
+                std::string_view entry = block.entry(*column, middle);
+                if (upper ? entry <= filter.value : entry < filter.value) low = middle + 1;
+                else high = middle;
+            }
+            return low;
+        };
+        const uint32_t lower = bound(false), upper = bound(true);
+        const uint32_t* codes = block.values<uint32_t>(*column);
+        if (ne) {
+            if (lower == upper) {
+                narrow(mask, codes, [](uint32_t c) { return c != resultsNullCode; });
+                return true;
+            }
+            if (size == 1 && column->nullCount == 0) return false;
+            narrow(mask, codes, [lower](uint32_t c) { return c != resultsNullCode && c != lower; });
+            return true;
+        }
+        // Словарь отсортирован: условие выполняется для непрерывного диапазона кодов [from, to).
+        uint32_t from = 0, to = size;
+        if (filter.op == "=") { from = lower; to = upper; }
+        else if (filter.op == "<") to = lower;
+        else if (filter.op == "<=") to = upper;
+        else if (filter.op == ">") from = upper;
+        else if (filter.op == ">=") from = lower;
+        if (from >= to) return false;
+        narrow(mask, codes, [from, to](uint32_t c) { return c >= from && c < to; });
+        return true;
+    }
+
+    std::optional<double> number = parseNumber(filter.value);
+    if (!number) return false;
+    const double v = *number;
+    if (column->type == static_cast<uint32_t>(ResultsType::Real)) {
+        const double* values = block.values<double>(*column);
+        if (ne) {
+            if (column->minReal == v && column->maxReal == v) return false;
+            narrow(mask, values, [v](double x) { return x == x && x != v; });
+            return true;
+        }
+        Range r = rangeOf(filter.op, v);
+        if (column->maxReal < r.low || (r.lowOpen && column->maxReal <= r.low) || column->minReal > r.high
+            || (r.highOpen && column->minReal >= r.high))
+            return false;
+        // NaN (NULL) не удовлетворяет ни одному сравнению.
+        narrow(mask, values, [r](double x) {
+            return (r.lowOpen ? x > r.low : x >= r.low) && (r.highOpen ? x < r.high : x <= r.high);
+        });
+        return true;
+    }
+
+    // Int: граница условия переводится в целые числа, чтобы сравнивать без преобразования значений.
+    const int64_t* values = block.values<int64_t>(*column);
+    const double limit = 9.2e18;
+    const bool integral = std::floor(v) == v;
+    if (ne) {
+        if (!integral || std::fabs(v) > limit) {
+            narrow(mask, values, [](int64_t x) { return x != resultsNullInt; });
+            return true;
+        }
+        const int64_t t = static_cast<int64_t>(v);
+        if (column->minInt == t && column->maxInt == t) return false;
+        narrow(mask, values, [t](int64_t x) { return x != resultsNullInt && x != t; });
+        return true;
+    }
+    Range r = rangeOf(filter.op, v);
+    // Наименьшее значение Int занято NULL и в диапазон не входит.
+    int64_t low = std::numeric_limits<int64_t>::min() + 1, high = std::numeric_limits<int64_t>::max();
+    if (r.low != -INFINITY) {
+        if (r.low >= limit) return false;
+        if (r.low > -limit) low = static_cast<int64_t>(r.lowOpen ? std::floor(r.low) + 1 : std::ceil(r.low));
+    }
+    if (r.high != INFINITY) {
+        if (r.high <= -limit) return false;
+        if (r.high < limit) high = static_cast<int64_t>(r.highOpen ? std::ceil(r.high) - 1 : std::floor(r.high));
+    }
+    if (low > high) return false;
+    if (column->maxInt < low || column->minInt > high) return false;
+    narrow(mask, values, [low, high](int64_t x) { return x >= low && x <= high; });
+    return true;
+}
+
+/**
+ * @brief Значение столбца строки блока для группировки; отсутствующий столбец — NULL.
+ */
+ResultsValue valueAt(const ResultsBlock& block, const ResultsColumnHeader* column, uint32_t row) {
+    if (!column) return std::monostate{};
+    if (column->type == static_cast<uint32_t>(ResultsType::Int)) {
+        int64_t v = block.values<int64_t>(*column)[row];
+        return v == resultsNullInt ? ResultsValue{} : ResultsValue{static_cast<double>(v)};
+    }
+    if (column->type == static_cast<uint32_t>(ResultsType::Real)) {
+        double v = block.values<double>(*column)[row];
+        return std::isnan(v) ? ResultsValue{} : ResultsValue{v};
+    }
+    uint32_t code = block.values<uint32_t>(*column)[row];
+    return code == resultsNullCode ? ResultsValue{} : ResultsValue{std::string(block.entry(*column, code))};
+}
+
+/**
+ * @brief Накопитель агрегата.
+ */
+struct Accumulator {
+    size_t count = 0;
+    double sum = 0;
+    double min = INFINITY;
+    double max = -INFINITY;
+
+    void add(double x) {
+        ++count;
+        sum += x;
+        min = std::min(min, x);
+        max = std::max(max, x);
+    }
+};
+
+struct Group {
+    std::vector<ResultsValue> key;
+    size_t rows = 0;
+    std::vector<Accumulator> accumulators;
+};
+
+/**
+ * @brief Добавляет к накопителю числовые значения отобранных строк.
+ */
+void accumulate(const ResultsBlock& block, const ResultsColumnHeader* column, const std::vector<uint32_t>& rows,
+                Accumulator& accumulator) {
+    if (!column) return;
+    if (column->type == static_cast<uint32_t>(ResultsType::Int)) {
+        const int64_t* values = block.values<int64_t>(*column);
+        for (uint32_t r : rows)
+            if (values[r] != resultsNullInt) accumulator.add(static_cast<double>(values[r]));
+    } else if (column->type == static_cast<uint32_t>(ResultsType::Real)) {
+        const double* values = block.values<double>(*column);
+        for (uint32_t r : rows)
+            if (!std::isnan(values[r])) accumulator.add(values[r]);
+    }
+}
+
+} // namespace
+
+ResultsQuery parseResultsQuery(const std::string& where, const std::string& groupBy, const std::string& select) {
+    ResultsQuery query;
+    for (const std::string& item : splitList(where)) {
+        size_t at = item.find_first_of("<>=!");
+        if (at == std::string::npos || at == 0)
+            throw std::invalid_argument("Invalid condition: " + item);
+        size_t length = at + 1 < item.size() && item[at + 1] == '=' ? 2 : 1;
+        ResultsFilter filter{trim(item.substr(0, at)), item.substr(at, length), trim(item.substr(at + length))};
+        if (filter.op == "!" || filter.op == "==" || filter.value.find_first_of("<>=!") == 0)
+            throw std::invalid_argument("Invalid condition: " + item);
+        query.where.push_back(std::move(filter));
+    }
+    query.groupBy = splitList(groupBy);
+    for (const std::string& item : splitList(select)) {
+        size_t colon = item.find(':');
+        ResultsAggregate aggregate{trim(item.substr(0, colon)), colon == std::string::npos ? "" : trim(item.substr(colon + 1))};
+        const bool known = aggregate.function == "count" || aggregate.function == "min" || aggregate.function == "max"
+                           || aggregate.function == "sum" || aggregate.function == "avg";
+        if (!known || (aggregate.function != "count" && aggregate.column.empty()))
+            throw std::invalid_argument("Invalid aggregate: " + item + " (expected count or min|max|sum|avg:column)");
+        query.select.push_back(std::move(aggregate));
+    }
+    if (query.select.empty()) query.select.push_back({"count", ""});
+    return query;
+}
+
+ResultsQueryResult runResultsQuery(const ResultsTable& table, const ResultsQuery& query) {
+    ResultsQueryResult result;
+    result.columns = query.groupBy;
+    for (const ResultsAggregate& aggregate : query.select)
+        result.columns.push_back(aggregate.function == "count" ? "count" : aggregate.function + "(" + aggregate.column + ")");
+
+    std::vector<Group> groups;
+    std::map<std::vector<ResultsValue>, size_t> groupIndex;
+    std::vector<uint8_t> mask;
+    std::vector<uint32_t> selected;
+    for (const ResultsBlock& block : table.blocks()) {
+        ++result.blocks;
+        mask = block.live;
+        bool possible = true;
+        for (const ResultsFilter& filter : query.where) {
+            if (!applyFilter(block, filter, mask)) {
+                possible = false;
+                break;
+            }
+        }
+        if (!possible) {
+            ++result.skippedBlocks;
+            continue;
+        }
+        selected.clear();
+        for (uint32_t r = 0; r < block.rowCount(); ++r)
+            if (mask[r]) selected.push_back(r);
+        if (selected.empty()) continue;
+        result.matchedRows += selected.size();
+
+        // Строки блока распределяются по группам, затем агрегаты вычисляются по столбцам для каждой группы.
+        std::vector<const ResultsColumnHeader*> keyColumns;
+        for (const std::string& name : query.groupBy) keyColumns.push_back(block.find(name));
+        std::map<size_t, std::vector<uint32_t>> rowsByGroup;
+        std::vector<ResultsValue> key(keyColumns.size());
+        auto groupOf = [&]() {
+            auto [found, inserted] = groupIndex.try_emplace(key, groups.size());
+            if (inserted) groups.push_back({key, 0, std::vector<Accumulator>(query.select.size())});
+            return found->second;
+        };
+        if (keyColumns.empty()) {
+            rowsByGroup[groupOf()] = selected;
+        } else {
+            for (uint32_t r : selected) {
+                for (size_t k = 0; k < keyColumns.size(); ++k) key[k] = valueAt(block, keyColumns[k], r);
+                rowsByGroup[groupOf()].push_back(r);
+            }
+        }
+        for (const auto& [index, rows] : rowsByGroup) {
+            Group& group = groups[index];
+            group.rows += rows.size();
+            for (size_t a = 0; a < query.select.size(); ++a)
+                if (query.select[a].function != "count")
+                    accumulate(block, block.find(query.select[a].column), rows, group.accumulators[a]);
+        }
+    }
+
+    for (const auto& entry : groupIndex) {
+        const Group& group = groups[entry.second];
+        std::vector<ResultsValue> row = group.key;
+        for (size_t a = 0; a < query.select.size(); ++a) {
+            const std::string& function = query.select[a].function;
+            const Accumulator& accumulator = group.accumulators[a];
+            if (function == "count") row.push_back(static_cast<double>(group.rows));
+            else if (accumulator.count == 0) row.push_back(std::monostate{});
+            else if (function == "min") row.push_back(accumulator.min);
+            else if (function == "max") row.push_back(accumulator.max);
+            else if (function == "sum") row.push_back(accumulator.sum);
+            else row.push_back(accumulator.sum / static_cast<double>(accumulator.count));
+        }
+        result.rows.push_back(std::move(row));
+    }
+    // Без группировки результат — одна строка, даже если ни одна строка не отобрана.
+    if (result.rows.empty() && query.groupBy.empty()) {
+        std::vector<ResultsValue> row;
+        for (const ResultsAggregate& aggregate : query.select)
+            row.push_back(aggregate.function == "count" ? ResultsValue{0.0} : ResultsValue{});
+        result.rows.push_back(std::move(row));
+    }
+    return result;
+}
+
+} // namespace noc
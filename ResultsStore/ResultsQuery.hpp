@@ -0,0 +1,67 @@
+#pragma once
+/**
+ * @file ResultsQuery.hpp
+ * @brief Фильтрация и агрегирование строк хранилища итогов (ResultsTable).
+ *
+ * Запрос выполняется по блокам: сначала по картам зон и словарям отбрасываются блоки, в которых
+ * условие не может выполниться, затем условия вычисляются по столбцам целиком в маску отбора
+ * (простые циклы по массивам фиксированной ширины, которые компилятор векторизует), и по маске
+ * вычисляются агрегаты. Строки, заменённые более поздними, в запрос не попадают. NULL не удовлетворяет
+ * ни одному условию и не учитывается агрегатами, кроме count.
+ */
+
+#include <string>
+#include <variant>
+#include <vector>
+#include "ResultsStore.hpp"
+
+namespace noc {
+
+/**
+ * @brief Условие `столбец оператор значение`; операторы `=`, `!=`, `<`, `<=`, `>`, `>=`.
+ * Для строковых столбцов значения сравниваются лексикографически.
+ */
+struct ResultsFilter {
+    std::string column;
+    std::string op;
+    std::string value;
+};
+
+/**
+ * @brief Агрегат: count (число строк) или min, max, sum, avg по столбцу.
+ */
+struct ResultsAggregate {
+    std::string function;
+    std::string column;
+};
+
+struct ResultsQuery {
+    std::vector<ResultsFilter> where;
+    std::vector<std::string> groupBy;
+    std::vector<ResultsAggregate> select;
+};
+
+/**
+ * @brief Разбирает запрос из аргументов командной строки:
+ * условия `"Nx>=8,device=5CGXFC9E7F35C8"`, группировка `"Nx,Ny"`, агрегаты `"count,avg:fmax_mhz,max:alms"`
+ * (пустая строка агрегатов — count).
+ * @throws std::invalid_argument при ошибке синтаксиса.
+ */
+ResultsQuery parseResultsQuery(const std::string& where, const std::string& groupBy, const std::string& select);
+
+/// @brief Значение результата: NULL, число или строка.
+using ResultsValue = std::variant<std::monostate, double, std::string>;
+
+struct ResultsQueryResult {
+    /// Столбцы группировки, затем агрегаты ("count", "avg(fmax_mhz)", ...).
+    std::vector<std::string> columns;
+    /// Строки по группам в порядке возрастания значений группировки.
+    std::vector<std::vector<ResultsValue>> rows;
+    size_t blocks = 0;
+    size_t skippedBlocks = 0;  ///< Блоки, отброшенные по картам зон.
+    size_t matchedRows = 0;
+};
+
+ResultsQueryResult runResultsQuery(const ResultsTable& table, const ResultsQuery& query);
+
+} // namespace noc
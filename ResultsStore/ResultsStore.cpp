@@ -0,0 +1,452 @@
+#include "ResultsStore.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+#include "FileLock.hpp"
+#include "Hash.hpp"
+
+namespace noc {
+
+const std::vector<std::string_view> resultsColumns = {
+    "project", "device", "params", "alms", "alms_available", "registers", "ram_blocks", "block_memory_bits",
+    "dsp_blocks", "fmax_mhz", "restricted_fmax_mhz", "setup_slack_ns", "seed", "bitstream", "time"};
+
+namespace {
+
+namespace fs = std::filesystem;
+
+constexpr char resultsMagic[8] = {'N', 'O', 'C', 'R', 'S', 'L', 'T', '1'};
+
+/// Сжатие, когда блоков больше этого числа (мелкие блоки отдельных компиляций).
+constexpr size_t compactAfterBlocks = 64;
+
+static_assert(std::endian::native == std::endian::little, "Results store format is little-endian");
+static_assert(sizeof(ResultsBlockHeader) % 8 == 0);
+static_assert(sizeof(ResultsColumnHeader) % 8 == 0);
+
+uint64_t align8(uint64_t value) {
+    return (value + 7) & ~uint64_t(7);
+}
+
+/**
+ * @brief Значения одного столбца собираемого блока.
+ */
+struct ColumnData {
+    std::string name;
+    ResultsType type = ResultsType::Int;
+    std::vector<int64_t> ints;
+    std::vector<double> reals;
+    std::vector<std::optional<std::string>> strings;
+};
+
+/**
+ * @brief Пары `ключ=значение` строки params; ключи длиннее имени столбца и совпадающие
+ * с основными столбцами пропускаются.
+ */
+std::vector<std::pair<std::string, std::string>> splitParams(const std::string& params) {
+    std::vector<std::pair<std::string, std::string>> pairs;
+    size_t i = 0;
+    while (i < params.size()) {
+        while (i < params.size() && std::isspace(static_cast<unsigned char>(params[i]))) ++i;
+        size_t end = i;
+        while (end < params.size() && !std::isspace(static_cast<unsigned char>(params[end]))) ++end;
+        std::string token = params.substr(i, end - i);
+        i = end;
+        size_t eq = token.find('=');
+        if (eq == std::string::npos || eq == 0 || eq >= sizeof(ResultsColumnHeader::name)) continue;
+        std::string key = token.substr(0, eq);
+        if (std::find(resultsColumns.begin(), resultsColumns.end(), key) != resultsColumns.end()) continue;
+        pairs.emplace_back(std::move(key), token.substr(eq + 1));
+    }
+    return pairs;
+}
+
+std::optional<double> parseNumber(const std::string& text) {
+    if (text.empty()) return std::nullopt;
+    char* end = nullptr;
+    double value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size() || !std::isfinite(value)) return std::nullopt;
+    return value;
+}
+
+/**
+ * @brief Столбцы блока из строк: основные столбцы и столбцы параметров.
+ */
+std::vector<ColumnData> columnsOf(const std::vector<const ResultRecord*>& records) {
+    std::vector<ColumnData> columns(resultsColumns.size());
+    for (size_t c = 0; c < columns.size(); ++c) {
+        columns[c].name = resultsColumns[c];
+        columns[c].type = c < 3 ? ResultsType::String : (c >= 9 && c <= 11) ? ResultsType::Real : ResultsType::Int;
+    }
+    auto real = [](const std::optional<double>& v) { return v ? *v : std::nan(""); };
+    // Параметры: столбец числовой, если числовые все его значения в блоке.
+    std::map<std::string, std::vector<std::optional<std::string>>> params;
+    for (size_t r = 0; r < records.size(); ++r) {
+        const ResultRecord& record = *records[r];
+        columns[0].strings.push_back(record.project);
+        columns[1].strings.push_back(record.device);
+        columns[2].strings.push_back(record.params);
+        const int64_t ints[] = {record.alms, record.almsAvailable, record.registers, record.ramBlocks,
+                                record.blockMemoryBits, record.dspBlocks};
+        for (size_t c = 0; c < 6; ++c) columns[3 + c].ints.push_back(ints[c]);
+        columns[9].reals.push_back(real(record.fmaxMhz));
+        columns[10].reals.push_back(real(record.restrictedFmaxMhz));
+        columns[11].reals.push_back(real(record.setupSlackNs));
+        columns[12].ints.push_back(record.seed);
+        columns[13].ints.push_back(record.bitstream ? 1 : 0);
+        columns[14].ints.push_back(record.time);
+        for (auto& [key, value] : splitParams(record.params)) {
+            auto& values = params[key];
+            values.resize(records.size());
+            values[r] = std::move(value);
+        }
+    }
+    for (auto& [key, values] : params) {
+        values.resize(records.size());
+        ColumnData column;
+        column.name = key;
+        bool numeric = std::all_of(values.begin(), values.end(),
+                                   [](const std::optional<std::string>& v) { return !v || parseNumber(*v); });
+        if (numeric) {
+            column.type = ResultsType::Real;
+            for (const auto& v : values) column.reals.push_back(v ? *parseNumber(*v) : std::nan(""));
+        } else {
+            column.type = ResultsType::String;
+            column.strings = std::move(values);
+        }
+        columns.push_back(std::move(column));
+    }
+    return columns;
+}
+
+template <class T>
+void put(std::string& out, uint64_t offset, const T& value) {
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+
+/**
+ * @brief Кодирует строки в блок.
+ */
+std::string encodeBlock(const std::vector<const ResultRecord*>& records) {
+    const std::vector<ColumnData> columns = columnsOf(records);
+    const uint32_t rowCount = static_cast<uint32_t>(records.size());
+    std::vector<ResultsColumnHeader> headers(columns.size());
+    std::vector<std::vector<std::string>> dictionaries(columns.size());
+    uint64_t offset = sizeof(ResultsBlockHeader) + sizeof(ResultsColumnHeader) * columns.size();
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const ColumnData& column = columns[c];
+        ResultsColumnHeader& h = headers[c];
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.name, column.name.data(), std::min(column.name.size(), sizeof(h.name) - 1));
+        h.type = static_cast<uint32_t>(column.type);
+        h.data = offset;
+        h.minInt = std::numeric_limits<int64_t>::max();
+        h.maxInt = std::numeric_limits<int64_t>::min();
+        h.minReal = std::numeric_limits<double>::infinity();
+        h.maxReal = -std::numeric_limits<double>::infinity();
+        if (column.type == ResultsType::Int) {
+            for (int64_t v : column.ints) {
+                if (v == resultsNullInt) { ++h.nullCount; continue; }
+                h.minInt = std::min(h.minInt, v);
+                h.maxInt = std::max(h.maxInt, v);
+            }
+            offset += align8(8ull * rowCount);
+        } else if (column.type == ResultsType::Real) {
+            for (double v : column.reals) {
+                if (std::isnan(v)) { ++h.nullCount; continue; }
+                h.minReal = std::min(h.minReal, v);
+                h.maxReal = std::max(h.maxReal, v);
+            }
+            offset += align8(8ull * rowCount);
+        } else {
+            std::vector<std::string>& dictionary = dictionaries[c];
+            for (const auto& v : column.strings) {
+                if (v) dictionary.push_back(*v);
+                else ++h.nullCount;
+            }
+            std::sort(dictionary.begin(), dictionary.end());
+            dictionary.erase(std::unique(dictionary.begin(), dictionary.end()), dictionary.end());
+            h.dictionarySize = static_cast<uint32_t>(dictionary.size());
+            offset += align8(4ull * rowCount);
+            h.dictionary = offset;
+            uint64_t chars = 0;
+            for (const std::string& s : dictionary) chars += s.size();
+            offset += align8(4ull * (dictionary.size() + 1) + chars);
+        }
+    }
+
+    std::string out(offset, '\0');
+    for (size_t c = 0; c < columns.size(); ++c) {
+        const ColumnData& column = columns[c];
+        const ResultsColumnHeader& h = headers[c];
+        put(out, sizeof(ResultsBlockHeader) + sizeof(ResultsColumnHeader) * c, h);
+        if (column.type == ResultsType::Int) {
+            std::memcpy(out.data() + h.data, column.ints.data(), 8ull * rowCount);
+        } else if (column.type == ResultsType::Real) {
+            std::memcpy(out.data() + h.data, column.reals.data(), 8ull * rowCount);
+        } else {
+            const std::vector<std::string>& dictionary = dictionaries[c];
+            for (uint32_t r = 0; r < rowCount; ++r) {
+                const auto& v = column.strings[r];
+                uint32_t code = v ? static_cast<uint32_t>(std::lower_bound(dictionary.begin(), dictionary.end(), *v)
+                                                          - dictionary.begin())
+                                  : resultsNullCode;
+                put(out, h.data + 4ull * r, code);
+            }
+            uint64_t chars = h.dictionary + 4ull * (dictionary.size() + 1);
+            uint32_t position = 0;
+            for (size_t i = 0; i < dictionary.size(); ++i) {
+                put(out, h.dictionary + 4ull * i, position);
+                std::memcpy(out.data() + chars + position, dictionary[i].data(), dictionary[i].size());
+                position += static_cast<uint32_t>(dictionary[i].size());
+            }
+            put(out, h.dictionary + 4ull * dictionary.size(), position);
+        }
+    }
+    ResultsBlockHeader header{};
+    std::memcpy(header.magic, resultsMagic, sizeof(resultsMagic));
+    header.size = out.size();
+    header.rowCount = rowCount;
+    header.columnCount = static_cast<uint32_t>(columns.size());
+    header.checksum = common::hash64(std::string_view(out).substr(sizeof(ResultsBlockHeader)));
+    put(out, 0, header);
+    return out;
+}
+
+/**
+ * @brief Кодирует строки в блоки по resultsBlockRows строк.
+ */
+std::string encodeBlocks(const std::vector<const ResultRecord*>& records) {
+    std::string out;
+    for (size_t first = 0; first < records.size(); first += resultsBlockRows) {
+        size_t last = std::min(records.size(), first + resultsBlockRows);
+        out += encodeBlock(std::vector<const ResultRecord*>(records.begin() + first, records.begin() + last));
+    }
+    return out;
+}
+
+/**
+ * @brief Проверяет границы секций блока, чтобы чтение столбцов не выходило за его пределы.
+ */
+bool validBlock(const unsigned char* base, uint64_t available) {
+    ResultsBlockHeader header;
+    if (available < sizeof(header)) return false;
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, resultsMagic, sizeof(resultsMagic)) != 0) return false;
+    if (header.size > available || header.size % 8 != 0 || header.rowCount > resultsBlockRows) return false;
+    if (sizeof(header) + uint64_t(header.columnCount) * sizeof(ResultsColumnHeader) > header.size) return false;
+    std::string_view body(reinterpret_cast<const char*>(base) + sizeof(header), header.size - sizeof(header));
+    if (common::hash64(body) != header.checksum) return false;
+    const auto* columns = reinterpret_cast<const ResultsColumnHeader*>(base + sizeof(header));
+    for (uint32_t c = 0; c < header.columnCount; ++c) {
+        const ResultsColumnHeader& column = columns[c];
+        uint64_t width = column.type == static_cast<uint32_t>(ResultsType::String) ? 4 : 8;
+        if (column.type > static_cast<uint32_t>(ResultsType::String) || column.data % 8 != 0
+            || column.data + width * header.rowCount > header.size)
+            return false;
+        if (column.type != static_cast<uint32_t>(ResultsType::String)) continue;
+        uint64_t chars = column.dictionary + 4ull * (uint64_t(column.dictionarySize) + 1);
+        if (column.dictionary % 4 != 0 || chars > header.size) return false;
+        uint32_t total;
+        std::memcpy(&total, base + column.dictionary + 4ull * column.dictionarySize, sizeof(total));
+        if (chars + total > header.size) return false;
+        const uint32_t* codes = reinterpret_cast<const uint32_t*>(base + column.data);
+        for (uint32_t r = 0; r < header.rowCount; ++r)
+            if (codes[r] != resultsNullCode && codes[r] >= column.dictionarySize) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+std::string resultsStorePath(const std::string& location) {
+    return (fs::path(location) / "results_store.bin").string();
+}
+
+const ResultsColumnHeader* ResultsBlock::find(std::string_view name) const {
+    for (uint32_t c = 0; c < header->columnCount; ++c)
+        if (name == columns[c].name) return &columns[c];
+    return nullptr;
+}
+
+std::string_view ResultsBlock::entry(const ResultsColumnHeader& column, uint32_t code) const {
+    const uint32_t* offsets = reinterpret_cast<const uint32_t*>(base + column.dictionary);
+    const char* chars = reinterpret_cast<const char*>(offsets + column.dictionarySize + 1);
+    return std::string_view(chars + offsets[code], offsets[code + 1] - offsets[code]);
+}
+
+ResultsTable ResultsTable::load(const std::string& location) {
+    ResultsTable table;
+    const std::string path = resultsStorePath(location);
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) {
+        if (fs::exists(path)) throw std::runtime_error("Failed to open " + path);
+        return table;
+    }
+    in.seekg(0, std::ios::end);
+    const uint64_t size = static_cast<uint64_t>(in.tellg());
+    in.seekg(0);
+    // Буфер из uint64_t выравнивает столбцы на 8 байт.
+    table.buffer_.resize((size + 7) / 8);
+    if (!in.read(reinterpret_cast<char*>(table.buffer_.data()), static_cast<std::streamsize>(size)))
+        throw std::runtime_error("Failed to read " + path);
+
+    const auto* data = reinterpret_cast<const unsigned char*>(table.buffer_.data());
+    uint64_t offset = 0;
+    while (offset < size && validBlock(data + offset, size - offset)) {
+        ResultsBlock block;
+        block.base = data + offset;
+        block.header = reinterpret_cast<const ResultsBlockHeader*>(block.base);
+        block.columns = reinterpret_cast<const ResultsColumnHeader*>(block.base + sizeof(ResultsBlockHeader));
+        block.live.assign(block.rowCount(), 1);
+        table.rows_ += block.rowCount();
+        offset += block.header->size;
+        table.blocks_.push_back(std::move(block));
+    }
+    table.validSize_ = offset;
+
+    // Действует строка проекта и устройства с наибольшим временем; при равном времени — записанная позже.
+    std::unordered_map<std::string, std::pair<int64_t, std::pair<size_t, uint32_t>>> newest;
+    for (size_t b = 0; b < table.blocks_.size(); ++b) {
+        const ResultsBlock& block = table.blocks_[b];
+        const ResultsColumnHeader* project = block.find("project");
+        const ResultsColumnHeader* device = block.find("device");
+        const ResultsColumnHeader* time = block.find("time");
+        if (!project || !device || !time) continue;
+        const uint32_t* projects = block.values<uint32_t>(*project);
+        const uint32_t* devices = block.values<uint32_t>(*device);
+        const int64_t* times = block.values<int64_t>(*time);
+        for (uint32_t r = 0; r < block.rowCount(); ++r) {
+            std::string key;
+            if (projects[r] != resultsNullCode) key = block.entry(*project, projects[r]);
+            key += '\0';
+            if (devices[r] != resultsNullCode) key += block.entry(*device, devices[r]);
+            auto [found, inserted] = newest.try_emplace(std::move(key), times[r], std::make_pair(b, r));
+            if (inserted) continue;
+            if (times[r] < found->second.first) {
+                table.blocks_[b].live[r] = 0;
+                continue;
+            }
+            auto [oldBlock, oldRow] = found->second.second;
+            table.blocks_[oldBlock].live[oldRow] = 0;
+            found->second = {times[r], {b, r}};
+        }
+    }
+    table.liveRows_ = newest.size();
+    return table;
+}
+
+std::set<std::string> ResultsTable::projects() const {
+    std::set<std::string> projects;
+    for (const ResultsBlock& block : blocks_) {
+        const ResultsColumnHeader* project = block.find("project");
+        if (!project) continue;
+        const uint32_t* codes = block.values<uint32_t>(*project);
+        for (uint32_t r = 0; r < block.rowCount(); ++r)
+            if (block.live[r] && codes[r] != resultsNullCode) projects.emplace(block.entry(*project, codes[r]));
+    }
+    return projects;
+}
+
+ResultRecord ResultsTable::record(const ResultsBlock& block, uint32_t row) const {
+    ResultRecord record;
+    auto text = [&](const char* name) {
+        const ResultsColumnHeader* column = block.find(name);
+        if (!column || column->type != static_cast<uint32_t>(ResultsType::String)) return std::string();
+        uint32_t code = block.values<uint32_t>(*column)[row];
+        return code == resultsNullCode ? std::string() : std::string(block.entry(*column, code));
+    };
+    auto integer = [&](const char* name) -> int64_t {
+        const ResultsColumnHeader* column = block.find(name);
+        if (!column || column->type != static_cast<uint32_t>(ResultsType::Int)) return 0;
+        int64_t v = block.values<int64_t>(*column)[row];
+        return v == resultsNullInt ? 0 : v;
+    };
+    auto real = [&](const char* name) -> std::optional<double> {
+        const ResultsColumnHeader* column = block.find(name);
+        if (!column || column->type != static_cast<uint32_t>(ResultsType::Real)) return std::nullopt;
+        double v = block.values<double>(*column)[row];
+        return std::isnan(v) ? std::nullopt : std::optional<double>(v);
+    };
+    record.project = text("project");
+    record.device = text("device");
+    record.params = text("params");
+    record.alms = integer("alms");
+    record.almsAvailable = integer("alms_available");
+    record.registers = integer("registers");
+    record.ramBlocks = integer("ram_blocks");
+    record.blockMemoryBits = integer("block_memory_bits");
+    record.dspBlocks = integer("dsp_blocks");
+    record.fmaxMhz = real("fmax_mhz");
+    record.restrictedFmaxMhz = real("restricted_fmax_mhz");
+    record.setupSlackNs = real("setup_slack_ns");
+    record.seed = integer("seed");
+    record.bitstream = integer("bitstream") != 0;
+    record.time = integer("time");
+    return record;
+}
+
+void appendResults(const std::string& location, const std::vector<ResultRecord>& records) {
+    if (records.empty()) return;
+    common::FileLock lock((fs::path(location) / "results_store.lock").string());
+    const std::string path = resultsStorePath(location);
+    ResultsTable table = ResultsTable::load(location);
+
+    std::vector<const ResultRecord*> pointers;
+    for (const ResultRecord& record : records) pointers.push_back(&record);
+    const std::string appended = encodeBlocks(pointers);
+
+    const size_t dead = table.rows() - table.liveRows();
+    if (table.blocks().size() < compactAfterBlocks && dead <= std::max<size_t>(table.liveRows(), resultsBlockRows)) {
+        // Повреждённый хвост (запись, прерванная сбоем) отрезается, иначе новые блоки были бы не видны читателям.
+        std::error_code ec;
+        if (fs::exists(path, ec) && fs::file_size(path, ec) != table.validSize())
+            fs::resize_file(path, table.validSize());
+        std::ofstream out(path, std::ios::binary | std::ios::app);
+        out.write(appended.data(), static_cast<std::streamsize>(appended.size()));
+        out.flush();
+        if (!out) throw std::runtime_error("Failed to append to " + path);
+        return;
+    }
+
+    // Сжатие: действующие строки хранилища и новые строки переписываются полными блоками.
+    std::vector<ResultRecord> merged;
+    merged.reserve(table.liveRows() + records.size());
+    for (const ResultsBlock& block : table.blocks())
+        for (uint32_t r = 0; r < block.rowCount(); ++r)
+            if (block.live[r]) merged.push_back(table.record(block, r));
+    merged.insert(merged.end(), records.begin(), records.end());
+    std::stable_sort(merged.begin(), merged.end(), [](const ResultRecord& a, const ResultRecord& b) {
+        return std::tie(a.project, a.device) < std::tie(b.project, b.device);
+    });
+    pointers.clear();
+    for (size_t i = 0; i < merged.size(); ++i) {
+        // Из строк одного проекта и устройства остаётся последняя по времени (при равенстве — новая).
+        if (i + 1 < merged.size() && merged[i].project == merged[i + 1].project && merged[i].device == merged[i + 1].device) {
+            if (merged[i].time > merged[i + 1].time) std::swap(merged[i], merged[i + 1]);
+            continue;
+        }
+        pointers.push_back(&merged[i]);
+    }
+    const std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        std::string compacted = encodeBlocks(pointers);
+        out.write(compacted.data(), static_cast<std::streamsize>(compacted.size()));
+        out.flush();
+        if (!out) throw std::runtime_error("Failed to write " + tmp);
+    }
+    fs::rename(tmp, path);
+}
+
+} // namespace noc
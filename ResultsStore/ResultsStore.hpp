@@ -0,0 +1,174 @@
+#pragma once
+/**
+ * @file ResultsStore.hpp
+ * @brief Локальное колоночное хранилище итогов компиляции `<расположение>/results_store.bin`.
+ *
+ * Запросы по итогам серии проектов (ресурсы и Fmax в зависимости от Nx/Ny) читают один файл
+ * вместо метаданных каждого проекта или удалённой базы данных.
+ *
+ * Файл — последовательность самостоятельных блоков по не более чем resultsBlockRows строк.
+ * Значения блока хранятся по столбцам фиксированной ширины:
+ * - Int  — `int64_t[rowCount]`, NULL — resultsNullInt;
+ * - Real — `double[rowCount]`, NULL — NaN;
+ * - String — коды `uint32_t[rowCount]` в отсортированный словарь блока, NULL — resultsNullCode.
+ *
+ * Заголовок столбца содержит карту зон: наименьшее и наибольшее значение и число NULL, поэтому
+ * запрос пропускает блоки, не читая значений. Для строковых столбцов роль карты зон играет словарь.
+ *
+ * Кроме основных столбцов (resultsColumns) каждая пара `ключ=значение` из params становится
+ * отдельным столбцом блока: Real, если значения числовые, иначе String.
+ *
+ * Раскладка блока (little-endian, секции выровнены на 8 байт):
+ * - ResultsBlockHeader;
+ * - ResultsColumnHeader[columnCount];
+ * - значения и словари столбцов (словарь — `uint32_t offsets[dictionarySize + 1]` и символы).
+ *
+ * Блоки дописываются под блокировкой `results_store.lock`: Quartus_compiler и Database_writer
+ * пишут в хранилище одновременно. Из строк одного проекта и устройства действует строка с наибольшим
+ * временем time. Когда мелких блоков или заменённых строк становится много, запись сжимает файл:
+ * действующие строки переписываются полными блоками, упорядоченными по проекту, во временный файл,
+ * который затем заменяет хранилище. Читатели не берут блокировку: недописанный хвостовой блок
+ * не проходит проверку контрольной суммы и пропускается.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace noc {
+
+/// @brief Наибольшее число строк в блоке.
+constexpr uint32_t resultsBlockRows = 4096;
+/// @brief NULL в столбце Int.
+constexpr int64_t resultsNullInt = std::numeric_limits<int64_t>::min();
+/// @brief NULL в столбце String.
+constexpr uint32_t resultsNullCode = std::numeric_limits<uint32_t>::max();
+
+enum class ResultsType : uint32_t { Int = 0, Real = 1, String = 2 };
+
+/**
+ * @brief Заголовок блока.
+ */
+struct ResultsBlockHeader {
+    char magic[8];         ///< "NOCRSLT1".
+    uint64_t size;         ///< Размер блока вместе с заголовком.
+    uint64_t checksum;     ///< XXH64 байтов блока после заголовка.
+    uint32_t rowCount;
+    uint32_t columnCount;
+};
+
+/**
+ * @brief Заголовок столбца блока с картой зон. Смещения отсчитываются от начала блока.
+ */
+struct ResultsColumnHeader {
+    char name[32];          ///< Имя, завершённое нулём.
+    uint32_t type;          ///< ResultsType.
+    uint32_t nullCount;
+    uint64_t data;
+    uint64_t dictionary;    ///< Только String.
+    uint32_t dictionarySize;
+    uint32_t reserved;
+    int64_t minInt;         ///< Карта зон Int (без NULL).
+    int64_t maxInt;
+    double minReal;         ///< Карта зон Real (без NULL).
+    double maxReal;
+};
+
+/**
+ * @brief Итоги компиляции проекта для одного устройства.
+ */
+struct ResultRecord {
+    std::string project;
+    std::string device;
+    std::string params;
+    int64_t alms = 0;
+    int64_t almsAvailable = 0;
+    int64_t registers = 0;
+    int64_t ramBlocks = 0;
+    int64_t blockMemoryBits = 0;
+    int64_t dspBlocks = 0;
+    /// Временные характеристики худшего по запасу тактового сигнала; пустые, если отчёт их не содержит.
+    std::optional<double> fmaxMhz;
+    std::optional<double> restrictedFmaxMhz;
+    std::optional<double> setupSlackNs;
+    int64_t seed = 0;
+    bool bitstream = false;
+    /// Время получения итогов (нс от эпохи): более поздняя строка проекта и устройства заменяет более раннюю.
+    int64_t time = 0;
+};
+
+/// @brief Основные столбцы в порядке полей ResultRecord.
+extern const std::vector<std::string_view> resultsColumns;
+
+/**
+ * @brief Путь к файлу хранилища в расположении проектов.
+ */
+std::string resultsStorePath(const std::string& location);
+
+/**
+ * @brief Блок, разобранный из файла хранилища. Указатели действительны, пока жива таблица.
+ */
+struct ResultsBlock {
+    const unsigned char* base = nullptr;
+    const ResultsBlockHeader* header = nullptr;
+    const ResultsColumnHeader* columns = nullptr;
+    /// Строки, не заменённые более поздними строками того же проекта и устройства.
+    std::vector<uint8_t> live;
+
+    uint32_t rowCount() const { return header->rowCount; }
+    /// @brief Столбец по имени; nullptr, если в блоке его нет (все значения NULL).
+    const ResultsColumnHeader* find(std::string_view name) const;
+    template <class T>
+    const T* values(const ResultsColumnHeader& column) const {
+        return reinterpret_cast<const T*>(base + column.data);
+    }
+    /// @brief Строка словаря столбца String.
+    std::string_view entry(const ResultsColumnHeader& column, uint32_t code) const;
+};
+
+/**
+ * @brief Содержимое файла хранилища в памяти.
+ */
+class ResultsTable {
+public:
+    /**
+     * @brief Читает хранилище расположения. Отсутствующий файл — пустая таблица; чтение
+     * останавливается на первом повреждённом или недописанном блоке.
+     * @throws std::runtime_error если файл существует, но не читается.
+     */
+    static ResultsTable load(const std::string& location);
+
+    const std::vector<ResultsBlock>& blocks() const { return blocks_; }
+    size_t rows() const { return rows_; }
+    size_t liveRows() const { return liveRows_; }
+    /// @brief Размер проверенной части файла; дальше — повреждённый хвост.
+    uint64_t validSize() const { return validSize_; }
+
+    /// @brief Проекты, для которых в хранилище есть строки.
+    std::set<std::string> projects() const;
+
+    /// @brief Строка блока в виде ResultRecord.
+    ResultRecord record(const ResultsBlock& block, uint32_t row) const;
+
+private:
+    std::vector<uint64_t> buffer_;
+    std::vector<ResultsBlock> blocks_;
+    size_t rows_ = 0;
+    size_t liveRows_ = 0;
+    uint64_t validSize_ = 0;
+};
+
+/**
+ * @brief Дописывает итоги в хранилище расположения (создаёт его при первой записи) и при
+ * необходимости сжимает файл. Хранилище можно удалить в любой момент: его заново наполняют
+ * следующие компиляции и записи в базу данных.
+ * @throws std::runtime_error если файл не удалось записать.
+ */
+void appendResults(const std::string& location, const std::vector<ResultRecord>& records);
+
+} // namespace noc
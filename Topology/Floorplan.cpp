@@ -0,0 +1,151 @@
+#include "Floorplan.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+
+namespace noc {
+
+Floorplan planFloorplan(const Graph& graph, const FloorplanOptions& options) {
+    Floorplan plan;
+    const uint32_t nodes = graph.nodeCount();
+    if (nodes == 0) return plan;
+
+    int32_t minX = std::numeric_limits<int32_t>::max(), maxX = std::numeric_limits<int32_t>::min();
+    int32_t minY = minX, maxY = maxX;
+    for (uint32_t u = 0; u < nodes; ++u) {
+        minX = std::min(minX, graph.nodes.x[u]);
+        maxX = std::max(maxX, graph.nodes.x[u]);
+        minY = std::min(minY, graph.nodes.y[u]);
+        maxY = std::max(maxY, graph.nodes.y[u]);
+    }
+    const uint64_t spanX = uint64_t(int64_t(maxX) - minX) + 1, spanY = uint64_t(int64_t(maxY) - minY) + 1;
+
+    // Плитка по возможности квадратная; у вытянутых топологий (кольцо, fat-tree с малым числом уровней)
+    // она занимает всю высоту и добирает число маршрутизаторов по ширине.
+    uint64_t perRegion = std::max<uint32_t>(options.routersPerRegion, 1);
+    uint64_t tileW = 1, tileH = 1;
+    plan.partitioned = nodes <= options.maxPartitions;
+    plan.grouped = !plan.partitioned && options.maxPartitions != 0;
+    for (;;) {
+        const uint64_t side = static_cast<uint64_t>(std::ceil(std::sqrt(double(perRegion))));
+        tileH = std::min(side, spanY);
+        tileW = std::min((perRegion + tileH - 1) / tileH, spanX);
+        const uint64_t tiles = ((spanX + tileW - 1) / tileW) * ((spanY + tileH - 1) / tileH);
+        // С разделами по областям число областей ограничено так же, как число разделов.
+        if (!plan.grouped || tiles <= options.maxPartitions) break;
+        perRegion += std::max<uint64_t>(perRegion / 4, 1);
+    }
+    plan.tilesX = static_cast<uint32_t>((spanX + tileW - 1) / tileW);
+    plan.tilesY = static_cast<uint32_t>((spanY + tileH - 1) / tileH);
+
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> tiles; // (ty, tx) -> маршрутизаторы.
+    for (uint32_t u = 0; u < nodes; ++u) {
+        uint32_t tx = static_cast<uint32_t>((int64_t(graph.nodes.x[u]) - minX) / tileW);
+        uint32_t ty = static_cast<uint32_t>((int64_t(graph.nodes.y[u]) - minY) / tileH);
+        tiles[{ty, tx}].push_back(u);
+    }
+
+    // Если плиток больше, чем столбцов или строк LAB, закреплённые области не помещаются на кристалл.
+    const bool locked = options.deviceColumns >= plan.tilesX && options.deviceRows >= plan.tilesY
+        && options.deviceColumns != 0 && options.deviceRows != 0;
+    const uint32_t columnWidth = locked ? std::max<uint32_t>(options.deviceColumns / plan.tilesX, 1) : 0;
+    const uint32_t rowHeight = locked ? std::max<uint32_t>(options.deviceRows / plan.tilesY, 1) : 0;
+    for (auto& [tile, routers] : tiles) {
+        FloorplanRegion region;
+        region.tileX = tile.second;
+        region.tileY = tile.first;
+        region.name = "noc_region_" + std::to_string(region.tileX) + "_" + std::to_string(region.tileY);
+        region.routers = std::move(routers);
+        if (locked) {
+            // Координаты LAB начинаются с 1; плитки раскладываются по кристаллу в том же порядке, что и в сети.
+            region.originX = 1 + region.tileX * columnWidth;
+            region.originY = 1 + region.tileY * rowHeight;
+            region.width = columnWidth;
+            region.height = rowHeight;
+        }
+        plan.regions.push_back(std::move(region));
+    }
+    return plan;
+}
+
+std::vector<VerilogGroup> verilogGroups(const Floorplan& plan) {
+    std::vector<VerilogGroup> groups;
+    if (!plan.grouped) return groups;
+    groups.reserve(plan.regions.size());
+    for (const FloorplanRegion& region : plan.regions) {
+        const std::string tile = std::to_string(region.tileX) + "_" + std::to_string(region.tileY);
+        groups.push_back({"noc_region_" + tile, "region_" + tile, region.routers});
+    }
+    return groups;
+}
+
+uint64_t partitionCount(const Graph& graph, const Floorplan& plan) {
+    return plan.partitioned ? graph.nodeCount() : plan.grouped ? plan.regions.size() : 0;
+}
+
+std::string partitionName(uint32_t u) {
+    return "noc_r" + std::to_string(u);
+}
+
+void writeFloorplanQsf(const Graph& graph, const Floorplan& plan, const FloorplanOptions& options, std::ostream& out) {
+    out << "# Разделы и области размещения сети " << topologyName(graph.params.kind) << ". Областей: "
+        << plan.regions.size() << " (" << plan.tilesX << "x" << plan.tilesY << "), разделов: "
+        << partitionCount(graph, plan) << (plan.grouped ? " (по областям)" : "") << ".\n\n";
+
+    const std::vector<VerilogGroup> groups = verilogGroups(plan);
+    out << "set_global_assignment -name PARTITION_NETLIST_TYPE SOURCE -section_id Top\n"
+        << "set_instance_assignment -name PARTITION_HIERARCHY root_partition -to | -section_id Top\n";
+    for (size_t r = 0; r < groups.size(); ++r) {
+        const std::string name = "noc_p" + std::to_string(plan.regions[r].tileX) + "_" + std::to_string(plan.regions[r].tileY);
+        out << "set_global_assignment -name PARTITION_NETLIST_TYPE SOURCE -section_id " << name << "\n"
+            << "set_global_assignment -name PARTITION_FITTER_PRESERVATION_LEVEL PLACEMENT_AND_ROUTING -section_id " << name << "\n"
+            << "set_instance_assignment -name PARTITION_HIERARCHY " << name << " -to \""
+            << groupInstancePath(groups[r]) << "\" -section_id " << name << "\n";
+    }
+    if (plan.partitioned) {
+        for (uint32_t u = 0; u < graph.nodeCount(); ++u) {
+            const std::string name = partitionName(u);
+            out << "set_global_assignment -name PARTITION_NETLIST_TYPE SOURCE -section_id " << name << "\n"
+                << "set_global_assignment -name PARTITION_FITTER_PRESERVATION_LEVEL PLACEMENT_AND_ROUTING -section_id " << name << "\n"
+                << "set_instance_assignment -name PARTITION_HIERARCHY " << name << " -to \""
+                << routerInstancePath(graph, options.style, u) << "\" -section_id " << name << "\n";
+        }
+    }
+    out << "\n";
+
+    for (size_t r = 0; r < plan.regions.size(); ++r) {
+        const FloorplanRegion& region = plan.regions[r];
+        const std::string& id = region.name;
+        out << "set_global_assignment -name LL_ENABLED ON -section_id " << id << "\n"
+            << "set_global_assignment -name LL_RESERVED OFF -section_id " << id << "\n";
+        if (region.width != 0) {
+            out << "set_global_assignment -name LL_AUTO_SIZE OFF -section_id " << id << "\n"
+                << "set_global_assignment -name LL_STATE LOCKED -section_id " << id << "\n"
+                << "set_global_assignment -name LL_ORIGIN X" << region.originX << "_Y" << region.originY << " -section_id " << id << "\n"
+                << "set_global_assignment -name LL_WIDTH " << region.width << " -section_id " << id << "\n"
+                << "set_global_assignment -name LL_HEIGHT " << region.height << " -section_id " << id << "\n";
+        }
+        else {
+            out << "set_global_assignment -name LL_AUTO_SIZE ON -section_id " << id << "\n"
+                << "set_global_assignment -name LL_STATE FLOATING -section_id " << id << "\n";
+        }
+        // Модуль области целиком входит в область размещения.
+        if (!groups.empty()) {
+            out << "set_instance_assignment -name LL_MEMBER_OF " << id << " -to \"" << groupInstancePath(groups[r])
+                << "\" -section_id " << id << "\n\n";
+            continue;
+        }
+        for (uint32_t u : region.routers) {
+            out << "set_instance_assignment -name LL_MEMBER_OF " << id << " -to \""
+                << routerInstancePath(graph, options.style, u) << "\" -section_id " << id << "\n";
+            for (uint64_t i = 0; i < graph.degree(u); ++i)
+                out << "set_instance_assignment -name LL_MEMBER_OF " << id << " -to \""
+                    << linkInstancePath(graph, options.style, u, i) << "\" -section_id " << id << "\n";
+        }
+        out << "\n";
+    }
+}
+
+} // namespace noc
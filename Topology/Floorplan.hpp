@@ -0,0 +1,92 @@
+#pragma once
+/**
+ * @file Floorplan.hpp
+ * @brief Разбиение сети на проектные разделы (design partitions) и области размещения (LogicLock).
+ *
+ * Маршрутизаторы группируются в прямоугольные плитки по координатам узлов (`x`, `y`):
+ * каждая плитка становится областью размещения, в которую входят её маршрутизаторы
+ * и их исходящие звенья. Соседние в сети маршрутизаторы попадают в одну или соседние
+ * области, поэтому фиттер не тянет связи через весь кристалл.
+ *
+ * Каждый экземпляр маршрутизатора дополнительно выделяется в отдельный раздел —
+ * это основа инкрементальной перекомпиляции: неизменённые разделы берутся из
+ * предыдущей компиляции. Если маршрутизаторов больше FloorplanOptions::maxPartitions,
+ * раздел создаётся на каждую область: её маршрутизаторы и звенья оборачиваются в модуль
+ * области (VerilogOptions::groups, см. verilogGroups), а области укрупняются так, чтобы
+ * их было не больше maxPartitions.
+ *
+ * Результат — фрагмент настроек проекта Quartus (`noc_floorplan.qsf`) в каталоге
+ * `<имя>_NoC_description`, который включается в генерируемый файл `.qsf`.
+ */
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Topology.hpp"
+#include "VerilogEmitter.hpp"
+
+namespace noc {
+
+/**
+ * @brief Параметры разбиения.
+ */
+struct FloorplanOptions {
+    VerilogStyle style = VerilogStyle::PerNode; ///< Стиль Verilog: от него зависят пути экземпляров.
+    uint32_t routersPerRegion = 16;             ///< Желаемое число маршрутизаторов в области.
+    uint32_t maxPartitions = 256;               ///< При большем числе маршрутизаторов разделы создаются по областям.
+    /// Размер сетки LAB кристалла (столбцы и строки). Если не задан или меньше сетки плиток,
+    /// области плавающие: фиттер сам выбирает их положение и размер, сохраняя только состав.
+    uint32_t deviceColumns = 0;
+    uint32_t deviceRows = 0;
+};
+
+/**
+ * @brief Область размещения.
+ */
+struct FloorplanRegion {
+    std::string name;
+    uint32_t tileX = 0, tileY = 0;  ///< Положение плитки в сетке плиток.
+    std::vector<uint32_t> routers;  ///< Маршрутизаторы области по возрастанию номера.
+    uint32_t originX = 0, originY = 0, width = 0, height = 0; ///< Прямоугольник на кристалле; 0 — плавающая область.
+};
+
+/**
+ * @brief Результат разбиения.
+ */
+struct Floorplan {
+    uint32_t tilesX = 0, tilesY = 0;
+    std::vector<FloorplanRegion> regions;  ///< Непустые области в порядке (tileY, tileX).
+    bool partitioned = false;              ///< Созданы ли разделы по маршрутизаторам.
+    bool grouped = false;                  ///< Созданы ли разделы по областям (Verilog с группами verilogGroups).
+};
+
+/**
+ * @brief Строит разбиение по координатам узлов.
+ */
+Floorplan planFloorplan(const Graph& graph, const FloorplanOptions& options);
+
+/**
+ * @brief Группы Verilog для разбиения с разделами по областям (по одной на область, в порядке
+ * Floorplan::regions); пусто, если разделы по областям не создаются.
+ *
+ * Описание сети должно генерироваться с этими группами до записи `.qsf`: пути экземпляров зависят от них.
+ */
+std::vector<VerilogGroup> verilogGroups(const Floorplan& plan);
+
+/**
+ * @brief Число проектных разделов разбиения (без корневого).
+ */
+uint64_t partitionCount(const Graph& graph, const Floorplan& plan);
+
+/**
+ * @brief Имя раздела маршрутизатора `u`.
+ */
+std::string partitionName(uint32_t u);
+
+/**
+ * @brief Записывает назначения разделов и областей в формате `.qsf`.
+ */
+void writeFloorplanQsf(const Graph& graph, const Floorplan& plan, const FloorplanOptions& options, std::ostream& out);
+
+} // namespace noc
@@ -0,0 +1,259 @@
+#include "GraphBinary.hpp"
+
+#include <bit>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace noc {
+
+namespace {
+
+constexpr char graphBinaryMagic[8] = {'N', 'O', 'C', 'G', 'R', 'A', 'P', 'H'};
+constexpr uint32_t graphBinaryVersion = 1;
+
+static_assert(std::endian::native == std::endian::little, "Binary graph format is little-endian");
+static_assert(sizeof(GraphBinaryHeader) % 8 == 0);
+
+uint64_t align8(uint64_t value) {
+    return (value + 7) & ~uint64_t(7);
+}
+
+/**
+ * @brief Файл, отображённый в память только для чтения.
+ *
+ * Если отображение недоступно (другая платформа), файл читается в буфер целиком.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file_ == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("Failed to open " + path);
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file_, &size)) {
+            CloseHandle(file_);
+            throw std::runtime_error("Failed to stat " + path);
+        }
+        size_ = static_cast<size_t>(size.QuadPart);
+        if (size_ != 0) {
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping_ != nullptr)
+                data_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+            if (data_ == nullptr) {
+                if (mapping_ != nullptr) CloseHandle(mapping_);
+                CloseHandle(file_);
+                throw std::runtime_error("Failed to map " + path);
+            }
+        }
+#elif defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            throw std::runtime_error("Failed to open " + path);
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to stat " + path);
+        }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ != 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+            if (data == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("Failed to map " + path);
+            }
+            data_ = data;
+        }
+        // Отображение остаётся действительным и после закрытия дескриптора.
+        ::close(fd);
+#else
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            throw std::runtime_error("Failed to open " + path);
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        size_ = buffer_.size();
+        data_ = buffer_.data();
+#endif
+    }
+
+    ~MappedFile() {
+#if defined(_WIN32)
+        if (data_ != nullptr) UnmapViewOfFile(data_);
+        if (mapping_ != nullptr) CloseHandle(mapping_);
+        CloseHandle(file_);
+#elif defined(__unix__) || defined(__APPLE__)
+        if (data_ != nullptr) munmap(const_cast<void*>(data_), size_);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return static_cast<const char*>(data_); }
+    size_t size() const { return size_; }
+
+private:
+    const void* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = nullptr;
+#elif !defined(__unix__) && !defined(__APPLE__)
+    std::vector<char> buffer_;
+#endif
+};
+
+template <class T>
+void writeArray(std::ostream& out, uint64_t& position, uint64_t offset, const T* data, uint64_t count) {
+    static const char zeros[8] = {};
+    out.write(zeros, static_cast<std::streamsize>(offset - position));
+    out.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    position = offset + count * sizeof(T);
+}
+
+} // namespace
+
+void writeGraphBinary(const Graph& graph, std::ostream& out) {
+    const uint64_t nodes = graph.nodeCount(), edges = graph.edgeCount();
+
+    // Таблица строк: имя топологии, затем ключи параметров.
+    std::string strings = std::string(topologyName(graph.params.kind)) + '\0';
+    std::vector<GraphBinaryParam> params;
+    for (const auto& [key, value] : graph.params.values()) {
+        params.push_back({static_cast<uint32_t>(strings.size()), value});
+        strings += key + '\0';
+    }
+
+    GraphBinaryHeader header{};
+    std::memcpy(header.magic, graphBinaryMagic, sizeof(header.magic));
+    header.version = graphBinaryVersion;
+    header.headerSize = sizeof(GraphBinaryHeader);
+    header.nodeCount = nodes;
+    header.edgeCount = edges;
+    header.topology = 0;
+    header.paramCount = static_cast<uint32_t>(params.size());
+    header.offsets = sizeof(GraphBinaryHeader);
+    header.targets = align8(header.offsets + (nodes + 1) * sizeof(uint64_t));
+    header.nodeX = align8(header.targets + edges * sizeof(uint32_t));
+    header.nodeY = align8(header.nodeX + nodes * sizeof(int32_t));
+    header.ports = align8(header.nodeY + nodes * sizeof(int32_t));
+    header.nodeRadix = align8(header.ports + edges);
+    header.params = align8(header.nodeRadix + nodes);
+    header.strings = align8(header.params + params.size() * sizeof(GraphBinaryParam));
+    header.stringsSize = strings.size();
+    header.fileSize = header.strings + strings.size();
+
+    // У пустого графа нет массива offsets; в файле он всё равно состоит из одного нуля.
+    const uint64_t emptyOffsets = 0;
+    uint64_t position = 0;
+    writeArray(out, position, 0, &header, 1);
+    writeArray(out, position, header.offsets, graph.offsets.empty() ? &emptyOffsets : graph.offsets.data(), nodes + 1);
+    writeArray(out, position, header.targets, graph.targets.data(), edges);
+    writeArray(out, position, header.nodeX, graph.nodes.x.data(), nodes);
+    writeArray(out, position, header.nodeY, graph.nodes.y.data(), nodes);
+    writeArray(out, position, header.ports, graph.ports.data(), edges);
+    writeArray(out, position, header.nodeRadix, graph.nodes.radix.data(), nodes);
+    writeArray(out, position, header.params, params.data(), params.size());
+    writeArray(out, position, header.strings, strings.data(), strings.size());
+    out.flush();
+    if (!out)
+        throw std::runtime_error("Failed to write the binary graph");
+}
+
+GraphView GraphView::open(const std::string& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    auto fail = [&](const std::string& message) {
+        throw std::runtime_error("Invalid binary graph " + path + ": " + message);
+    };
+    if (file->size() < sizeof(GraphBinaryHeader))
+        fail("file is too short");
+
+    GraphView view;
+    view.base_ = file->data();
+    view.header_ = reinterpret_cast<const GraphBinaryHeader*>(view.base_);
+    const GraphBinaryHeader& h = *view.header_;
+    if (std::memcmp(h.magic, graphBinaryMagic, sizeof(h.magic)) != 0)
+        fail("bad magic");
+    if (h.version != graphBinaryVersion || h.headerSize != sizeof(GraphBinaryHeader))
+        fail("unsupported version");
+    if (h.fileSize != file->size())
+        fail("size mismatch");
+    if (h.nodeCount > UINT32_MAX || h.edgeCount > file->size())
+        fail("bad counts");
+
+    // Каждая секция выровнена под свой тип и целиком лежит внутри файла.
+    auto section = [&](uint64_t offset, uint64_t count, uint64_t elementSize) {
+        if (offset % 8 != 0 || offset < sizeof(GraphBinaryHeader) || offset > file->size()
+            || count > (file->size() - offset) / elementSize)
+            fail("section out of bounds");
+        return view.base_ + offset;
+    };
+    view.offsets_ = reinterpret_cast<const uint64_t*>(section(h.offsets, h.nodeCount + 1, sizeof(uint64_t)));
+    view.targets_ = reinterpret_cast<const uint32_t*>(section(h.targets, h.edgeCount, sizeof(uint32_t)));
+    view.x_ = reinterpret_cast<const int32_t*>(section(h.nodeX, h.nodeCount, sizeof(int32_t)));
+    view.y_ = reinterpret_cast<const int32_t*>(section(h.nodeY, h.nodeCount, sizeof(int32_t)));
+    view.ports_ = reinterpret_cast<const uint8_t*>(section(h.ports, h.edgeCount, 1));
+    view.radix_ = reinterpret_cast<const uint8_t*>(section(h.nodeRadix, h.nodeCount, 1));
+    section(h.params, h.paramCount, sizeof(GraphBinaryParam));
+    section(h.strings, h.stringsSize, 1);
+    if (h.stringsSize == 0 || view.base_[h.strings + h.stringsSize - 1] != '\0')
+        fail("string table is not terminated");
+    if (h.topology >= h.stringsSize)
+        fail("bad topology name");
+    const auto* params = reinterpret_cast<const GraphBinaryParam*>(view.base_ + h.params);
+    for (uint32_t i = 0; i < h.paramCount; ++i)
+        if (params[i].key >= h.stringsSize)
+            fail("bad parameter name");
+    if (view.offsets_[0] != 0 || view.offsets_[h.nodeCount] != h.edgeCount)
+        fail("offsets do not cover the edges");
+
+    view.mapping_ = std::move(file);
+    return view;
+}
+
+std::string_view GraphView::topology() const {
+    return base_ + header_->strings + header_->topology;
+}
+
+TopologyParams GraphView::params() const {
+    std::string text = "topology=" + std::string(topology());
+    const auto* params = reinterpret_cast<const GraphBinaryParam*>(base_ + header_->params);
+    for (uint32_t i = 0; i < header_->paramCount; ++i)
+        text += " " + std::string(base_ + header_->strings + params[i].key) + "=" + std::to_string(params[i].value);
+    return TopologyParams::parse(text);
+}
+
+void GraphView::verify() const {
+    for (uint64_t u = 0; u < header_->nodeCount; ++u)
+        if (offsets_[u] > offsets_[u + 1])
+            throw std::runtime_error("Binary graph offsets are not monotonic");
+    for (uint64_t e = 0; e < header_->edgeCount; ++e)
+        if (targets_[e] >= header_->nodeCount)
+            throw std::runtime_error("Binary graph edge references a missing node");
+}
+
+Graph GraphView::toGraph() const {
+    Graph graph;
+    graph.params = params();
+    graph.offsets.assign(offsets().begin(), offsets().end());
+    graph.targets.assign(targets().begin(), targets().end());
+    graph.ports.assign(ports().begin(), ports().end());
+    graph.nodes.x.assign(x().begin(), x().end());
+    graph.nodes.y.assign(y().begin(), y().end());
+    graph.nodes.radix.assign(radix().begin(), radix().end());
+    return graph;
+}
+
+} // namespace noc
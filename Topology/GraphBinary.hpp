@@ -0,0 +1,124 @@
+#pragma once
+/**
+ * @file GraphBinary.hpp
+ * @brief Двоичный формат графа `<имя>_graph_object.bin`, пригодный для отображения в память.
+ *
+ * Файл записывается рядом с `_graph_object_serialized.json` и содержит тот же граф
+ * в виде готовых массивов CSR, поэтому потребители отображают его в память и работают
+ * с массивами на месте, без разбора текста и копирования.
+ *
+ * Раскладка (little-endian, каждая секция выровнена на 8 байт):
+ * - GraphBinaryHeader;
+ * - `offsets`   — `uint64_t[nodeCount + 1]`;
+ * - `targets`   — `uint32_t[edgeCount]`;
+ * - `nodeX`, `nodeY` — `int32_t[nodeCount]`;
+ * - `ports`     — `uint8_t[edgeCount]`;
+ * - `nodeRadix` — `uint8_t[nodeCount]`;
+ * - `params`    — `GraphBinaryParam[paramCount]`;
+ * - таблица строк — строки, завершённые нулём; на них ссылаются имя топологии и ключи параметров.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+#include "Topology.hpp"
+
+namespace noc {
+
+/**
+ * @brief Заголовок двоичного файла графа. Смещения секций отсчитываются от начала файла.
+ */
+struct GraphBinaryHeader {
+    char magic[8];         ///< "NOCGRAPH".
+    uint32_t version;      ///< Версия формата (1).
+    uint32_t headerSize;   ///< sizeof(GraphBinaryHeader).
+    uint64_t fileSize;
+    uint64_t nodeCount;
+    uint64_t edgeCount;
+    uint32_t topology;     ///< Смещение имени топологии в таблице строк.
+    uint32_t paramCount;
+    uint64_t offsets;
+    uint64_t targets;
+    uint64_t ports;
+    uint64_t nodeX;
+    uint64_t nodeY;
+    uint64_t nodeRadix;
+    uint64_t params;
+    uint64_t strings;
+    uint64_t stringsSize;
+};
+
+/**
+ * @brief Параметр топологии: ключ — смещение в таблице строк.
+ */
+struct GraphBinaryParam {
+    uint32_t key;
+    uint32_t value;
+};
+
+/**
+ * @brief Записывает граф в двоичном формате.
+ * @throws std::runtime_error если поток в ошибке.
+ */
+void writeGraphBinary(const Graph& graph, std::ostream& out);
+
+/**
+ * @brief Граф, отображённый из двоичного файла.
+ *
+ * Массивы указывают прямо в отображённую память и действительны, пока жив
+ * хотя бы один экземпляр GraphView (копии разделяют одно отображение).
+ * На Linux файл отображается через `mmap`, на Windows — через `MapViewOfFile`.
+ */
+class GraphView {
+public:
+    /**
+     * @brief Отображает файл и проверяет заголовок и границы секций (за O(1)).
+     * @throws std::runtime_error если файл не открывается или повреждён.
+     */
+    static GraphView open(const std::string& path);
+
+    uint32_t nodeCount() const { return static_cast<uint32_t>(header_->nodeCount); }
+    uint64_t edgeCount() const { return header_->edgeCount; }
+    uint64_t degree(uint32_t node) const { return offsets_[node + 1] - offsets_[node]; }
+
+    std::span<const uint64_t> offsets() const { return {offsets_, header_->nodeCount + 1}; }
+    std::span<const uint32_t> targets() const { return {targets_, header_->edgeCount}; }
+    std::span<const uint8_t> ports() const { return {ports_, header_->edgeCount}; }
+    std::span<const int32_t> x() const { return {x_, header_->nodeCount}; }
+    std::span<const int32_t> y() const { return {y_, header_->nodeCount}; }
+    std::span<const uint8_t> radix() const { return {radix_, header_->nodeCount}; }
+
+    std::string_view topology() const;
+    TopologyParams params() const;
+
+    /**
+     * @brief Проверяет содержимое массивов: монотонность `offsets` и номера узлов в `targets`.
+     *
+     * Проход линейный, поэтому выполняется только по запросу (например, конвертером),
+     * а не при каждом открытии.
+     *
+     * @throws std::runtime_error при нарушении.
+     */
+    void verify() const;
+
+    /**
+     * @brief Копирует граф в обычные векторы.
+     */
+    Graph toGraph() const;
+
+private:
+    std::shared_ptr<const void> mapping_;
+    const char* base_ = nullptr;
+    const GraphBinaryHeader* header_ = nullptr;
+    const uint64_t* offsets_ = nullptr;
+    const uint32_t* targets_ = nullptr;
+    const uint8_t* ports_ = nullptr;
+    const int32_t* x_ = nullptr;
+    const int32_t* y_ = nullptr;
+    const uint8_t* radix_ = nullptr;
+};
+
+} // namespace noc
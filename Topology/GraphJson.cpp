@@ -0,0 +1,505 @@
+#include "GraphJson.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace noc {
+
+namespace {
+
+/// Размер буфера писателя, после которого данные сбрасываются в поток.
+constexpr size_t writeBufferSize = 1 << 20;
+/// Размер порции, которой читатель заполняет буфер.
+constexpr size_t readBufferSize = 1 << 16;
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    }
+    else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+    else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// GraphJsonWriter
+
+GraphJsonWriter::GraphJsonWriter(std::ostream& out, const GraphHeader& header)
+    : out_(out), expectedNodes_(header.nodeCount), expectedEdges_(header.edgeCount) {
+    buffer_.reserve(writeBufferSize + 256);
+    buffer_ += "{\"format\":";
+    appendString(header.format.empty() ? "noc-graph" : header.format);
+    buffer_ += ",\"version\":";
+    appendNumber(header.version == 0 ? 1 : header.version);
+    buffer_ += ",\"topology\":";
+    appendString(header.topology);
+    buffer_ += ",\"params\":{";
+    bool first = true;
+    for (const auto& [key, value] : header.params) {
+        if (!first) buffer_ += ',';
+        first = false;
+        appendString(key);
+        buffer_ += ':';
+        appendNumber(value);
+    }
+    buffer_ += "},\"nodeCount\":";
+    appendNumber(static_cast<int64_t>(header.nodeCount));
+    buffer_ += ",\"edgeCount\":";
+    appendNumber(static_cast<int64_t>(header.edgeCount));
+    buffer_ += ",\"nodes\":[";
+}
+
+void GraphJsonWriter::appendNumber(int64_t value) {
+    char text[24];
+    auto result = std::to_chars(text, text + sizeof(text), value);
+    buffer_.append(text, result.ptr);
+}
+
+void GraphJsonWriter::appendString(const std::string& value) {
+    buffer_ += '"';
+    for (char c : value) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            buffer_ += '\\';
+            buffer_ += c;
+        }
+        else if (u < 0x20) {
+            char escape[8];
+            std::snprintf(escape, sizeof(escape), "\\u%04x", u);
+            buffer_ += escape;
+        }
+        else {
+            buffer_ += c;
+        }
+    }
+    buffer_ += '"';
+}
+
+void GraphJsonWriter::flushIfFull() {
+    if (buffer_.size() >= writeBufferSize) {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        buffer_.clear();
+    }
+}
+
+void GraphJsonWriter::node(const GraphNodeRecord& node) {
+    if (edges_ != 0)
+        throw std::logic_error("Graph nodes must be written before edges");
+    buffer_ += nodes_++ == 0 ? "{\"id\":" : ",{\"id\":";
+    appendNumber(node.id);
+    buffer_ += ",\"x\":";
+    appendNumber(node.x);
+    buffer_ += ",\"y\":";
+    appendNumber(node.y);
+    buffer_ += ",\"radix\":";
+    appendNumber(node.radix);
+    buffer_ += '}';
+    flushIfFull();
+}
+
+void GraphJsonWriter::edge(const GraphEdgeRecord& edge) {
+    buffer_ += edges_++ == 0 ? "],\"edges\":[{\"src\":" : ",{\"src\":";
+    appendNumber(edge.src);
+    buffer_ += ",\"dst\":";
+    appendNumber(edge.dst);
+    buffer_ += ",\"port\":";
+    appendNumber(edge.port);
+    buffer_ += '}';
+    flushIfFull();
+}
+
+void GraphJsonWriter::finish() {
+    if (nodes_ != expectedNodes_ || edges_ != expectedEdges_)
+        throw std::runtime_error("Graph record count does not match the header");
+    buffer_ += edges_ == 0 ? "],\"edges\":[]}" : "]}";
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+    out_.flush();
+    if (!out_)
+        throw std::runtime_error("Failed to write the graph");
+}
+
+void writeGraphJson(const Graph& graph, std::ostream& out) {
+    GraphHeader header;
+    header.topology = topologyName(graph.params.kind);
+    for (const auto& [key, value] : graph.params.values())
+        header.params[key] = value;
+    header.nodeCount = graph.nodeCount();
+    header.edgeCount = graph.edgeCount();
+
+    GraphJsonWriter writer(out, header);
+    for (uint32_t u = 0; u < graph.nodeCount(); ++u)
+        writer.node({u, graph.nodes.x[u], graph.nodes.y[u], graph.nodes.radix[u]});
+    for (uint32_t u = 0; u < graph.nodeCount(); ++u) {
+        for (uint64_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e)
+            writer.edge({u, graph.targets[e], graph.ports[e]});
+    }
+    writer.finish();
+}
+
+Graph readGraphJson(std::istream& in) {
+    GraphJsonReader reader(in);
+    Graph graph;
+    std::vector<GraphEdgeRecord> edges;
+    for (GraphEvent event; (event = reader.next()) != GraphEvent::End;) {
+        if (event == GraphEvent::Edge) {
+            if (edges.empty() && reader.header().edgeCount != 0)
+                edges.reserve(reader.header().edgeCount);
+            edges.push_back(reader.edge());
+            continue;
+        }
+        const GraphNodeRecord& node = reader.node();
+        if (node.id >= graph.nodes.x.size()) {
+            size_t size = std::max<size_t>(node.id + 1, reader.header().nodeCount);
+            graph.nodes.x.resize(size);
+            graph.nodes.y.resize(size);
+            graph.nodes.radix.resize(size);
+        }
+        graph.nodes.x[node.id] = node.x;
+        graph.nodes.y[node.id] = node.y;
+        graph.nodes.radix[node.id] = static_cast<uint8_t>(node.radix);
+    }
+
+    const GraphHeader& header = reader.header();
+    std::string params = "topology=" + header.topology;
+    for (const auto& [key, value] : header.params)
+        params += " " + key + "=" + std::to_string(value);
+    graph.params = TopologyParams::parse(params);
+
+    const uint64_t nodes = graph.nodes.x.size();
+    if (nodes != header.nodeCount || edges.size() != header.edgeCount)
+        throw std::runtime_error("Graph record count does not match the header");
+    graph.offsets.assign(nodes + 1, 0);
+    for (const GraphEdgeRecord& edge : edges) {
+        if (edge.src >= nodes || edge.dst >= nodes)
+            throw std::runtime_error("Graph edge references a missing node");
+        ++graph.offsets[edge.src + 1];
+    }
+    for (uint64_t u = 0; u < nodes; ++u)
+        graph.offsets[u + 1] += graph.offsets[u];
+    graph.targets.resize(edges.size());
+    graph.ports.resize(edges.size());
+    std::vector<uint64_t> cursor(graph.offsets.begin(), graph.offsets.end() - 1);
+    for (const GraphEdgeRecord& edge : edges) {
+        uint64_t e = cursor[edge.src]++;
+        graph.targets[e] = edge.dst;
+        graph.ports[e] = static_cast<uint8_t>(edge.port);
+    }
+    return graph;
+}
+
+// ---------------------------------------------------------------------------
+// GraphJsonReader
+
+GraphJsonReader::GraphJsonReader(std::istream& in) : in_(in), buffer_(readBufferSize) {}
+
+void GraphJsonReader::fail(const std::string& message) const {
+    throw std::runtime_error("Graph JSON error at byte " + std::to_string(consumed_ + pos_) + ": " + message);
+}
+
+int GraphJsonReader::peek() {
+    if (pos_ == size_) {
+        consumed_ += size_;
+        in_.read(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        size_ = static_cast<size_t>(in_.gcount());
+        pos_ = 0;
+        if (size_ == 0) return -1;
+    }
+    return static_cast<unsigned char>(buffer_[pos_]);
+}
+
+int GraphJsonReader::get() {
+    int c = peek();
+    if (c >= 0) ++pos_;
+    return c;
+}
+
+void GraphJsonReader::skipWhitespace() {
+    for (int c = peek(); c == ' ' || c == '\n' || c == '\r' || c == '\t'; c = peek())
+        ++pos_;
+}
+
+void GraphJsonReader::expect(char c) {
+    skipWhitespace();
+    if (get() != c) fail(std::string("expected '") + c + "'");
+}
+
+std::string GraphJsonReader::parseString() {
+    expect('"');
+    std::string value;
+    for (;;) {
+        int c = get();
+        if (c < 0) fail("unterminated string");
+        if (c == '"') return value;
+        if (c != '\\') {
+            value += static_cast<char>(c);
+            continue;
+        }
+        c = get();
+        switch (c) {
+        case '"': value += '"'; break;
+        case '\\': value += '\\'; break;
+        case '/': value += '/'; break;
+        case 'b': value += '\b'; break;
+        case 'f': value += '\f'; break;
+        case 'n': value += '\n'; break;
+        case 'r': value += '\r'; break;
+        case 't': value += '\t'; break;
+        case 'u': {
+            auto hex4 = [&]() {
+                uint32_t cp = 0;
+                for (int i = 0; i < 4; ++i) {
+                    int h = get();
+                    cp <<= 4;
+                    if (h >= '0' && h <= '9') cp |= h - '0';
+                    else if (h >= 'a' && h <= 'f') cp |= h - 'a' + 10;
+                    else if (h >= 'A' && h <= 'F') cp |= h - 'A' + 10;
+                    else fail("invalid \\u escape");
+                }
+                return cp;
+            };
+            uint32_t cp = hex4();
+            if (cp >= 0xD800 && cp < 0xDC00) {
+                if (get() != '\\' || get() != 'u') fail("invalid surrogate pair");
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (hex4() - 0xDC00);
+            }
+            appendUtf8(value, cp);
+            break;
+        }
+        default:
+            fail("invalid escape");
+        }
+    }
+}
+
+int64_t GraphJsonReader::parseNumber() {
+    skipWhitespace();
+    char text[64];
+    size_t length = 0;
+    for (int c = peek(); (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E'; c = peek()) {
+        if (length == sizeof(text) - 1) fail("number is too long");
+        text[length++] = static_cast<char>(c);
+        ++pos_;
+    }
+    if (length == 0) fail("expected a number");
+    int64_t value = 0;
+    auto result = std::from_chars(text, text + length, value);
+    if (result.ec == std::errc() && result.ptr == text + length) return value;
+    // Дробные значения и экспоненты в графе не используются, но допускаются.
+    text[length] = '\0';
+    return static_cast<int64_t>(std::strtod(text, nullptr));
+}
+
+void GraphJsonReader::skipValue(int depth) {
+    // Глубина ограничена, чтобы вложенные контейнеры во входных данных не переполнили стек.
+    if (depth > 256) fail("nesting is too deep");
+    skipWhitespace();
+    int c = peek();
+    if (c == '"') {
+        parseString();
+    }
+    else if (c == '{') {
+        ++pos_;
+        skipWhitespace();
+        if (peek() == '}') {
+            ++pos_;
+            return;
+        }
+        for (;;) {
+            parseString();
+            expect(':');
+            skipValue(depth + 1);
+            skipWhitespace();
+            int d = get();
+            if (d == '}') return;
+            if (d != ',') fail("expected ',' or '}'");
+        }
+    }
+    else if (c == '[') {
+        ++pos_;
+        skipWhitespace();
+        if (peek() == ']') {
+            ++pos_;
+            return;
+        }
+        for (;;) {
+            skipValue(depth + 1);
+            skipWhitespace();
+            int d = get();
+            if (d == ']') return;
+            if (d != ',') fail("expected ',' or ']'");
+        }
+    }
+    else if (c == 't' || c == 'f' || c == 'n') {
+        while ((c = peek()) >= 'a' && c <= 'z') ++pos_;
+    }
+    else {
+        parseNumber();
+    }
+}
+
+void GraphJsonReader::parseParams() {
+    expect('{');
+    skipWhitespace();
+    if (peek() == '}') {
+        ++pos_;
+        return;
+    }
+    for (;;) {
+        std::string key = parseString();
+        expect(':');
+        skipWhitespace();
+        int c = peek();
+        if ((c >= '0' && c <= '9') || c == '-') header_.params[key] = parseNumber();
+        else skipValue();
+        skipWhitespace();
+        int d = get();
+        if (d == '}') return;
+        if (d != ',') fail("expected ',' or '}'");
+    }
+}
+
+template <class Fn>
+void GraphJsonReader::parseRecord(Fn&& field) {
+    expect('{');
+    skipWhitespace();
+    if (peek() == '}') {
+        ++pos_;
+        return;
+    }
+    for (;;) {
+        std::string key = parseString();
+        expect(':');
+        if (!field(key)) skipValue();
+        skipWhitespace();
+        int c = get();
+        if (c == '}') return;
+        if (c != ',') fail("expected ',' or '}'");
+    }
+}
+
+GraphEvent GraphJsonReader::next() {
+    for (;;) {
+        switch (state_) {
+        case State::Start:
+            expect('{');
+            state_ = State::TopLevel;
+            first_ = true;
+            skipWhitespace();
+            if (peek() == '}') {
+                ++pos_;
+                state_ = State::Done;
+            }
+            break;
+
+        case State::Nodes:
+        case State::Edges: {
+            skipWhitespace();
+            int c = peek();
+            if (c == ']') {
+                ++pos_;
+                state_ = State::TopLevel;
+                first_ = false;
+                break;
+            }
+            // Элементы разделяются ровно одной запятой: пропущенная или лишняя запятая — ошибка формата.
+            if (!first_) {
+                if (c != ',') fail("expected ',' or ']'");
+                ++pos_;
+            }
+            first_ = false;
+            if (state_ == State::Nodes) {
+                node_ = GraphNodeRecord();
+                parseRecord([&](const std::string& key) {
+                    if (key == "id") node_.id = static_cast<uint32_t>(parseNumber());
+                    else if (key == "x") node_.x = static_cast<int32_t>(parseNumber());
+                    else if (key == "y") node_.y = static_cast<int32_t>(parseNumber());
+                    else if (key == "radix") node_.radix = static_cast<uint32_t>(parseNumber());
+                    else return false;
+                    return true;
+                });
+                return GraphEvent::Node;
+            }
+            edge_ = GraphEdgeRecord();
+            parseRecord([&](const std::string& key) {
+                if (key == "src") edge_.src = static_cast<uint32_t>(parseNumber());
+                else if (key == "dst") edge_.dst = static_cast<uint32_t>(parseNumber());
+                else if (key == "port") edge_.port = static_cast<uint32_t>(parseNumber());
+                else return false;
+                return true;
+            });
+            return GraphEvent::Edge;
+        }
+
+        case State::TopLevel: {
+            skipWhitespace();
+            int c = peek();
+            if (c == '}') {
+                ++pos_;
+                state_ = State::Done;
+                break;
+            }
+            if (!first_) {
+                if (c != ',') fail("expected ',' or '}'");
+                ++pos_;
+            }
+            first_ = false;
+            std::string key = parseString();
+            expect(':');
+            if (key == "nodes" || key == "edges") {
+                expect('[');
+                skipWhitespace();
+                if (peek() == ']') ++pos_;
+                else {
+                    state_ = key == "nodes" ? State::Nodes : State::Edges;
+                    first_ = true;
+                }
+            }
+            else if (key == "format") header_.format = parseString();
+            else if (key == "topology") header_.topology = parseString();
+            else if (key == "version") header_.version = parseNumber();
+            else if (key == "nodeCount") header_.nodeCount = static_cast<uint64_t>(parseNumber());
+            else if (key == "edgeCount") header_.edgeCount = static_cast<uint64_t>(parseNumber());
+            else if (key == "params") parseParams();
+            else skipValue();
+            break;
+        }
+
+        case State::Done:
+            return GraphEvent::End;
+        }
+    }
+}
+
+bool GraphJsonReader::nextEdge(GraphEdgeRecord& edge) {
+    for (;;) {
+        switch (next()) {
+        case GraphEvent::Edge:
+            edge = edge_;
+            return true;
+        case GraphEvent::Node:
+            continue;
+        case GraphEvent::End:
+            return false;
+        }
+    }
+}
+
+} // namespace noc
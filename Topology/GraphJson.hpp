@@ -0,0 +1,172 @@
+#pragma once
+/**
+ * @file GraphJson.hpp
+ * @brief Потоковая запись и чтение файла `<имя>_graph_object_serialized.json`.
+ *
+ * Формат файла:
+ * @code
+ * {
+ *   "format": "noc-graph", "version": 1,
+ *   "topology": "mesh", "params": {"Nx": 4, "Ny": 4},
+ *   "nodeCount": 16, "edgeCount": 48,
+ *   "nodes": [{"id": 0, "x": 0, "y": 0, "radix": 2}, ...],
+ *   "edges": [{"src": 0, "dst": 1, "port": 0}, ...]
+ * }
+ * @endcode
+ * Рёбра идут в порядке CSR: сгруппированы по источнику, внутри — по номеру порта.
+ *
+ * Ни запись, ни чтение не строят JSON-дерево: писатель выводит узлы и рёбра
+ * по одному через буфер фиксированного размера, читатель разбирает поток
+ * порциями и отдаёт записи по запросу, поэтому потребление памяти не зависит
+ * от размера графа.
+ */
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Topology.hpp"
+
+namespace noc {
+
+/**
+ * @brief Скалярные поля файла графа.
+ */
+struct GraphHeader {
+    std::string format;
+    int64_t version = 0;
+    std::string topology;
+    std::map<std::string, int64_t> params;
+    uint64_t nodeCount = 0;
+    uint64_t edgeCount = 0;
+};
+
+/**
+ * @brief Узел графа в том виде, в котором он хранится в файле.
+ */
+struct GraphNodeRecord {
+    uint32_t id = 0;
+    int32_t x = 0;
+    int32_t y = 0;
+    uint32_t radix = 0;
+};
+
+/**
+ * @brief Ребро графа в том виде, в котором оно хранится в файле.
+ */
+struct GraphEdgeRecord {
+    uint32_t src = 0;
+    uint32_t dst = 0;
+    uint32_t port = 0;
+};
+
+/**
+ * @brief Потоковый писатель файла графа.
+ *
+ * Порядок вызовов: конструктор (заголовок), `node()` для каждого узла, `edge()` для каждого ребра, `finish()`.
+ * Число узлов и рёбер задаётся заранее и проверяется в `finish()`.
+ */
+class GraphJsonWriter {
+public:
+    GraphJsonWriter(std::ostream& out, const GraphHeader& header);
+
+    void node(const GraphNodeRecord& node);
+    void edge(const GraphEdgeRecord& edge);
+
+    /**
+     * @brief Закрывает массивы и сбрасывает буфер.
+     * @throws std::runtime_error если число записей не совпало с заголовком или поток в ошибке.
+     */
+    void finish();
+
+private:
+    void flushIfFull();
+    void appendNumber(int64_t value);
+    void appendString(const std::string& value);
+
+    std::ostream& out_;
+    std::string buffer_;
+    uint64_t expectedNodes_, expectedEdges_;
+    uint64_t nodes_ = 0, edges_ = 0;
+};
+
+/**
+ * @brief Событие потокового читателя.
+ */
+enum class GraphEvent {
+    Node, ///< Прочитан узел, см. GraphJsonReader::node().
+    Edge, ///< Прочитано ребро, см. GraphJsonReader::edge().
+    End   ///< Файл прочитан полностью; заголовок заполнен.
+};
+
+/**
+ * @brief Потоковый (pull) читатель файла графа.
+ *
+ * Каждый вызов `next()` продвигается до следующего узла или ребра. Скалярные поля
+ * заголовка заполняются по мере того, как встречаются в файле: у файлов, записанных
+ * GraphJsonWriter, они идут до узлов, в остальных случаях заголовок полон после `End`.
+ * Неизвестные поля пропускаются без сохранения.
+ */
+class GraphJsonReader {
+public:
+    explicit GraphJsonReader(std::istream& in);
+
+    /**
+     * @throws std::runtime_error при синтаксической ошибке.
+     */
+    GraphEvent next();
+
+    /**
+     * @brief Переходит к следующему ребру, пропуская узлы.
+     * @return false, если рёбер больше нет.
+     */
+    bool nextEdge(GraphEdgeRecord& edge);
+
+    const GraphHeader& header() const { return header_; }
+    const GraphNodeRecord& node() const { return node_; }
+    const GraphEdgeRecord& edge() const { return edge_; }
+
+private:
+    enum class State { Start, TopLevel, Nodes, Edges, Done };
+
+    int peek();
+    int get();
+    void skipWhitespace();
+    void expect(char c);
+    std::string parseString();
+    int64_t parseNumber();
+    void skipValue(int depth = 0);
+    void parseParams();
+    template <class Fn> void parseRecord(Fn&& field);
+    [[noreturn]] void fail(const std::string& message) const;
+
+    std::istream& in_;
+    std::vector<char> buffer_;
+    size_t pos_ = 0, size_ = 0;
+    uint64_t consumed_ = 0;
+    State state_ = State::Start;
+    bool first_ = true;  ///< Следующий элемент текущего объекта или массива — первый (без запятой перед ним).
+    GraphHeader header_;
+    GraphNodeRecord node_;
+    GraphEdgeRecord edge_;
+};
+
+/**
+ * @brief Сериализует граф потоковым писателем.
+ */
+void writeGraphJson(const Graph& graph, std::ostream& out);
+
+/**
+ * @brief Читает файл графа в CSR.
+ *
+ * Рёбра раскладываются по источникам устойчивой сортировкой подсчётом, поэтому порядок
+ * рёбер в файле может быть любым, а рёбра одного узла сохраняют исходный порядок.
+ *
+ * @throws std::runtime_error при синтаксической ошибке или ссылке на несуществующий узел.
+ * @throws std::invalid_argument если топология или её параметры неизвестны.
+ */
+Graph readGraphJson(std::istream& in);
+
+} // namespace noc
@@ -0,0 +1,220 @@
+#include "Topology.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+#include <stdexcept>
+
+namespace noc {
+
+namespace {
+
+uint32_t parseCount(const std::string& key, const std::string& value) {
+    size_t pos = 0;
+    unsigned long long n = 0;
+    try {
+        n = std::stoull(value, &pos);
+    }
+    catch (const std::exception&) {
+        pos = 0;
+    }
+    if (pos != value.size() || value.empty() || value[0] == '-' || n > UINT32_MAX)
+        throw std::invalid_argument("Invalid value for " + key + ": " + value);
+    return static_cast<uint32_t>(n);
+}
+
+std::string lower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+/**
+ * @brief Последовательно заполняет CSR: узлы добавляются по порядку, рёбра — сразу за своим узлом.
+ */
+class CsrBuilder {
+public:
+    CsrBuilder(Graph& graph, uint64_t nodes, uint64_t edges) : graph_(graph) {
+        graph_.offsets.reserve(nodes + 1);
+        graph_.offsets.push_back(0);
+        graph_.targets.reserve(edges);
+        graph_.ports.reserve(edges);
+        graph_.nodes.x.reserve(nodes);
+        graph_.nodes.y.reserve(nodes);
+        graph_.nodes.radix.reserve(nodes);
+    }
+
+    void edge(uint32_t target, uint8_t port) {
+        graph_.targets.push_back(target);
+        graph_.ports.push_back(port);
+    }
+
+    void endNode(int32_t x, int32_t y, uint8_t radix) {
+        graph_.offsets.push_back(graph_.targets.size());
+        graph_.nodes.x.push_back(x);
+        graph_.nodes.y.push_back(y);
+        graph_.nodes.radix.push_back(radix);
+    }
+
+private:
+    Graph& graph_;
+};
+
+void requireNodes(uint64_t nodes) {
+    if (nodes == 0)
+        throw std::invalid_argument("Topology has no nodes: check the parameters");
+    if (nodes > UINT32_MAX)
+        throw std::invalid_argument("Topology is too large");
+}
+
+void buildGrid(Graph& graph, bool wrap) {
+    const uint32_t nx = graph.params.nx, ny = graph.params.ny;
+    requireNodes(uint64_t(nx) * ny);
+    CsrBuilder csr(graph, uint64_t(nx) * ny, uint64_t(nx) * ny * 4);
+    // В торе связи по измерению размера 1 были бы петлями — такие связи не создаются.
+    const bool wrapX = wrap && nx > 1, wrapY = wrap && ny > 1;
+    for (uint32_t y = 0; y < ny; ++y) {
+        for (uint32_t x = 0; x < nx; ++x) {
+            const uint32_t id = y * nx + x;
+            uint8_t radix = 0;
+            if (x + 1 < nx) csr.edge(id + 1, PortEast), ++radix;
+            else if (wrapX) csr.edge(y * nx, PortEast), ++radix;
+            if (x > 0) csr.edge(id - 1, PortWest), ++radix;
+            else if (wrapX) csr.edge(y * nx + nx - 1, PortWest), ++radix;
+            if (y > 0) csr.edge(id - nx, PortNorth), ++radix;
+            else if (wrapY) csr.edge((ny - 1) * nx + x, PortNorth), ++radix;
+            if (y + 1 < ny) csr.edge(id + nx, PortSouth), ++radix;
+            else if (wrapY) csr.edge(x, PortSouth), ++radix;
+            csr.endNode(static_cast<int32_t>(x), static_cast<int32_t>(y), radix);
+        }
+    }
+}
+
+void buildRing(Graph& graph) {
+    const uint32_t n = graph.params.n;
+    requireNodes(n);
+    CsrBuilder csr(graph, n, uint64_t(n) * 2);
+    for (uint32_t i = 0; i < n; ++i) {
+        uint8_t radix = 0;
+        if (n > 1) {
+            csr.edge((i + 1) % n, 0), ++radix;
+            csr.edge((i + n - 1) % n, 1), ++radix;
+        }
+        csr.endNode(static_cast<int32_t>(i), 0, radix);
+    }
+}
+
+/**
+ * @brief k-арное n-дерево: `levels` уровней по `k^(levels-1)` коммутаторов.
+ *
+ * Коммутатор `w` уровня `l` связан с коммутаторами уровня `l+1`, номера которых
+ * отличаются от `w` только цифрой `l` в системе счисления по основанию `k`.
+ * Порты `0..k-1` направлены вниз (у листьев — к оконечным устройствам, не входящим в граф),
+ * порты `k..2k-1` — вверх.
+ */
+void buildFatTree(Graph& graph) {
+    const uint32_t k = graph.params.k, levels = graph.params.levels;
+    if (k < 2 || levels < 1)
+        throw std::invalid_argument("Fat tree needs k >= 2 and levels >= 1");
+    if (2 * uint64_t(k) > UINT8_MAX)
+        throw std::invalid_argument("Fat tree arity is too large");
+    uint64_t perLevel = 1;
+    for (uint32_t l = 1; l < levels; ++l) {
+        perLevel *= k;
+        if (perLevel * levels > UINT32_MAX)
+            throw std::invalid_argument("Topology is too large");
+    }
+    requireNodes(perLevel * levels);
+    CsrBuilder csr(graph, perLevel * levels, perLevel * (levels - 1) * k * 2);
+
+    for (uint32_t l = 0; l < levels; ++l) {
+        for (uint64_t w = 0; w < perLevel; ++w) {
+            uint8_t radix = static_cast<uint8_t>(l + 1 < levels ? 2 * k : k);
+            // Вниз: цифра l-1 номера заменяется на d.
+            if (l > 0) {
+                uint64_t stride = 1;
+                for (uint32_t i = 0; i + 1 < l; ++i) stride *= k;
+                uint64_t base = w - (w / stride % k) * stride;
+                for (uint32_t d = 0; d < k; ++d)
+                    csr.edge(static_cast<uint32_t>((l - 1) * perLevel + base + d * stride), static_cast<uint8_t>(d));
+            }
+            // Вверх: цифра l номера заменяется на d.
+            if (l + 1 < levels) {
+                uint64_t stride = 1;
+                for (uint32_t i = 0; i < l; ++i) stride *= k;
+                uint64_t base = w - (w / stride % k) * stride;
+                for (uint32_t d = 0; d < k; ++d)
+                    csr.edge(static_cast<uint32_t>((l + 1) * perLevel + base + d * stride), static_cast<uint8_t>(k + d));
+            }
+            csr.endNode(static_cast<int32_t>(w), static_cast<int32_t>(l), radix);
+        }
+    }
+}
+
+} // namespace
+
+const char* topologyName(TopologyKind kind) {
+    switch (kind) {
+    case TopologyKind::Mesh: return "mesh";
+    case TopologyKind::Torus: return "torus";
+    case TopologyKind::Ring: return "ring";
+    case TopologyKind::FatTree: return "fattree";
+    }
+    return "unknown";
+}
+
+TopologyKind topologyFromName(const std::string& name) {
+    std::string key = lower(name);
+    if (key == "mesh") return TopologyKind::Mesh;
+    if (key == "torus") return TopologyKind::Torus;
+    if (key == "ring") return TopologyKind::Ring;
+    if (key == "fattree" || key == "fat-tree") return TopologyKind::FatTree;
+    throw std::invalid_argument("Unknown topology: " + name);
+}
+
+TopologyParams TopologyParams::parse(const std::string& text) {
+    TopologyParams params;
+    std::istringstream in(text);
+    std::string token;
+    while (in >> token) {
+        size_t eq = token.find('=');
+        if (eq == std::string::npos)
+            throw std::invalid_argument("Expected key=value, got: " + token);
+        std::string key = lower(token.substr(0, eq));
+        std::string value = token.substr(eq + 1);
+        if (key == "topology") params.kind = topologyFromName(value);
+        else if (key == "nx") params.nx = parseCount(key, value);
+        else if (key == "ny") params.ny = parseCount(key, value);
+        else if (key == "n") params.n = parseCount(key, value);
+        else if (key == "k") params.k = parseCount(key, value);
+        else if (key == "levels") params.levels = parseCount(key, value);
+        else throw std::invalid_argument("Unknown topology parameter: " + token.substr(0, eq));
+    }
+    return params;
+}
+
+std::map<std::string, uint32_t> TopologyParams::values() const {
+    switch (kind) {
+    case TopologyKind::Mesh:
+    case TopologyKind::Torus:
+        return {{"Nx", nx}, {"Ny", ny}};
+    case TopologyKind::Ring:
+        return {{"N", n}};
+    case TopologyKind::FatTree:
+        return {{"k", k}, {"levels", levels}};
+    }
+    return {};
+}
+
+Graph buildTopology(const TopologyParams& params) {
+    Graph graph;
+    graph.params = params;
+    switch (params.kind) {
+    case TopologyKind::Mesh: buildGrid(graph, false); break;
+    case TopologyKind::Torus: buildGrid(graph, true); break;
+    case TopologyKind::Ring: buildRing(graph); break;
+    case TopologyKind::FatTree: buildFatTree(graph); break;
+    }
+    return graph;
+}
+
+} // namespace noc
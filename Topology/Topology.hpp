@@ -0,0 +1,121 @@
+#pragma once
+/**
+ * @file Topology.hpp
+ * @brief Нативный генератор топологий NoC.
+ *
+ * Граф хранится в формате CSR (compressed sparse row): для узла `u` исходящие
+ * рёбра занимают диапазон `[offsets[u], offsets[u + 1])` массивов `targets`
+ * и `ports`. Атрибуты узлов хранятся по столбцам (SoA), чтобы проходы по одной
+ * координате не тянули в кэш остальные поля.
+ *
+ * Поддерживаемые топологии и параметры (строка вида `"topology=mesh Nx=4 Ny=4"`):
+ * - `mesh`, `torus` — `Nx`, `Ny`;
+ * - `ring` — `N`;
+ * - `fattree` — `k` (арность), `levels` (число уровней коммутаторов).
+ */
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace noc {
+
+/**
+ * @brief Вид топологии.
+ */
+enum class TopologyKind : uint8_t {
+    Mesh,
+    Torus,
+    Ring,
+    FatTree
+};
+
+/**
+ * @brief Направления портов маршрутизатора в сетке и торе.
+ */
+enum MeshPort : uint8_t {
+    PortEast = 0,
+    PortWest = 1,
+    PortNorth = 2,
+    PortSouth = 3
+};
+
+/**
+ * @brief Параметры генерации топологии.
+ */
+struct TopologyParams {
+    TopologyKind kind = TopologyKind::Mesh;
+    uint32_t nx = 0;     ///< Число столбцов (mesh, torus).
+    uint32_t ny = 0;     ///< Число строк (mesh, torus).
+    uint32_t n = 0;      ///< Число узлов кольца (ring).
+    uint32_t k = 0;      ///< Арность коммутатора (fattree).
+    uint32_t levels = 0; ///< Число уровней коммутаторов (fattree).
+
+    /**
+     * @brief Разбирает строку параметров `"key=value key=value"`.
+     *
+     * Без `topology=` используется `mesh`, что совпадает с параметрами
+     * `Nx=4 Ny=4`, которые Broker передаёт Graph_verilog_generator.
+     *
+     * @throws std::invalid_argument при неизвестном ключе, топологии или некорректном значении.
+     */
+    static TopologyParams parse(const std::string& text);
+
+    /**
+     * @brief Возвращает параметры в виде пар "ключ — значение" (только относящиеся к топологии).
+     */
+    std::map<std::string, uint32_t> values() const;
+};
+
+/**
+ * @brief Возвращает имя топологии ("mesh", "torus", "ring", "fattree").
+ */
+const char* topologyName(TopologyKind kind);
+
+/**
+ * @brief Возвращает вид топологии по имени.
+ * @throws std::invalid_argument если имя неизвестно.
+ */
+TopologyKind topologyFromName(const std::string& name);
+
+/**
+ * @brief Атрибуты узлов в виде отдельных столбцов.
+ *
+ * Для сетки и тора `x`, `y` — координаты маршрутизатора, для кольца `x` — позиция,
+ * для fat-tree `x` — номер коммутатора на уровне, `y` — уровень (0 — листья).
+ */
+struct NodeAttributes {
+    std::vector<int32_t> x;
+    std::vector<int32_t> y;
+    std::vector<uint8_t> radix; ///< Число сетевых портов маршрутизатора (без локального).
+};
+
+/**
+ * @brief Ориентированный граф топологии в формате CSR.
+ *
+ * Каждая двунаправленная связь представлена двумя ориентированными рёбрами.
+ */
+struct Graph {
+    TopologyParams params;
+    std::vector<uint64_t> offsets; ///< Размер nodeCount() + 1.
+    std::vector<uint32_t> targets; ///< Узел-получатель каждого ребра.
+    std::vector<uint8_t> ports;    ///< Номер выходного порта маршрутизатора-источника.
+    NodeAttributes nodes;
+
+    uint32_t nodeCount() const { return offsets.empty() ? 0 : static_cast<uint32_t>(offsets.size() - 1); }
+    uint64_t edgeCount() const { return targets.size(); }
+    uint64_t degree(uint32_t node) const { return offsets[node + 1] - offsets[node]; }
+};
+
+/**
+ * @brief Строит граф топологии.
+ *
+ * Узлы и рёбра генерируются сразу в порядке CSR, без промежуточного списка рёбер
+ * и сортировки, поэтому построение линейно по числу рёбер.
+ *
+ * @throws std::invalid_argument если параметры не заданы или вне допустимого диапазона.
+ */
+Graph buildTopology(const TopologyParams& params);
+
+} // namespace noc
@@ -0,0 +1,1011 @@
+#include "VerilogEmitter.hpp"
+
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "Parallel.hpp"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace noc {
+
+namespace {
+
+/**
+ * @brief Буфер текста модуля: строка с заранее зарезервированной ёмкостью и быстрым выводом чисел.
+ */
+class Text {
+public:
+    explicit Text(size_t capacity) { text_.reserve(capacity); }
+
+    Text& operator<<(std::string_view value) {
+        text_.append(value);
+        return *this;
+    }
+
+    Text& operator<<(char value) {
+        text_ += value;
+        return *this;
+    }
+
+    template <class T, std::enable_if_t<std::is_integral_v<T>, int> = 0>
+    Text& operator<<(T value) {
+        char digits[24];
+        auto result = std::to_chars(digits, digits + sizeof(digits), value);
+        text_.append(digits, result.ptr);
+        return *this;
+    }
+
+    std::string& str() { return text_; }
+
+private:
+    std::string text_;
+};
+
+unsigned bitsFor(uint64_t values) {
+    unsigned bits = 1;
+    while (bits < 64 && (uint64_t(1) << bits) < values) ++bits;
+    return bits;
+}
+
+/**
+ * @brief Для каждого ребра `u -> v` — номер входного порта `v`, на который оно приходит.
+ *
+ * Это номер обратного ребра `v -> u` среди рёбер `v`; параллельные рёбра сопоставляются по порядку.
+ */
+std::vector<uint32_t> reversePorts(const Graph& graph, unsigned jobs) {
+    std::vector<uint32_t> reverse(graph.edgeCount());
+    common::parallelFor(graph.nodeCount(), jobs, [&](size_t u) {
+        for (uint64_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+            const uint32_t v = graph.targets[e];
+            uint64_t occurrence = 0;
+            for (uint64_t p = graph.offsets[u]; p < e; ++p)
+                occurrence += graph.targets[p] == v;
+            uint64_t r = graph.offsets[v];
+            for (; r < graph.offsets[v + 1]; ++r) {
+                if (graph.targets[r] == u && occurrence-- == 0) break;
+            }
+            if (r == graph.offsets[v + 1])
+                throw std::invalid_argument("Edge " + std::to_string(u) + " -> " + std::to_string(v) + " has no reverse edge");
+            reverse[e] = static_cast<uint32_t>(r - graph.offsets[v]);
+        }
+    });
+    return reverse;
+}
+
+/**
+ * @brief Пишет тело функции маршрутизации `route(dst)` маршрутизатора `u`.
+ *
+ * Сетка и тор — XY-маршрутизация (в торе по кратчайшему направлению), кольцо — по кратчайшей дуге,
+ * fat-tree — вверх до общего предка, затем вниз по цифрам номера листа.
+ */
+void writeRoute(Text& out, const Graph& graph, uint32_t u) {
+    const uint32_t degree = static_cast<uint32_t>(graph.degree(u));
+    std::vector<int> local(256, -1); // Номер графа порта -> номер порта маршрутизатора.
+    for (uint32_t i = 0; i < degree; ++i)
+        local[graph.ports[graph.offsets[u] + i]] = static_cast<int>(i);
+    auto port = [&](unsigned graphPort) -> std::string {
+        return local[graphPort] < 0 ? std::string("LOCAL") : std::to_string(local[graphPort]);
+    };
+    const TopologyParams& p = graph.params;
+    const int32_t x = graph.nodes.x[u], y = graph.nodes.y[u];
+
+    switch (p.kind) {
+    case TopologyKind::Mesh:
+    case TopologyKind::Torus: {
+        out << "    localparam NX = " << p.nx << ", NY = " << p.ny << ", X = " << x << ", Y = " << y << ";\n\n"
+            << "    function automatic [SEL_WIDTH-1:0] route(input [ID_WIDTH-1:0] dst);\n"
+            << "        integer dx, dy;\n"
+            << "        begin\n"
+            << "            dx = dst % NX;\n"
+            << "            dy = dst / NX;\n";
+        if (p.kind == TopologyKind::Mesh) {
+            out << "            if (dx > X) route = " << port(PortEast) << ";\n"
+                << "            else if (dx < X) route = " << port(PortWest) << ";\n"
+                << "            else if (dy > Y) route = " << port(PortSouth) << ";\n"
+                << "            else if (dy < Y) route = " << port(PortNorth) << ";\n";
+        }
+        else {
+            out << "            if (dx != X) route = ((dx - X + NX) % NX <= NX / 2) ? " << port(PortEast) << " : " << port(PortWest) << ";\n"
+                << "            else if (dy != Y) route = ((dy - Y + NY) % NY <= NY / 2) ? " << port(PortSouth) << " : " << port(PortNorth) << ";\n";
+        }
+        out << "            else route = LOCAL;\n"
+            << "        end\n"
+            << "    endfunction\n";
+        break;
+    }
+    case TopologyKind::Ring:
+        out << "    localparam N = " << p.n << ", POS = " << x << ";\n\n"
+            << "    function automatic [SEL_WIDTH-1:0] route(input [ID_WIDTH-1:0] dst);\n"
+            << "        begin\n"
+            << "            if (dst == POS) route = LOCAL;\n"
+            << "            else route = ((dst - POS + N) % N <= N / 2) ? " << port(0) << " : " << port(1) << ";\n"
+            << "        end\n"
+            << "    endfunction\n";
+        break;
+    case TopologyKind::FatTree: {
+        // x — номер коммутатора на уровне, y — уровень; получатель — номер листа.
+        uint64_t upStride = 1;
+        for (int32_t i = 0; i < y; ++i) upStride *= p.k;
+        const uint64_t downStride = y > 0 ? upStride / p.k : 1;
+        out << "    localparam K = " << p.k << ", W = " << x << ", UP_STRIDE = " << upStride
+            << ", DOWN_STRIDE = " << downStride << ";\n\n"
+            << "    function automatic [SEL_WIDTH-1:0] route(input [ID_WIDTH-1:0] dst);\n"
+            << "        begin\n"
+            << "            if (dst / UP_STRIDE == W / UP_STRIDE) begin\n";
+        if (y == 0) {
+            out << "                route = LOCAL;\n";
+        }
+        else {
+            out << "                case ((dst / DOWN_STRIDE) % K)\n";
+            for (uint32_t d = 0; d < p.k; ++d)
+                out << "                    " << d << ": route = " << port(d) << ";\n";
+            out << "                    default: route = LOCAL;\n"
+                << "                endcase\n";
+        }
+        out << "            end\n"
+            << "            else begin\n";
+        if (static_cast<uint32_t>(y) + 1 < p.levels) {
+            out << "                case ((dst / UP_STRIDE) % K)\n";
+            for (uint32_t d = 0; d < p.k; ++d)
+                out << "                    " << d << ": route = " << port(p.k + d) << ";\n";
+            out << "                    default: route = LOCAL;\n"
+                << "                endcase\n";
+        }
+        else {
+            out << "                route = LOCAL;\n";
+        }
+        out << "            end\n"
+            << "        end\n"
+            << "    endfunction\n";
+        break;
+    }
+    }
+}
+
+/**
+ * @brief Коммутатор маршрутизатора и конец модуля; использует `route()`, PORTS, SEL_WIDTH и ID_WIDTH.
+ */
+void writeSwitch(Text& out) {
+    out << "\n"
+        << "    // Коммутатор с фиксированным приоритетом: при конфликте побеждает младший входной порт.\n"
+        << "    integer i;\n"
+        << "    reg [SEL_WIDTH-1:0] sel;\n"
+        << "    always @(posedge clk) begin\n"
+        << "        out_valid <= {PORTS{1'b0}};\n"
+        << "        if (!rst) begin\n"
+        << "            for (i = PORTS - 1; i >= 0; i = i - 1) begin\n"
+        << "                if (in_valid[i]) begin\n"
+        << "                    sel = route(in_flit[i*FLIT_WIDTH +: ID_WIDTH]);\n"
+        << "                    out_flit[sel*FLIT_WIDTH +: FLIT_WIDTH] <= in_flit[i*FLIT_WIDTH +: FLIT_WIDTH];\n"
+        << "                    out_valid[sel] <= 1'b1;\n"
+        << "                end\n"
+        << "            end\n"
+        << "        end\n"
+        << "    end\n"
+        << "endmodule\n";
+}
+
+void writeRouter(Text& out, const Graph& graph, uint32_t u, unsigned flitWidth) {
+    const uint64_t ports = graph.degree(u) + 1;
+    out << "// Маршрутизатор " << u << " (" << topologyName(graph.params.kind) << ", x = " << graph.nodes.x[u]
+        << ", y = " << graph.nodes.y[u] << "). ";
+    if (ports > 1)
+        out << "Порты 0.." << ports - 2 << " — сетевые, " << ports - 1 << " — локальный.\n";
+    else
+        out << "Единственный порт 0 — локальный.\n";
+    out << "module noc_router_" << u << " #(\n"
+        << "    parameter FLIT_WIDTH = " << flitWidth << "\n"
+        << ") (\n"
+        << "    input  wire clk,\n"
+        << "    input  wire rst,\n"
+        << "    input  wire [" << ports << "*FLIT_WIDTH-1:0] in_flit,\n"
+        << "    input  wire [" << ports - 1 << ":0] in_valid,\n"
+        << "    output reg  [" << ports << "*FLIT_WIDTH-1:0] out_flit,\n"
+        << "    output reg  [" << ports - 1 << ":0] out_valid\n"
+        << ");\n"
+        << "    localparam PORTS = " << ports << ";\n"
+        << "    localparam LOCAL = " << ports - 1 << ";\n"
+        << "    localparam SEL_WIDTH = " << bitsFor(ports) << ";\n"
+        << "    localparam ID_WIDTH = " << bitsFor(graph.nodeCount()) << ";\n";
+    writeRoute(out, graph, u);
+    writeSwitch(out);
+}
+
+void writeLinks(Text& out, const Graph& graph, const std::vector<uint32_t>& reverse, uint32_t u, unsigned flitWidth) {
+    for (uint64_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+        const uint64_t i = e - graph.offsets[u];
+        out << "// Звено " << u << ":" << i << " -> " << graph.targets[e] << ":" << reverse[e] << ".\n"
+            << "module noc_link_" << u << "_" << i << " #(\n"
+            << "    parameter FLIT_WIDTH = " << flitWidth << "\n"
+            << ") (\n"
+            << "    input  wire                  clk,\n"
+            << "    input  wire                  rst,\n"
+            << "    input  wire [FLIT_WIDTH-1:0] in_flit,\n"
+            << "    input  wire                  in_valid,\n"
+            << "    output reg  [FLIT_WIDTH-1:0] out_flit,\n"
+            << "    output reg                   out_valid\n"
+            << ");\n"
+            << "    always @(posedge clk) begin\n"
+            << "        out_flit <= in_flit;\n"
+            << "        out_valid <= !rst && in_valid;\n"
+            << "    end\n"
+            << "endmodule\n\n";
+    }
+}
+
+/**
+ * @brief Объявления проводов маршрутизатора `u` в модуле верхнего уровня.
+ */
+void writeTopWires(Text& out, const Graph& graph, uint32_t u) {
+    const uint64_t ports = graph.degree(u) + 1;
+    out << "    wire [" << ports << "*FLIT_WIDTH-1:0] r" << u << "_in_flit, r" << u << "_out_flit;\n"
+        << "    wire [" << ports - 1 << ":0] r" << u << "_in_valid, r" << u << "_out_valid;\n";
+}
+
+/**
+ * @brief Экземпляр маршрутизатора `u`, его локальный порт и исходящие звенья.
+ */
+void writeTopInstances(Text& out, const Graph& graph, const std::vector<uint32_t>& reverse, uint32_t u) {
+    const uint64_t local = graph.degree(u);
+    out << "\n    noc_router_" << u << " #(.FLIT_WIDTH(FLIT_WIDTH)) router_" << u << " (\n"
+        << "        .clk(clk), .rst(rst),\n"
+        << "        .in_flit(r" << u << "_in_flit), .in_valid(r" << u << "_in_valid),\n"
+        << "        .out_flit(r" << u << "_out_flit), .out_valid(r" << u << "_out_valid)\n"
+        << "    );\n"
+        << "    assign r" << u << "_in_flit[" << local << "*FLIT_WIDTH +: FLIT_WIDTH] = local_in_flit[" << u << "*FLIT_WIDTH +: FLIT_WIDTH];\n"
+        << "    assign r" << u << "_in_valid[" << local << "] = local_in_valid[" << u << "];\n"
+        << "    assign local_out_flit[" << u << "*FLIT_WIDTH +: FLIT_WIDTH] = r" << u << "_out_flit[" << local << "*FLIT_WIDTH +: FLIT_WIDTH];\n"
+        << "    assign local_out_valid[" << u << "] = r" << u << "_out_valid[" << local << "];\n";
+    for (uint64_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+        const uint64_t i = e - graph.offsets[u];
+        const uint32_t v = graph.targets[e];
+        out << "    noc_link_" << u << "_" << i << " #(.FLIT_WIDTH(FLIT_WIDTH)) link_" << u << "_" << i << " (\n"
+            << "        .clk(clk), .rst(rst),\n"
+            << "        .in_flit(r" << u << "_out_flit[" << i << "*FLIT_WIDTH +: FLIT_WIDTH]), .in_valid(r" << u << "_out_valid[" << i << "]),\n"
+            << "        .out_flit(r" << v << "_in_flit[" << reverse[e] << "*FLIT_WIDTH +: FLIT_WIDTH]), .out_valid(r" << v << "_in_valid[" << reverse[e] << "])\n"
+            << "    );\n";
+    }
+}
+
+/**
+ * @brief Записывает файл одним вызовом write (файл создаётся заново).
+ */
+void writeWholeFile(const fs::path& path, const std::string& text) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Failed to create " + path.string());
+    const char* data = text.data();
+    size_t left = text.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd, data, left);
+        if (written < 0) {
+            ::close(fd);
+            throw std::runtime_error("Failed to write " + path.string());
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+    if (::close(fd) != 0)
+        throw std::runtime_error("Failed to write " + path.string());
+#else
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    out.close();
+    if (!out)
+        throw std::runtime_error("Failed to write " + path.string());
+#endif
+}
+
+/**
+ * @brief Сбрасывает на диск файл или каталог.
+ */
+void syncPath(const fs::path& path, bool directory) {
+#if defined(_WIN32)
+    // Каталоги на Windows не сбрасываются: rename в NTFS журналируется.
+    if (directory) return;
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("Failed to open " + path.string());
+    BOOL ok = FlushFileBuffers(file);
+    CloseHandle(file);
+    if (!ok)
+        throw std::runtime_error("Failed to sync " + path.string());
+#elif defined(__unix__) || defined(__APPLE__)
+    int fd = ::open(path.c_str(), (directory ? O_RDONLY | O_DIRECTORY : O_RDONLY) | O_CLOEXEC);
+    if (fd < 0)
+        throw std::runtime_error("Failed to open " + path.string());
+    int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0)
+        throw std::runtime_error("Failed to sync " + path.string());
+#else
+    (void)path;
+    (void)directory;
+#endif
+}
+
+/**
+ * @brief Пишет модули групп и `noc_top`, который соединяет группы (VerilogOptions::groups).
+ *
+ * Звено входит в группу своего маршрутизатора-источника. Звено в другую группу выводится из модуля
+ * группы портами `x<u>_<i>_flit` и `x<u>_<i>_valid` (`u` — источник, `i` — номер ребра), которые в `noc_top`
+ * соединены проводами с теми же именами со входами группы-получателя. Имена портов зависят только от
+ * рёбер, поэтому изменение одной группы не меняет создание экземпляров остальных.
+ *
+ * @param ports Число портов всех маршрутизаторов (параметризованный стиль) или 0 — у каждого
+ * маршрутизатора степень + 1 портов (стиль PerNode).
+ * @return Размер записанных файлов в байтах.
+ */
+uint64_t emitGroups(const Graph& graph, const fs::path& staging, const VerilogOptions& options,
+                    const std::vector<uint32_t>& reverse, uint64_t ports, std::vector<fs::path>& files) {
+    const uint32_t nodes = graph.nodeCount();
+    const std::vector<VerilogGroup>& groups = options.groups;
+    std::vector<uint32_t> groupOf(nodes, UINT32_MAX);
+    for (size_t g = 0; g < groups.size(); ++g) {
+        for (uint32_t u : groups[g].routers) {
+            if (u >= nodes || groupOf[u] != UINT32_MAX)
+                throw std::invalid_argument("Router " + std::to_string(u) + " is outside the network or in two groups");
+            groupOf[u] = static_cast<uint32_t>(g);
+        }
+    }
+    for (uint32_t u = 0; u < nodes; ++u)
+        if (groupOf[u] == UINT32_MAX) throw std::invalid_argument("Router " + std::to_string(u) + " is in no group");
+
+    const bool perNode = ports == 0;
+    // Выходной порт ребра `e` маршрутизатора `u`; вход того же номера принимает флиты от того же соседа.
+    auto portOf = [&](uint32_t u, uint64_t e) -> uint64_t { return perNode ? e - graph.offsets[u] : graph.ports[e]; };
+    auto targetPort = [&](uint64_t e) -> uint64_t {
+        const uint32_t v = graph.targets[e];
+        return perNode ? reverse[e] : graph.ports[graph.offsets[v] + reverse[e]];
+    };
+    const TopologyParams& p = graph.params;
+    auto power = [](uint64_t base, int32_t exponent) {
+        uint64_t result = 1;
+        for (int32_t j = 0; j < exponent; ++j) result *= base;
+        return result;
+    };
+
+    std::vector<std::string> wires(groups.size()), instances(groups.size());
+    std::vector<uint64_t> bytes(groups.size(), 0);
+    common::parallelFor(groups.size(), options.jobs, [&](size_t g) {
+        const VerilogGroup& group = groups[g];
+        const uint64_t n = group.routers.size();
+        std::vector<std::string> crossIn, crossOut; // Имена проводов звеньев из группы и в группу.
+        for (uint32_t u : group.routers) {
+            for (uint64_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                const uint32_t v = graph.targets[e];
+                if (groupOf[v] == g) continue;
+                crossOut.push_back("x" + std::to_string(u) + "_" + std::to_string(e - graph.offsets[u]));
+                crossIn.push_back("x" + std::to_string(v) + "_" + std::to_string(reverse[e]));
+            }
+        }
+
+        Text module(2048 + 1024 * n + 256 * (crossIn.size() + crossOut.size()));
+        module << "// Группа " << group.module << ": маршрутизаторов " << n << ", звеньев из группы "
+               << crossOut.size() << ", в группу " << crossIn.size() << ".\n"
+               << "module " << group.module << " #(\n"
+               << "    parameter FLIT_WIDTH = " << options.flitWidth << "\n"
+               << ") (\n"
+               << "    input  wire clk,\n"
+               << "    input  wire rst,\n"
+               << "    input  wire [" << n << "*FLIT_WIDTH-1:0] local_in_flit,\n"
+               << "    input  wire [" << n - 1 << ":0] local_in_valid,\n"
+               << "    output wire [" << n << "*FLIT_WIDTH-1:0] local_out_flit,\n"
+               << "    output wire [" << n - 1 << ":0] local_out_valid";
+        for (const std::string& name : crossIn)
+            module << ",\n    input  wire [FLIT_WIDTH-1:0] " << name << "_flit,\n    input  wire " << name << "_valid";
+        for (const std::string& name : crossOut)
+            module << ",\n    output wire [FLIT_WIDTH-1:0] " << name << "_flit,\n    output wire " << name << "_valid";
+        module << "\n);\n";
+        if (!perNode)
+            module << "    localparam ID_WIDTH = " << bitsFor(nodes) << ";\n";
+        for (uint32_t u : group.routers) {
+            const uint64_t routerPorts = perNode ? graph.degree(u) + 1 : ports;
+            module << "    wire [" << routerPorts << "*FLIT_WIDTH-1:0] r" << u << "_in_flit, r" << u << "_out_flit;\n"
+                   << "    wire [" << routerPorts - 1 << ":0] r" << u << "_in_valid, r" << u << "_out_valid;\n";
+        }
+
+        size_t cross = 0;
+        for (uint64_t slot = 0; slot < n; ++slot) {
+            const uint32_t u = group.routers[slot];
+            const uint64_t local = perNode ? graph.degree(u) : ports - 1;
+            const int32_t x = graph.nodes.x[u], y = graph.nodes.y[u];
+            module << "\n";
+            if (perNode) {
+                module << "    noc_router_" << u << " #(.FLIT_WIDTH(FLIT_WIDTH)) router_" << u << " (\n";
+            }
+            else {
+                module << "    noc_router #(.FLIT_WIDTH(FLIT_WIDTH), .ID_WIDTH(ID_WIDTH), ";
+                switch (p.kind) {
+                case TopologyKind::Mesh:
+                case TopologyKind::Torus: module << ".X(" << x << "), .Y(" << y << ")"; break;
+                case TopologyKind::Ring: module << ".POS(" << x << ")"; break;
+                case TopologyKind::FatTree:
+                    module << ".LEVEL(" << y << "), .W(" << x << "), .UP_STRIDE(" << power(p.k, y) << "), .DOWN_STRIDE("
+                           << (y > 0 ? power(p.k, y - 1) : 1) << ")";
+                    break;
+                }
+                module << ") router_" << u << " (\n";
+            }
+            module << "        .clk(clk), .rst(rst),\n"
+                   << "        .in_flit(r" << u << "_in_flit), .in_valid(r" << u << "_in_valid),\n"
+                   << "        .out_flit(r" << u << "_out_flit), .out_valid(r" << u << "_out_valid)\n"
+                   << "    );\n"
+                   << "    assign r" << u << "_in_flit[" << local << "*FLIT_WIDTH +: FLIT_WIDTH] = local_in_flit[" << slot << "*FLIT_WIDTH +: FLIT_WIDTH];\n"
+                   << "    assign r" << u << "_in_valid[" << local << "] = local_in_valid[" << slot << "];\n"
+                   << "    assign local_out_flit[" << slot << "*FLIT_WIDTH +: FLIT_WIDTH] = r" << u << "_out_flit[" << local << "*FLIT_WIDTH +: FLIT_WIDTH];\n"
+                   << "    assign local_out_valid[" << slot << "] = r" << u << "_out_valid[" << local << "];\n";
+
+            std::vector<bool> connected(local, false);
+            for (uint64_t e = graph.offsets[u]; e < graph.offsets[u + 1]; ++e) {
+                const uint64_t i = e - graph.offsets[u];
+                const uint32_t v = graph.targets[e];
+                const uint64_t port = portOf(u, e);
+                connected[port] = true;
+                if (perNode)
+                    module << "    noc_link_" << u << "_" << i;
+                else
+                    module << "    noc_link";
+                module << " #(.FLIT_WIDTH(FLIT_WIDTH)) link_" << u << "_" << i << " (\n"
+                       << "        .clk(clk), .rst(rst),\n"
+                       << "        .in_flit(r" << u << "_out_flit[" << port << "*FLIT_WIDTH +: FLIT_WIDTH]), .in_valid(r" << u << "_out_valid[" << port << "]),\n";
+                if (groupOf[v] == g) {
+                    module << "        .out_flit(r" << v << "_in_flit[" << targetPort(e) << "*FLIT_WIDTH +: FLIT_WIDTH]), .out_valid(r" << v
+                           << "_in_valid[" << targetPort(e) << "])\n"
+                           << "    );\n";
+                    continue;
+                }
+                const std::string& out = crossOut[cross];
+                const std::string& in = crossIn[cross];
+                ++cross;
+                module << "        .out_flit(" << out << "_flit), .out_valid(" << out << "_valid)\n"
+                       << "    );\n"
+                       << "    assign r" << u << "_in_flit[" << port << "*FLIT_WIDTH +: FLIT_WIDTH] = " << in << "_flit;\n"
+                       << "    assign r" << u << "_in_valid[" << port << "] = " << in << "_valid;\n";
+            }
+            // Порты отсутствующих соседей параметризованного маршрутизатора (край сетки, листья и корни fat-tree).
+            for (uint64_t port = 0; port < local; ++port) {
+                if (connected[port]) continue;
+                module << "    assign r" << u << "_in_flit[" << port << "*FLIT_WIDTH +: FLIT_WIDTH] = {FLIT_WIDTH{1'b0}};\n"
+                       << "    assign r" << u << "_in_valid[" << port << "] = 1'b0;\n";
+            }
+        }
+        module << "endmodule\n";
+        writeWholeFile(staging / (group.module + ".v"), module.str());
+        bytes[g] = module.str().size();
+
+        // Часть noc_top: провода звеньев из группы и экземпляр группы. Локальные порты собираются
+        // конкатенацией, старший элемент — первым.
+        Text wire(96 * crossOut.size());
+        for (const std::string& name : crossOut)
+            wire << "    wire [FLIT_WIDTH-1:0] " << name << "_flit;\n    wire " << name << "_valid;\n";
+        wires[g] = std::move(wire.str());
+        Text instance(1024 + 160 * n + 96 * (crossIn.size() + crossOut.size()));
+        auto concatenation = [&](std::string_view bus, bool flit) {
+            instance << "{";
+            for (uint64_t slot = n; slot-- > 0;) {
+                instance << bus << "[" << group.routers[slot];
+                if (flit) instance << "*FLIT_WIDTH +: FLIT_WIDTH";
+                instance << "]" << (slot != 0 ? ", " : "");
+            }
+            instance << "}";
+        };
+        instance << "\n    " << group.module << " #(.FLIT_WIDTH(FLIT_WIDTH)) " << group.instance << " (\n"
+                 << "        .clk(clk), .rst(rst),\n"
+                 << "        .local_in_flit(";
+        concatenation("local_in_flit", true);
+        instance << "),\n        .local_in_valid(";
+        concatenation("local_in_valid", false);
+        instance << "),\n        .local_out_flit(";
+        concatenation("local_out_flit", true);
+        instance << "),\n        .local_out_valid(";
+        concatenation("local_out_valid", false);
+        instance << ")";
+        for (const std::vector<std::string>* names : {&crossIn, &crossOut})
+            for (const std::string& name : *names)
+                instance << ",\n        ." << name << "_flit(" << name << "_flit), ." << name << "_valid(" << name << "_valid)";
+        instance << "\n    );\n";
+        instances[g] = std::move(instance.str());
+    });
+
+    size_t topSize = 1024;
+    for (size_t g = 0; g < groups.size(); ++g)
+        topSize += wires[g].size() + instances[g].size();
+    Text top(topSize);
+    top << "// Верхний уровень сети " << topologyName(p.kind) << ": " << nodes << " маршрутизаторов, "
+        << graph.edgeCount() << " звеньев в " << groups.size() << " группах.\n"
+        << "module noc_top #(\n"
+        << "    parameter FLIT_WIDTH = " << options.flitWidth << "\n"
+        << ") (\n"
+        << "    input  wire clk,\n"
+        << "    input  wire rst,\n"
+        << "    input  wire [" << nodes << "*FLIT_WIDTH-1:0] local_in_flit,\n"
+        << "    input  wire [" << nodes - 1 << ":0] local_in_valid,\n"
+        << "    output wire [" << nodes << "*FLIT_WIDTH-1:0] local_out_flit,\n"
+        << "    output wire [" << nodes - 1 << ":0] local_out_valid\n"
+        << ");\n";
+    for (const std::string& wire : wires) top << wire;
+    for (const std::string& instance : instances) top << instance;
+    top << "endmodule\n";
+    writeWholeFile(staging / "noc_top.v", top.str());
+
+    uint64_t total = top.str().size();
+    for (size_t g = 0; g < groups.size(); ++g) {
+        files.push_back(staging / (groups[g].module + ".v"));
+        total += bytes[g];
+    }
+    files.push_back(staging / "noc_top.v");
+    return total;
+}
+
+/**
+ * @brief Пишет по модулю маршрутизатора и звена на каждый узел и ребро (VerilogStyle::PerNode).
+ */
+VerilogStats emitPerNode(const Graph& graph, const fs::path& staging, const VerilogOptions& options,
+                         std::vector<fs::path>& files) {
+    const uint32_t nodes = graph.nodeCount();
+    const std::vector<uint32_t> reverse = reversePorts(graph, options.jobs);
+
+    std::vector<uint64_t> bytes(nodes, 0);
+    std::vector<std::string> wires(nodes), instances(nodes);
+
+    // Маршрутизатор, его звенья и его часть модуля верхнего уровня — одна задача.
+    common::parallelFor(nodes, options.jobs, [&](size_t index) {
+        const uint32_t u = static_cast<uint32_t>(index);
+        const uint64_t degree = graph.degree(u);
+
+        Text router(2048 + 64 * degree + 64 * graph.params.k);
+        writeRouter(router, graph, u, options.flitWidth);
+        writeWholeFile(staging / ("noc_router_" + std::to_string(u) + ".v"), router.str());
+        bytes[u] = router.str().size();
+
+        if (degree != 0) {
+            Text links(512 * degree);
+            writeLinks(links, graph, reverse, u, options.flitWidth);
+            writeWholeFile(staging / ("noc_links_" + std::to_string(u) + ".v"), links.str());
+            bytes[u] += links.str().size();
+        }
+
+        if (!options.groups.empty()) return;
+        Text wire(160);
+        writeTopWires(wire, graph, u);
+        wires[u] = std::move(wire.str());
+        Text instance(640 + 320 * degree);
+        writeTopInstances(instance, graph, reverse, u);
+        instances[u] = std::move(instance.str());
+    });
+
+    VerilogStats stats;
+    stats.modules = nodes + graph.edgeCount();
+    for (uint64_t b : bytes) stats.bytes += b;
+    files.reserve(2 * size_t(nodes) + options.groups.size() + 1);
+    for (uint32_t u = 0; u < nodes; ++u) {
+        files.push_back(staging / ("noc_router_" + std::to_string(u) + ".v"));
+        if (graph.degree(u) != 0)
+            files.push_back(staging / ("noc_links_" + std::to_string(u) + ".v"));
+    }
+    if (!options.groups.empty()) {
+        stats.modules += options.groups.size() + 1;
+        stats.bytes += emitGroups(graph, staging, options, reverse, 0, files);
+        return stats;
+    }
+
+    size_t topSize = 1024;
+    for (uint32_t u = 0; u < nodes; ++u)
+        topSize += wires[u].size() + instances[u].size();
+    Text top(topSize);
+    top << "// Верхний уровень сети " << topologyName(graph.params.kind) << ": " << nodes << " маршрутизаторов, "
+        << graph.edgeCount() << " звеньев.\n"
+        << "module noc_top #(\n"
+        << "    parameter FLIT_WIDTH = " << options.flitWidth << "\n"
+        << ") (\n"
+        << "    input  wire clk,\n"
+        << "    input  wire rst,\n"
+        << "    input  wire [" << nodes << "*FLIT_WIDTH-1:0] local_in_flit,\n"
+        << "    input  wire [" << nodes - 1 << ":0] local_in_valid,\n"
+        << "    output wire [" << nodes << "*FLIT_WIDTH-1:0] local_out_flit,\n"
+        << "    output wire [" << nodes - 1 << ":0] local_out_valid\n"
+        << ");\n";
+    for (const std::string& wire : wires) top << wire;
+    for (const std::string& instance : instances) top << instance;
+    top << "endmodule\n";
+    writeWholeFile(staging / "noc_top.v", top.str());
+
+    stats.modules += 1;
+    stats.bytes += top.str().size();
+    files.push_back(staging / "noc_top.v");
+    return stats;
+}
+
+/**
+ * @brief Общая часть модуля верхнего уровня в параметризованном стиле: порты и шины всех маршрутизаторов.
+ *
+ * Все маршрутизаторы одной топологии имеют одинаковое число портов PORTS, поэтому порт `p`
+ * маршрутизатора `id` — это срез `[(id*PORTS + p)*FLIT_WIDTH +: FLIT_WIDTH]` общей шины.
+ */
+void writeParameterizedTopHeader(Text& out, const Graph& graph, unsigned flitWidth, uint64_t ports) {
+    const uint32_t nodes = graph.nodeCount();
+    out << "// Верхний уровень сети " << topologyName(graph.params.kind) << ": " << nodes << " маршрутизаторов, "
+        << graph.edgeCount() << " звеньев (параметризованные модули).\n"
+        << "module noc_top #(\n"
+        << "    parameter FLIT_WIDTH = " << flitWidth << "\n"
+        << ") (\n"
+        << "    input  wire clk,\n"
+        << "    input  wire rst,\n"
+        << "    input  wire [" << nodes << "*FLIT_WIDTH-1:0] local_in_flit,\n"
+        << "    input  wire [" << nodes - 1 << ":0] local_in_valid,\n"
+        << "    output wire [" << nodes << "*FLIT_WIDTH-1:0] local_out_flit,\n"
+        << "    output wire [" << nodes - 1 << ":0] local_out_valid\n"
+        << ");\n"
+        << "    localparam N = " << nodes << ";\n"
+        << "    localparam PORTS = " << ports << ";\n"
+        << "    localparam LOCAL = " << ports - 1 << ";\n"
+        << "    localparam ID_WIDTH = " << bitsFor(nodes) << ";\n\n"
+        << "    wire [N*PORTS*FLIT_WIDTH-1:0] rin_flit, rout_flit;\n"
+        << "    wire [N*PORTS-1:0] rin_valid, rout_valid;\n\n";
+}
+
+/**
+ * @brief Подключение локального порта маршрутизатора ID внутри блока generate.
+ */
+void writeParameterizedLocal(Text& out, std::string_view indent) {
+    out << indent << "assign rin_flit[(ID*PORTS+LOCAL)*FLIT_WIDTH +: FLIT_WIDTH] = local_in_flit[ID*FLIT_WIDTH +: FLIT_WIDTH];\n"
+        << indent << "assign rin_valid[ID*PORTS+LOCAL] = local_in_valid[ID];\n"
+        << indent << "assign local_out_flit[ID*FLIT_WIDTH +: FLIT_WIDTH] = rout_flit[(ID*PORTS+LOCAL)*FLIT_WIDTH +: FLIT_WIDTH];\n"
+        << indent << "assign local_out_valid[ID] = rout_valid[ID*PORTS+LOCAL];\n";
+}
+
+/**
+ * @brief Звено от выходного порта `port` маршрутизатора ID ко входу `targetPort` маршрутизатора `target`
+ * либо, если условия `condition` не выполнено, обнуление входа `port` самого маршрутизатора ID
+ * (связи симметричны, поэтому вход этого направления тоже не подключён).
+ */
+void writeParameterizedLink(Text& out, std::string_view indent, std::string_view label, std::string_view condition,
+                            std::string_view port, std::string_view target, std::string_view targetPort) {
+    out << indent << "if (" << condition << ") begin : " << label << "\n"
+        << indent << "    noc_link #(.FLIT_WIDTH(FLIT_WIDTH)) link (\n"
+        << indent << "        .clk(clk), .rst(rst),\n"
+        << indent << "        .in_flit(rout_flit[(ID*PORTS+" << port << ")*FLIT_WIDTH +: FLIT_WIDTH]), .in_valid(rout_valid[ID*PORTS+" << port << "]),\n"
+        << indent << "        .out_flit(rin_flit[((" << target << ")*PORTS+" << targetPort << ")*FLIT_WIDTH +: FLIT_WIDTH]), .out_valid(rin_valid[(" << target << ")*PORTS+" << targetPort << "])\n"
+        << indent << "    );\n"
+        << indent << "end\n"
+        << indent << "else begin : " << label << "_none\n"
+        << indent << "    assign rin_flit[(ID*PORTS+" << port << ")*FLIT_WIDTH +: FLIT_WIDTH] = {FLIT_WIDTH{1'b0}};\n"
+        << indent << "    assign rin_valid[ID*PORTS+" << port << "] = 1'b0;\n"
+        << indent << "end\n";
+}
+
+/**
+ * @brief Пишет один параметризованный маршрутизатор, одно звено и верхний уровень с циклами generate
+ * (VerilogStyle::Parameterized).
+ *
+ * Номера портов одинаковы у всех маршрутизаторов топологии: у отсутствующих соседей (край сетки,
+ * листья и корни fat-tree) порты остаются, их входы обнуляются, и синтез удаляет лишнюю логику.
+ * Сетка и тор: 0 — восток, 1 — запад, 2 — север, 3 — юг; кольцо: 0 — по часовой, 1 — против;
+ * fat-tree: `0..K-1` — вниз, `K..2K-1` — вверх. Последний порт — локальный.
+ */
+VerilogStats emitParameterized(const Graph& graph, const fs::path& staging, const VerilogOptions& options,
+                               std::vector<fs::path>& files) {
+    const TopologyParams& p = graph.params;
+    uint64_t ports = 0;
+    switch (p.kind) {
+    case TopologyKind::Mesh:
+    case TopologyKind::Torus: ports = 5; break;
+    case TopologyKind::Ring: ports = 3; break;
+    case TopologyKind::FatTree: ports = 2 * uint64_t(p.k) + 1; break;
+    }
+
+    Text router(4096);
+    router << "// Маршрутизатор сети " << topologyName(p.kind) << ", общий для всех узлов; положение узла задаётся параметрами.\n"
+           << "module noc_router #(\n"
+           << "    parameter FLIT_WIDTH = " << options.flitWidth << ",\n"
+           << "    parameter ID_WIDTH = " << bitsFor(graph.nodeCount()) << ",\n";
+    switch (p.kind) {
+    case TopologyKind::Mesh:
+    case TopologyKind::Torus:
+        router << "    parameter NX = " << p.nx << ",\n"
+               << "    parameter NY = " << p.ny << ",\n"
+               << "    parameter X = 0,\n"
+               << "    parameter Y = 0\n";
+        break;
+    case TopologyKind::Ring:
+        router << "    parameter N = " << p.n << ",\n"
+               << "    parameter POS = 0\n";
+        break;
+    case TopologyKind::FatTree:
+        router << "    parameter K = " << p.k << ",\n"
+               << "    parameter LEVELS = " << p.levels << ",\n"
+               << "    parameter LEVEL = 0,\n"
+               << "    parameter W = 0,\n"
+               << "    parameter UP_STRIDE = 1,\n"
+               << "    parameter DOWN_STRIDE = 1\n";
+        break;
+    }
+    router << ") (\n"
+           << "    input  wire clk,\n"
+           << "    input  wire rst,\n"
+           << "    input  wire [" << ports << "*FLIT_WIDTH-1:0] in_flit,\n"
+           << "    input  wire [" << ports - 1 << ":0] in_valid,\n"
+           << "    output reg  [" << ports << "*FLIT_WIDTH-1:0] out_flit,\n"
+           << "    output reg  [" << ports - 1 << ":0] out_valid\n"
+           << ");\n"
+           << "    localparam PORTS = " << ports << ";\n"
+           << "    localparam LOCAL = " << ports - 1 << ";\n"
+           << "    localparam SEL_WIDTH = " << bitsFor(ports) << ";\n\n"
+           << "    function automatic [SEL_WIDTH-1:0] route(input [ID_WIDTH-1:0] dst);\n";
+    switch (p.kind) {
+    case TopologyKind::Mesh:
+        router << "        integer dx, dy;\n"
+               << "        begin\n"
+               << "            dx = dst % NX;\n"
+               << "            dy = dst / NX;\n"
+               << "            if (dx > X) route = 0;\n"
+               << "            else if (dx < X) route = 1;\n"
+               << "            else if (dy > Y) route = 3;\n"
+               << "            else if (dy < Y) route = 2;\n"
+               << "            else route = LOCAL;\n"
+               << "        end\n";
+        break;
+    case TopologyKind::Torus:
+        router << "        integer dx, dy;\n"
+               << "        begin\n"
+               << "            dx = dst % NX;\n"
+               << "            dy = dst / NX;\n"
+               << "            if (dx != X) route = ((dx - X + NX) % NX <= NX / 2) ? 0 : 1;\n"
+               << "            else if (dy != Y) route = ((dy - Y + NY) % NY <= NY / 2) ? 3 : 2;\n"
+               << "            else route = LOCAL;\n"
+               << "        end\n";
+        break;
+    case TopologyKind::Ring:
+        router << "        begin\n"
+               << "            if (dst == POS) route = LOCAL;\n"
+               << "            else route = ((dst - POS + N) % N <= N / 2) ? 0 : 1;\n"
+               << "        end\n";
+        break;
+    case TopologyKind::FatTree:
+        router << "        begin\n"
+               << "            if (dst / UP_STRIDE == W / UP_STRIDE)\n"
+               << "                route = LEVEL == 0 ? LOCAL : (dst / DOWN_STRIDE) % K;\n"
+               << "            else\n"
+               << "                route = LEVEL + 1 < LEVELS ? K + (dst / UP_STRIDE) % K : LOCAL;\n"
+               << "        end\n";
+        break;
+    }
+    router << "    endfunction\n";
+    writeSwitch(router);
+
+    Text link(1024);
+    link << "// Регистровое звено между маршрутизаторами.\n"
+         << "module noc_link #(\n"
+         << "    parameter FLIT_WIDTH = " << options.flitWidth << "\n"
+         << ") (\n"
+         << "    input  wire                  clk,\n"
+         << "    input  wire                  rst,\n"
+         << "    input  wire [FLIT_WIDTH-1:0] in_flit,\n"
+         << "    input  wire                  in_valid,\n"
+         << "    output reg  [FLIT_WIDTH-1:0] out_flit,\n"
+         << "    output reg                   out_valid\n"
+         << ");\n"
+         << "    always @(posedge clk) begin\n"
+         << "        out_flit <= in_flit;\n"
+         << "        out_valid <= !rst && in_valid;\n"
+         << "    end\n"
+         << "endmodule\n";
+
+    if (!options.groups.empty()) {
+        files = {staging / "noc_router.v", staging / "noc_link.v"};
+        writeWholeFile(files[0], router.str());
+        writeWholeFile(files[1], link.str());
+        VerilogStats stats;
+        stats.modules = 3 + options.groups.size();
+        stats.bytes = router.str().size() + link.str().size()
+            + emitGroups(graph, staging, options, reversePorts(graph, options.jobs), ports, files);
+        return stats;
+    }
+
+    Text top(8192);
+    writeParameterizedTopHeader(top, graph, options.flitWidth, ports);
+    switch (p.kind) {
+    case TopologyKind::Mesh:
+    case TopologyKind::Torus: {
+        const std::string in = "            ";
+        top << "    localparam NX = " << p.nx << ", NY = " << p.ny << ";\n"
+            << "    localparam WRAP = " << (p.kind == TopologyKind::Torus ? 1 : 0) << ";\n\n"
+            << "    genvar x, y;\n"
+            << "    generate\n"
+            << "        for (y = 0; y < NY; y = y + 1) begin : row\n"
+            << "        for (x = 0; x < NX; x = x + 1) begin : col\n"
+            << in << "localparam ID = y*NX + x;\n"
+            << in << "noc_router #(.FLIT_WIDTH(FLIT_WIDTH), .ID_WIDTH(ID_WIDTH), .NX(NX), .NY(NY), .X(x), .Y(y)) router (\n"
+            << in << "    .clk(clk), .rst(rst),\n"
+            << in << "    .in_flit(rin_flit[ID*PORTS*FLIT_WIDTH +: PORTS*FLIT_WIDTH]), .in_valid(rin_valid[ID*PORTS +: PORTS]),\n"
+            << in << "    .out_flit(rout_flit[ID*PORTS*FLIT_WIDTH +: PORTS*FLIT_WIDTH]), .out_valid(rout_valid[ID*PORTS +: PORTS])\n"
+            << in << ");\n";
+        writeParameterizedLocal(top, in);
+        writeParameterizedLink(top, in, "east", "x + 1 < NX || (WRAP && NX > 1)", "0", "y*NX + (x + 1) % NX", "1");
+        writeParameterizedLink(top, in, "west", "x > 0 || (WRAP && NX > 1)", "1", "y*NX + (x + NX - 1) % NX", "0");
+        writeParameterizedLink(top, in, "north", "y > 0 || (WRAP && NY > 1)", "2", "((y + NY - 1) % NY)*NX + x", "3");
+        writeParameterizedLink(top, in, "south", "y + 1 < NY || (WRAP && NY > 1)", "3", "((y + 1) % NY)*NX + x", "2");
+        top << "        end\n"
+            << "        end\n"
+            << "    endgenerate\n";
+        break;
+    }
+    case TopologyKind::Ring: {
+        const std::string in = "            ";
+        top << "    genvar i;\n"
+            << "    generate\n"
+            << "        for (i = 0; i < N; i = i + 1) begin : node\n"
+            << in << "localparam ID = i;\n"
+            << in << "noc_router #(.FLIT_WIDTH(FLIT_WIDTH), .ID_WIDTH(ID_WIDTH), .N(N), .POS(i)) router (\n"
+            << in << "    .clk(clk), .rst(rst),\n"
+            << in << "    .in_flit(rin_flit[ID*PORTS*FLIT_WIDTH +: PORTS*FLIT_WIDTH]), .in_valid(rin_valid[ID*PORTS +: PORTS]),\n"
+            << in << "    .out_flit(rout_flit[ID*PORTS*FLIT_WIDTH +: PORTS*FLIT_WIDTH]), .out_valid(rout_valid[ID*PORTS +: PORTS])\n"
+            << in << ");\n";
+        writeParameterizedLocal(top, in);
+        writeParameterizedLink(top, in, "cw", "N > 1", "0", "(i + 1) % N", "1");
+        writeParameterizedLink(top, in, "ccw", "N > 1", "1", "(i + N - 1) % N", "0");
+        top << "        end\n"
+            << "    endgenerate\n";
+        break;
+    }
+    case TopologyKind::FatTree: {
+        const std::string in = "            ";
+        const std::string inner = "                ";
+        uint64_t perLevel = graph.nodeCount() / p.levels;
+        top << "    localparam K = " << p.k << ", LEVELS = " << p.levels << ", PER_LEVEL = " << perLevel << ";\n\n"
+            << "    function integer ipow(input integer base, input integer exponent);\n"
+            << "        integer j;\n"
+            << "        begin\n"
+            << "            ipow = 1;\n"
+            << "            for (j = 0; j < exponent; j = j + 1) ipow = ipow * base;\n"
+            << "        end\n"
+            << "    endfunction\n\n"
+            << "    genvar l, w, d;\n"
+            << "    generate\n"
+            << "        for (l = 0; l < LEVELS; l = l + 1) begin : level\n"
+            << "        for (w = 0; w < PER_LEVEL; w = w + 1) begin : sw\n"
+            << in << "localparam ID = l*PER_LEVEL + w;\n"
+            << in << "localparam UP_STRIDE = ipow(K, l);\n"
+            << in << "localparam DOWN_STRIDE = l > 0 ? ipow(K, l - 1) : 1;\n"
+            << in << "noc_router #(.FLIT_WIDTH(FLIT_WIDTH), .ID_WIDTH(ID_WIDTH), .K(K), .LEVELS(LEVELS), .LEVEL(l), .W(w),\n"
+            << in << "             .UP_STRIDE(UP_STRIDE), .DOWN_STRIDE(DOWN_STRIDE)) router (\n"
+            << in << "    .clk(clk), .rst(rst),\n"
+            << in << "    .in_flit(rin_flit[ID*PORTS*FLIT_WIDTH +: PORTS*FLIT_WIDTH]), .in_valid(rin_valid[ID*PORTS +: PORTS]),\n"
+            << in << "    .out_flit(rout_flit[ID*PORTS*FLIT_WIDTH +: PORTS*FLIT_WIDTH]), .out_valid(rout_valid[ID*PORTS +: PORTS])\n"
+            << in << ");\n";
+        writeParameterizedLocal(top, in);
+        // Вниз: цифра l-1 номера заменяется на d, ребро приходит на восходящий порт K + цифра l-1 номера w.
+        // Вверх: цифра l номера заменяется на d, ребро приходит на нисходящий порт, равный цифре l номера w.
+        top << in << "for (d = 0; d < K; d = d + 1) begin : port\n";
+        writeParameterizedLink(top, inner, "down", "l > 0", "d",
+                               "(l - 1)*PER_LEVEL + w - ((w / DOWN_STRIDE) % K)*DOWN_STRIDE + d*DOWN_STRIDE",
+                               "K + (w / DOWN_STRIDE) % K");
+        writeParameterizedLink(top, inner, "up", "l + 1 < LEVELS", "K + d",
+                               "(l + 1)*PER_LEVEL + w - ((w / UP_STRIDE) % K)*UP_STRIDE + d*UP_STRIDE",
+                               "(w / UP_STRIDE) % K");
+        top << in << "end\n"
+            << "        end\n"
+            << "        end\n"
+            << "    endgenerate\n";
+        break;
+    }
+    }
+    top << "endmodule\n";
+
+    files = {staging / "noc_router.v", staging / "noc_link.v", staging / "noc_top.v"};
+    writeWholeFile(files[0], router.str());
+    writeWholeFile(files[1], link.str());
+    writeWholeFile(files[2], top.str());
+
+    VerilogStats stats;
+    stats.modules = 3;
+    stats.bytes = router.str().size() + link.str().size() + top.str().size();
+    return stats;
+}
+
+} // namespace
+
+std::string groupInstancePath(const VerilogGroup& group) {
+    return group.module + ":" + group.instance;
+}
+
+std::string routerInstancePath(const Graph& graph, VerilogStyle style, uint32_t u, const VerilogGroup* group) {
+    const std::string id = std::to_string(u);
+    // В группах экземпляры создаются явно в обоих стилях.
+    if (group != nullptr)
+        return groupInstancePath(*group) + "|" + (style == VerilogStyle::PerNode ? "noc_router_" + id : "noc_router")
+            + ":router_" + id;
+    if (style == VerilogStyle::PerNode)
+        return "noc_router_" + id + ":router_" + id;
+    const std::string x = std::to_string(graph.nodes.x[u]), y = std::to_string(graph.nodes.y[u]);
+    switch (graph.params.kind) {
+    case TopologyKind::Mesh:
+    case TopologyKind::Torus: return "noc_router:row[" + y + "].col[" + x + "].router";
+    case TopologyKind::Ring: return "noc_router:node[" + x + "].router";
+    case TopologyKind::FatTree: return "noc_router:level[" + y + "].sw[" + x + "].router";
+    }
+    return {};
+}
+
+std::string linkInstancePath(const Graph& graph, VerilogStyle style, uint32_t u, uint64_t i, const VerilogGroup* group) {
+    if (group != nullptr) {
+        const std::string name = std::to_string(u) + "_" + std::to_string(i);
+        return groupInstancePath(*group) + "|" + (style == VerilogStyle::PerNode ? "noc_link_" + name : "noc_link")
+            + ":link_" + name;
+    }
+    if (style == VerilogStyle::PerNode) {
+        const std::string name = std::to_string(u) + "_" + std::to_string(i);
+        return "noc_link_" + name + ":link_" + name;
+    }
+    const uint8_t port = graph.ports[graph.offsets[u] + i];
+    const std::string x = std::to_string(graph.nodes.x[u]), y = std::to_string(graph.nodes.y[u]);
+    switch (graph.params.kind) {
+    case TopologyKind::Mesh:
+    case TopologyKind::Torus: {
+        static const char* const directions[] = {"east", "west", "north", "south"};
+        return "noc_link:row[" + y + "].col[" + x + "]." + directions[port] + ".link";
+    }
+    case TopologyKind::Ring:
+        return "noc_link:node[" + x + "]." + (port == 0 ? "cw" : "ccw") + ".link";
+    case TopologyKind::FatTree: {
+        const uint32_t k = graph.params.k;
+        const bool down = port < k;
+        return "noc_link:level[" + y + "].sw[" + x + "].port[" + std::to_string(down ? port : port - k) + "]."
+            + (down ? "down" : "up") + ".link";
+    }
+    }
+    return {};
+}
+
+VerilogStats emitVerilog(const Graph& graph, const std::string& directory, const VerilogOptions& options) {
+    const fs::path target(directory);
+    const fs::path staging(directory + ".staging");
+    fs::remove_all(staging);
+    fs::create_directories(staging);
+
+    std::vector<fs::path> files;
+    VerilogStats stats = options.style == VerilogStyle::Parameterized
+        ? emitParameterized(graph, staging, options, files)
+        : emitPerNode(graph, staging, options, files);
+    stats.files = files.size();
+    for (const auto& [name, text] : options.extraFiles) {
+        writeWholeFile(staging / name, text);
+        files.push_back(staging / name);
+    }
+
+    // Пакетный сброс: все файлы записаны, теперь они синхронизируются параллельно.
+    if (options.sync) {
+        common::parallelFor(files.size(), options.jobs, [&](size_t i) { syncPath(files[i], false); });
+        syncPath(staging, true);
+    }
+
+    // Прежний каталог откладывается в сторону, а не перезаписывается: его файлы могут быть
+    // жёсткими ссылками на объекты хранилища артефактов.
+    const fs::path previous(directory + ".old");
+    fs::remove_all(previous);
+    if (fs::exists(target))
+        fs::rename(target, previous);
+    fs::rename(staging, target);
+    if (options.sync)
+        syncPath(target.parent_path().empty() ? fs::path(".") : target.parent_path(), true);
+    fs::remove_all(previous);
+    return stats;
+}
+
+} // namespace noc
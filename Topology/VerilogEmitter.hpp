@@ -0,0 +1,118 @@
+#pragma once
+/**
+ * @file VerilogEmitter.hpp
+ * @brief Параллельная генерация Verilog-описания сети `<имя>_NoC_description`.
+ *
+ * Поддерживаются два стиля вывода (VerilogStyle).
+ *
+ * PerNode — для каждого маршрутизатора `u` создаются файлы:
+ * - `noc_router_<u>.v` — модуль `noc_router_<u>` с функцией маршрутизации для его координат;
+ * - `noc_links_<u>.v`  — модули `noc_link_<u>_<i>`: регистровые звенья исходящих связей.
+ *
+ * Файл `noc_top.v` содержит модуль `noc_top`, который соединяет маршрутизаторы звеньями
+ * и выводит локальные порты всех маршрутизаторов наружу.
+ *
+ * Порты маршрутизатора: `0..degree-1` — сетевые, в порядке рёбер CSR; последний — локальный.
+ * Входной порт `i` маршрутизатора `u` принимает флиты от соседа, к которому ведёт выходной порт `i`.
+ * Флит однословный, в младших разрядах — номер узла назначения.
+ *
+ * Parameterized — три файла: `noc_router.v` с единственным модулем `noc_router`, положение которого
+ * в сети задаётся параметрами, `noc_link.v` с модулем `noc_link` и `noc_top.v`, где маршрутизаторы
+ * и звенья создаются циклами generate. Объём исходников не зависит от размера сети, и Quartus
+ * анализирует каждый модуль один раз, а не по разу на узел.
+ *
+ * Если заданы группы (VerilogOptions::groups), маршрутизаторы каждой группы вместе с их исходящими
+ * звеньями оборачиваются в модуль группы (`<модуль группы>.v`), а `noc_top` соединяет группы:
+ * так группа становится одним экземпляром, на который можно назначить проектный раздел.
+ * Внутри групп экземпляры создаются явно в обоих стилях; в параметризованном стиле они используют
+ * общие модули `noc_router` и `noc_link` с параметрами положения узла.
+ */
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "Topology.hpp"
+
+namespace noc {
+
+/**
+ * @brief Стиль Verilog-описания.
+ */
+enum class VerilogStyle {
+    PerNode,       ///< Отдельные модули для каждого маршрутизатора и звена.
+    Parameterized  ///< Общие параметризованные модули и циклы generate.
+};
+
+/**
+ * @brief Группа маршрутизаторов, обёрнутая в отдельный модуль.
+ */
+struct VerilogGroup {
+    std::string module;             ///< Имя модуля группы (и его файла).
+    std::string instance;           ///< Имя экземпляра группы в `noc_top`.
+    std::vector<uint32_t> routers;  ///< Маршрутизаторы группы по возрастанию номера.
+};
+
+/**
+ * @brief Параметры генерации.
+ */
+struct VerilogOptions {
+    VerilogStyle style = VerilogStyle::PerNode;
+    unsigned jobs = 1;        ///< Число потоков; на содержимое файлов не влияет.
+    unsigned flitWidth = 32;  ///< Значение по умолчанию параметра FLIT_WIDTH.
+    bool sync = true;         ///< Сбросить файлы на диск перед заменой каталога.
+    /// Группы маршрутизаторов; пусто — маршрутизаторы создаются прямо в `noc_top`.
+    /// Каждый маршрутизатор должен входить ровно в одну группу.
+    std::vector<VerilogGroup> groups;
+    /// Дополнительные файлы каталога (имя, содержимое), например назначения Quartus для групп.
+    /// Записываются во временный каталог вместе с модулями и появляются в `directory` одновременно с ними;
+    /// в VerilogStats::files не учитываются.
+    std::vector<std::pair<std::string, std::string>> extraFiles;
+};
+
+/**
+ * @brief Итоги генерации.
+ */
+struct VerilogStats {
+    uint64_t modules = 0;
+    uint64_t files = 0;
+    uint64_t bytes = 0;
+};
+
+/**
+ * @brief Иерархический путь экземпляра маршрутизатора `u` относительно `noc_top`
+ * в нотации Quartus (`модуль:экземпляр`, вложенность — `|`, блоки generate — `метка[индекс].`).
+ *
+ * @param group Группа, в которую входит `u`, если описание сгенерировано с группами.
+ */
+std::string routerInstancePath(const Graph& graph, VerilogStyle style, uint32_t u, const VerilogGroup* group = nullptr);
+
+/**
+ * @brief Иерархический путь экземпляра звена, выходящего из порта `i` маршрутизатора `u`
+ * (`i` — номер ребра среди рёбер `u` в порядке CSR).
+ */
+std::string linkInstancePath(const Graph& graph, VerilogStyle style, uint32_t u, uint64_t i,
+                             const VerilogGroup* group = nullptr);
+
+/**
+ * @brief Путь экземпляра группы относительно `noc_top`.
+ */
+std::string groupInstancePath(const VerilogGroup& group);
+
+/**
+ * @brief Генерирует Verilog-описание графа в каталог `directory`.
+ *
+ * Модули формируются параллельно в заранее зарезервированных буферах и записываются
+ * каждый одним вызовом во временный каталог `<directory>.staging`. После записи всех
+ * файлов они сбрасываются на диск одним пакетом, и временный каталог атомарно заменяет
+ * прежний. Файлы прежнего каталога не перезаписываются на месте: они могут быть
+ * жёсткими ссылками на объекты хранилища артефактов.
+ *
+ * Результат побайтно одинаков при любом числе потоков.
+ *
+ * @throws std::invalid_argument если граф несимметричен (у ребра нет обратного).
+ * @throws std::runtime_error при ошибке записи.
+ */
+VerilogStats emitVerilog(const Graph& graph, const std::string& directory, const VerilogOptions& options);
+
+} // namespace noc